@@ -0,0 +1,142 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: asynctexloader.cpp
+ *        Created: 10/16/2026 23:58:20
+ *    Description:
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#include <algorithm>
+#include "fflerror.hpp"
+#include "asynctexloader.hpp"
+
+extern AsyncTexLoader *g_asyncTexLoader;
+
+AsyncTexLoader::AsyncTexLoader(size_t threadCount)
+    : m_stop(false)
+{
+    if(!threadCount){
+        throw fflerror("async texture loader requires at least one thread");
+    }
+
+    for(size_t i = 0; i < threadCount; ++i){
+        m_threadList.emplace_back([this]()
+        {
+            while(true){
+                std::function<void()> job;
+                {
+                    std::unique_lock<std::mutex> lockGuard(m_lock);
+                    m_cond.wait(lockGuard, [this]() -> bool
+                    {
+                        return m_stop || !m_jobQ.empty();
+                    });
+
+                    if(m_stop){
+                        return;
+                    }
+
+                    job = std::move(m_jobQ.front());
+                    m_jobQ.pop_front();
+                }
+                job();
+            }
+        });
+    }
+}
+
+AsyncTexLoader::~AsyncTexLoader()
+{
+    {
+        std::lock_guard<std::mutex> lockGuard(m_lock);
+        m_stop = true;
+        m_jobQ.clear();
+    }
+
+    m_cond.notify_all();
+    for(auto &t: m_threadList){
+        t.join();
+    }
+}
+
+void AsyncTexLoader::addJob(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lockGuard(m_lock);
+        m_jobQ.push_back(std::move(job));
+    }
+    m_cond.notify_one();
+}
+
+AsyncTexQueue::~AsyncTexQueue()
+{
+    // worker threads should have been stopped
+    // see the exit sequence in main.cpp
+    for(auto &result: m_doneList){
+        if(result.surface){
+            SDL_FreeSurface(result.surface);
+        }
+    }
+}
+
+bool AsyncTexQueue::schedule(uint32_t key, std::function<AsyncTexResult()> fnDecode)
+{
+    if(!g_asyncTexLoader){
+        return false;
+    }
+
+    if(!m_pendingSet.insert(key).second){
+        return true;
+    }
+
+    g_asyncTexLoader->addJob([this, key, fnDecode = std::move(fnDecode)]()
+    {
+        // worker can't report errors
+        // failed decoding gets an empty texture, same as loadResource()
+        AsyncTexResult result {key, nullptr, 0, 0};
+        try{
+            result = fnDecode();
+        }
+        catch(...){}
+
+        {
+            std::lock_guard<std::mutex> lockGuard(m_doneLock);
+            m_doneList.push_back(result);
+        }
+    });
+    return true;
+}
+
+size_t AsyncTexQueue::upload(size_t maxCount, const std::function<void(const AsyncTexResult &)> &fnUpload)
+{
+    std::vector<AsyncTexResult> resultList;
+    {
+        std::lock_guard<std::mutex> lockGuard(m_doneLock);
+        if(m_doneList.empty()){
+            return 0;
+        }
+
+        const auto count = std::min<size_t>(maxCount, m_doneList.size());
+        resultList.assign(m_doneList.begin(), m_doneList.begin() + count);
+        m_doneList.erase(m_doneList.begin(), m_doneList.begin() + count);
+    }
+
+    for(const auto &result: resultList){
+        m_pendingSet.erase(result.key);
+        fnUpload(result);
+
+        if(result.surface){
+            SDL_FreeSurface(result.surface);
+        }
+    }
+    return resultList.size();
+}
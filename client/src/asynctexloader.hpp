@@ -0,0 +1,99 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: asynctexloader.hpp
+ *        Created: 10/16/2026 23:58:20
+ *    Description: decode textures in worker threads
+ *
+ *                 workers only read the database and decode PNG to SDL_Surface
+ *                 SDL_Texture can only be created in the main thread, database calls
+ *                 Upload() in the main loop to convert finished surfaces to textures
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#pragma once
+#include <mutex>
+#include <deque>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <unordered_set>
+#include <condition_variable>
+#include <SDL2/SDL.h>
+
+class AsyncTexLoader final
+{
+    private:
+        bool m_stop;
+
+    private:
+        std::mutex m_lock;
+        std::condition_variable m_cond;
+        std::deque<std::function<void()>> m_jobQ;
+
+    private:
+        std::vector<std::thread> m_threadList;
+
+    public:
+        AsyncTexLoader(size_t);
+
+    public:
+        // jobs not started yet get dropped
+        ~AsyncTexLoader();
+
+    public:
+        void addJob(std::function<void()>);
+};
+
+struct AsyncTexResult
+{
+    uint32_t     key;
+    SDL_Surface *surface;
+
+    int DX;
+    int DY;
+};
+
+// async loading state of one database
+// pending keys are only accessed in the main thread, done list is shared with workers
+class AsyncTexQueue final
+{
+    private:
+        std::unordered_set<uint32_t> m_pendingSet;
+
+    private:
+        std::mutex m_doneLock;
+        std::vector<AsyncTexResult> m_doneList;
+
+    public:
+        AsyncTexQueue() = default;
+
+    public:
+        ~AsyncTexQueue();
+
+    public:
+        bool pending(uint32_t key) const
+        {
+            return m_pendingSet.find(key) != m_pendingSet.end();
+        }
+
+    public:
+        // returns false if async loading is disabled, caller should load it synchronously
+        // fnDecode runs in worker thread
+        bool schedule(uint32_t, std::function<AsyncTexResult()>);
+
+    public:
+        // call fnUpload in main thread for at most maxCount finished results
+        // surface is freed after fnUpload returns
+        size_t upload(size_t, const std::function<void(const AsyncTexResult &)> &);
+};
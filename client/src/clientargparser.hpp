@@ -17,7 +17,10 @@
  */
 
 #pragma once
+#include <string>
+#include <thread>
 #include <cstdint>
+#include <algorithm>
 #include "argparser.hpp"
 
 struct ClientArgParser
@@ -41,6 +44,9 @@ struct ClientArgParser
     const std::string serverIP;         // "--server-ip"
     const std::string serverPort;       // "--server-port"
 
+    const int asyncTexThread;           // "--async-tex-thread"
+    const int prefetchRadius;           // "--prefetch-radius"
+
     bool traceMove;
 
     ClientArgParser(const arg_parser &cmdParser)
@@ -61,6 +67,33 @@ struct ClientArgParser
         , drawFPS(cmdParser["draw-fps"])
         , serverIP(cmdParser("server-ip").str())
         , serverPort(cmdParser("server-port").str())
+        , asyncTexThread([&cmdParser]() -> int
+          {
+              // threads decoding map textures in background
+              // 0 disables async loading, textures are decoded in main thread when drawing
+              if(const auto numStr = cmdParser("async-tex-thread").str(); !numStr.empty()){
+                  try{
+                      return std::max<int>(0, std::stoi(numStr));
+                  }
+                  catch(...){
+                      return 0;
+                  }
+              }
+              return std::clamp<int>((int)(std::thread::hardware_concurrency()) / 2, 1, 4);
+          }())
+        , prefetchRadius([&cmdParser]() -> int
+          {
+              // grids around the drawing region to load before scrolling into view
+              if(const auto numStr = cmdParser("prefetch-radius").str(); !numStr.empty()){
+                  try{
+                      return std::max<int>(0, std::stoi(numStr));
+                  }
+                  catch(...){
+                      return 0;
+                  }
+              }
+              return 8;
+          }())
         , traceMove(cmdParser["trace-move"])
     {}
 };
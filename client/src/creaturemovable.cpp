@@ -117,6 +117,35 @@ std::vector<PathFind::PathNode> CreatureMovable::parseMovePath(int x0, int y0, i
                     // leave it to the complex path solver
                 }
 
+                // the grid path solver
+                // it only knows ground and gives unit steps, use it for walking only
+                // if any creature on the path can't be ignored, leave it to the complex path solver
+
+                if(checkGround && nMaxStep == 1){
+                    const auto pathList = m_processRun->getHPAGraph().search(x0, y0, x1, y1);
+
+                    // empty path doesn't mean unreachable, HPA* caps its search window
+                    bool pathFree = !pathList.empty();
+                    for(size_t i = 1; pathFree && checkCreature && i + 1 < pathList.size(); ++i){
+                        switch(m_processRun->CheckPathGrid(pathList[i].X, pathList[i].Y)){
+                            case PathFind::OCCUPIED:
+                            case PathFind::LOCKED:
+                                {
+                                    pathFree = false;
+                                    break;
+                                }
+                            default:
+                                {
+                                    break;
+                                }
+                        }
+                    }
+
+                    if(pathFree){
+                        return pathList;
+                    }
+                }
+
                 // the complex path solver
                 // we can always use this solver only
 
@@ -19,6 +19,7 @@
 
 #pragma once
 #include <map>
+#include <memory>
 #include <cstring>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
@@ -27,6 +28,7 @@
 #include "inndb.hpp"
 #include "fflerror.hpp"
 #include "hexstr.hpp"
+#include "texatlas.hpp"
 #include "sdldevice.hpp"
 
 enum FontStyle: uint8_t
@@ -42,7 +44,28 @@ enum FontStyle: uint8_t
 
 struct FontexEntry
 {
+    // standalone texture
+    // null if the glyph is packed into the atlas of its font
     SDL_Texture *Texture;
+
+    // region.page is -1 for standalone texture
+    // region.w/h always gives the glyph size
+    TexAtlasRegion Region {};
+
+    // 0XFF00 : font index
+    // 0X00FF : font point size
+    uint16_t TTFIndex = 0;
+};
+
+struct FontexRegion
+{
+    SDL_Texture *texture = nullptr;
+    SDL_Rect     rect {0, 0, 0, 0};
+
+    operator bool () const
+    {
+        return texture != nullptr;
+    }
 };
 
 class FontexDB: public innDB<uint64_t, FontexEntry>
@@ -59,12 +82,21 @@ class FontexDB: public innDB<uint64_t, FontexEntry>
     private:
         std::map<uint8_t, std::vector<uint8_t>> m_fontDataCache;
 
+    private:
+        // one atlas per (font, size), same key as m_TTFCache
+        // glyphs of one line mostly share one page then they can be drawn in one batch
+        const int m_atlasPage;
+        std::map<uint16_t, std::unique_ptr<TexAtlas>> m_atlasList;
+
     public:
-        FontexDB(size_t nResMax)
+        // nAtlasPage > 0 enables glyph atlas with at most nAtlasPage pages per (font, size)
+        // glyphs in atlas can only be accessed by RetrieveRegion()
+        FontexDB(size_t nResMax, int nAtlasPage = 0)
             : innDB<uint64_t, FontexEntry>(nResMax)
             , m_zsdbPtr()
             , m_TTFCache()
             , m_fontDataCache()
+            , m_atlasPage(nAtlasPage)
         {}
 
         virtual ~FontexDB()
@@ -146,6 +178,57 @@ class FontexDB: public innDB<uint64_t, FontexEntry>
             return Retrieve(nKey);
         }
 
+    public:
+        // texture is the atlas page or the standalone texture
+        // draw with rect as source, don't change texture states since the page is shared
+        FontexRegion RetrieveRegion(uint64_t nKey)
+        {
+            if(FontexEntry stEntry {nullptr}; this->RetrieveResource(nKey, &stEntry)){
+                if(stEntry.Region.page >= 0){
+                    return {m_atlasList.at(stEntry.TTFIndex)->pageTexture(stEntry.Region.page), {stEntry.Region.x, stEntry.Region.y, stEntry.Region.w, stEntry.Region.h}};
+                }
+
+                if(stEntry.Texture){
+                    return {stEntry.Texture, {0, 0, stEntry.Region.w, stEntry.Region.h}};
+                }
+            }
+            return {};
+        }
+
+    private:
+        static uint16_t getTTFIndex(uint64_t nKey)
+        {
+            return (uint16_t)((nKey & 0X00FFFF0000000000) >> 40);
+        }
+
+        FontexEntry createEntry(uint16_t nTTFIndex, SDL_Surface *pSurface)
+        {
+            FontexEntry stEntry {nullptr};
+            stEntry.TTFIndex = nTTFIndex;
+
+            if(!pSurface){
+                return stEntry;
+            }
+
+            if(m_atlasPage > 0){
+                auto &pAtlas = m_atlasList[nTTFIndex];
+                if(!pAtlas){
+                    // glyphs are small, use 8px units and 512px pages
+                    pAtlas = std::make_unique<TexAtlas>(m_atlasPage, 64, 8, 64);
+                }
+
+                if(pAtlas->add(pSurface, &stEntry.Region)){
+                    return stEntry;
+                }
+            }
+
+            extern SDLDevice *g_sdlDevice;
+            stEntry.Texture = g_sdlDevice->CreateTextureFromSurface(pSurface);
+            stEntry.Region.w = pSurface->w;
+            stEntry.Region.h = pSurface->h;
+            return stEntry;
+        }
+
     public:
         uint8_t findFontName(const char *fontName)
         {
@@ -172,7 +255,7 @@ class FontexDB: public innDB<uint64_t, FontexEntry>
         {
             FontexEntry stEntry {nullptr};
 
-            uint16_t nTTFIndex  = ((nKey & 0X00FFFF0000000000) >> 40);
+            uint16_t nTTFIndex  = getTTFIndex(nKey);
             uint8_t  nFontStyle = ((nKey & 0X000000FF00000000) >> 32);
             uint32_t nUTF8Code  = ((nKey & 0X00000000FFFFFFFF) >>  0);
 
@@ -224,11 +307,10 @@ class FontexDB: public innDB<uint64_t, FontexEntry>
                 return {stEntry, 0};
             }
 
-            extern SDLDevice *g_sdlDevice;
-            stEntry.Texture = g_sdlDevice->CreateTextureFromSurface(pSurface);
+            stEntry = createEntry(nTTFIndex, pSurface);
             SDL_FreeSurface(pSurface);
 
-            return {stEntry, stEntry.Texture ? 1 : 0};
+            return {stEntry, (stEntry.Texture || stEntry.Region.page >= 0) ? 1 : 0};
         }
 
         virtual void freeResource(FontexEntry &rstEntry)
@@ -237,5 +319,10 @@ class FontexDB: public innDB<uint64_t, FontexEntry>
                 SDL_DestroyTexture(rstEntry.Texture);
                 rstEntry.Texture = nullptr;
             }
+
+            if(rstEntry.Region.page >= 0){
+                m_atlasList.at(rstEntry.TTFIndex)->remove(rstEntry.Region);
+                rstEntry.Region.page = -1;
+            }
         }
 };
@@ -238,7 +238,15 @@ void LayoutBoard::addPar(int loc, const std::array<int, 4> &parMargin, const tin
     }
 
     if(updateSize){
-        setupSize();
+        if(std::next(currNode) == m_parNodeList.end()){
+            // appending only extends the board
+            // chat log appends a lot, don't check all paragraphs
+            m_w = std::max<int>(m_w, currNode->margin[2] + currNode->tpset->pw() + currNode->margin[3]);
+            m_h = currNode->startY + currNode->margin[0] + currNode->margin[1] + currNode->tpset->ph();
+        }
+        else{
+            setupSize();
+        }
     }
 }
 
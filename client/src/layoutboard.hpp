@@ -149,6 +149,12 @@ class LayoutBoard: public Widget
     private:
         auto ithParIterator(int i)
         {
+            // appending is the most common case
+            // don't walk through the whole list
+            if(i == parCount()){
+                return m_parNodeList.end();
+            }
+
             auto p = m_parNodeList.begin();
             std::advance(p, i);
             return p;
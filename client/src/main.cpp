@@ -26,6 +26,7 @@
 #include "emoticondb.hpp"
 #include "debugboard.hpp"
 #include "pngtexoffdb.hpp"
+#include "asynctexloader.hpp"
 #include "clientargparser.hpp"
 
 // global variables, decide to follow pattern in MapEditor
@@ -33,6 +34,7 @@
 
 ClientArgParser *g_clientArgParser = nullptr;
 Log             *g_log             = nullptr; // log information handler, must be inited first
+AsyncTexLoader  *g_asyncTexLoader  = nullptr; // background texture decoding, null if disabled
 PNGTexDB        *g_progUseDB       = nullptr; // database for all PNG texture only
 PNGTexDB        *g_itemDB          = nullptr; // database for all PNG texture only
 PNGTexDB        *g_mapDB           = nullptr;
@@ -62,10 +64,12 @@ int main(int argc, char *argv[])
 
         const auto fnAtExit = +[]()
         {
+            // stop texture decoding threads first
+            // they refer to the texture databases
+            delete g_asyncTexLoader ; g_asyncTexLoader  = nullptr;
             delete g_clientArgParser; g_clientArgParser = nullptr;
             delete g_log            ; g_log             = nullptr;
             delete g_XMLConf        ; g_XMLConf         = nullptr;
-            delete g_sdlDevice      ; g_sdlDevice       = nullptr;
             delete g_progUseDB      ; g_progUseDB       = nullptr;
             delete g_itemDB         ; g_itemDB          = nullptr;
             delete g_mapDB          ; g_mapDB           = nullptr;
@@ -74,6 +78,10 @@ int main(int argc, char *argv[])
             delete g_fontexDB       ; g_fontexDB        = nullptr;
             delete g_mapBinDB       ; g_mapBinDB        = nullptr;
             delete g_emoticonDB     ; g_emoticonDB      = nullptr;
+
+            // texture databases free textures and atlas pages
+            // delete them before the renderer
+            delete g_sdlDevice      ; g_sdlDevice       = nullptr;
             delete g_notifyBoard    ; g_notifyBoard     = nullptr;
             delete g_client         ; g_client          = nullptr;
         };
@@ -94,15 +102,16 @@ int main(int argc, char *argv[])
     try{
         g_XMLConf         = new XMLConf();
         g_sdlDevice       = new SDLDevice();
+        g_asyncTexLoader  = g_clientArgParser->asyncTexThread > 0 ? new AsyncTexLoader(g_clientArgParser->asyncTexThread) : nullptr;
         g_progUseDB       = new PNGTexDB(1024);
         g_itemDB          = new PNGTexDB(1024);
-        g_mapDB           = new PNGTexDB(8192);
+        g_mapDB           = new PNGTexDB(8192, 4);
         g_heroDB          = new PNGTexOffDB(1024);
         g_monsterDB       = new PNGTexOffDB(1024);
         g_weaponDB        = new PNGTexOffDB(1024);
         g_magicDB         = new PNGTexOffDB(1024);
         g_standNPCDB      = new PNGTexOffDB(1024);
-        g_fontexDB        = new FontexDB(1024);
+        g_fontexDB        = new FontexDB(1024, 4);
         g_mapBinDB        = new MapBinDB();
         g_emoticonDB      = new emoticonDB();
         g_client          = new Client();       // loads fontex resource
@@ -0,0 +1,124 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: mapchunktable.cpp
+ *        Created: 10/17/2026 13:20:46
+ *    Description:
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#include "fflerror.hpp"
+#include "mapchunktable.hpp"
+
+void MapChunkTable::reset(const Mir2xMapData *mapDataPtr)
+{
+    m_mapData = mapDataPtr;
+    m_chunkList.clear();
+
+    if(m_mapData && m_mapData->Valid()){
+        m_chunkW = (m_mapData->W() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        m_chunkH = (m_mapData->H() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        m_chunkList.resize((size_t)(m_chunkW) * (size_t)(m_chunkH));
+    }
+    else{
+        m_mapData = nullptr;
+        m_chunkW  = 0;
+        m_chunkH  = 0;
+    }
+}
+
+const MapChunkTable::MapChunk &MapChunkTable::getChunk(int cx, int cy)
+{
+    if(!(cx >= 0 && cx < m_chunkW && cy >= 0 && cy < m_chunkH)){
+        throw fflerror("invalid chunk: cx = %d, cy = %d", cx, cy);
+    }
+
+    auto &chunk = m_chunkList[(size_t)(cy) * (size_t)(m_chunkW) + (size_t)(cx)];
+    if(!chunk.done){
+        buildChunk(cx, cy, &chunk);
+        chunk.done = true;
+    }
+    return chunk;
+}
+
+void MapChunkTable::buildChunk(int cx, int cy, MapChunk *chunkPtr) const
+{
+    const int x0 = cx * CHUNK_SIZE;
+    const int y0 = cy * CHUNK_SIZE;
+    const int x1 = std::min<int>(x0 + CHUNK_SIZE, m_mapData->W());
+    const int y1 = std::min<int>(y0 + CHUNK_SIZE, m_mapData->H());
+
+    for(int y = y0; y < y0 + CHUNK_SIZE; ++y){
+        for(auto &layer: chunkPtr->layerList){
+            layer.rowOff[y - y0] = (uint32_t)(layer.cmdList.size());
+        }
+
+        if(y >= y1){
+            continue;
+        }
+
+        for(int x = x0; x < x1; ++x){
+            if(!(x % 2) && !(y % 2)){
+                if(const auto &tile = m_mapData->Tile(x, y); tile.Valid()){
+                    chunkPtr->layerList[LAYER_TILE].cmdList.push_back(MapDrawCmd
+                    {
+                        .x = x,
+                        .y = y,
+                        .image = tile.Image(),
+                        .aniType = -1,
+                        .aniFrame = 0,
+                        .alpha = false,
+                    });
+                }
+            }
+
+            for(const int i: {0, 1}){
+                const auto objArr = m_mapData->Cell(x, y).ObjectArray(i);
+                if(!(objArr[4] & 0X80)){
+                    continue;
+                }
+
+                MapDrawCmd cmd
+                {
+                    .x = x,
+                    .y = y,
+                    .image = 0
+                        | (((uint32_t)(objArr[2])) << 16)
+                        | (((uint32_t)(objArr[1])) <<  8)
+                        | (((uint32_t)(objArr[0])) <<  0),
+
+                    .aniType = -1,
+                    .aniFrame = 0,
+                    .alpha = (bool)(objArr[4] & 0B00000010),
+                };
+
+                if(objArr[3] & 0X80){
+                    if(false
+                            || objArr[2] == 11
+                            || objArr[2] == 26
+                            || objArr[2] == 41
+                            || objArr[2] == 56
+                            || objArr[2] == 71){
+                        cmd.aniType  = (int8_t)((objArr[3] & 0B01110000) >> 4);
+                        cmd.aniFrame = (int8_t)((objArr[3] & 0B00001111));
+                    }
+                }
+                chunkPtr->layerList[(objArr[4] & 0X01) ? LAYER_GROUND : LAYER_OVERGROUND].cmdList.push_back(cmd);
+            }
+        }
+    }
+
+    for(auto &layer: chunkPtr->layerList){
+        layer.rowOff[CHUNK_SIZE] = (uint32_t)(layer.cmdList.size());
+        layer.cmdList.shrink_to_fit();
+    }
+}
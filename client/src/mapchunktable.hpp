@@ -0,0 +1,123 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: mapchunktable.hpp
+ *        Created: 10/17/2026 13:20:46
+ *    Description: static draw commands of map tiles and objects
+ *
+ *                 map is split into CHUNK_SIZE x CHUNK_SIZE chunks, one chunk decodes its
+ *                 cells into draw commands at first access, commands are sorted by (y, x, index)
+ *                 then drawing one row only touches cells which really have something to draw
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#pragma once
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include "mir2xmapdata.hpp"
+
+struct MapDrawCmd
+{
+    // grid location
+    // tile is anchored at top-left, object is anchored at bottom-left
+    int x;
+    int y;
+
+    uint32_t image;
+
+    // animated object only, aniType is -1 for static image
+    // draw image + aniTileFrame[aniType][aniFrame]
+    int8_t aniType;
+    int8_t aniFrame;
+
+    bool alpha;
+};
+
+class MapChunkTable final
+{
+    public:
+        constexpr static int CHUNK_SIZE = 16;
+
+    public:
+        enum LayerType: int
+        {
+            LAYER_TILE = 0,
+            LAYER_GROUND,
+            LAYER_OVERGROUND,
+            LAYER_MAX,
+        };
+
+    private:
+        struct ChunkLayer
+        {
+            // commands in row r of the chunk are cmdList[rowOff[r], rowOff[r + 1])
+            std::vector<MapDrawCmd> cmdList;
+            std::array<uint32_t, CHUNK_SIZE + 1> rowOff {};
+        };
+
+        struct MapChunk
+        {
+            bool done = false;
+            std::array<ChunkLayer, LAYER_MAX> layerList;
+        };
+
+    private:
+        const Mir2xMapData *m_mapData = nullptr;
+
+    private:
+        int m_chunkW = 0;
+        int m_chunkH = 0;
+        std::vector<MapChunk> m_chunkList;
+
+    public:
+        MapChunkTable() = default;
+
+    public:
+        // map data should outlive the table, call it again after map data changes
+        void reset(const Mir2xMapData *);
+
+    public:
+        // visit commands of one layer in row y with x in [x0, x1], ordered by x
+        template<typename F> void forEachCmd(int layer, int y, int x0, int x1, F &&f)
+        {
+            if(!(m_mapData && y >= 0 && y < m_mapData->H())){
+                return;
+            }
+
+            x0 = std::max<int>(x0, 0);
+            x1 = std::min<int>(x1, m_mapData->W() - 1);
+
+            const int r = y % CHUNK_SIZE;
+            for(int cx = x0 / CHUNK_SIZE; cx <= x1 / CHUNK_SIZE; ++cx){
+                const auto &chunkLayer = getChunk(cx, y / CHUNK_SIZE).layerList.at(layer);
+                for(auto i = chunkLayer.rowOff[r]; i < chunkLayer.rowOff[r + 1]; ++i){
+                    const auto &cmd = chunkLayer.cmdList[i];
+                    if(cmd.x < x0){
+                        continue;
+                    }
+
+                    if(cmd.x > x1){
+                        break;
+                    }
+                    f(cmd);
+                }
+            }
+        }
+
+    private:
+        const MapChunk &getChunk(int, int);
+
+    private:
+        void buildChunk(int, int, MapChunk *) const;
+};
@@ -100,6 +100,11 @@ NetIO::NetIO()
     , m_readHC(0)
     , m_readLen {0, 0, 0, 0}
     , m_readBuf(1024)
+    , m_netCaps(NETCAP_NONE)
+    , m_readLZ4(false)
+    , m_decodeBuf()
+    , m_deltaCodec()
+    , m_lz4Decoder()
     , m_msgHandler()
     , m_sendQueue()
     , m_memoryPN()
@@ -203,7 +208,9 @@ void NetIO::readHeadCode()
                         else{
                             uint32_t nDataLenU32 = 0;
                             std::memcpy(&nDataLenU32, m_readLen, 4);
-                            readBody(0, nDataLenU32);
+
+                            m_readLZ4 = (nDataLenU32 & NETCODEC_LZ4FLAG);
+                            readBody(0, nDataLenU32 & ~NETCODEC_LZ4FLAG);
                         }
                     };
                     asio::async_read(m_socket, asio::buffer(m_readLen, 4), fnOnReadLen);
@@ -217,6 +224,7 @@ void NetIO::readHeadCode()
                 }
         }
     };
+    m_readLZ4 = false;
     asio::async_read(m_socket, asio::buffer(&m_readHC, 1), fnOnReadHC);
 }
 
@@ -322,6 +330,40 @@ bool NetIO::readBody(size_t nMaskLen, size_t nBodyLen)
                     }
                 }
 
+                // delta mode: decoded data is XOR against last message of same type
+                if(nMaskLen && (m_netCaps & NETCAP_DELTA) && stSMSG.deltaEncode()){
+                    m_deltaCodec.decode(m_readHC, &(m_readBuf[((nMaskLen + nBodyLen + 7) / 8) * 8]), stSMSG.dataLen());
+                }
+
+                // lz4 mode: [origLen][LZ4 data]
+                if(m_readLZ4){
+                    uint32_t nOrigLenU32 = 0;
+                    if(nBodyLen > 4){
+                        std::memcpy(&nOrigLenU32, &(m_readBuf[0]), 4);
+                    }
+
+                    m_decodeBuf.resize(nOrigLenU32);
+                    if(!(nOrigLenU32 && m_lz4Decoder.decode(m_decodeBuf.data(), nOrigLenU32, &(m_readBuf[4]), nBodyLen - 4))){
+                        // LZ4 stream is broken, all following messages can't be decoded
+                        shutdown();
+                        g_log->addLog(LOGTYPE_WARNING, "LZ4 decode failed: BodyLen = %d, OrigLen = %d", (int)(nBodyLen), (int)(nOrigLenU32));
+                        fnReportCurrentMessage();
+                        return;
+                    }
+
+                    m_msgHandler(m_readHC, m_decodeBuf.data(), m_decodeBuf.size());
+                    readHeadCode();
+                    return;
+                }
+
+                // server switches codec right after SM_NETCAPS
+                // this is handled by NetIO and also forwarded to the message handler
+                if(m_readHC == SM_NETCAPS){
+                    m_netCaps = ServerMsg::conv<SMNetCaps>(&(m_readBuf[0]), nBodyLen).caps;
+                    m_deltaCodec.reset();
+                    m_lz4Decoder.reset();
+                }
+
                 // no matter decoding is needed or not
                 // we should call the completion handler here
 
@@ -541,6 +583,14 @@ void NetIO::start(const char *IPStr, const char * portStr, const std::function<v
             //    all readHeadCode() should be called after the invocation of completion handler
         }
         else{
+            // ask server to encode in delta / lz4 mode
+            // server replies SM_NETCAPS with modes accepted
+            CMNetCaps cmNC;
+            std::memset(&cmNC, 0, sizeof(cmNC));
+
+            cmNC.caps = NETCAP_DELTA | NETCAP_LZ4;
+            send(CM_NETCAPS, cmNC);
+
             readHeadCode();
         }
     });
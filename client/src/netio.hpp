@@ -28,6 +28,7 @@
 #include <asio.hpp>
 #include <queue>
 #include <functional>
+#include "netcodec.hpp"
 #include "memorychunkpn.hpp"
 
 class NetIO final
@@ -51,6 +52,15 @@ class NetIO final
         uint8_t              m_readLen[4];
         std::vector<uint8_t> m_readBuf;
 
+    private:
+        // codec enabled by SM_NETCAPS
+        // m_readLZ4 marks current type 3 body is compressed
+        uint32_t             m_netCaps;
+        bool                 m_readLZ4;
+        std::vector<uint8_t> m_decodeBuf;
+        NetDeltaCodec        m_deltaCodec;
+        NetLZ4Decoder        m_lz4Decoder;
+
     private:
         std::function<void(uint8_t, const uint8_t *, size_t)> m_msgHandler;
 
@@ -30,7 +30,7 @@ bool Pack2D::occupied(int x, int y) const
     if(y >= (int)(m_packMap.size())){
         return false;
     }
-    return (bool)(m_packMap[y] & (1 << x));
+    return (bool)(m_packMap[y] & ((uint64_t)(1) << x));
 }
 
 bool Pack2D::occupied(int x, int y, int argW, int argH, bool occupiedAny) const
@@ -60,11 +60,11 @@ void Pack2D::occupy(int x, int y, bool takeIt)
     }
 
     if(takeIt){
-        m_packMap[y] |= (1 << x);
+        m_packMap[y] |= ((uint64_t)(1) << x);
     }
     else{
-        m_packMap[y] |= (1 << x);
-        m_packMap[y] ^= (1 << x);
+        m_packMap[y] |= ((uint64_t)(1) << x);
+        m_packMap[y] ^= ((uint64_t)(1) << x);
     }
     shrink();
 }
@@ -17,29 +17,60 @@
  */
 
 #pragma once
+#include <mutex>
 #include <vector>
 #include <memory>
 #include <unordered_map>
 
 #include "zsdb.hpp"
 #include "inndb.hpp"
-#include "hexstr.hpp"
+#include "texatlas.hpp"
 #include "sdldevice.hpp"
+#include "asynctexloader.hpp"
 
 struct PNGTexEntry
 {
+    // standalone texture
+    // null if the image is packed into the atlas
     SDL_Texture *Texture;
+
+    // region.page is -1 for standalone texture
+    // region.w/h always gives the image size
+    TexAtlasRegion Region {};
+};
+
+struct PNGTexRegion
+{
+    SDL_Texture *texture = nullptr;
+    SDL_Rect     rect {0, 0, 0, 0};
+
+    operator bool () const
+    {
+        return texture != nullptr;
+    }
 };
 
 class PNGTexDB: public innDB<uint32_t, PNGTexEntry>
 {
     private:
+        // ZSDB has one FILE * and one decompression context
+        // async loading threads share it with the main thread
+        std::mutex m_zsdbLock;
         std::unique_ptr<ZSDB> m_zsdbPtr;
 
+    private:
+        AsyncTexQueue m_asyncQueue;
+
+    private:
+        std::unique_ptr<TexAtlas> m_atlas;
+
     public:
-        PNGTexDB(size_t nResMax)
+        // nAtlasPage > 0 enables the atlas, images in atlas can only be accessed by RetrieveRegion()
+        // only small images are packed, large ones still get standalone textures
+        PNGTexDB(size_t nResMax, int nAtlasPage = 0)
             : innDB<uint32_t, PNGTexEntry>(nResMax)
             , m_zsdbPtr()
+            , m_atlas((nAtlasPage > 0) ? std::make_unique<TexAtlas>(nAtlasPage, 256) : nullptr)
         {}
 
     public:
@@ -68,16 +99,135 @@ class PNGTexDB: public innDB<uint32_t, PNGTexEntry>
         }
 
     public:
-        virtual std::tuple<PNGTexEntry, size_t> loadResource(uint32_t nKey)
+        // won't block on decoding
+        // returns nullptr if not ready yet, caller should skip it in current frame
+        SDL_Texture *RetrieveAsync(uint32_t nKey)
+        {
+            if(PNGTexEntry stEntry {nullptr}; retrieveEntryAsync(nKey, &stEntry)){
+                return stEntry.Texture;
+            }
+            return nullptr;
+        }
+
+    public:
+        // texture is the atlas page or the standalone texture
+        // draw with rect as source, don't change texture states since the page is shared
+        PNGTexRegion RetrieveRegion(uint32_t nKey)
+        {
+            if(PNGTexEntry stEntry {nullptr}; this->RetrieveResource(nKey, &stEntry)){
+                return getRegion(stEntry);
+            }
+            return {};
+        }
+
+        PNGTexRegion RetrieveRegionAsync(uint32_t nKey)
+        {
+            if(PNGTexEntry stEntry {nullptr}; retrieveEntryAsync(nKey, &stEntry)){
+                return getRegion(stEntry);
+            }
+            return {};
+        }
+
+    public:
+        void Prefetch(uint32_t nKey)
+        {
+            if(!this->HasResource(nKey)){
+                scheduleLoad(nKey);
+            }
+        }
+
+        // create textures for decoded surfaces
+        // main thread only, returns number of textures created
+        size_t Upload(size_t nMaxCount)
+        {
+            return m_asyncQueue.upload(nMaxCount, [this](const AsyncTexResult &rstResult)
+            {
+                const auto stEntry = createEntry(rstResult.surface);
+                this->AddResource(rstResult.key, stEntry, (stEntry.Texture || stEntry.Region.page >= 0) ? 1 : 0);
+            });
+        }
+
+    private:
+        bool retrieveEntryAsync(uint32_t nKey, PNGTexEntry *pEntry)
+        {
+            if(this->PeekResource(nKey, pEntry)){
+                return true;
+            }
+
+            if(!scheduleLoad(nKey)){
+                return this->RetrieveResource(nKey, pEntry);
+            }
+            return false;
+        }
+
+        PNGTexRegion getRegion(const PNGTexEntry &rstEntry) const
+        {
+            if(rstEntry.Region.page >= 0){
+                return {m_atlas->pageTexture(rstEntry.Region.page), {rstEntry.Region.x, rstEntry.Region.y, rstEntry.Region.w, rstEntry.Region.h}};
+            }
+
+            if(rstEntry.Texture){
+                return {rstEntry.Texture, {0, 0, rstEntry.Region.w, rstEntry.Region.h}};
+            }
+            return {};
+        }
+
+        PNGTexEntry createEntry(SDL_Surface *pSurface)
         {
-            char szKeyString[16];
             PNGTexEntry stEntry {nullptr};
+            if(!pSurface){
+                return stEntry;
+            }
 
-            if(std::vector<uint8_t> stBuf; m_zsdbPtr->Decomp(hexstr::to_string<uint32_t, 4>(nKey, szKeyString, true), 8, &stBuf)){
-                extern SDLDevice *g_sdlDevice;
-                stEntry.Texture = g_sdlDevice->CreateTexture(stBuf.data(), stBuf.size());
+            if(m_atlas && m_atlas->add(pSurface, &stEntry.Region)){
+                return stEntry;
             }
-            return {stEntry, stEntry.Texture ? 1 : 0};
+
+            extern SDLDevice *g_sdlDevice;
+            stEntry.Texture = g_sdlDevice->CreateTextureFromSurface(pSurface);
+            stEntry.Region.w = pSurface->w;
+            stEntry.Region.h = pSurface->h;
+            return stEntry;
+        }
+
+    private:
+        bool scheduleLoad(uint32_t nKey)
+        {
+            if(m_asyncQueue.pending(nKey)){
+                return true;
+            }
+
+            return m_asyncQueue.schedule(nKey, [this, nKey]() -> AsyncTexResult
+            {
+                std::vector<uint8_t> stBuf;
+                {
+                    std::lock_guard<std::mutex> stLockGuard(m_zsdbLock);
+                    if(!m_zsdbPtr->Decomp(nKey, &stBuf)){
+                        return {nKey, nullptr, 0, 0};
+                    }
+                }
+                return {nKey, SDLDevice::CreateSurface(stBuf.data(), stBuf.size()), 0, 0};
+            });
+        }
+
+    public:
+        virtual std::tuple<PNGTexEntry, size_t> loadResource(uint32_t nKey)
+        {
+            std::vector<uint8_t> stBuf;
+            {
+                std::lock_guard<std::mutex> stLockGuard(m_zsdbLock);
+                if(!m_zsdbPtr->Decomp(nKey, &stBuf)){
+                    return {PNGTexEntry {nullptr}, 0};
+                }
+            }
+
+            auto pSurface = SDLDevice::CreateSurface(stBuf.data(), stBuf.size());
+            const auto stEntry = createEntry(pSurface);
+
+            if(pSurface){
+                SDL_FreeSurface(pSurface);
+            }
+            return {stEntry, (stEntry.Texture || stEntry.Region.page >= 0) ? 1 : 0};
         }
 
         virtual void freeResource(PNGTexEntry &rstEntry)
@@ -86,5 +236,10 @@ class PNGTexDB: public innDB<uint32_t, PNGTexEntry>
                 SDL_DestroyTexture(rstEntry.Texture);
                 rstEntry.Texture = nullptr;
             }
+
+            if(rstEntry.Region.page >= 0){
+                m_atlas->remove(rstEntry.Region);
+                rstEntry.Region.page = -1;
+            }
         }
 };
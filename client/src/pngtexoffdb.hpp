@@ -17,6 +17,7 @@
  */
 
 #pragma once
+#include <mutex>
 #include <memory>
 #include <vector>
 #include <cstdint>
@@ -28,6 +29,7 @@
 #include "inndb.hpp"
 #include "hexstr.hpp"
 #include "sdldevice.hpp"
+#include "asynctexloader.hpp"
 
 struct PNGTexOffEntry
 {
@@ -39,8 +41,14 @@ struct PNGTexOffEntry
 class PNGTexOffDB: public innDB<uint32_t, PNGTexOffEntry>
 {
     private:
+        // ZSDB has one FILE * and one decompression context
+        // async loading threads share it with the main thread
+        std::mutex m_zsdbLock;
         std::unique_ptr<ZSDB> m_zsdbPtr;
 
+    private:
+        AsyncTexQueue m_asyncQueue;
+
     public:
         PNGTexOffDB(size_t nResMax)
             : innDB<uint32_t, PNGTexOffEntry>(nResMax)
@@ -79,30 +87,97 @@ class PNGTexOffDB: public innDB<uint32_t, PNGTexOffEntry>
         }
 
     public:
-        virtual std::tuple<PNGTexOffEntry, size_t> loadResource(uint32_t nKey)
+        // won't block on decoding
+        // returns nullptr if not ready yet, caller should skip it in current frame
+        SDL_Texture *RetrieveAsync(uint32_t nKey, int *pDX, int *pDY)
         {
-            char szKeyString[16];
-            std::vector<uint8_t> stBuf;
-            PNGTexOffEntry stEntry {nullptr, 0, 0};
+            if(PNGTexOffEntry stEntry {nullptr, 0, 0}; this->PeekResource(nKey, &stEntry)){
+                if(pDX){
+                    *pDX = stEntry.DX;
+                }
+                if(pDY){
+                    *pDY = stEntry.DY;
+                }
+                return stEntry.Texture;
+            }
+
+            if(!scheduleLoad(nKey)){
+                return Retrieve(nKey, pDX, pDY);
+            }
+            return nullptr;
+        }
+
+        void Prefetch(uint32_t nKey)
+        {
+            if(!this->HasResource(nKey)){
+                scheduleLoad(nKey);
+            }
+        }
 
-            if(auto szFileName = m_zsdbPtr->Decomp(hexstr::to_string<uint32_t, 4>(nKey, szKeyString, true), 8, &stBuf); szFileName && (std::strlen(szFileName) >= 18)){
-                //
-                // [0 ~ 7] [8] [9] [10 ~ 13] [14 ~ 17]
-                //  <KEY>  <S> <S>   <+DX>     <+DY>
-                //    4    1/2 1/2     2         2
-                //
-                //   KEY: 3 bytes
-                //   S  : sign of DX, take 1 char, 1/2 byte, + for 1, - for 0
-                //   S  : sign of DY, take 1 char, 1/2 byte
-                //   +DX: abs(DX) take 4 chars, 2 bytes
-                //   +DY: abs(DY) take 4 chars, 2 bytes
+        // create textures for decoded surfaces
+        // main thread only, returns number of textures created
+        size_t Upload(size_t nMaxCount)
+        {
+            return m_asyncQueue.upload(nMaxCount, [this](const AsyncTexResult &rstResult)
+            {
+                extern SDLDevice *g_sdlDevice;
+                PNGTexOffEntry stEntry {g_sdlDevice->CreateTextureFromSurface(rstResult.surface), rstResult.DX, rstResult.DY};
+                this->AddResource(rstResult.key, stEntry, stEntry.Texture ? 1 : 0);
+            });
+        }
+
+    private:
+        // parse the offset encoded in file name
+        //
+        // [0 ~ 7] [8] [9] [10 ~ 13] [14 ~ 17]
+        //  <KEY>  <S> <S>   <+DX>     <+DY>
+        //    4    1/2 1/2     2         2
+        //
+        //   KEY: 3 bytes
+        //   S  : sign of DX, take 1 char, 1/2 byte, + for 1, - for 0
+        //   S  : sign of DY, take 1 char, 1/2 byte
+        //   +DX: abs(DX) take 4 chars, 2 bytes
+        //   +DY: abs(DY) take 4 chars, 2 bytes
+        //
+        // returns false if no such file
+        bool decompOff(uint32_t nKey, std::vector<uint8_t> *pBuf, int *pDX, int *pDY)
+        {
+            std::lock_guard<std::mutex> stLockGuard(m_zsdbLock);
 
-                stEntry.DX = (szFileName[8] != '0') ? 1 : (-1);
-                stEntry.DY = (szFileName[9] != '0') ? 1 : (-1);
+            if(auto szFileName = m_zsdbPtr->Decomp(nKey, pBuf); szFileName && (std::strlen(szFileName) >= 18)){
+                *pDX = ((szFileName[8] != '0') ? 1 : (-1)) * (int)(hexstr::to_hex<uint32_t, 2>(szFileName + 10));
+                *pDY = ((szFileName[9] != '0') ? 1 : (-1)) * (int)(hexstr::to_hex<uint32_t, 2>(szFileName + 14));
+                return true;
+            }
+            return false;
+        }
 
-                stEntry.DX *= (int)(hexstr::to_hex<uint32_t, 2>(szFileName + 10));
-                stEntry.DY *= (int)(hexstr::to_hex<uint32_t, 2>(szFileName + 14));
+        bool scheduleLoad(uint32_t nKey)
+        {
+            if(m_asyncQueue.pending(nKey)){
+                return true;
+            }
+
+            return m_asyncQueue.schedule(nKey, [this, nKey]() -> AsyncTexResult
+            {
+                int nDX = 0;
+                int nDY = 0;
+                std::vector<uint8_t> stBuf;
+
+                if(!decompOff(nKey, &stBuf, &nDX, &nDY)){
+                    return {nKey, nullptr, 0, 0};
+                }
+                return {nKey, SDLDevice::CreateSurface(stBuf.data(), stBuf.size()), nDX, nDY};
+            });
+        }
+
+    public:
+        virtual std::tuple<PNGTexOffEntry, size_t> loadResource(uint32_t nKey)
+        {
+            std::vector<uint8_t> stBuf;
+            PNGTexOffEntry stEntry {nullptr, 0, 0};
 
+            if(decompOff(nKey, &stBuf, &stEntry.DX, &stEntry.DY)){
                 extern SDLDevice *g_sdlDevice;
                 stEntry.Texture = g_sdlDevice->CreateTexture(stBuf.data(), stBuf.size());
             }
@@ -108,6 +108,10 @@ void ProcessRun::scrollMap()
 
 void ProcessRun::update(double fUpdateTime)
 {
+    // textures decoded in background
+    // limit textures created per update, prefetching can finish hundreds of them in a burst
+    g_mapDB->Upload(128);
+
     constexpr uint32_t delayTicks[]
     {
         150, 200, 250, 300, 350, 400, 420, 450,
@@ -130,6 +134,8 @@ void ProcessRun::update(double fUpdateTime)
     m_GUIManager.update(fUpdateTime);
 
     getMyHero()->update(fUpdateTime);
+    updateCreatureIndex(m_myHeroUID);
+
     const int myHeroX = getMyHero()->x();
     const int myHeroY = getMyHero()->y();
 
@@ -146,9 +152,11 @@ void ProcessRun::update(double fUpdateTime)
                 p->second->querySelf();
             }
             p->second->update(fUpdateTime);
+            updateCreatureIndex(p->first);
             ++p;
         }
         else{
+            removeCreatureIndex(p->first);
             p = m_coList.erase(p);
         }
     }
@@ -284,15 +292,28 @@ void ProcessRun::draw()
     const int x1 = fnLimitedRegion(0, m_mir2xMapData.W(), +SYS_OBJMAXW + (m_viewX + 2 * SYS_MAPGRIDXP + g_sdlDevice->getRendererWidth() ) / SYS_MAPGRIDXP);
     const int y1 = fnLimitedRegion(0, m_mir2xMapData.H(), +SYS_OBJMAXH + (m_viewY + 2 * SYS_MAPGRIDYP + g_sdlDevice->getRendererHeight()) / SYS_MAPGRIDYP);
 
-    drawTile(x0, y0, x1, y1);
+    // tile is 2 x 2 grids, no need to expand as objects
+    drawTile(
+            m_viewX / SYS_MAPGRIDXP - 2,
+            m_viewY / SYS_MAPGRIDYP - 2,
+            (m_viewX + g_sdlDevice->getRendererWidth ()) / SYS_MAPGRIDXP + 1,
+            (m_viewY + g_sdlDevice->getRendererHeight()) / SYS_MAPGRIDYP + 1);
 
     // ground objects
-    for(int y = y0; y <= y1; ++y){
-        for(int x = x0; x <= x1; ++x){
-            drawGroundObject(x, y, true);
+    {
+        SDLDevice::TextureBatch batch;
+        for(int y = y0; y <= y1; ++y){
+            m_mapChunkTable.forEachCmd(MapChunkTable::LAYER_GROUND, y, x0, x1, [this, &batch](const MapDrawCmd &cmd)
+            {
+                drawMapObject(cmd, batch);
+            });
         }
     }
 
+    // after tiles and objects in view get scheduled
+    // then they are decoded before grids outside
+    prefetchMap(x0, y0, x1, y1);
+
     if(g_clientArgParser->drawMapGrid){
         const int gridX0 = m_viewX / SYS_MAPGRIDXP;
         const int gridY0 = m_viewY / SYS_MAPGRIDYP;
@@ -318,46 +339,42 @@ void ProcessRun::draw()
 
     drawGroundItem(x0, y0, x1, y1);
 
-    const auto locHashTable = [this]()
-    {
-        LocHashTable<std::vector<ClientCreature *>> table;
-        for(auto &p: m_coList){
-            table[p.second->location()].push_back(p.second.get());
-        }
-        return table;
-    }();
-
     // over ground objects
     for(int y = y0; y <= y1; ++y){
-        for(int x = x0; x <= x1; ++x){
-            drawGroundObject(x, y, false);
+        {
+            // flush before drawing creatures in this row
+            SDLDevice::TextureBatch batch;
+            m_mapChunkTable.forEachCmd(MapChunkTable::LAYER_OVERGROUND, y, x0, x1, [this, &batch](const MapDrawCmd &cmd)
+            {
+                drawMapObject(cmd, batch);
+            });
         }
 
-        for(int x = x0; x <= x1; ++x){
-            if(auto p = locHashTable.find({x, y}); p != locHashTable.end()){
-                for(auto creaturePtr: p->second){
-                    if(!(creaturePtr && creaturePtr->location() == std::make_tuple(x, y))){
-                        throw fflerror("invalid creature location table");
-                    }
+        for(auto p = m_coLocIndex.lower_bound({y, x0}); p != m_coLocIndex.end() && std::get<0>(p->first) == y && std::get<1>(p->first) <= x1; ++p){
+            const auto x = std::get<1>(p->first);
+            for(const auto uid: p->second){
+                auto creaturePtr = findUID(uid, false);
+                if(!(creaturePtr && creaturePtr->location() == std::make_tuple(x, y))){
+                    throw fflerror("invalid creature location index");
+                }
 
-                    if(!creaturePtr->alive()){
-                        continue;
-                    }
+                if(!creaturePtr->alive()){
+                    continue;
+                }
 
-                    int focusMask = 0;
-                    for(auto focusType = 0; focusType < FOCUS_MAX; ++focusType){
-                        if(FocusUID(focusType) == creaturePtr->UID()){
-                            focusMask |= (1 << focusType);
-                        }
+                int focusMask = 0;
+                for(auto focusType = 0; focusType < FOCUS_MAX; ++focusType){
+                    if(FocusUID(focusType) == creaturePtr->UID()){
+                        focusMask |= (1 << focusType);
                     }
-                    creaturePtr->draw(m_viewX, m_viewY, focusMask);
                 }
+                creaturePtr->draw(m_viewX, m_viewY, focusMask);
+            }
 
-                if(g_clientArgParser->drawCreatureCover){
-                    SDLDevice::EnableRenderColor enableColor(colorf::RGBA(0, 0, 255, 128));
-                    SDLDevice::EnableRenderBlendMode enableBlendMode(SDL_BLENDMODE_BLEND);
-                    g_sdlDevice->fillRectangle(x * SYS_MAPGRIDXP - m_viewX, y * SYS_MAPGRIDYP - m_viewY, SYS_MAPGRIDXP, SYS_MAPGRIDYP);
-                }
+            if(g_clientArgParser->drawCreatureCover){
+                SDLDevice::EnableRenderColor enableColor(colorf::RGBA(0, 0, 255, 128));
+                SDLDevice::EnableRenderBlendMode enableBlendMode(SDL_BLENDMODE_BLEND);
+                g_sdlDevice->fillRectangle(x * SYS_MAPGRIDXP - m_viewX, y * SYS_MAPGRIDYP - m_viewY, SYS_MAPGRIDXP, SYS_MAPGRIDYP);
             }
         }
     }
@@ -568,9 +585,23 @@ void ProcessRun::loadMap(uint32_t mapID)
 
     m_mapID = mapID;
     m_mir2xMapData = *mapBinPtr;
+    m_hpaGraph.reset();
+    m_mapChunkTable.reset(&m_mir2xMapData);
+    m_prefetchRegion = {-1, -1, -1, -1};
     m_groundItemList.clear();
 }
 
+PathFind::HPAGraph &ProcessRun::getHPAGraph()
+{
+    if(!m_hpaGraph){
+        m_hpaGraph = std::make_unique<PathFind::HPAGraph>(m_mir2xMapData.W(), m_mir2xMapData.H(), [this](int nX, int nY) -> bool
+        {
+            return m_mir2xMapData.ValidC(nX, nY) && m_mir2xMapData.Cell(nX, nY).CanThrough();
+        });
+    }
+    return *m_hpaGraph;
+}
+
 bool ProcessRun::canMove(bool bCheckGround, int nCheckCreature, int nX, int nY)
 {
     switch(auto nGrid = CheckPathGrid(nX, nY)){
@@ -863,6 +894,7 @@ std::vector<int> ProcessRun::GetPlayerList()
             }
             ++p;
         }else{
+            removeCreatureIndex(p->first);
             p = m_coList.erase(p);
         }
     }
@@ -1402,7 +1434,7 @@ void ProcessRun::onActionSpawn(uint64_t uid, const ActionNode &action)
                         .direction = DIR_DOWNLEFT,
                     };
 
-                    m_coList[uid].reset(new ClientTaoSkeleton(uid, this, stand));
+                    addCreature(std::make_unique<ClientTaoSkeleton>(uid, this, stand));
                     m_actionBlocker.erase(uid);
                     queryCORecord(uid);
                     return true;
@@ -1415,13 +1447,13 @@ void ProcessRun::onActionSpawn(uint64_t uid, const ActionNode &action)
         case DBCOM_MONSTERID(u8"神兽"):
             {
                 addCBLog(CBLOG_SYS, u8"使用魔法: 召唤神兽");
-                m_coList[uid].reset(new ClientTaoDog(uid, this, action));
+                addCreature(std::make_unique<ClientTaoDog>(uid, this, action));
                 queryCORecord(uid);
                 return;
             }
         default:
             {
-                m_coList[uid].reset(new ClientMonster(uid, this, action));
+                addCreature(std::make_unique<ClientMonster>(uid, this, action));
                 queryCORecord(uid);
                 return;
             }
@@ -1517,56 +1549,112 @@ void ProcessRun::drawGroundItem(int x0, int y0, int x1, int y1)
 
 void ProcessRun::drawTile(int x0, int y0, int x1, int y1)
 {
-    for(int y = y0; y < y1; ++y){
-        for(int x = x0; x <= x1; ++x){
-            if(m_mir2xMapData.ValidC(x, y) && !(x % 2) && !(y % 2)){
-                if(const auto &tile = m_mir2xMapData.Tile(x, y); tile.Valid()){
-                    if(auto texPtr = g_mapDB->Retrieve(tile.Image())){
-                        g_sdlDevice->drawTexture(texPtr, x * SYS_MAPGRIDXP - m_viewX, y * SYS_MAPGRIDYP - m_viewY);
-                    }
-                }
+    SDLDevice::TextureBatch batch;
+    for(int y = y0; y <= y1; ++y){
+        m_mapChunkTable.forEachCmd(MapChunkTable::LAYER_TILE, y, x0, x1, [this, &batch](const MapDrawCmd &cmd)
+        {
+            if(const auto texRegion = g_mapDB->RetrieveRegionAsync(cmd.image)){
+                batch.add(texRegion.texture, texRegion.rect, {cmd.x * SYS_MAPGRIDXP - m_viewX, cmd.y * SYS_MAPGRIDYP - m_viewY, texRegion.rect.w, texRegion.rect.h});
             }
+        });
+    }
+}
+
+void ProcessRun::drawMapObject(const MapDrawCmd &cmd, SDLDevice::TextureBatch &batch)
+{
+    uint32_t imageId = cmd.image;
+    if(cmd.aniType >= 0){
+        imageId += m_aniTileFrame[cmd.aniType][cmd.aniFrame];
+    }
+
+    // objects overlap each other
+    // batch keeps the drawing order, it only merges consecutive copies from one atlas page
+    if(const auto texRegion = g_mapDB->RetrieveRegionAsync(imageId)){
+        const int texH = texRegion.rect.h;
+        batch.add(texRegion.texture, texRegion.rect, {cmd.x * SYS_MAPGRIDXP - m_viewX, (cmd.y + 1) * SYS_MAPGRIDYP - m_viewY - texH, texRegion.rect.w, texRegion.rect.h}, cmd.alpha ? 128 : 255);
+    }
+}
+
+void ProcessRun::addCreature(std::unique_ptr<ClientCreature> coPtr)
+{
+    // replaces the creature with same UID
+    // its index entry is moved to the new location if it differs
+    const auto uid = coPtr->UID();
+    m_coList[uid] = std::move(coPtr);
+    updateCreatureIndex(uid);
+}
+
+void ProcessRun::updateCreatureIndex(uint64_t uid)
+{
+    auto coIter = m_coList.find(uid);
+    if(coIter == m_coList.end()){
+        throw fflerror("creature not in list: %s", uidf::getUIDString(uid).c_str());
+    }
+
+    const auto [x, y] = coIter->second->location();
+    const auto key = std::make_tuple(y, x);
+
+    if(auto p = m_coLocCache.find(uid); p == m_coLocCache.end()){
+        m_coLocCache.emplace(uid, key);
+        m_coLocIndex[key].push_back(uid);
+    }
+    else if(p->second != key){
+        removeCreatureIndex(uid, p->second);
+        p->second = key;
+        m_coLocIndex[key].push_back(uid);
+    }
+}
+
+void ProcessRun::removeCreatureIndex(uint64_t uid)
+{
+    if(auto p = m_coLocCache.find(uid); p != m_coLocCache.end()){
+        removeCreatureIndex(uid, p->second);
+        m_coLocCache.erase(p);
+    }
+}
+
+void ProcessRun::removeCreatureIndex(uint64_t uid, const std::tuple<int, int> &key)
+{
+    if(auto p = m_coLocIndex.find(key); p != m_coLocIndex.end()){
+        std::erase(p->second, uid);
+        if(p->second.empty()){
+            m_coLocIndex.erase(p);
         }
     }
 }
 
-void ProcessRun::drawGroundObject(int x, int y, bool ground)
+void ProcessRun::prefetchMap(int x0, int y0, int x1, int y1)
 {
-    if(!m_mir2xMapData.ValidC(x, y)){
+    if(std::make_tuple(x0, y0, x1, y1) == m_prefetchRegion){
         return;
     }
 
-    for(const int i: {0, 1}){
-        const auto objArr = m_mir2xMapData.Cell(x, y).ObjectArray(i);
-        if(true
-                && ((bool)(objArr[4] & 0X80))
-                && ((bool)(objArr[4] & 0X01) == ground)){
-            uint32_t imageId = 0
-                | (((uint32_t)(objArr[2])) << 16)
-                | (((uint32_t)(objArr[1])) <<  8)
-                | (((uint32_t)(objArr[0])) <<  0);
-
-            if(objArr[3] & 0X80){
-                if(false
-                        || objArr[2] == 11
-                        || objArr[2] == 26
-                        || objArr[2] == 41
-                        || objArr[2] == 56
-                        || objArr[2] == 71){
-                    const int aniType = (objArr[3] & 0B01110000) >> 4;
-                    const int aniFrameType = (objArr[3] & 0B00001111);
-                    imageId += m_aniTileFrame[aniType][aniFrameType];
+    m_prefetchRegion = {x0, y0, x1, y1};
+    if(g_clientArgParser->prefetchRadius <= 0){
+        return;
+    }
+
+    const int r = g_clientArgParser->prefetchRadius;
+    for(int y = std::max<int>(0, y0 - r); y <= std::min<int>(m_mir2xMapData.H() - 1, y1 + r); ++y){
+        for(int x = std::max<int>(0, x0 - r); x <= std::min<int>(m_mir2xMapData.W() - 1, x1 + r); ++x){
+            if(!m_mir2xMapData.ValidC(x, y)){
+                continue;
+            }
+
+            if(!(x % 2) && !(y % 2)){
+                if(const auto &tile = m_mir2xMapData.Tile(x, y); tile.Valid()){
+                    g_mapDB->Prefetch(tile.Image());
                 }
             }
 
-            const bool alphaRender = (objArr[4] & 0B00000010);
-            if(auto texPtr = g_mapDB->Retrieve(imageId)){
-                const int texH = SDLDevice::getTextureHeight(texPtr);
-                if(alphaRender){
-                    SDL_SetTextureBlendMode(texPtr, SDL_BLENDMODE_BLEND);
-                    SDL_SetTextureAlphaMod(texPtr, 128);
+            // animated objects only get their first frame prefetched
+            for(const int i: {0, 1}){
+                if(const auto objArr = m_mir2xMapData.Cell(x, y).ObjectArray(i); objArr[4] & 0X80){
+                    g_mapDB->Prefetch(0
+                            | (((uint32_t)(objArr[2])) << 16)
+                            | (((uint32_t)(objArr[1])) <<  8)
+                            | (((uint32_t)(objArr[0])) <<  0));
                 }
-                g_sdlDevice->drawTexture(texPtr, x * SYS_MAPGRIDXP - m_viewX, (y + 1) * SYS_MAPGRIDYP - m_viewY - texH);
             }
         }
     }
@@ -31,8 +31,10 @@
 #include "focustype.hpp"
 #include "ascendstr.hpp"
 #include "commonitem.hpp"
+#include "jpsfinder.hpp"
 #include "guimanager.hpp"
 #include "lochashtable.hpp"
+#include "mapchunktable.hpp"
 #include "mir2xmapdata.hpp"
 #include "fixedlocmagic.hpp"
 #include "followuidmagic.hpp"
@@ -69,6 +71,15 @@ class ProcessRun: public Process
         uint32_t     m_mapID;
         Mir2xMapData m_mir2xMapData;
 
+    private:
+        // built at first use after loadMap()
+        std::unique_ptr<PathFind::HPAGraph> m_hpaGraph;
+
+    private:
+        // static tiles and objects as draw commands
+        // chunks are built at first draw after loadMap()
+        MapChunkTable m_mapChunkTable;
+
     private:
         LocHashTable<std::vector<CommonItem>> m_groundItemList;
 
@@ -101,6 +112,11 @@ class ProcessRun: public Process
         uint32_t m_aniSaveTick[8];
         uint8_t  m_aniTileFrame[8][16];
 
+    private:
+        // last region sent to prefetchMap()
+        // prefetch only when the drawing region changes
+        std::tuple<int, int, int, int> m_prefetchRegion {-1, -1, -1, -1};
+
     private:
         ClientLuaModule m_luaModule;
 
@@ -114,6 +130,13 @@ class ProcessRun: public Process
     private:
         std::unordered_map<uint64_t, std::unique_ptr<ClientCreature>> m_coList;
 
+    private:
+        // creature location index, key is (y, x) so one row is a continuous range
+        // creatures only move in update() and parseAction(), both are called by ProcessRun
+        // every call site and every add/erase of m_coList updates the index, no per-frame scan
+        std::map<std::tuple<int, int>, std::vector<uint64_t>> m_coLocIndex;
+        std::unordered_map<uint64_t, std::tuple<int, int>> m_coLocCache;
+
     private:
         std::set<uint64_t> m_actionBlocker;
 
@@ -208,6 +231,9 @@ class ProcessRun: public Process
         bool canMove(bool, int, int, int);
         bool canMove(bool, int, int, int, int, int);
 
+    public:
+        PathFind::HPAGraph &getHPAGraph();
+
     public:
         double MoveCost(bool, int, int, int, int);
 
@@ -350,7 +376,18 @@ class ProcessRun: public Process
         void drawRotateStar(int, int, int, int);
 
     private:
-        void drawGroundObject(int, int, bool);
+        void drawMapObject(const MapDrawCmd &, SDLDevice::TextureBatch &);
+
+    private:
+        void addCreature(std::unique_ptr<ClientCreature>);
+
+    private:
+        void updateCreatureIndex(uint64_t);
+        void removeCreatureIndex(uint64_t);
+        void removeCreatureIndex(uint64_t, const std::tuple<int, int> &);
+
+    private:
+        void prefetchMap(int, int, int, int);
 
     private:
         void checkMagicSpell(const SDL_Event &);
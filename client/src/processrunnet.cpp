@@ -56,12 +56,12 @@ void ProcessRun::net_LOGINOK(const uint8_t *bufPtr, size_t nLen)
         loadMap(nMapID);
 
         m_myHeroUID = nUID;
-        m_coList[nUID] = std::make_unique<MyHero>(nUID, nDBID, bGender, nDressID, this, ActionStand
+        addCreature(std::make_unique<MyHero>(nUID, nDBID, bGender, nDressID, this, ActionStand
         {
             .x = nX,
             .y = nY,
             .direction = nDirection,
-        });
+        }));
 
         centerMyHero();
         getMyHero()->pullGold();
@@ -104,15 +104,19 @@ void ProcessRun::net_ACTION(const uint8_t *bufPtr, size_t)
         loadMap(smA.MapID);
 
         m_coList.clear();
-        m_coList[m_myHeroUID] = std::make_unique<MyHero>(nUID, nDBID, bGender, nDress, this, ActionStand
+        m_coLocIndex.clear();
+        m_coLocCache.clear();
+
+        addCreature(std::make_unique<MyHero>(nUID, nDBID, bGender, nDress, this, ActionStand
         {
             .x = nX,
             .y = nY,
             .direction = nDirection,
-        });
+        }));
 
         centerMyHero();
         getMyHero()->parseAction(smA.action);
+        updateCreatureIndex(m_myHeroUID);
         return;
     }
 
@@ -127,6 +131,8 @@ void ProcessRun::net_ACTION(const uint8_t *bufPtr, size_t)
         }
 
         coPtr->parseAction(smA.action);
+        updateCreatureIndex(smA.UID);
+
         switch(smA.action.type){
             case ACTION_SPACEMOVE2:
                 {
@@ -168,20 +174,20 @@ void ProcessRun::net_ACTION(const uint8_t *bufPtr, size_t)
                                 case DBCOM_MONSTERID(u8"变异骷髅"):
                                     {
                                         if(!m_actionBlocker.contains(smA.UID)){
-                                            m_coList[smA.UID] = std::make_unique<ClientTaoSkeleton>(smA.UID, this, smA.action);
+                                            addCreature(std::make_unique<ClientTaoSkeleton>(smA.UID, this, smA.action));
                                         }
                                         return;
                                     }
                                 case DBCOM_MONSTERID(u8"神兽"):
                                     {
                                         if(!m_actionBlocker.contains(smA.UID)){
-                                            m_coList[smA.UID] = std::make_unique<ClientTaoDog>(smA.UID, this, smA.action);
+                                            addCreature(std::make_unique<ClientTaoDog>(smA.UID, this, smA.action));
                                         }
                                         return;
                                     }
                                 default:
                                     {
-                                        m_coList[smA.UID] = std::make_unique<ClientMonster>(smA.UID, this, smA.action);
+                                        addCreature(std::make_unique<ClientMonster>(smA.UID, this, smA.action));
                                         return;
                                     }
                             }
@@ -192,7 +198,7 @@ void ProcessRun::net_ACTION(const uint8_t *bufPtr, size_t)
             }
         case UID_NPC:
             {
-                m_coList[smA.UID] = std::make_unique<ClientNPC>(smA.UID, this, smA.action);
+                addCreature(std::make_unique<ClientNPC>(smA.UID, this, smA.action));
                 return;
             }
         default:
@@ -211,6 +217,7 @@ void ProcessRun::net_CORECORD(const uint8_t *bufPtr, size_t)
 
     if(auto p = m_coList.find(smCOR.UID); p != m_coList.end()){
         p->second->parseAction(smCOR.action);
+        updateCreatureIndex(smCOR.UID);
         return;
     }
 
@@ -220,17 +227,17 @@ void ProcessRun::net_CORECORD(const uint8_t *bufPtr, size_t)
                 switch(uidf::getMonsterID(smCOR.UID)){
                     case DBCOM_MONSTERID(u8"变异骷髅"):
                         {
-                            m_coList[smCOR.UID].reset(new ClientTaoSkeleton(smCOR.UID, this, smCOR.action));
+                            addCreature(std::make_unique<ClientTaoSkeleton>(smCOR.UID, this, smCOR.action));
                             break;
                         }
                     case DBCOM_MONSTERID(u8"神兽"):
                         {
-                            m_coList[smCOR.UID].reset(new ClientTaoDog(smCOR.UID, this, smCOR.action));
+                            addCreature(std::make_unique<ClientTaoDog>(smCOR.UID, this, smCOR.action));
                             break;
                         }
                     default:
                         {
-                            m_coList[smCOR.UID] = std::make_unique<ClientMonster>(smCOR.UID, this, smCOR.action);
+                            addCreature(std::make_unique<ClientMonster>(smCOR.UID, this, smCOR.action));
                             break;
                         }
                 }
@@ -238,7 +245,7 @@ void ProcessRun::net_CORECORD(const uint8_t *bufPtr, size_t)
             }
         case UID_PLY:
             {
-                m_coList[smCOR.UID] = std::make_unique<Hero>(smCOR.UID, smCOR.Player.DBID, true, 0, this, smCOR.action);
+                addCreature(std::make_unique<Hero>(smCOR.UID, smCOR.Player.DBID, true, 0, this, smCOR.action));
                 break;
             }
         default:
@@ -272,6 +279,7 @@ void ProcessRun::net_NOTIFYDEAD(const uint8_t *bufPtr, size_t)
             .y = p->y(),
             .fadeOut = true,
         });
+        updateCreatureIndex(stSMND.UID);
     }
 }
 
@@ -240,19 +240,25 @@ SDL_Texture *SDLDevice::CreateTexture(const uint8_t *pMem, size_t nSize)
     // currently it doesn't support dynamic set of context
     // because all textures are based on current m_renderer
 
+    SDL_Texture *pstTexture = nullptr;
+    if(auto pstSurface = CreateSurface(pMem, nSize)){
+        if(m_renderer){
+            pstTexture = SDL_CreateTextureFromSurface(m_renderer, pstSurface);
+        }
+        SDL_FreeSurface(pstSurface);
+    }
+    return pstTexture;
+}
+
+SDL_Surface *SDLDevice::CreateSurface(const uint8_t *pMem, size_t nSize)
+{
     SDL_RWops   *pstRWops   = nullptr;
     SDL_Surface *pstSurface = nullptr;
-    SDL_Texture *pstTexture = nullptr;
 
     if(pMem && nSize){
         pstRWops = SDL_RWFromConstMem((const void *)(pMem), nSize);
         if(pstRWops){
             pstSurface = IMG_LoadPNG_RW(pstRWops);
-            if(pstSurface){
-                if(m_renderer){
-                    pstTexture = SDL_CreateTextureFromSurface(m_renderer, pstSurface);
-                }
-            }
         }
     }
 
@@ -262,11 +268,121 @@ SDL_Texture *SDLDevice::CreateTexture(const uint8_t *pMem, size_t nSize)
     if(pstRWops){
         SDL_FreeRW(pstRWops);
     }
+    return pstSurface;
+}
 
-    if(pstSurface){
-        SDL_FreeSurface(pstSurface);
+void SDLDevice::TextureBatch::add(SDL_Texture *texPtr, const SDL_Rect &src, const SDL_Rect &dst, Uint8 alpha)
+{
+    if(!texPtr){
+        return;
+    }
+
+    if(texPtr != m_texPtr){
+        flush();
+        m_texPtr = texPtr;
+    }
+    m_copyList.push_back({src, dst, alpha});
+}
+
+void SDLDevice::TextureBatch::addModColor(SDL_Texture *texPtr, const SDL_Rect &src, const SDL_Rect &dst, uint32_t color)
+{
+    if(!texPtr){
+        return;
+    }
+
+    if(texPtr != m_texPtr){
+        flush();
+        m_texPtr = texPtr;
+    }
+    m_copyList.push_back({src, dst, colorf::A(color), colorf::R(color), colorf::G(color), colorf::B(color)});
+}
+
+void SDLDevice::TextureBatch::flush()
+{
+    if(m_texPtr && !m_copyList.empty()){
+        g_sdlDevice->drawTextureList(m_texPtr, m_copyList.data(), m_copyList.size());
+    }
+
+    m_texPtr = nullptr;
+    m_copyList.clear();
+}
+
+void SDLDevice::drawTextureList(SDL_Texture *texPtr, const TextureCopy *copyList, size_t copyCount)
+{
+    if(!(texPtr && copyList && copyCount)){
+        return;
+    }
+
+    // alpha only works with blending
+    // atlas pages are created with blending, standalone texture gets its own mode back after the batch
+    const bool needBlend = std::any_of(copyList, copyList + copyCount, [](const auto &copy){ return copy.alpha != 255; });
+    const EnableTextureBlendMode enableBlendMode(needBlend ? texPtr : nullptr, SDL_BLENDMODE_BLEND);
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    const auto [texW, texH] = getTextureSize(texPtr);
+
+    m_indexList.clear();
+    m_vertexList.clear();
+
+    for(size_t i = 0; i < copyCount; ++i){
+        const auto &src = copyList[i].src;
+        const auto &dst = copyList[i].dst;
+
+        const float u0 = 1.0f * (src.x        ) / texW;
+        const float v0 = 1.0f * (src.y        ) / texH;
+        const float u1 = 1.0f * (src.x + src.w) / texW;
+        const float v1 = 1.0f * (src.y + src.h) / texH;
+
+        const float x0 = 1.0f * (dst.x        );
+        const float y0 = 1.0f * (dst.y        );
+        const float x1 = 1.0f * (dst.x + dst.w);
+        const float y1 = 1.0f * (dst.y + dst.h);
+
+        // color and alpha are applied as vertex color
+        // same as SDL_SetTextureColorMod() and SDL_SetTextureAlphaMod() with blend mode
+        const SDL_Color color {copyList[i].r, copyList[i].g, copyList[i].b, copyList[i].alpha};
+        const int base = (int)(m_vertexList.size());
+
+        m_vertexList.push_back({{x0, y0}, color, {u0, v0}});
+        m_vertexList.push_back({{x1, y0}, color, {u1, v0}});
+        m_vertexList.push_back({{x1, y1}, color, {u1, v1}});
+        m_vertexList.push_back({{x0, y1}, color, {u0, v1}});
+
+        for(const int index: {0, 1, 2, 2, 3, 0}){
+            m_indexList.push_back(base + index);
+        }
+    }
+    SDL_RenderGeometry(m_renderer, texPtr, m_vertexList.data(), (int)(m_vertexList.size()), m_indexList.data(), (int)(m_indexList.size()));
+#else
+    for(size_t i = 0; i < copyCount; ++i){
+        const auto &copy = copyList[i];
+        if(copy.alpha == 255 && copy.r == 255 && copy.g == 255 && copy.b == 255){
+            SDL_RenderCopy(m_renderer, texPtr, &copy.src, &copy.dst);
+        }
+        else{
+            Uint8 savedR = 255;
+            Uint8 savedG = 255;
+            Uint8 savedB = 255;
+            Uint8 savedAlpha = 255;
+
+            SDL_GetTextureColorMod(texPtr, &savedR, &savedG, &savedB);
+            SDL_GetTextureAlphaMod(texPtr, &savedAlpha);
+
+            SDL_SetTextureColorMod(texPtr, copy.r, copy.g, copy.b);
+            SDL_SetTextureAlphaMod(texPtr, copy.alpha);
+            SDL_RenderCopy(m_renderer, texPtr, &copy.src, &copy.dst);
+
+            SDL_SetTextureColorMod(texPtr, savedR, savedG, savedB);
+            SDL_SetTextureAlphaMod(texPtr, savedAlpha);
+        }
+    }
+#endif
+
+    if(g_clientArgParser->debugdrawTexture){
+        for(size_t i = 0; i < copyCount; ++i){
+            drawRectangle(colorf::BLUE + 128, copyList[i].dst.x, copyList[i].dst.y, copyList[i].dst.w, copyList[i].dst.h);
+        }
     }
-    return pstTexture;
 }
 
 void SDLDevice::drawTexture(SDL_Texture *pstTexture,
@@ -104,6 +104,42 @@ class SDLDevice final
                ~EnableTextureModColor();
         };
 
+    public:
+        struct TextureCopy
+        {
+            SDL_Rect src;
+            SDL_Rect dst;
+            Uint8 alpha;
+
+            // color mod, glyphs in one atlas page can have different colors
+            Uint8 r = 255;
+            Uint8 g = 255;
+            Uint8 b = 255;
+        };
+
+        // collect consecutive copies from the same texture, flush when texture changes
+        // copies from one atlas page then go to the renderer in one call
+        class TextureBatch
+        {
+            private:
+                SDL_Texture *m_texPtr = nullptr;
+                std::vector<TextureCopy> m_copyList;
+
+            public:
+                TextureBatch() = default;
+
+            public:
+               ~TextureBatch()
+               {
+                   flush();
+               }
+
+            public:
+                void add(SDL_Texture *, const SDL_Rect &, const SDL_Rect &, Uint8 = 255);
+                void addModColor(SDL_Texture *, const SDL_Rect &, const SDL_Rect &, uint32_t);
+                void flush();
+        };
+
     private:
        SDL_Window   *m_window   = nullptr;
        SDL_Renderer *m_renderer = nullptr;
@@ -114,6 +150,12 @@ class SDLDevice final
     private:
        std::unordered_map<int, SDL_Texture *> m_cover;
 
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    private:
+       std::vector<int> m_indexList;
+       std::vector<SDL_Vertex> m_vertexList;
+#endif
+
     private:
        std::unordered_map<uint8_t, TTF_Font *> m_fontList;
 
@@ -127,12 +169,19 @@ class SDLDevice final
     public:
        SDL_Texture *CreateTexture(const uint8_t *, size_t);
 
+    public:
+       // decode PNG only, no renderer involved
+       // safe to call in threads other than the main thread
+       static SDL_Surface *CreateSurface(const uint8_t *, size_t);
+
     public:
        void SetWindowIcon();
        void drawTexture(SDL_Texture *, int, int);
        void drawTexture(SDL_Texture *, int, int, int, int, int, int);
        void drawTexture(SDL_Texture *, int, int, int, int, int, int, int, int);
 
+       void drawTextureList(SDL_Texture *, const TextureCopy *, size_t);
+
     public:
        void drawTextureEx(SDL_Texture *,
                int,     // x on src
@@ -0,0 +1,163 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: texatlas.cpp
+ *        Created: 10/17/2026 00:42:18
+ *    Description:
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#include <algorithm>
+#include "log.hpp"
+#include "totype.hpp"
+#include "texatlas.hpp"
+#include "fflerror.hpp"
+#include "sdldevice.hpp"
+
+extern Log *g_log;
+extern SDLDevice *g_sdlDevice;
+
+TexAtlas::TexAtlas(int maxPageCount, int maxRegionSize, int unitSize, int pageUnit)
+    : m_unitSize(unitSize)
+    , m_pageUnit(pageUnit)
+    , m_pageSize(unitSize * pageUnit)
+    , m_maxPageCount(maxPageCount)
+    , m_maxRegionSize(std::min<int>(maxRegionSize, unitSize * pageUnit))
+{
+    if(maxPageCount < 0 || maxRegionSize < 0){
+        throw fflerror("invalid atlas argument: maxPageCount = %d, maxRegionSize = %d", maxPageCount, maxRegionSize);
+    }
+
+    if(unitSize <= 0 || pageUnit <= 0 || pageUnit > 64){
+        throw fflerror("invalid atlas argument: unitSize = %d, pageUnit = %d", unitSize, pageUnit);
+    }
+}
+
+TexAtlas::~TexAtlas()
+{
+    for(auto &page: m_pageList){
+        SDL_DestroyTexture(page.texture);
+    }
+}
+
+bool TexAtlas::addPage()
+{
+    if((int)(m_pageList.size()) >= m_maxPageCount){
+        return false;
+    }
+
+    SDL_RendererInfo info;
+    if(SDL_GetRendererInfo(g_sdlDevice->getRenderer(), &info)){
+        return false;
+    }
+
+    // zero means no limit
+    if((info.max_texture_width && info.max_texture_width < m_pageSize) || (info.max_texture_height && info.max_texture_height < m_pageSize)){
+        return false;
+    }
+
+    auto texPtr = SDL_CreateTexture(g_sdlDevice->getRenderer(), SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, m_pageSize, m_pageSize);
+    if(!texPtr){
+        g_log->addLog(LOGTYPE_WARNING, "Failed to create atlas page: %s", SDL_GetError());
+        return false;
+    }
+
+    SDL_SetTextureBlendMode(texPtr, SDL_BLENDMODE_BLEND);
+    m_pageList.push_back({texPtr, Pack2D(m_pageUnit)});
+    return true;
+}
+
+bool TexAtlas::add(SDL_Surface *surfPtr, TexAtlasRegion *regionPtr)
+{
+    if(!(surfPtr && regionPtr)){
+        throw fflerror("invalid argument: surfPtr = %p, regionPtr = %p", to_cvptr(surfPtr), to_cvptr(regionPtr));
+    }
+
+    if(surfPtr->w <= 0 || surfPtr->h <= 0 || surfPtr->w > m_maxRegionSize || surfPtr->h > m_maxRegionSize){
+        return false;
+    }
+
+    PackBin bin;
+    bin.id = 1;
+    bin.w  = (surfPtr->w + m_unitSize - 1) / m_unitSize;
+    bin.h  = (surfPtr->h + m_unitSize - 1) / m_unitSize;
+
+    int page = 0;
+    for(;; ++page){
+        if(page >= (int)(m_pageList.size()) && !addPage()){
+            return false;
+        }
+
+        // Pack2D grows downward without limit
+        // take it back if it goes beyond the page
+        auto &pack = m_pageList[page].pack;
+        pack.add(&bin);
+
+        if(bin.y + bin.h <= m_pageUnit){
+            break;
+        }
+        pack.remove(bin);
+    }
+
+    const SDL_Rect rect {bin.x * m_unitSize, bin.y * m_unitSize, surfPtr->w, surfPtr->h};
+    const auto fnUpdate = [this, page, &rect](SDL_Surface *argSurfPtr) -> bool
+    {
+        if(SDL_MUSTLOCK(argSurfPtr) && SDL_LockSurface(argSurfPtr)){
+            return false;
+        }
+
+        const bool updated = !SDL_UpdateTexture(m_pageList[page].texture, &rect, argSurfPtr->pixels, argSurfPtr->pitch);
+        if(SDL_MUSTLOCK(argSurfPtr)){
+            SDL_UnlockSurface(argSurfPtr);
+        }
+        return updated;
+    };
+
+    bool updated = false;
+    if(surfPtr->format->format == SDL_PIXELFORMAT_ARGB8888){
+        updated = fnUpdate(surfPtr);
+    }
+    else if(auto convSurfPtr = SDL_ConvertSurfaceFormat(surfPtr, SDL_PIXELFORMAT_ARGB8888, 0)){
+        updated = fnUpdate(convSurfPtr);
+        SDL_FreeSurface(convSurfPtr);
+    }
+
+    if(!updated){
+        m_pageList[page].pack.remove(bin);
+        return false;
+    }
+
+    regionPtr->page = page;
+    regionPtr->x    = rect.x;
+    regionPtr->y    = rect.y;
+    regionPtr->w    = rect.w;
+    regionPtr->h    = rect.h;
+    return true;
+}
+
+void TexAtlas::remove(const TexAtlasRegion &region)
+{
+    if(region.page < 0 || region.page >= (int)(m_pageList.size())){
+        throw fflerror("invalid atlas page: %d", region.page);
+    }
+
+    PackBin bin;
+    bin.id = 1;
+    bin.x  = region.x / m_unitSize;
+    bin.y  = region.y / m_unitSize;
+    bin.w  = (region.w + m_unitSize - 1) / m_unitSize;
+    bin.h  = (region.h + m_unitSize - 1) / m_unitSize;
+
+    // stale pixels are left in the page
+    // they get overwritten by the next surface taking this room
+    m_pageList[region.page].pack.remove(bin);
+}
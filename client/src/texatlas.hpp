@@ -0,0 +1,86 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: texatlas.hpp
+ *        Created: 10/17/2026 00:42:18
+ *    Description: pack small textures into large pages
+ *                 then consecutive draws from the same page can be batched into one call
+ *
+ *                 page is split into 64 x 64 units and packed by Pack2D
+ *                 one unit is 32 pixels, exactly 3 x 2 units for one map tile
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#pragma once
+#include <vector>
+#include <SDL2/SDL.h>
+#include "pack2d.hpp"
+
+struct TexAtlasRegion
+{
+    int page = -1;
+
+    int x = 0;
+    int y = 0;
+    int w = 0;
+    int h = 0;
+};
+
+class TexAtlas final
+{
+    private:
+        struct AtlasPage
+        {
+            SDL_Texture *texture;
+            Pack2D pack;
+        };
+
+    private:
+        const int m_unitSize;
+        const int m_pageUnit;
+        const int m_pageSize;
+
+    private:
+        const int m_maxPageCount;
+        const int m_maxRegionSize;
+
+    private:
+        std::vector<AtlasPage> m_pageList;
+
+    public:
+        // surface larger than maxRegionSize in either dimension won't go to atlas
+        // page has pageUnit x pageUnit units, pageUnit can't exceed 64 since Pack2D uses one uint64_t per row
+        TexAtlas(int, int, int = 32, int = 64);
+
+    public:
+       ~TexAtlas();
+
+    public:
+        // returns false if surface can't be packed
+        // then caller should create a standalone texture for it
+        bool add(SDL_Surface *, TexAtlasRegion *);
+        void remove(const TexAtlasRegion &);
+
+    public:
+        SDL_Texture *pageTexture(int page) const
+        {
+            return m_pageList.at(page).texture;
+        }
+
+        size_t pageCount() const
+        {
+            return m_pageList.size();
+        }
+
+    private:
+        bool addPage();
+};
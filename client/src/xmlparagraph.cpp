@@ -193,10 +193,15 @@ void XMLParagraph::deleteToken(int leaf, int leafOff, int tokenCount)
     int deletedToken = 0;
 
     while(deletedToken < tokenCount){
+        // if current leaf gets removed, next leaf takes its index
+        // don't advance, otherwise the deleted tokens are not consecutive
+        bool leafDeleted = false;
         switch(leafRef(currLeaf).Type()){
             case LEAF_UTF8GROUP:
                 {
                     const int needDelete = std::min<int>(leafRef(currLeaf).length() - currLeafOff, tokenCount - deletedToken);
+                    leafDeleted = (needDelete == leafRef(currLeaf).length());
+
                     deleteUTF8Char(currLeaf, currLeafOff, needDelete);
                     deletedToken += needDelete;
                     break;
@@ -206,6 +211,7 @@ void XMLParagraph::deleteToken(int leaf, int leafOff, int tokenCount)
                 {
                     deleteLeaf(currLeaf);
                     deletedToken += 1;
+                    leafDeleted = true;
                     break;
                 }
             default:
@@ -214,7 +220,9 @@ void XMLParagraph::deleteToken(int leaf, int leafOff, int tokenCount)
                 }
         }
 
-        currLeaf++;
+        if(!leafDeleted){
+            currLeaf++;
+        }
         currLeafOff = 0;
     }
 }
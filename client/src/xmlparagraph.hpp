@@ -54,6 +54,15 @@ class XMLParagraph
             return (int)(m_leafList.size());
         }
 
+        int tokenCount() const
+        {
+            int count = 0;
+            for(const auto &leaf: m_leafList){
+                count += leaf.length();
+            }
+            return count;
+        }
+
     public:
         bool leafValid(int leaf) const
         {
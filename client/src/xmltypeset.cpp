@@ -16,7 +16,10 @@
  * =====================================================================================
  */
 
+#include <list>
 #include <cinttypes>
+#include <string_view>
+#include <unordered_map>
 #include "log.hpp"
 #include "lalign.hpp"
 #include "totype.hpp"
@@ -35,6 +38,128 @@ extern SDLDevice *g_sdlDevice;
 extern emoticonDB *g_emoticonDB;
 extern ClientArgParser *g_clientArgParser;
 
+class XMLTypeset::TypesetRunCache
+{
+    private:
+        constexpr static size_t MAX_RUN_COUNT = 256;
+
+        // don't keep huge paragraphs
+        // they are rarely reloaded and copying them costs as much as typesetting
+        constexpr static size_t MAX_KEY_LENGTH = 16 * 1024;
+
+    private:
+        // front is the most recently used
+        // keys in m_runMap refer to strings in m_runList
+        std::list<std::pair<std::string, TypesetRun>> m_runList;
+        std::unordered_map<std::string_view, decltype(m_runList)::iterator> m_runMap;
+
+    public:
+        const TypesetRun *find(const std::string &key)
+        {
+            const auto p = m_runMap.find(key);
+            if(p == m_runMap.end()){
+                return nullptr;
+            }
+
+            m_runList.splice(m_runList.begin(), m_runList, p->second);
+            return &(p->second->second);
+        }
+
+        void add(const std::string &key, TypesetRun run)
+        {
+            if(key.size() > MAX_KEY_LENGTH){
+                return;
+            }
+
+            if(const auto p = m_runMap.find(key); p != m_runMap.end()){
+                const auto runIter = p->second;
+                m_runMap.erase(p);
+                m_runList.erase(runIter);
+            }
+
+            m_runList.emplace_front(key, std::move(run));
+            m_runMap.emplace(m_runList.front().first, m_runList.begin());
+
+            while(m_runList.size() > MAX_RUN_COUNT){
+                m_runMap.erase(m_runList.back().first);
+                m_runList.pop_back();
+            }
+        }
+};
+
+XMLTypeset::TypesetRunCache &XMLTypeset::getRunCache()
+{
+    static TypesetRunCache s_runCache;
+    return s_runCache;
+}
+
+void XMLTypeset::loadXML(const char *szXMLString)
+{
+    clear();
+    m_paragraph.loadXML(szXMLString);
+    loadTypeset(typesetRunKey(szXMLString));
+}
+
+void XMLTypeset::loadXMLNode(const tinyxml2::XMLNode *node)
+{
+    if(!node){
+        throw fflerror("null xml node");
+    }
+
+    clear();
+    m_paragraph.loadXMLNode(node);
+
+    tinyxml2::XMLPrinter printer(nullptr, true);
+    node->Accept(&printer);
+    loadTypeset(typesetRunKey(printer.CStr()));
+}
+
+void XMLTypeset::loadTypeset(const std::string &key)
+{
+    if(m_paragraph.leafCount() <= 0){
+        m_ph = getDefaultFontHeight();
+        return;
+    }
+
+    if(const auto runPtr = getRunCache().find(key)){
+        m_lineList      = runPtr->lineList;
+        m_leaf2TokenLoc = runPtr->leaf2TokenLoc;
+
+        m_px = runPtr->px;
+        m_py = runPtr->py;
+        m_pw = runPtr->pw;
+        m_ph = runPtr->ph;
+        return;
+    }
+
+    buildTypeset(0, 0);
+    getRunCache().add(key, TypesetRun
+    {
+        .lineList      = m_lineList,
+        .leaf2TokenLoc = m_leaf2TokenLoc,
+
+        .px = m_px,
+        .py = m_py,
+        .pw = m_pw,
+        .ph = m_ph,
+    });
+}
+
+std::string XMLTypeset::typesetRunKey(const char *xmlString) const
+{
+    // everything affects layout except the XML itself
+    // colors are applied when drawing
+    return str_printf("%d:%d:%d:%d:%d:%d:%d:%d:",
+            m_lineWidth,
+            m_LAlign,
+            (int)(m_canThrough),
+            m_wordSpace,
+            m_lineSpace,
+            (int)(m_font),
+            (int)(m_fontSize),
+            (int)(m_fontStyle)) + (xmlString ? xmlString : "");
+}
+
 void XMLTypeset::SetTokenBoxWordSpace(int nLine)
 {
     if(!lineValid(nLine)){
@@ -544,7 +669,7 @@ void XMLTypeset::SetLineTokenStartY(int nLine)
 void XMLTypeset::checkDefaultFontEx() const
 {
     const uint64_t u64key = utf8f::buildU64Key(m_font, m_fontSize, 0, utf8f::peekUTF8Code("0"));
-    if(!g_fontexDB->Retrieve(u64key)){
+    if(!g_fontexDB->RetrieveRegion(u64key)){
         throw fflerror("invalid default font: font = %d, fontsize = %d", (int)(m_font), (int)(m_fontSize));
     }
 }
@@ -555,28 +680,30 @@ TOKEN XMLTypeset::buildUTF8Token(int leaf, uint8_t nFont, uint8_t nFontSize, uin
     std::memset(&(stToken), 0, sizeof(stToken));
     auto nU64Key = utf8f::buildU64Key(nFont, nFontSize, nFontStyle, nUTF8Code);
 
+    // glyph size comes with the atlas region
+    // no texture query needed
+    const auto fnSetGlyph = [&stToken](uint64_t nGlyphKey, const FontexRegion &rstRegion)
+    {
+        stToken.Box.Info.W      = rstRegion.rect.w;
+        stToken.Box.Info.H      = rstRegion.rect.h;
+        stToken.Box.State.H1    = stToken.Box.Info.H;
+        stToken.Box.State.H2    = 0;
+        stToken.UTF8Char.U64Key = nGlyphKey;
+    };
+
     stToken.leaf = leaf;
-    if(auto pTexture = g_fontexDB->Retrieve(nU64Key)){
-        int nBoxW = -1;
-        int nBoxH = -1;
-        if(!SDL_QueryTexture(pTexture, nullptr, nullptr, &nBoxW, &nBoxH)){
-            stToken.Box.Info.W      = nBoxW;
-            stToken.Box.Info.H      = nBoxH;
-            stToken.Box.State.H1    = stToken.Box.Info.H;
-            stToken.Box.State.H2    = 0;
-            stToken.UTF8Char.U64Key = nU64Key;
-            return stToken;
-        }
-        throw fflerror("SDL_QueryTexture(%p) failed", to_cvptr(pTexture));
+    if(const auto stRegion = g_fontexDB->RetrieveRegion(nU64Key)){
+        fnSetGlyph(nU64Key, stRegion);
+        return stToken;
     }
 
     nU64Key = utf8f::buildU64Key(m_font, m_fontSize, 0, nUTF8Code);
-    if(g_fontexDB->Retrieve(nU64Key)){
+    if(g_fontexDB->RetrieveRegion(nU64Key)){
         throw fflerror("can't find texture for UTF8: %" PRIX32, nUTF8Code);
     }
 
     nU64Key = utf8f::buildU64Key(m_font, m_fontSize, nFontStyle, utf8f::peekUTF8Code("0"));
-    if(g_fontexDB->Retrieve(nU64Key)){
+    if(g_fontexDB->RetrieveRegion(nU64Key)){
         throw fflerror("invalid font style: %" PRIX8, nFontStyle);
     }
 
@@ -584,19 +711,10 @@ TOKEN XMLTypeset::buildUTF8Token(int leaf, uint8_t nFont, uint8_t nFontSize, uin
     // use system default font, don't fail it
 
     nU64Key = utf8f::buildU64Key(m_font, m_fontSize, nFontStyle, nUTF8Code);
-    if(auto pTexture = g_fontexDB->Retrieve(nU64Key)){
-        int nBoxW = -1;
-        int nBoxH = -1;
-        if(!SDL_QueryTexture(pTexture, nullptr, nullptr, &nBoxW, &nBoxH)){
-            g_log->addLog(LOGTYPE_WARNING, "Fallback to default font: font: %d -> %d, fontsize: %d -> %d", (int)(nFont), (int)(m_font), (int)(nFontSize), (int)(m_fontSize));
-            stToken.Box.Info.W      = nBoxW;
-            stToken.Box.Info.H      = nBoxH;
-            stToken.Box.State.H1    = stToken.Box.Info.H;
-            stToken.Box.State.H2    = 0;
-            stToken.UTF8Char.U64Key = nU64Key;
-            return stToken;
-        }
-        throw fflerror("SDL_QueryTexture(%p) failed", to_cvptr(pTexture));
+    if(const auto stRegion = g_fontexDB->RetrieveRegion(nU64Key)){
+        g_log->addLog(LOGTYPE_WARNING, "Fallback to default font: font: %d -> %d, fontsize: %d -> %d", (int)(nFont), (int)(m_font), (int)(nFontSize), (int)(m_fontSize));
+        fnSetGlyph(nU64Key, stRegion);
+        return stToken;
     }
     throw fflerror("fallback to default font failed: font: %d -> %d, fontsize: %d -> %d", (int)(nFont), (int)(m_font), (int)(nFontSize), (int)(m_fontSize));
 }
@@ -663,7 +781,8 @@ TOKEN XMLTypeset::createToken(int leaf, int leafOff) const
 // notice:
 // this function may get called after any XML update, the (x, y) in XMLTypeset may be
 // invalid but as long as it's valid in XMLParagraph it's well-defined
-void XMLTypeset::buildTypeset(int x, int y)
+// if reuse provided, stops at the first new line which can take the rest old lines
+void XMLTypeset::buildTypeset(int x, int y, TypesetReuse *reuse)
 {
     for(int line = 0; line < y; ++line){
         if(lineEmpty(line)){
@@ -696,6 +815,15 @@ void XMLTypeset::buildTypeset(int x, int y)
         }
     }
 
+    // global index of the token to add
+    // only needed to match old lines
+    int currToken = x;
+    if(reuse){
+        for(int line = 0; line < y; ++line){
+            currToken += lineTokenCount(line);
+        }
+    }
+
     // we start to push token from (leaf, leafOff)
     // if current it's a utf8String and not start from the beginning, we should keep the leaf record
     m_leaf2TokenLoc.resize(leaf + (int)(leafOff > 0));
@@ -707,7 +835,7 @@ void XMLTypeset::buildTypeset(int x, int y)
     int advanced = 1;
     int currLine = y;
 
-    for(; advanced; std::tie(leaf, leafOff, advanced) = m_paragraph.nextLeafOff(leaf, leafOff, 1)){
+    for(; advanced; std::tie(leaf, leafOff, advanced) = m_paragraph.nextLeafOff(leaf, leafOff, 1), ++currToken){
         const TOKEN token = createToken(leaf, leafOff);
         if(addRawToken(currLine, token)){
             if(leafOff == 0){
@@ -721,6 +849,11 @@ void XMLTypeset::buildTypeset(int x, int y)
         currLine++;
         m_lineList.resize(currLine + 1);
 
+        if(reuse && reuseLines(currLine, currToken, reuse)){
+            resetBoardPixelRegion();
+            return;
+        }
+
         if(!addRawToken(currLine, token)){
             throw fflerror("insert token to a new line failed: line = %d", (int)(currLine));
         }
@@ -734,6 +867,103 @@ void XMLTypeset::buildTypeset(int x, int y)
     resetBoardPixelRegion();
 }
 
+// re-layout after m_paragraph gets edited at cursor (x, y)
+// oldTokenCount and oldLeafCount are counts of m_paragraph before the edit
+// lines before the edit stay, lines after the edit get reused if line breaks line up again
+void XMLTypeset::updateTypeset(int x, int y, int oldTokenCount, int oldLeafCount)
+{
+    if(lineCount() == 0){
+        buildTypeset(0, 0);
+        return;
+    }
+
+    int editToken = x;
+    for(int line = 0; line < y; ++line){
+        editToken += lineTokenCount(line);
+    }
+
+    // restart from the token before the edit
+    // if the edit is at line head, the line before may take some new tokens
+    int restartX = 0;
+    int restartY = 0;
+
+    if(x > 0){
+        restartX = x - 1;
+        restartY = y;
+    }
+    else if(y > 0){
+        restartX = lineTokenCount(y - 1) - 1;
+        restartY = y - 1;
+    }
+
+    TypesetReuse reuse;
+    reuse.tokenDelta = m_paragraph.tokenCount() - oldTokenCount;
+    reuse.leafDelta  = m_paragraph.leafCount()  - oldLeafCount;
+    reuse.minToken   = editToken + std::max<int>(0, -reuse.tokenDelta);
+
+    // global index of the first token in line restartY + 1
+    reuse.firstLine = restartY + 1;
+    reuse.lineToken = editToken - x + ((restartY < y) ? 0 : lineTokenCount(restartY));
+
+    for(int line = reuse.firstLine; line < lineCount(); ++line){
+        reuse.lineList.push_back(std::move(m_lineList[line]));
+    }
+
+    buildTypeset(restartX, restartY, &reuse);
+}
+
+// (line, token) is the start of a new line, line is empty
+// append old lines if old line starting from the same token exists
+bool XMLTypeset::reuseLines(int line, int token, TypesetReuse *reuse)
+{
+    const int oldToken = token - reuse->tokenDelta;
+    if(oldToken < reuse->minToken){
+        return false;
+    }
+
+    while((reuse->line < (int)(reuse->lineList.size())) && (reuse->lineToken < oldToken)){
+        reuse->lineToken += (int)(reuse->lineList[reuse->line].content.size());
+        reuse->line++;
+    }
+
+    if(reuse->line >= (int)(reuse->lineList.size()) || reuse->lineToken != oldToken){
+        return false;
+    }
+
+    // old line (firstLine + reuse->line) becomes current line
+    // every line after it keeps the same tokens and X, only needs leaf and Y shifted
+    m_lineList.resize(line);
+    for(int i = reuse->line; i < (int)(reuse->lineList.size()); ++i){
+        m_lineList.push_back(std::move(reuse->lineList[i]));
+    }
+
+    const int oldStartY = m_lineList[line].startY;
+    SetLineTokenStartY(line);
+    const int dy = m_lineList[line].startY - oldStartY;
+
+    // don't take leaf locations from old lines
+    // if the edit removes head of a leaf, the new head can be in lines reused
+    for(int i = line; i < lineCount(); ++i){
+        if(i > line){
+            m_lineList[i].startY += dy;
+        }
+
+        for(int x = 0; x < lineTokenCount(i); ++x){
+            auto &token = m_lineList[i].content[x];
+            token.leaf += reuse->leafDelta;
+
+            if(i > line){
+                token.Box.State.Y += dy;
+            }
+
+            if(token.leaf >= (int)(m_leaf2TokenLoc.size())){
+                m_leaf2TokenLoc.push_back({x, i});
+            }
+        }
+    }
+    return true;
+}
+
 std::tuple<int, int> XMLTypeset::leafLocInXMLParagraph(int tokenX, int tokenY) const
 {
     if(!tokenLocValid(tokenX, tokenY)){
@@ -805,7 +1035,7 @@ std::tuple<int, int> XMLTypeset::prevTokenLoc(int nX, int nY) const
     if(nX){
         return {nX - 1, nY};
     }else{
-        return {lineTokenCount(nY - 1), nY - 1};
+        return {lineTokenCount(nY - 1) - 1, nY - 1};
     }
 }
 
@@ -836,6 +1066,9 @@ void XMLTypeset::deleteToken(int x, int y, int tokenCount)
         return;
     }
 
+    const int oldTokenCount = m_paragraph.tokenCount();
+    const int oldLeafCount  = m_paragraph.leafCount();
+
     const auto [leaf, leafOff] = leafLocInXMLParagraph(x, y);
     m_paragraph.deleteToken(leaf, leafOff, tokenCount);
 
@@ -843,7 +1076,7 @@ void XMLTypeset::deleteToken(int x, int y, int tokenCount)
         clear();
     }
     else{
-        buildTypeset(x, y);
+        updateTypeset(x, y, oldTokenCount, oldLeafCount);
     }
 }
 
@@ -885,6 +1118,9 @@ void XMLTypeset::insertUTF8String(int x, int y, const char *text)
     // XMLParagraph doesn't have cursor
     // need to parse here
 
+    const int oldTokenCount = m_paragraph.tokenCount();
+    const int oldLeafCount  = m_paragraph.leafCount();
+
     if(x == 0 && y == 0){
         if(m_paragraph.leafRef(0).Type() != LEAF_UTF8GROUP){
             m_paragraph.insertLeafXML(0, fnParXMLString(text));
@@ -892,7 +1128,7 @@ void XMLTypeset::insertUTF8String(int x, int y, const char *text)
         else{
             m_paragraph.insertUTF8String(0, 0, text);
         }
-        buildTypeset(0, 0);
+        updateTypeset(x, y, oldTokenCount, oldLeafCount);
         return;
     }
 
@@ -906,7 +1142,7 @@ void XMLTypeset::insertUTF8String(int x, int y, const char *text)
         else{
             m_paragraph.insertUTF8String(leafCount() - 1, m_paragraph.backLeafRef().utf8CharOffRef().size(), text);
         }
-        buildTypeset(0, 0);
+        updateTypeset(x, y, oldTokenCount, oldLeafCount);
         return;
     }
 
@@ -934,7 +1170,7 @@ void XMLTypeset::insertUTF8String(int x, int y, const char *text)
         }
     }
 
-    buildTypeset(0, 0);
+    updateTypeset(x, y, oldTokenCount, oldLeafCount);
 }
 
 void XMLTypeset::drawEx(int dstX, int dstY, int srcX, int srcY, int srcW, int srcH) const
@@ -949,6 +1185,10 @@ void XMLTypeset::drawEx(int dstX, int dstY, int srcX, int srcY, int srcW, int sr
     uint32_t fgColorVal = 0;
     uint32_t bgColorVal = 0;
 
+    // glyphs of one font share atlas pages
+    // consecutive glyphs on one page go to the renderer in one call
+    SDLDevice::TextureBatch glyphBatch;
+
     int lastLeaf = -1;
     for(int line = 0; line < lineCount(); ++line){
         for(int token = 0; token < lineTokenCount(line); ++token){
@@ -971,6 +1211,7 @@ void XMLTypeset::drawEx(int dstX, int dstY, int srcX, int srcY, int srcW, int sr
                 int bgBoxH = tokenPtr->Box.Info.H;
 
                 if(mathf::rectangleOverlapRegion(srcX, srcY, srcW, srcH, &bgBoxX, &bgBoxY, &bgBoxW, &bgBoxH)){
+                    glyphBatch.flush(); // background can overlap glyphs pending in the batch
                     g_sdlDevice->fillRectangle(bgColorVal, bgBoxX + dstDX, bgBoxY + dstDY, bgBoxW, bgBoxH);
                 }
             }
@@ -993,9 +1234,8 @@ void XMLTypeset::drawEx(int dstX, int dstY, int srcX, int srcY, int srcW, int sr
             switch(leaf.Type()){
                 case LEAF_UTF8GROUP:
                     {
-                        if(auto texPtr = g_fontexDB->Retrieve(tokenPtr->UTF8Char.U64Key)){
-                            SDLDevice::EnableTextureModColor enableMod(texPtr, fgColorVal);
-                            g_sdlDevice->drawTexture(texPtr, drawDstX, drawDstY, dx, dy, boxW, boxH);
+                        if(const auto glyph = g_fontexDB->RetrieveRegion(tokenPtr->UTF8Char.U64Key)){
+                            glyphBatch.addModColor(glyph.texture, {glyph.rect.x + dx, glyph.rect.y + dy, boxW, boxH}, {drawDstX, drawDstY, boxW, boxH}, fgColorVal);
                         }
                         else{
                             g_sdlDevice->drawRectangle(colorf::CompColor(bgColorVal), drawDstX, drawDstY, boxW, boxH);
@@ -1024,6 +1264,7 @@ void XMLTypeset::drawEx(int dstX, int dstY, int srcX, int srcY, int srcW, int sr
                         int yOnTex = 0;
 
                         if(auto texPtr = g_emoticonDB->Retrieve(emojiKey, &xOnTex, &yOnTex, 0, 0, 0, 0, 0)){
+                            glyphBatch.flush();
                             SDLDevice::EnableTextureModColor enableMod(texPtr, m_imageMaskColor);
                             g_sdlDevice->drawTexture(texPtr, drawDstX, drawDstY, xOnTex + dx, yOnTex + dy, boxW, boxH);
                         }
@@ -1037,6 +1278,7 @@ void XMLTypeset::drawEx(int dstX, int dstY, int srcX, int srcY, int srcW, int sr
         }
     }
 
+    glyphBatch.flush();
     if(g_clientArgParser->drawBoardFrame){
         g_sdlDevice->drawRectangle(colorf::YELLOW + 255, dstX, dstY, srcW, srcH);
     }
@@ -1271,8 +1513,8 @@ void XMLTypeset::setLineWidth(int lineWidth)
 
 int XMLTypeset::getDefaultFontHeight() const
 {
-    if(auto texPtr = g_fontexDB->Retrieve(utf8f::buildU64Key(m_font, m_fontSize, m_fontStyle, utf8f::peekUTF8Code(" ")))){
-        return SDLDevice::getTextureHeight(texPtr);
+    if(const auto stRegion = g_fontexDB->RetrieveRegion(utf8f::buildU64Key(m_font, m_fontSize, m_fontStyle, utf8f::peekUTF8Code(" ")))){
+        return stRegion.rect.h;
     }
     return 20;
 }
@@ -18,6 +18,8 @@
 
 #pragma once
 #include <tuple>
+#include <string>
+#include <vector>
 #include "token.hpp"
 #include "lalign.hpp"
 #include "xmlf.hpp"
@@ -119,32 +121,32 @@ class XMLTypeset // means XMLParagraph typeset
             return m_lineList.at(line).content.empty();
         }
 
-    public:
-        void loadXML(const char *szXMLString)
+    private:
+        // lines of one typeset XML paragraph
+        // same XML with same fonts and line width always gets the same lines
+        struct TypesetRun
         {
-            clear();
-            m_paragraph.loadXML(szXMLString);
+            std::vector<contentLine> lineList;
+            std::vector<std::tuple<int, int>> leaf2TokenLoc;
 
-            if(m_paragraph.leafCount() > 0){
-                buildTypeset(0, 0);
-            }
-            else{
-                m_ph = getDefaultFontHeight();
-            }
-        }
+            int px;
+            int py;
+            int pw;
+            int ph;
+        };
 
-        void loadXMLNode(const tinyxml2::XMLNode *node)
-        {
-            clear();
-            m_paragraph.loadXMLNode(node);
+        // LRU of recently typeset runs, shared by all instances
+        // labels and chat boards reload the same XML again and again
+        class TypesetRunCache;
+        static TypesetRunCache &getRunCache();
 
-            if(m_paragraph.leafCount() > 0){
-                buildTypeset(0, 0);
-            }
-            else{
-                m_ph = getDefaultFontHeight();
-            }
-        }
+    public:
+        void loadXML(const char *);
+        void loadXMLNode(const tinyxml2::XMLNode *);
+
+    private:
+        void loadTypeset(const std::string &);
+        std::string typesetRunKey(const char *) const;
 
     public:
         void clear()
@@ -154,6 +156,7 @@ class XMLTypeset // means XMLParagraph typeset
             m_pw = 0;
             m_ph = 0;
             m_lineList.clear();
+            m_leaf2TokenLoc.clear();
             m_paragraph.clear();
         }
 
@@ -406,7 +409,29 @@ class XMLTypeset // means XMLParagraph typeset
         TOKEN createToken(int, int) const;
 
     private:
-        void buildTypeset(int, int);
+        // old lines after an edit location
+        // tokens after the edit don't change but get shifted in paragraph by tokenDelta, and their leaves by leafDelta
+        // once a new line starts at the same token as an old line, the rest old lines can be reused with only Y shifted
+        struct TypesetReuse
+        {
+            int minToken   = 0;
+            int tokenDelta = 0;
+            int leafDelta  = 0;
+
+            int firstLine = 0;
+            std::vector<contentLine> lineList;
+
+            // cursor to lineList, and global token index of its first token
+            int line      = 0;
+            int lineToken = 0;
+        };
+
+    private:
+        void buildTypeset(int, int, TypesetReuse * = nullptr);
+
+    private:
+        void updateTypeset(int, int, int, int);
+        bool reuseLines(int, int, TypesetReuse *);
 
     private:
         int LineReachMaxX(int) const;
@@ -0,0 +1,275 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: texturebatchbench.cpp
+ *        Created: 10/17/2026 23:48:06
+ *    Description: frame time of map drawing on the software renderer
+ *
+ *                 one frame is a screen of tiles plus ground objects drawn in map order,
+ *                 some objects are drawn with alpha, drawn three ways:
+ *
+ *                     standalone : one texture per image, one SDL_RenderCopy per copy,
+ *                                  the way map textures were drawn before atlas pages
+ *                     atlas copy : images packed in one atlas page, one SDL_RenderCopy per
+ *                                  copy, SDLDevice::drawTextureList() before SDL 2.0.18
+ *                     atlas batch: images packed in one atlas page, one SDL_RenderGeometry
+ *                                  per frame, SDLDevice::drawTextureList()
+ *
+ *                 software renderer draws into a surface, no window or GPU needed
+ *
+ *                     $ texturebatchbench [frames] [objects]
+ *
+ *                 not run by ctest, numbers depend on the machine
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <SDL2/SDL.h>
+#include "fflerror.hpp"
+#include "raiitimer.hpp"
+
+constexpr int SCREEN_W = 800;
+constexpr int SCREEN_H = 600;
+
+constexpr int TILE_W = 96;
+constexpr int TILE_H = 64;
+
+constexpr int ATLAS_SIZE = 2048;
+
+struct BenchImage
+{
+    int w = 0;
+    int h = 0;
+
+    SDL_Rect atlasRect {};
+    SDL_Texture *texPtr = nullptr;
+};
+
+struct BenchCopy
+{
+    int image = 0;
+    SDL_Rect dst {};
+    Uint8 alpha = 255;
+};
+
+static SDL_Texture *createTexture(SDL_Renderer *renderer, int w, int h)
+{
+    auto texPtr = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, w, h);
+    if(!texPtr){
+        throw fflerror("create texture failed: %s", SDL_GetError());
+    }
+
+    SDL_SetTextureBlendMode(texPtr, SDL_BLENDMODE_BLEND);
+    return texPtr;
+}
+
+// transparent corners like real map objects, random colors inside
+static std::vector<uint32_t> createPixel(int w, int h, std::minstd_rand &rng)
+{
+    std::vector<uint32_t> pixelList((size_t)(w) * h);
+    for(int y = 0; y < h; ++y){
+        for(int x = 0; x < w; ++x){
+            const bool opaque = std::abs(2 * x - w) * h + std::abs(2 * y - h) * w < w * h;
+            pixelList[x + y * w] = opaque ? (0XFF000000 | (rng() & 0X00FFFFFF)) : 0;
+        }
+    }
+    return pixelList;
+}
+
+// tiles first, then 2 sizes of ground objects
+// shelf packing, all of them fit in one atlas page
+static std::vector<BenchImage> createImageList(SDL_Renderer *renderer, SDL_Texture *atlasPtr)
+{
+    std::minstd_rand rng(17);
+    std::vector<BenchImage> imageList;
+
+    int shelfX = 0;
+    int shelfY = 0;
+    int shelfH = 0;
+
+    for(int i = 0; i < 192; ++i){
+        BenchImage image;
+        if(i < 64){
+            image.w = TILE_W;
+            image.h = TILE_H;
+        }
+        else{
+            image.w = 48 * (1 + rng() % 2);
+            image.h = 32 * (1 + rng() % 4);
+        }
+
+        if(shelfX + image.w > ATLAS_SIZE){
+            shelfX  = 0;
+            shelfY += shelfH;
+            shelfH  = 0;
+        }
+
+        if(shelfY + image.h > ATLAS_SIZE){
+            throw fflerror("atlas page is full");
+        }
+
+        image.atlasRect = {shelfX, shelfY, image.w, image.h};
+        image.texPtr = createTexture(renderer, image.w, image.h);
+
+        const auto pixelList = createPixel(image.w, image.h, rng);
+        SDL_UpdateTexture(image.texPtr, nullptr, pixelList.data(), image.w * 4);
+        SDL_UpdateTexture(atlasPtr, &image.atlasRect, pixelList.data(), image.w * 4);
+
+        shelfX += image.w;
+        shelfH  = std::max<int>(shelfH, image.h);
+        imageList.push_back(image);
+    }
+    return imageList;
+}
+
+static std::vector<BenchCopy> createCopyList(const std::vector<BenchImage> &imageList, int objCount)
+{
+    std::minstd_rand rng(19);
+    std::vector<BenchCopy> copyList;
+
+    for(int y = 0; y < SCREEN_H; y += TILE_H){
+        for(int x = 0; x < SCREEN_W; x += TILE_W){
+            copyList.push_back({(int)(rng() % 64), {x, y, TILE_W, TILE_H}, 255});
+        }
+    }
+
+    for(int i = 0; i < objCount; ++i){
+        const int image = 64 + rng() % (imageList.size() - 64);
+        copyList.push_back({image, {(int)(rng() % SCREEN_W), (int)(rng() % SCREEN_H), imageList[image].w, imageList[image].h}, (Uint8)((rng() % 8) ? 255 : 128)});
+    }
+    return copyList;
+}
+
+static void drawCopy(SDL_Renderer *renderer, SDL_Texture *texPtr, const SDL_Rect &src, const BenchCopy &copy)
+{
+    if(copy.alpha == 255){
+        SDL_RenderCopy(renderer, texPtr, &src, &copy.dst);
+    }
+    else{
+        SDL_SetTextureAlphaMod(texPtr, copy.alpha);
+        SDL_RenderCopy(renderer, texPtr, &src, &copy.dst);
+        SDL_SetTextureAlphaMod(texPtr, 255);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const int frameCount = (argc > 1) ? std::max<int>(1, std::atoi(argv[1])) : 200;
+    const int objCount   = (argc > 2) ? std::max<int>(0, std::atoi(argv[2])) : 400;
+
+    try{
+        auto surfacePtr = SDL_CreateRGBSurfaceWithFormat(0, SCREEN_W, SCREEN_H, 32, SDL_PIXELFORMAT_ARGB8888);
+        if(!surfacePtr){
+            throw fflerror("create surface failed: %s", SDL_GetError());
+        }
+
+        auto renderer = SDL_CreateSoftwareRenderer(surfacePtr);
+        if(!renderer){
+            throw fflerror("create software renderer failed: %s", SDL_GetError());
+        }
+
+        auto atlasPtr = createTexture(renderer, ATLAS_SIZE, ATLAS_SIZE);
+        const auto imageList = createImageList(renderer, atlasPtr);
+        const auto copyList  = createCopyList(imageList, objCount);
+
+        std::vector<int> indexList;
+        std::vector<SDL_Vertex> vertexList;
+
+        const auto fnRun = [renderer, frameCount](const auto &fnDraw)
+        {
+            const hres_timer timer;
+            for(int i = 0; i < frameCount; ++i){
+                SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+                SDL_RenderClear(renderer);
+                fnDraw();
+                SDL_RenderPresent(renderer);
+            }
+            return timer.diff_nsec() / 1000000.0 / frameCount;
+        };
+
+        const double standaloneTime = fnRun([renderer, &imageList, &copyList]()
+        {
+            for(const auto &copy: copyList){
+                const auto &image = imageList[copy.image];
+                drawCopy(renderer, image.texPtr, {0, 0, image.w, image.h}, copy);
+            }
+        });
+
+        const double atlasCopyTime = fnRun([renderer, atlasPtr, &imageList, &copyList]()
+        {
+            for(const auto &copy: copyList){
+                drawCopy(renderer, atlasPtr, imageList[copy.image].atlasRect, copy);
+            }
+        });
+
+        std::printf("frames: %d, copies per frame: %zu, screen: %dx%d\n", frameCount, copyList.size(), SCREEN_W, SCREEN_H);
+        std::printf("standalone : %8.3f ms/frame\n", standaloneTime);
+        std::printf("atlas copy : %8.3f ms/frame\n", atlasCopyTime);
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+        // same vertex layout as SDLDevice::drawTextureList()
+        const double atlasBatchTime = fnRun([renderer, atlasPtr, &imageList, &copyList, &indexList, &vertexList]()
+        {
+            indexList.clear();
+            vertexList.clear();
+
+            for(const auto &copy: copyList){
+                const auto &src = imageList[copy.image].atlasRect;
+                const auto &dst = copy.dst;
+
+                const float u0 = 1.0f * (src.x        ) / ATLAS_SIZE;
+                const float v0 = 1.0f * (src.y        ) / ATLAS_SIZE;
+                const float u1 = 1.0f * (src.x + src.w) / ATLAS_SIZE;
+                const float v1 = 1.0f * (src.y + src.h) / ATLAS_SIZE;
+
+                const float x0 = 1.0f * (dst.x        );
+                const float y0 = 1.0f * (dst.y        );
+                const float x1 = 1.0f * (dst.x + dst.w);
+                const float y1 = 1.0f * (dst.y + dst.h);
+
+                const SDL_Color color {255, 255, 255, copy.alpha};
+                const int base = (int)(vertexList.size());
+
+                vertexList.push_back({{x0, y0}, color, {u0, v0}});
+                vertexList.push_back({{x1, y0}, color, {u1, v0}});
+                vertexList.push_back({{x1, y1}, color, {u1, v1}});
+                vertexList.push_back({{x0, y1}, color, {u0, v1}});
+
+                for(const int index: {0, 1, 2, 2, 3, 0}){
+                    indexList.push_back(base + index);
+                }
+            }
+            SDL_RenderGeometry(renderer, atlasPtr, vertexList.data(), (int)(vertexList.size()), indexList.data(), (int)(indexList.size()));
+        });
+        std::printf("atlas batch: %8.3f ms/frame\n", atlasBatchTime);
+#else
+        std::printf("atlas batch: requires SDL 2.0.18\n");
+#endif
+
+        for(const auto &image: imageList){
+            SDL_DestroyTexture(image.texPtr);
+        }
+
+        SDL_DestroyTexture(atlasPtr);
+        SDL_DestroyRenderer(renderer);
+        SDL_FreeSurface(surfacePtr);
+    }
+    catch(const std::exception &e){
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,290 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: xmltypesetbench.cpp
+ *        Created: 10/17/2026 03:05:44
+ *    Description: typeset, edit and draw time of XMLTypeset, chat log append time
+ *
+ *                 paragraph is random common CJK characters with punctuation, ASCII words
+ *                 and colored spans, same as NPC dialogs and chat text, cases:
+ *
+ *                     cold   : first load, glyphs are rendered and packed into atlas pages
+ *                     layout : paragraph rotated to a different text each load, glyphs are
+ *                              cached but the typeset run cache misses
+ *                     cached : same paragraph loaded again, hits the typeset run cache, XML
+ *                              over 16KB is not kept by the cache, same as layout then
+ *                     draw   : whole paragraph drawn per frame, consecutive glyphs on one
+ *                              atlas page go to the renderer in one call
+ *                     insert : one character typed at the end and at the front of the
+ *                              paragraph, re-layout starts from the edited line
+ *                     chat   : messages appended to a LayoutBoard set up as the chat log of
+ *                              ControlBoard, time per message of every 1/10 of the log
+ *                              shows if append cost grows with the log length
+ *
+ *                 runs in the client bin directory, needs Res/Font/FontexDB.ZSDB, window
+ *                 can be hidden by SDL_VIDEODRIVER=offscreen
+ *
+ *                     $ xmltypesetbench [--bench-char=4000] [--bench-width=400]
+ *                                       [--bench-font=1] [--bench-font-size=12]
+ *                                       [--bench-chat=10000]
+ *                                       [--bench-fontex-db=Res/Font/FontexDB.ZSDB]
+ *
+ *                 not run by ctest, numbers depend on the machine
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include "log.hpp"
+#include "utf8f.hpp"
+#include "xmlconf.hpp"
+#include "fflerror.hpp"
+#include "fontexdb.hpp"
+#include "raiitimer.hpp"
+#include "sdldevice.hpp"
+#include "emoticondb.hpp"
+#include "xmltypeset.hpp"
+#include "layoutboard.hpp"
+#include "clientargparser.hpp"
+
+ClientArgParser *g_clientArgParser = nullptr;
+Log             *g_log             = nullptr;
+XMLConf         *g_XMLConf         = nullptr;
+SDLDevice       *g_sdlDevice       = nullptr;
+FontexDB        *g_fontexDB        = nullptr;
+emoticonDB      *g_emoticonDB      = nullptr; // bench text has no emoji
+
+// common characters of NPC dialogs, 3 bytes each in UTF-8
+constexpr const char *g_CJKCharList = ""
+    "的一是不了人我在有他这中大来上国个到说们为子和你地出道也时年得就那要下以生会自着去之过家学对可她里后小么心多天而能好都然没日于起还发成事只作当想看文无开手十用主行方又如前所本见经头面公同三已老从动两长知民样现分将外但身些与高意进把法此实回二理美点月明其种声全工己话儿者向情部正名定女问力机给等几很业最间新什打便位因重被走电四第门相次东政海口使教西再平真听世气信北少关并内加化由却代军产入先山五太水万市眼体别处总才场师书比住员九笑性通目华报立马命张活难神数件安表原车白应路期叫死常提感金何更反合放做系计或司利受光王果亲界及今京务制解各任至清物台象记边共风战干接它许八特觉望直服毛林题建南度统色字请交爱让认算论百吃义科怎元社术结六功指思非流每青管夫连远资队跟带花快条院变联言权往展该领传近留红治决周保达办运武半候七必城父强步完革深区即求品士转量空甚众技轻程告江语英基派满式李息写呢识极令黄德收脸钱党倒未持取设始版双历越史商千片容研像找友孩站广改议形委早房音火际则首单影病失参写";
+
+constexpr const char *g_ASCIIWordList[]
+{
+    "HP", "MP", "EXP", "NPC", "BOSS", "mir2x", "OK", "1024", "99",
+};
+
+constexpr const char *g_colorList[]
+{
+    "red", "green", "yellow", "blue",
+};
+
+// text only, XML is built by the caller
+static std::vector<std::string> randomCJKTokenList(int charCount, std::minstd_rand &rng)
+{
+    std::vector<std::string> charList;
+    const std::string charString = g_CJKCharList;
+    const auto offList = utf8f::buildUTF8Off(g_CJKCharList);
+
+    for(size_t i = 0; i < offList.size(); ++i){
+        const size_t end = (i + 1 < offList.size()) ? offList[i + 1] : charString.size();
+        charList.push_back(charString.substr(offList[i], end - offList[i]));
+    }
+
+    std::vector<std::string> tokenList;
+    for(int i = 0; i < charCount; ++i){
+        switch(rng() % 40){
+            case 0 : tokenList.push_back("，"); break;
+            case 1 : tokenList.push_back("。"); break;
+            case 2 : tokenList.push_back(std::string(" ") + g_ASCIIWordList[rng() % std::size(g_ASCIIWordList)] + " "); break;
+            default: tokenList.push_back(charList[rng() % charList.size()]); break;
+        }
+    }
+    return tokenList;
+}
+
+// one colored span every 50 tokens, starts at token offset
+// different offset gives different XML with the same glyphs
+static std::string buildParXML(const std::vector<std::string> &tokenList, size_t offset)
+{
+    std::string xmlString = "<par>";
+    for(size_t i = 0; i < tokenList.size(); ++i){
+        const size_t index = (i + offset) % tokenList.size();
+        if(i % 50 == 10){
+            xmlString += std::string("<font color=\"") + g_colorList[(i / 50) % std::size(g_colorList)] + "\">";
+        }
+
+        xmlString += tokenList[index];
+        if(i % 50 == 15){
+            xmlString += "</font>";
+        }
+    }
+
+    if(tokenList.size() % 50 > 10 && tokenList.size() % 50 <= 15){
+        xmlString += "</font>";
+    }
+    return xmlString + "</par>";
+}
+
+// same XML as ControlBoard::addLog()
+// message text is escaped by tinyxml2
+static std::string buildChatXML(int logType, const std::string &text)
+{
+    tinyxml2::XMLDocument xmlDoc;
+    const char *xmlString = (logType == 0) ? "<par></par>" : "<par bgcolor = \"0x008000ff\"></par>";
+
+    if(xmlDoc.Parse(xmlString) != tinyxml2::XML_SUCCESS){
+        throw fflerror("parse xml template failed: %s", xmlString);
+    }
+
+    xmlDoc.RootElement()->SetText(text.c_str());
+    tinyxml2::XMLPrinter printer;
+
+    xmlDoc.Print(&printer);
+    return printer.CStr();
+}
+
+static int parseInt(const argh::parser &cmdParser, const char *name, int defVal)
+{
+    if(const auto numStr = cmdParser(name).str(); !numStr.empty()){
+        try{
+            return std::max<int>(1, std::stoi(numStr));
+        }
+        catch(...){
+            return defVal;
+        }
+    }
+    return defVal;
+}
+
+int main(int argc, char *argv[])
+{
+    try{
+        arg_parser cmdParser(argc, argv);
+        g_clientArgParser = new ClientArgParser(cmdParser);
+        g_log = new Log("xmltypesetbench");
+
+        const int charCount = parseInt(cmdParser, "bench-char"     , 4000);
+        const int lineWidth = parseInt(cmdParser, "bench-width"    ,  400);
+        const int font      = parseInt(cmdParser, "bench-font"     ,    1);
+        const int fontSize  = parseInt(cmdParser, "bench-font-size",   12);
+        const int chatCount = parseInt(cmdParser, "bench-chat"     , 10000);
+
+        const auto fontexDBName = [&cmdParser]() -> std::string
+        {
+            if(const auto name = cmdParser("bench-fontex-db").str(); !name.empty()){
+                return name;
+            }
+            return "Res/Font/FontexDB.ZSDB";
+        }();
+
+        g_sdlDevice = new SDLDevice();
+        g_sdlDevice->CreateInitViewWindow();
+
+        g_fontexDB = new FontexDB(1024, 4);
+        if(!g_fontexDB->Load(fontexDBName.c_str())){
+            throw fflerror("failed to load font database: %s", fontexDBName.c_str());
+        }
+
+        std::minstd_rand rng(17);
+        const auto tokenList = randomCJKTokenList(charCount, rng);
+        const auto xmlString = buildParXML(tokenList, 0);
+
+        XMLTypeset board(lineWidth, LALIGN_JUSTIFY, false, font, fontSize, 0, colorf::WHITE + 255);
+        const auto fnLoad = [&board](const std::string &xml)
+        {
+            const hres_timer timer;
+            board.loadXML(xml.c_str());
+            return timer.diff_nsec() / 1000000.0;
+        };
+
+        const double coldTime = fnLoad(xmlString);
+        std::printf("chars: %d, XML: %zu bytes, width: %d, font: %d, size: %d, lines: %d, height: %d\n", charCount, xmlString.size(), lineWidth, font, fontSize, board.lineCount(), board.ph());
+
+        // build rotated paragraphs first, don't time the string building
+        std::vector<std::string> rotateList;
+        for(int i = 1; i <= 20; ++i){
+            rotateList.push_back(buildParXML(tokenList, i * tokenList.size() / 21));
+        }
+
+        double layoutTime = 0.0;
+        for(const auto &rotateXML: rotateList){
+            layoutTime += fnLoad(rotateXML);
+        }
+        layoutTime /= rotateList.size();
+
+        double cachedTime = 0.0;
+        for(int i = 0; i < 20; ++i){
+            cachedTime += fnLoad(xmlString);
+        }
+        cachedTime /= 20;
+
+        // window is small, draw the whole board to the renderer anyway
+        // clipping is done by the renderer, XMLTypeset draws every glyph in the region
+        constexpr int frameCount = 100;
+        const hres_timer drawTimer;
+        for(int i = 0; i < frameCount; ++i){
+            SDLDevice::RenderNewFrame newFrame;
+            board.drawEx(0, 0, 0, 0, board.pw(), board.ph());
+        }
+        const double drawTime = drawTimer.diff_nsec() / 1000000.0 / frameCount;
+
+        // typing goes through insertUTF8String(), not the typeset run cache
+        constexpr int insertCount = 200;
+        const auto fnInsert = [&board, &tokenList](bool atEnd)
+        {
+            const hres_timer timer;
+            for(int i = 0; i < insertCount; ++i){
+                const int line = atEnd ? (board.lineCount() - 1) : 0;
+                board.insertUTF8String(atEnd ? board.lineTokenCount(line) : 0, line, tokenList[i % tokenList.size()].c_str());
+            }
+            return timer.diff_nsec() / 1000000.0 / insertCount;
+        };
+
+        const double insertEndTime   = fnInsert(true);
+        const double insertFrontTime = fnInsert(false);
+
+        std::printf("cold   : %10.3f ms\n", coldTime);
+        std::printf("layout : %10.3f ms\n", layoutTime);
+        std::printf("cached : %10.3f ms\n", cachedTime);
+        std::printf("draw   : %10.3f ms/frame\n", drawTime);
+        std::printf("insert : %10.3f ms at end, %.3f ms at front\n", insertEndTime, insertFrontTime);
+
+        // same parameters as ControlBoard::m_logBoard of 800x600 window
+        // one message is one paragraph, 1/5 of them system messages with background
+        LayoutBoard logBoard(9, 0, 341, false, {0, 0, 0, 0}, false, 1, 12, 0, colorf::WHITE + 255, 0, LALIGN_JUSTIFY, 0, 0);
+
+        std::vector<std::string> chatList;
+        for(int i = 0; i < chatCount; ++i){
+            std::string text = "player" + std::to_string(i % 37) + ": ";
+            for(int j = 0, charCount = 4 + rng() % 60; j < charCount; ++j){
+                text += tokenList[rng() % tokenList.size()];
+            }
+            chatList.push_back(buildChatXML((rng() % 5) ? 0 : 1, text));
+        }
+
+        std::printf("chat   : %d messages\n", chatCount);
+        const int blockSize = std::max<int>(1, chatCount / 10);
+
+        for(int i = 0; i < chatCount; i += blockSize){
+            const int currCount = std::min<int>(blockSize, chatCount - i);
+            const hres_timer timer;
+
+            for(int j = i; j < i + currCount; ++j){
+                logBoard.addParXML(logBoard.parCount(), {0, 0, 0, 0}, chatList[j].c_str());
+            }
+            std::printf("         %6d - %6d : %8.2f us/message, board height %d\n", i, i + currCount, timer.diff_nsec() / 1000.0 / currCount, logBoard.h());
+        }
+
+        delete g_fontexDB;
+        delete g_sdlDevice;
+    }
+    catch(const std::exception &e){
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
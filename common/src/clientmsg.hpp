@@ -42,6 +42,7 @@ enum CMType: uint8_t
     CM_ACCOUNT,
     CM_NPCEVENT,
     CM_QUERYSELLITEM,
+    CM_NETCAPS,
     CM_END,
 };
 
@@ -116,6 +117,13 @@ struct CMQuerySellItem
     uint64_t npcUID;
     uint32_t itemID;
 };
+
+struct CMNetCaps
+{
+    // NETCAP_XXX requested by client
+    // handled by Channel and won't be forwarded to actors
+    uint32_t caps;
+};
 #pragma pack(pop)
 
 // I was using class name ClientMessage
@@ -152,6 +160,7 @@ class ClientMsg final: public MsgBase
                 _add_client_msg_type_case(CM_ACCOUNT,            1, sizeof(CMAccount)           )
                 _add_client_msg_type_case(CM_NPCEVENT,           1, sizeof(CMNPCEvent)          )
                 _add_client_msg_type_case(CM_QUERYSELLITEM,      1, sizeof(CMQuerySellItem)     )
+                _add_client_msg_type_case(CM_NETCAPS,            2, sizeof(CMNetCaps)           )
 #undef _add_client_msg_type_case
             };
 
@@ -174,7 +183,8 @@ class ClientMsg final: public MsgBase
                     || std::is_same_v<T, CMPickUp>
                     || std::is_same_v<T, CMAccount>
                     || std::is_same_v<T, CMNPCEvent>
-                    || std::is_same_v<T, CMQuerySellItem>);
+                    || std::is_same_v<T, CMQuerySellItem>
+                    || std::is_same_v<T, CMNetCaps>);
 
             if(bufLen && bufLen != sizeof(T)){
                 throw fflerror("invalid buffer length");
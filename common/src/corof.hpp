@@ -71,6 +71,11 @@ namespace corof
         public:
             inline bool poll_one();
 
+        public:
+            // remaining msec the innermost coroutine sleeps by async_wait()
+            // caller can skip poll_one() until then, resume before that does nothing but suspend again
+            inline uint64_t wait_msec() const;
+
         private:
             static inline handle_type find_handle(handle_type);
 
@@ -141,6 +146,19 @@ namespace corof
             long_jmper::handle_type m_inner_handle;
             long_jmper::handle_type m_outer_handle;
 
+        private:
+            // setup by async_wait() when suspended
+            // timer lives in coroutine frame and outlives the suspension
+            const hres_timer *m_wait_timer = nullptr;
+            uint64_t m_wait_msec = 0;
+
+        public:
+            void set_wait(const hres_timer *timer, uint64_t msec)
+            {
+                m_wait_timer = timer;
+                m_wait_msec  = msec;
+            }
+
         public:
             template<typename T> T &get_value()
             {
@@ -224,6 +242,26 @@ namespace corof
         return m_handle.done();
     }
 
+    inline uint64_t long_jmper::wait_msec() const
+    {
+        if(!m_handle){
+            throw fflerror("long_jmper has no eval-context associated");
+        }
+
+        const auto curr_handle = find_handle(m_handle);
+        if(curr_handle.done()){
+            return 0;
+        }
+
+        const auto &promise = curr_handle.promise();
+        if(!promise.m_wait_timer){
+            return 0;
+        }
+
+        const auto diff_msec = promise.m_wait_timer->diff_msec();
+        return (diff_msec < promise.m_wait_msec) ? (promise.m_wait_msec - diff_msec) : 0;
+    }
+
     // inline bool long_jmper::poll_one()
     // {
     //     if(!m_handle){
@@ -317,6 +355,40 @@ namespace corof
             }
     };
 
+    class [[nodiscard]] wait_op
+    {
+        private:
+            const hres_timer *m_timer;
+            const uint64_t    m_msec;
+
+        private:
+            long_jmper::handle_type m_handle;
+
+        public:
+            wait_op(const hres_timer *timer, uint64_t msec) noexcept
+                : m_timer(timer)
+                , m_msec(msec)
+                , m_handle(nullptr)
+            {}
+
+        public:
+            bool await_ready() noexcept
+            {
+                return false;
+            }
+
+            void await_suspend(long_jmper::handle_type handle) noexcept
+            {
+                m_handle = handle;
+                m_handle.promise().set_wait(m_timer, m_msec);
+            }
+
+            void await_resume() noexcept
+            {
+                m_handle.promise().set_wait(nullptr, 0);
+            }
+    };
+
     inline auto async_wait(uint64_t msec) noexcept
     {
         const auto fnwait = +[](uint64_t msec) -> corof::long_jmper
@@ -329,7 +401,7 @@ namespace corof
             else{
                 hres_timer timer;
                 while(timer.diff_msec() < msec){
-                    co_await std::suspend_always{};
+                    co_await corof::wait_op(&timer, msec);
                     count++;
                 }
             }
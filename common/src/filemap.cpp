@@ -0,0 +1,110 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: filemap.cpp
+ *        Created: 10/17/2026 16:05:37
+ *    Description:
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include <cerrno>
+#include <cstring>
+#include "filemap.hpp"
+#include "fflerror.hpp"
+
+#if defined(_WIN32)
+FileMap::FileMap(const char *path)
+{
+    if(!path){
+        throw fflerror("null file path");
+    }
+
+    const auto fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(fileHandle == INVALID_HANDLE_VALUE){
+        throw fflerror("failed to open file: %s", path);
+    }
+
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart <= 0){
+        CloseHandle(fileHandle);
+        throw fflerror("failed to get file size: %s", path);
+    }
+
+    const auto mapHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(!mapHandle){
+        CloseHandle(fileHandle);
+        throw fflerror("failed to create file mapping: %s", path);
+    }
+
+    const auto dataPtr = MapViewOfFile(mapHandle, FILE_MAP_READ, 0, 0, 0);
+    if(!dataPtr){
+        CloseHandle(mapHandle);
+        CloseHandle(fileHandle);
+        throw fflerror("failed to map file: %s", path);
+    }
+
+    m_data = (const uint8_t *)(dataPtr);
+    m_size = (size_t)(fileSize.QuadPart);
+
+    m_fileHandle = fileHandle;
+    m_mapHandle  = mapHandle;
+}
+
+FileMap::~FileMap()
+{
+    UnmapViewOfFile(m_data);
+    CloseHandle(m_mapHandle);
+    CloseHandle(m_fileHandle);
+}
+#else
+FileMap::FileMap(const char *path)
+{
+    if(!path){
+        throw fflerror("null file path");
+    }
+
+    const int fd = open(path, O_RDONLY);
+    if(fd < 0){
+        throw fflerror("failed to open file: %s: %s", path, std::strerror(errno));
+    }
+
+    struct stat fileStat;
+    if(fstat(fd, &fileStat) || fileStat.st_size <= 0){
+        close(fd);
+        throw fflerror("failed to get file size: %s", path);
+    }
+
+    const auto dataPtr = mmap(nullptr, (size_t)(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if(dataPtr == MAP_FAILED){
+        throw fflerror("failed to map file: %s: %s", path, std::strerror(errno));
+    }
+
+    m_data = (const uint8_t *)(dataPtr);
+    m_size = (size_t)(fileStat.st_size);
+}
+
+FileMap::~FileMap()
+{
+    munmap((void *)(m_data), m_size);
+}
+#endif
@@ -0,0 +1,56 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: filemap.hpp
+ *        Created: 10/17/2026 16:05:37
+ *    Description: map a whole file into memory for read-only access
+ *                 data stays valid until the object gets destroyed
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+class FileMap final
+{
+    private:
+        const uint8_t *m_data = nullptr;
+        size_t         m_size = 0;
+
+    private:
+        // platform handles
+        // windows needs both the file and the mapping object
+        void *m_fileHandle = nullptr;
+        void *m_mapHandle  = nullptr;
+
+    public:
+        FileMap(const char *);
+
+    public:
+        ~FileMap();
+
+    public:
+        FileMap(const FileMap &) = delete;
+        FileMap &operator = (const FileMap &) = delete;
+
+    public:
+        const uint8_t *data() const
+        {
+            return m_data;
+        }
+
+        size_t size() const
+        {
+            return m_size;
+        }
+};
@@ -82,7 +82,14 @@ template<typename KeyT, typename ResT> class innDB
         }
 
     protected:
-        bool RetrieveResource(KeyT nKey, ResT *pResource)
+        bool HasResource(KeyT nKey) const
+        {
+            return m_cache.find(nKey) != m_cache.end();
+        }
+
+        // only check the cache
+        // won't call loadResource() if not found
+        bool PeekResource(KeyT nKey, ResT *pResource)
         {
             if(auto p = m_cache.find(nKey); p != m_cache.end()){
                 if(pResource){
@@ -93,8 +100,17 @@ template<typename KeyT, typename ResT> class innDB
                 }
                 return true;
             }
+            return false;
+        }
 
-            auto [stResource, nWeight] = loadResource(nKey);
+        // add resource loaded outside of loadResource()
+        // if the key is already loaded the provided resource gets freed
+        void AddResource(KeyT nKey, ResT stResource, size_t nWeight)
+        {
+            if(HasResource(nKey)){
+                freeResource(stResource);
+                return;
+            }
 
             if(m_resMax){
                 m_DLink.PushHead(nKey);
@@ -113,6 +129,16 @@ template<typename KeyT, typename ResT> class innDB
                     Resize();
                 }
             }
+        }
+
+        bool RetrieveResource(KeyT nKey, ResT *pResource)
+        {
+            if(PeekResource(nKey, pResource)){
+                return true;
+            }
+
+            auto [stResource, nWeight] = loadResource(nKey);
+            AddResource(nKey, stResource, nWeight);
 
             if(pResource){
                 *pResource = stResource;
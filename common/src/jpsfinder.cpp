@@ -0,0 +1,692 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: jpsfinder.cpp
+ *        Created: 10/16/2026 23:10:42
+ *    Description:
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+#include <array>
+#include <queue>
+#include <climits>
+#include <unordered_map>
+#include "mathf.hpp"
+#include "fflerror.hpp"
+#include "jpsfinder.hpp"
+
+// min-heap of (f, node)
+using JPSOpenList = std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>, std::greater<std::pair<int, int>>>;
+
+// search state of JPSFinder, shared by all finders in one thread
+// indexed by grid offset inside the search window, grows to the largest window searched by this thread
+// a node is valid only if its stamp equals to current search ID, then no clear needed
+struct JPSScratch
+{
+    uint32_t searchID = 0;
+    std::vector<uint32_t> stampList;
+    std::vector<uint32_t> closeList;
+    std::vector<int> costList;
+    std::vector<int> parentList;
+};
+
+static thread_local JPSScratch t_jpsScratch;
+
+PathFind::GridMask::GridMask(int nW, int nH, const std::function<bool(int, int)> &fnWalkable)
+    : m_w(nW)
+    , m_h(nH)
+    , m_mask()
+{
+    if(nW <= 0 || nH <= 0){
+        throw fflerror("invalid grid mask size: (%d, %d)", nW, nH);
+    }
+
+    if(!fnWalkable){
+        throw fflerror("grid mask requires a walkable function");
+    }
+
+    m_mask.resize((size_t)(nW) * nH, 0);
+    for(int nY = 0; nY < nH; ++nY){
+        for(int nX = 0; nX < nW; ++nX){
+            m_mask[nX + nY * nW] = fnWalkable(nX, nY) ? 1 : 0;
+        }
+    }
+}
+
+PathFind::JPSFinder::JPSFinder(const PathFind::GridMask &rstMask)
+    : m_mask(rstMask)
+{}
+
+int PathFind::JPSFinder::jump(int nX, int nY, int nDX, int nDY, int nGoalX, int nGoalY) const
+{
+    // (nX, nY) is the first grid after moving one step from parent
+    // straight jump is a plain loop, diagonal jump calls straight jump only, no deep recursion
+
+    while(true){
+        if(!walkable(nX, nY)){
+            return -1;
+        }
+
+        if(nX == nGoalX && nY == nGoalY){
+            return windowIndex(nX, nY);
+        }
+
+        if(nDX && nDY){
+            if(false
+                    || ( walkable(nX - nDX, nY + nDY) && !walkable(nX - nDX, nY))
+                    || ( walkable(nX + nDX, nY - nDY) && !walkable(nX, nY - nDY))){
+                return windowIndex(nX, nY);
+            }
+
+            if(jump(nX + nDX, nY, nDX, 0, nGoalX, nGoalY) >= 0 || jump(nX, nY + nDY, 0, nDY, nGoalX, nGoalY) >= 0){
+                return windowIndex(nX, nY);
+            }
+        }
+        else if(nDX){
+            if(false
+                    || (walkable(nX + nDX, nY + 1) && !walkable(nX, nY + 1))
+                    || (walkable(nX + nDX, nY - 1) && !walkable(nX, nY - 1))){
+                return windowIndex(nX, nY);
+            }
+        }
+        else{
+            if(false
+                    || (walkable(nX + 1, nY + nDY) && !walkable(nX + 1, nY))
+                    || (walkable(nX - 1, nY + nDY) && !walkable(nX - 1, nY))){
+                return windowIndex(nX, nY);
+            }
+        }
+
+        nX += nDX;
+        nY += nDY;
+    }
+}
+
+bool PathFind::JPSFinder::doSearch(int nX0, int nY0, int nX1, int nY1, const PathFind::GridRegion &rstRegion)
+{
+    // clip search window to the map
+    const int nRegionX0 = std::max<int>(rstRegion.X, 0);
+    const int nRegionY0 = std::max<int>(rstRegion.Y, 0);
+    const int nRegionX1 = std::min<int>(rstRegion.X + rstRegion.W, m_mask.W());
+    const int nRegionY1 = std::min<int>(rstRegion.Y + rstRegion.H, m_mask.H());
+
+    if(nRegionX0 >= nRegionX1 || nRegionY0 >= nRegionY1){
+        return false;
+    }
+
+    m_region = {nRegionX0, nRegionY0, nRegionX1 - nRegionX0, nRegionY1 - nRegionY0};
+    if(!(m_region.in(nX0, nY0) && walkable(nX1, nY1))){
+        return false;
+    }
+
+    auto &rstScratch = t_jpsScratch;
+    if(const size_t nWindowSize = (size_t)(m_region.W) * m_region.H; rstScratch.stampList.size() < nWindowSize){
+        rstScratch.stampList .resize(nWindowSize, 0);
+        rstScratch.closeList .resize(nWindowSize, 0);
+        rstScratch.costList  .resize(nWindowSize, 0);
+        rstScratch.parentList.resize(nWindowSize, -1);
+    }
+
+    if(++rstScratch.searchID == 0){
+        std::fill(rstScratch.stampList.begin(), rstScratch.stampList.end(), 0);
+        std::fill(rstScratch.closeList.begin(), rstScratch.closeList.end(), 0);
+        rstScratch.searchID = 1;
+    }
+
+    const uint32_t nSearchID = rstScratch.searchID;
+    auto &stStampList  = rstScratch.stampList;
+    auto &stCloseList  = rstScratch.closeList;
+    auto &stCostList   = rstScratch.costList;
+    auto &stParentList = rstScratch.parentList;
+
+    const int nW = m_region.W;
+    const int nStart = windowIndex(nX0, nY0);
+
+    stStampList [nStart] = nSearchID;
+    stCostList  [nStart] = 0;
+    stParentList[nStart] = -1;
+
+    JPSOpenList stOpenList;
+    stOpenList.emplace(octileCost(nX0, nY0, nX1, nY1), nStart);
+
+    while(!stOpenList.empty()){
+        const int nCurr = stOpenList.top().second;
+        stOpenList.pop();
+
+        if(stCloseList[nCurr] == nSearchID){
+            continue;
+        }
+        stCloseList[nCurr] = nSearchID;
+
+        const int nX = m_region.X + nCurr % nW;
+        const int nY = m_region.Y + nCurr / nW;
+
+        if(nX == nX1 && nY == nY1){
+            return true;
+        }
+
+        int nDirCount = 0;
+        std::array<std::pair<int, int>, 8> stDirList;
+
+        const auto fnAddDir = [&nDirCount, &stDirList](int nDX, int nDY)
+        {
+            stDirList[nDirCount++] = {nDX, nDY};
+        };
+
+        if(const int nParent = stParentList[nCurr]; nParent < 0){
+            for(int nDY = -1; nDY <= 1; ++nDY){
+                for(int nDX = -1; nDX <= 1; ++nDX){
+                    if((nDX || nDY) && walkable(nX + nDX, nY + nDY)){
+                        fnAddDir(nDX, nDY);
+                    }
+                }
+            }
+        }
+        else{
+            // prune neighbors by the direction from parent
+            // keep natural neighbors and forced neighbors only
+
+            const int nPX = m_region.X + nParent % nW;
+            const int nPY = m_region.Y + nParent / nW;
+            const int nDX = (nX > nPX) - (nX < nPX);
+            const int nDY = (nY > nPY) - (nY < nPY);
+
+            if(nDX && nDY){
+                if(walkable(nX, nY + nDY)){
+                    fnAddDir(0, nDY);
+                }
+
+                if(walkable(nX + nDX, nY)){
+                    fnAddDir(nDX, 0);
+                }
+
+                if(walkable(nX + nDX, nY + nDY)){
+                    fnAddDir(nDX, nDY);
+                }
+
+                if(!walkable(nX - nDX, nY) && walkable(nX - nDX, nY + nDY)){
+                    fnAddDir(-nDX, nDY);
+                }
+
+                if(!walkable(nX, nY - nDY) && walkable(nX + nDX, nY - nDY)){
+                    fnAddDir(nDX, -nDY);
+                }
+            }
+            else if(nDX){
+                if(walkable(nX + nDX, nY)){
+                    fnAddDir(nDX, 0);
+                }
+
+                if(!walkable(nX, nY + 1) && walkable(nX + nDX, nY + 1)){
+                    fnAddDir(nDX, 1);
+                }
+
+                if(!walkable(nX, nY - 1) && walkable(nX + nDX, nY - 1)){
+                    fnAddDir(nDX, -1);
+                }
+            }
+            else{
+                if(walkable(nX, nY + nDY)){
+                    fnAddDir(0, nDY);
+                }
+
+                if(!walkable(nX + 1, nY) && walkable(nX + 1, nY + nDY)){
+                    fnAddDir(1, nDY);
+                }
+
+                if(!walkable(nX - 1, nY) && walkable(nX - 1, nY + nDY)){
+                    fnAddDir(-1, nDY);
+                }
+            }
+        }
+
+        for(int nIndex = 0; nIndex < nDirCount; ++nIndex){
+            const auto [nDX, nDY] = stDirList[nIndex];
+            const int nJump = jump(nX + nDX, nY + nDY, nDX, nDY, nX1, nY1);
+
+            if(nJump < 0 || stCloseList[nJump] == nSearchID){
+                continue;
+            }
+
+            const int nJX = m_region.X + nJump % nW;
+            const int nJY = m_region.Y + nJump / nW;
+            const int nCost = stCostList[nCurr] + octileCost(nX, nY, nJX, nJY);
+
+            if(stStampList[nJump] != nSearchID || nCost < stCostList[nJump]){
+                stStampList [nJump] = nSearchID;
+                stCostList  [nJump] = nCost;
+                stParentList[nJump] = nCurr;
+                stOpenList.emplace(nCost + octileCost(nJX, nJY, nX1, nY1), nJump);
+            }
+        }
+    }
+    return false;
+}
+
+std::vector<PathFind::PathNode> PathFind::JPSFinder::search(int nX0, int nY0, int nX1, int nY1)
+{
+    return search(nX0, nY0, nX1, nY1, {0, 0, m_mask.W(), m_mask.H()});
+}
+
+std::vector<PathFind::PathNode> PathFind::JPSFinder::search(int nX0, int nY0, int nX1, int nY1, const PathFind::GridRegion &rstRegion)
+{
+    if(nX0 == nX1 && nY0 == nY1){
+        return {{nX0, nY0}};
+    }
+
+    if(!doSearch(nX0, nY0, nX1, nY1, rstRegion)){
+        return {};
+    }
+
+    // collect jump points backward
+    // two adjacent jump points are always on a straight or diagonal line
+
+    // parents are in window index of the search just done
+    const int nW = m_region.W;
+    const auto &rstParentList = t_jpsScratch.parentList;
+    std::vector<int> stJumpList;
+
+    for(int nCurr = windowIndex(nX1, nY1); nCurr >= 0; nCurr = rstParentList[nCurr]){
+        stJumpList.push_back(nCurr);
+    }
+
+    std::vector<PathNode> stPathList {{nX0, nY0}};
+    for(auto p = stJumpList.rbegin() + 1; p != stJumpList.rend(); ++p){
+        const int nEndX = m_region.X + *p % nW;
+        const int nEndY = m_region.Y + *p / nW;
+
+        int nCurrX = stPathList.back().X;
+        int nCurrY = stPathList.back().Y;
+
+        const int nDX = (nEndX > nCurrX) - (nEndX < nCurrX);
+        const int nDY = (nEndY > nCurrY) - (nEndY < nCurrY);
+
+        while(nCurrX != nEndX || nCurrY != nEndY){
+            nCurrX += nDX;
+            nCurrY += nDY;
+            stPathList.emplace_back(nCurrX, nCurrY);
+        }
+    }
+    return stPathList;
+}
+
+PathFind::HPAGraph::HPAGraph(int nW, int nH, const std::function<bool(int, int)> &fnWalkable, int nClusterSize)
+    : m_mask(nW, nH, fnWalkable)
+    , m_clusterSize(std::max<int>(nClusterSize, 4))
+    , m_clusterW((nW + m_clusterSize - 1) / m_clusterSize)
+    , m_clusterH((nH + m_clusterSize - 1) / m_clusterSize)
+    , m_nodeList()
+    , m_clusterNodeList((size_t)(m_clusterW) * m_clusterH)
+    , m_clusterDoneList((size_t)(m_clusterW) * m_clusterH, 0)
+    , m_finder(m_mask)
+{
+    buildEntrance();
+}
+
+PathFind::GridRegion PathFind::HPAGraph::clusterRegion(int nCluster) const
+{
+    const int nX = (nCluster % m_clusterW) * m_clusterSize;
+    const int nY = (nCluster / m_clusterW) * m_clusterSize;
+
+    return {nX, nY, std::min<int>(m_clusterSize, m_mask.W() - nX), std::min<int>(m_clusterSize, m_mask.H() - nY)};
+}
+
+void PathFind::HPAGraph::buildEntrance()
+{
+    // one grid can be on two borders at cluster corner
+    // reuse its node instead of creating a new one
+    std::unordered_map<int, int> stNodeIndex;
+
+    const auto fnAddNode = [this, &stNodeIndex](int nX, int nY) -> int
+    {
+        if(auto p = stNodeIndex.find(nX + nY * m_mask.W()); p != stNodeIndex.end()){
+            return p->second;
+        }
+
+        const int nNode = (int)(m_nodeList.size());
+        const int nCluster = clusterIndex(nX, nY);
+
+        m_nodeList.push_back({nX, nY, nCluster, {}});
+        m_clusterNodeList[nCluster].push_back(nNode);
+
+        stNodeIndex[nX + nY * m_mask.W()] = nNode;
+        return nNode;
+    };
+
+    const auto fnAddTransition = [this, &fnAddNode](int nX0, int nY0, int nX1, int nY1)
+    {
+        const int nNode0 = fnAddNode(nX0, nY0);
+        const int nNode1 = fnAddNode(nX1, nY1);
+        const int nCost  = JPSFinder::octileCost(nX0, nY0, nX1, nY1);
+
+        m_nodeList[nNode0].edgeList.push_back({nNode1, nCost});
+        m_nodeList[nNode1].edgeList.push_back({nNode0, nCost});
+    };
+
+    // scan grids along one border, fnOpen(i) tells if both sides of i are walkable
+    // short entrance gets one transition at middle, long entrance gets two at both ends
+    const auto fnScanBorder = [](int nBegin, int nEnd, const auto &fnOpen, const auto &fnTransition)
+    {
+        for(int nIndex = nBegin; nIndex < nEnd;){
+            if(!fnOpen(nIndex)){
+                nIndex++;
+                continue;
+            }
+
+            const int nRunBegin = nIndex;
+            while(nIndex < nEnd && fnOpen(nIndex)){
+                nIndex++;
+            }
+
+            if(nIndex - nRunBegin < 6){
+                fnTransition((nRunBegin + nIndex - 1) / 2);
+            }
+            else{
+                fnTransition(nRunBegin);
+                fnTransition(nIndex - 1);
+            }
+        }
+    };
+
+    for(int nCY = 0; nCY < m_clusterH; ++nCY){
+        for(int nCX = 0; nCX < m_clusterW; ++nCX){
+            const int nBeginX = nCX * m_clusterSize;
+            const int nBeginY = nCY * m_clusterSize;
+            const int nEndX = std::min<int>(nBeginX + m_clusterSize, m_mask.W());
+            const int nEndY = std::min<int>(nBeginY + m_clusterSize, m_mask.H());
+
+            // right border
+            if(nEndX < m_mask.W()){
+                fnScanBorder(nBeginY, nEndY, [this, nEndX](int nY)
+                {
+                    return m_mask.walkable(nEndX - 1, nY) && m_mask.walkable(nEndX, nY);
+                },
+
+                [&fnAddTransition, nEndX](int nY)
+                {
+                    fnAddTransition(nEndX - 1, nY, nEndX, nY);
+                });
+            }
+
+            // bottom border
+            if(nEndY < m_mask.H()){
+                fnScanBorder(nBeginX, nEndX, [this, nEndY](int nX)
+                {
+                    return m_mask.walkable(nX, nEndY - 1) && m_mask.walkable(nX, nEndY);
+                },
+
+                [&fnAddTransition, nEndY](int nX)
+                {
+                    fnAddTransition(nX, nEndY - 1, nX, nEndY);
+                });
+            }
+        }
+    }
+}
+
+void PathFind::HPAGraph::clusterCost(int nX, int nY, std::vector<int> &stCostList) const
+{
+    // plain dijkstra inside one cluster
+    // one pass gives costs to all entrances, cheaper than one JPS for each pair
+
+    const auto stRegion = clusterRegion(clusterIndex(nX, nY));
+    stCostList.assign((size_t)(stRegion.W) * stRegion.H, -1);
+
+    JPSOpenList stOpenList;
+    stOpenList.emplace(0, (nX - stRegion.X) + (nY - stRegion.Y) * stRegion.W);
+
+    while(!stOpenList.empty()){
+        const auto [nCost, nCurr] = stOpenList.top();
+        stOpenList.pop();
+
+        if(stCostList[nCurr] >= 0){
+            continue;
+        }
+        stCostList[nCurr] = nCost;
+
+        const int nCurrX = stRegion.X + nCurr % stRegion.W;
+        const int nCurrY = stRegion.Y + nCurr / stRegion.W;
+
+        for(int nDY = -1; nDY <= 1; ++nDY){
+            for(int nDX = -1; nDX <= 1; ++nDX){
+                const int nNextX = nCurrX + nDX;
+                const int nNextY = nCurrY + nDY;
+
+                if((nDX || nDY) && stRegion.in(nNextX, nNextY) && m_mask.walkable(nNextX, nNextY)){
+                    if(const int nNext = (nNextX - stRegion.X) + (nNextY - stRegion.Y) * stRegion.W; stCostList[nNext] < 0){
+                        stOpenList.emplace(nCost + ((nDX && nDY) ? 14 : 10), nNext);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void PathFind::HPAGraph::buildIntraEdge(int nCluster)
+{
+    if(m_clusterDoneList[nCluster]){
+        return;
+    }
+    m_clusterDoneList[nCluster] = 1;
+
+    std::vector<int> stCostList;
+    const auto stRegion = clusterRegion(nCluster);
+
+    for(const int nSrc: m_clusterNodeList[nCluster]){
+        clusterCost(m_nodeList[nSrc].X, m_nodeList[nSrc].Y, stCostList);
+        for(const int nDst: m_clusterNodeList[nCluster]){
+            if(nDst == nSrc){
+                continue;
+            }
+
+            if(const int nCost = stCostList[(m_nodeList[nDst].X - stRegion.X) + (m_nodeList[nDst].Y - stRegion.Y) * stRegion.W]; nCost >= 0){
+                m_nodeList[nSrc].edgeList.push_back({nDst, nCost});
+            }
+        }
+    }
+}
+
+bool PathFind::HPAGraph::searchAbstract(int nX0, int nY0, int nX1, int nY1, std::vector<int> &stNodeList)
+{
+    // start and goal are inserted as temporary nodes
+    // edges to them are not stored in the graph
+
+    const int nStart = (int)(m_nodeList.size());
+    const int nGoal  = (int)(m_nodeList.size()) + 1;
+
+    const int nStartCluster = clusterIndex(nX0, nY0);
+    const int nGoalCluster  = clusterIndex(nX1, nY1);
+
+    std::vector<int> stCostList;
+    std::vector<AbstractEdge> stStartEdgeList;
+    std::vector<AbstractEdge> stGoalEdgeList;
+
+    const auto fnLocalCost = [this, &stCostList](int nCluster, int nX, int nY) -> int
+    {
+        const auto stRegion = clusterRegion(nCluster);
+        return stCostList[(nX - stRegion.X) + (nY - stRegion.Y) * stRegion.W];
+    };
+
+    clusterCost(nX0, nY0, stCostList);
+    for(const int nNode: m_clusterNodeList[nStartCluster]){
+        if(const int nCost = fnLocalCost(nStartCluster, m_nodeList[nNode].X, m_nodeList[nNode].Y); nCost >= 0){
+            stStartEdgeList.push_back({nNode, nCost});
+        }
+    }
+
+    if(nStartCluster == nGoalCluster){
+        if(const int nCost = fnLocalCost(nStartCluster, nX1, nY1); nCost >= 0){
+            stStartEdgeList.push_back({nGoal, nCost});
+        }
+    }
+
+    // grid is undirected, cost from goal equals to cost to goal
+    clusterCost(nX1, nY1, stCostList);
+    for(const int nNode: m_clusterNodeList[nGoalCluster]){
+        if(const int nCost = fnLocalCost(nGoalCluster, m_nodeList[nNode].X, m_nodeList[nNode].Y); nCost >= 0){
+            stGoalEdgeList.push_back({nNode, nCost});
+        }
+    }
+
+    const auto fnNodeX = [this, nStart, nX0, nX1](int nNode) -> int
+    {
+        return (nNode < nStart) ? m_nodeList[nNode].X : ((nNode == nStart) ? nX0 : nX1);
+    };
+
+    const auto fnNodeY = [this, nStart, nY0, nY1](int nNode) -> int
+    {
+        return (nNode < nStart) ? m_nodeList[nNode].Y : ((nNode == nStart) ? nY0 : nY1);
+    };
+
+    std::vector<int> stGList(m_nodeList.size() + 2, INT_MAX);
+    std::vector<int> stParentList(m_nodeList.size() + 2, -1);
+    std::vector<uint8_t> stCloseList(m_nodeList.size() + 2, 0);
+
+    JPSOpenList stOpenList;
+    stGList[nStart] = 0;
+    stOpenList.emplace(JPSFinder::octileCost(nX0, nY0, nX1, nY1), nStart);
+
+    while(!stOpenList.empty()){
+        const int nCurr = stOpenList.top().second;
+        stOpenList.pop();
+
+        if(stCloseList[nCurr]){
+            continue;
+        }
+        stCloseList[nCurr] = 1;
+
+        if(nCurr == nGoal){
+            stNodeList.clear();
+            for(int nNode = stParentList[nGoal]; nNode >= 0 && nNode != nStart; nNode = stParentList[nNode]){
+                stNodeList.push_back(nNode);
+            }
+
+            std::reverse(stNodeList.begin(), stNodeList.end());
+            return true;
+        }
+
+        const auto fnRelax = [&](int nNext, int nCost)
+        {
+            if(!stCloseList[nNext] && stGList[nCurr] + nCost < stGList[nNext]){
+                stGList[nNext] = stGList[nCurr] + nCost;
+                stParentList[nNext] = nCurr;
+                stOpenList.emplace(stGList[nNext] + JPSFinder::octileCost(fnNodeX(nNext), fnNodeY(nNext), nX1, nY1), nNext);
+            }
+        };
+
+        if(nCurr == nStart){
+            for(const auto &rstEdge: stStartEdgeList){
+                fnRelax(rstEdge.node, rstEdge.cost);
+            }
+            continue;
+        }
+
+        buildIntraEdge(m_nodeList[nCurr].cluster);
+        for(const auto &rstEdge: m_nodeList[nCurr].edgeList){
+            fnRelax(rstEdge.node, rstEdge.cost);
+        }
+
+        if(m_nodeList[nCurr].cluster == nGoalCluster){
+            for(const auto &rstEdge: stGoalEdgeList){
+                if(rstEdge.node == nCurr){
+                    fnRelax(nGoal, rstEdge.cost);
+                    break;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+std::vector<PathFind::PathNode> PathFind::HPAGraph::search(int nX0, int nY0, int nX1, int nY1)
+{
+    if(!(m_mask.walkable(nX1, nY1) && nX0 >= 0 && nX0 < m_mask.W() && nY0 >= 0 && nY0 < m_mask.H())){
+        return {};
+    }
+
+    if(nX0 == nX1 && nY0 == nY1){
+        return {{nX0, nY0}};
+    }
+
+    const int nCX0 = nX0 / m_clusterSize;
+    const int nCY0 = nY0 / m_clusterSize;
+    const int nCX1 = nX1 / m_clusterSize;
+    const int nCY1 = nY1 / m_clusterSize;
+
+    // start and goal are close
+    // search in their clusters with one cluster margin, exact and cheap
+    if(std::abs(nCX0 - nCX1) <= 1 && std::abs(nCY0 - nCY1) <= 1){
+        const int nRegionX0 = std::max<int>(std::min<int>(nCX0, nCX1) - 1, 0) * m_clusterSize;
+        const int nRegionY0 = std::max<int>(std::min<int>(nCY0, nCY1) - 1, 0) * m_clusterSize;
+        const int nRegionX1 = std::min<int>((std::max<int>(nCX0, nCX1) + 2) * m_clusterSize, m_mask.W());
+        const int nRegionY1 = std::min<int>((std::max<int>(nCY0, nCY1) + 2) * m_clusterSize, m_mask.H());
+
+        if(auto stPathList = m_finder.search(nX0, nY0, nX1, nY1, {nRegionX0, nRegionY0, nRegionX1 - nRegionX0, nRegionY1 - nRegionY0}); !stPathList.empty()){
+            return stPathList;
+        }
+    }
+
+    if(std::vector<int> stNodeList; searchAbstract(nX0, nY0, nX1, nY1, stNodeList)){
+        std::vector<PathNode> stWayPointList {{nX0, nY0}};
+        for(const int nNode: stNodeList){
+            stWayPointList.emplace_back(m_nodeList[nNode].X, m_nodeList[nNode].Y);
+        }
+        stWayPointList.emplace_back(nX1, nY1);
+
+        // refine each abstract edge
+        // transition edge connects two neighbor grids, intra edge stays inside one cluster
+        bool bRefined = true;
+        std::vector<PathNode> stPathList {{nX0, nY0}};
+
+        for(size_t nIndex = 1; bRefined && nIndex < stWayPointList.size(); ++nIndex){
+            const auto &rstSrc = stWayPointList[nIndex - 1];
+            const auto &rstDst = stWayPointList[nIndex];
+
+            switch(mathf::LDistance2(rstSrc.X, rstSrc.Y, rstDst.X, rstDst.Y)){
+                case 0:
+                    {
+                        break;
+                    }
+                case 1:
+                case 2:
+                    {
+                        stPathList.push_back(rstDst);
+                        break;
+                    }
+                default:
+                    {
+                        if(auto stSubPathList = m_finder.search(rstSrc.X, rstSrc.Y, rstDst.X, rstDst.Y, clusterRegion(clusterIndex(rstSrc.X, rstSrc.Y))); !stSubPathList.empty()){
+                            stPathList.insert(stPathList.end(), stSubPathList.begin() + 1, stSubPathList.end());
+                        }
+                        else{
+                            bRefined = false;
+                        }
+                        break;
+                    }
+            }
+        }
+
+        if(bRefined){
+            return stPathList;
+        }
+    }
+
+    // entrance only counts straight crossing
+    // diagonal-only crossing between clusters is missed by the abstract graph
+    // search bounding box of start and goal with margin, never the whole map, a miss here is left to the caller's fallback
+    const int nMargin = 2 * m_clusterSize;
+    const int nRegionX0 = std::max<int>(std::min<int>(nX0, nX1) - nMargin, 0);
+    const int nRegionY0 = std::max<int>(std::min<int>(nY0, nY1) - nMargin, 0);
+    const int nRegionX1 = std::min<int>(std::max<int>(nX0, nX1) + nMargin + 1, m_mask.W());
+    const int nRegionY1 = std::min<int>(std::max<int>(nY0, nY1) + nMargin + 1, m_mask.H());
+
+    return m_finder.search(nX0, nY0, nX1, nY1, {nRegionX0, nRegionY0, nRegionX1 - nRegionX0, nRegionY1 - nRegionY0});
+}
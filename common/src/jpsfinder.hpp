@@ -0,0 +1,198 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: jpsfinder.hpp
+ *        Created: 10/16/2026 23:10:42
+ *    Description: grid-specialized path finding on static walkability
+ *
+ *                 JPSFinder : jump point search, 8-connected and diagonal move can cut corners,
+ *                             same as ServerMap::OneStepCost() which only checks the dst grid
+ *                 HPAGraph  : map is split into clusters, entrances on cluster borders become
+ *                             abstract nodes, long path is searched on the abstract graph and
+ *                             refined by JPS inside each cluster
+ *
+ *                 both only know the static walkability, creatures and locks are checked by
+ *                 the caller on the returned path
+ *
+ *                 cost uses octile distance: straight step 10, diagonal step 14
+ *                 returned path always has unit steps and includes the start and end points
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <functional>
+#include "pathfinder.hpp"
+
+namespace PathFind
+{
+    class GridMask final
+    {
+        private:
+            const int m_w;
+            const int m_h;
+
+        private:
+            std::vector<uint8_t> m_mask;
+
+        public:
+            GridMask(int, int, const std::function<bool(int, int)> &);
+
+        public:
+            int W() const { return m_w; }
+            int H() const { return m_h; }
+
+        public:
+            bool walkable(int nX, int nY) const
+            {
+                return nX >= 0 && nX < m_w && nY >= 0 && nY < m_h && m_mask[nX + nY * m_w];
+            }
+    };
+
+    struct GridRegion final
+    {
+        int X = 0;
+        int Y = 0;
+        int W = 0;
+        int H = 0;
+
+        bool in(int nX, int nY) const
+        {
+            return nX >= X && nX < X + W && nY >= Y && nY < Y + H;
+        }
+    };
+
+    class JPSFinder final
+    {
+        private:
+            const GridMask &m_mask;
+
+        private:
+            // window of current search
+            // per-grid search state is indexed inside the window and shared by all finders in one thread
+            // then a finder only owns the walkability mask, no W * H scratch for every map
+            GridRegion m_region;
+
+        public:
+            JPSFinder(const GridMask &);
+
+        public:
+            // returns empty if no path
+            // region limits the search, default searches the whole map
+            std::vector<PathNode> search(int, int, int, int);
+            std::vector<PathNode> search(int, int, int, int, const GridRegion &);
+
+        public:
+            static int octileCost(int nX0, int nY0, int nX1, int nY1)
+            {
+                const int nDX = std::abs(nX1 - nX0);
+                const int nDY = std::abs(nY1 - nY0);
+                return 10 * std::max<int>(nDX, nDY) + 4 * std::min<int>(nDX, nDY);
+            }
+
+        private:
+            bool walkable(int nX, int nY) const
+            {
+                return m_region.in(nX, nY) && m_mask.walkable(nX, nY);
+            }
+
+            int windowIndex(int nX, int nY) const
+            {
+                return (nX - m_region.X) + (nY - m_region.Y) * m_region.W;
+            }
+
+        private:
+            int  jump(int, int, int, int, int, int) const;
+            bool doSearch(int, int, int, int, const GridRegion &);
+    };
+
+    class HPAGraph final
+    {
+        private:
+            struct AbstractEdge
+            {
+                int node;
+                int cost;
+            };
+
+            struct AbstractNode
+            {
+                int X;
+                int Y;
+                int cluster;
+                std::vector<AbstractEdge> edgeList;
+            };
+
+        private:
+            const GridMask m_mask;
+            const int m_clusterSize;
+
+        private:
+            int m_clusterW = 0;
+            int m_clusterH = 0;
+
+        private:
+            std::vector<AbstractNode> m_nodeList;
+            std::vector<std::vector<int>> m_clusterNodeList;
+
+        private:
+            // intra-cluster edges are built at first visit of the cluster
+            // most clusters of a large map never see a long path
+            std::vector<uint8_t> m_clusterDoneList;
+
+        private:
+            JPSFinder m_finder;
+
+        public:
+            // walkability is sampled once at construction
+            // create a new graph if the static walkability changes
+            HPAGraph(int, int, const std::function<bool(int, int)> &, int = 16);
+
+        public:
+            HPAGraph(const HPAGraph &) = delete;
+            HPAGraph &operator = (const HPAGraph &) = delete;
+
+        public:
+            // returns empty if no path found, caller should fallback to a general path finder
+            // when abstract graph fails it only searches the bounding box of start and goal with a margin
+            std::vector<PathNode> search(int, int, int, int);
+
+        public:
+            size_t nodeCount() const
+            {
+                return m_nodeList.size();
+            }
+
+        private:
+            int clusterIndex(int nX, int nY) const
+            {
+                return (nX / m_clusterSize) + (nY / m_clusterSize) * m_clusterW;
+            }
+
+            GridRegion clusterRegion(int) const;
+
+        private:
+            void buildEntrance();
+            void buildIntraEdge(int);
+
+        private:
+            // costs from (x, y) to all grids inside the cluster, -1 if unreachable
+            void clusterCost(int, int, std::vector<int> &) const;
+
+        private:
+            // abstract nodes passed from (x0, y0) to (x1, y1), excluding both ends
+            bool searchAbstract(int, int, int, int, std::vector<int> &);
+    };
+}
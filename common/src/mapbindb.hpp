@@ -22,7 +22,6 @@
 
 #include "zsdb.hpp"
 #include "inndb.hpp"
-#include "hexstr.hpp"
 #include "mir2xmapdata.hpp"
 
 struct MapBinEntry
@@ -64,10 +63,9 @@ class MapBinDB: public innDB<uint32_t, MapBinEntry>
     public:
         virtual std::tuple<MapBinEntry, size_t> loadResource(uint32_t nKey)
         {
-            char szKeyString[16];
             MapBinEntry stEntry {nullptr};
 
-            if(std::vector<uint8_t> stBuf; m_ZSDBPtr->Decomp(hexstr::to_string<uint32_t, 4>(nKey, szKeyString, true), 8, &stBuf)){
+            if(std::vector<uint8_t> stBuf; m_ZSDBPtr->Decomp(nKey, &stBuf)){
                 auto pMap = new Mir2xMapData();
                 if(pMap->Load(stBuf.data(), stBuf.size())){
                     stEntry.Map = pMap;
@@ -68,6 +68,7 @@
 
 #include <mutex>
 #include <array>
+#include <atomic>
 #include <vector>
 #include <memory>
 #include <cstdint>
@@ -409,7 +410,7 @@ class MemoryChunkPN
         }InnMemoryChunkPoolBranch;
 
     private:
-        size_t m_count;
+        std::atomic<size_t> m_count;
         InnMemoryChunkPoolBranch m_MCPBV[BranchSize];
 
     public:
@@ -489,7 +490,7 @@ class MemoryChunkPN
             }
 
             // ok this is in multi-thread environment, we need the lock
-            InnLockGuard(m_MCPBV[pHead->BranchID].Lock);
+            InnLockGuard stLockGuard(m_MCPBV[pHead->BranchID].Lock);
             m_MCPBV[pHead->BranchID].PoolV[pHead->PoolID]->Free(pHead->NodeID);
         }
 };
@@ -59,11 +59,13 @@ bool Mir2xMapData::Load(const char *szFullName)
     m_W = 0;
     m_H = 0;
     m_data.clear();
+    m_fileMap.reset();
     return false;
 }
 
 bool Mir2xMapData::Load(const uint8_t *pData, size_t nDataLen)
 {
+    m_fileMap.reset();
     if(true
             && pData
             && nDataLen >= 4){
@@ -88,6 +90,39 @@ bool Mir2xMapData::Load(const uint8_t *pData, size_t nDataLen)
     m_W = 0;
     m_H = 0;
     m_data.clear();
+    m_fileMap.reset();
+    return false;
+}
+
+bool Mir2xMapData::Load(std::shared_ptr<const FileMap> fileMap)
+{
+    m_data.clear();
+    m_fileMap.reset();
+
+    if(true
+            && fileMap
+            && fileMap->size() >= 4){
+
+        uint16_t nW = 0;
+        uint16_t nH = 0;
+
+        std::memcpy(&nW, fileMap->data() + 0, 2);
+        std::memcpy(&nH, fileMap->data() + 2, 2);
+
+        if(true
+                && (nW / 2 > 0) && !(nW % 2)
+                && (nH / 2 > 0) && !(nH % 2)
+                && ((sizeof(BLOCK) * (nW / 2) * (nH / 2)) + 4) == fileMap->size()){
+
+            m_W = nW;
+            m_H = nH;
+            m_fileMap = std::move(fileMap);
+            return true;
+        }
+    }
+
+    m_W = 0;
+    m_H = 0;
     return false;
 }
 
@@ -113,6 +148,7 @@ bool Mir2xMapData::Allocate(uint16_t nW, uint16_t nH)
         m_W = nW;
         m_H = nH;
 
+        m_fileMap.reset();
         m_data.resize(m_W * m_H / 4);
         std::memset(&(m_data[0]), 0, sizeof(m_data[0]) * m_data.size());
         return true;
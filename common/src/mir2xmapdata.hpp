@@ -22,10 +22,12 @@
 
 #pragma once
 #include <array>
+#include <memory>
 #include <vector>
 #include <cstdint>
 #include <functional>
 #include "strf.hpp"
+#include "filemap.hpp"
 #include "landtype.hpp"
 #include "sysconst.hpp"
 #include "fflerror.hpp"
@@ -199,11 +201,17 @@ class Mir2xMapData final
     private:
         std::vector<BLOCK> m_data;
 
+    private:
+        // set if blocks refer to a mapped file, then m_data is empty
+        // mapped map data is read-only, copies share the mapping
+        std::shared_ptr<const FileMap> m_fileMap;
+
     public:
         Mir2xMapData()
             : m_W(0)
             , m_H(0)
             , m_data()
+            , m_fileMap()
         {}
 
         Mir2xMapData(const char *pName)
@@ -217,12 +225,21 @@ class Mir2xMapData final
     public:
         const uint8_t *Data() const
         {
-            return (uint8_t *)(&m_data[0]);
+            return (const uint8_t *)(blockData());
         }
 
         size_t DataLen() const
         {
-            return m_data.size() * sizeof(m_data[0]);
+            return (size_t)(m_W / 2) * (size_t)(m_H / 2) * sizeof(BLOCK);
+        }
+
+    private:
+        const BLOCK *blockData() const
+        {
+            if(m_fileMap){
+                return (const BLOCK *)(m_fileMap->data() + 4);
+            }
+            return m_data.data();
         }
 
     public:
@@ -235,6 +252,9 @@ class Mir2xMapData final
     public:
         auto &Block(int nX, int nY)
         {
+            if(m_fileMap){
+                throw fflerror("mapped map data is read-only");
+            }
             return m_data[nX / 2 + (nY / 2) * (m_W / 2)];
         }
 
@@ -251,7 +271,7 @@ class Mir2xMapData final
     public:
         const auto &Block(int nX, int nY) const
         {
-            return m_data[nX / 2 + (nY / 2) * (m_W / 2)];
+            return blockData()[nX / 2 + (nY / 2) * (m_W / 2)];
         }
 
         const auto &Tile(int nX, int nY) const
@@ -268,13 +288,18 @@ class Mir2xMapData final
         bool Load(const char *);
         bool Load(const uint8_t *, size_t);
 
+    public:
+        // use the mapped file in place, no copy
+        // file has the same layout as Save() writes
+        bool Load(std::shared_ptr<const FileMap>);
+
     public:
         bool Save(const char *);
 
     public:
         bool Valid() const
         {
-            return !m_data.empty();
+            return m_fileMap || !m_data.empty();
         }
 
         bool ValidC(int nX, int nY) const
@@ -0,0 +1,207 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: netcodec.hpp
+ *        Created: 10/16/2026 21:30:12
+ *    Description: per-channel codec state shared by server Channel and client NetIO
+ *
+ *                 1. delta mode: fixed size message is XOR-ed against the last one of same
+ *                    header code sent through this channel, then fields not changed become
+ *                    zero bytes and get dropped by zcompf::xorEncode()
+ *
+ *                 2. lz4 mode: variable size message is compressed by one LZ4 stream per
+ *                    channel, later messages use earlier ones as dictionary
+ *
+ *                 both ends enable the codec at SM_NETCAPS, encoder and decoder state has
+ *                 to be updated in exactly the same message order
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#pragma once
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include "lz4.h"
+#include "fflerror.hpp"
+
+enum NetCapType: uint32_t
+{
+    NETCAP_NONE  = 0,
+    NETCAP_DELTA = 1 << 0,
+    NETCAP_LZ4   = 1 << 1,
+};
+
+// type 3 message sets this bit in the 4-byte length field if body is compressed by LZ4
+// compressed body: [uint32_t origLen][LZ4 data], length field includes the origLen
+constexpr uint32_t NETCODEC_LZ4FLAG = 0X80000000;
+
+// don't compress small variable size messages
+// they don't go through the LZ4 stream and leave the dictionary untouched
+constexpr size_t NETCODEC_LZ4MINSIZE = 32;
+
+class NetDeltaCodec
+{
+    private:
+        std::array<std::vector<uint8_t>, 256> m_lastList;
+
+    public:
+        void reset()
+        {
+            for(auto &buf: m_lastList){
+                buf.clear();
+            }
+        }
+
+    public:
+        // dst = src ^ last, and src becomes the new last
+        // dst and src can be the same buffer
+        void encode(uint8_t headCode, uint8_t *dst, const uint8_t *src, size_t bufLen)
+        {
+            auto &last = m_lastList[headCode];
+            last.resize(bufLen, 0);
+
+            for(size_t i = 0; i < bufLen; ++i){
+                const auto curr = src[i];
+                dst[i] = curr ^ last[i];
+                last[i] = curr;
+            }
+        }
+
+        // buf = buf ^ last, and decoded buf becomes the new last
+        void decode(uint8_t headCode, uint8_t *buf, size_t bufLen)
+        {
+            auto &last = m_lastList[headCode];
+            last.resize(bufLen, 0);
+
+            for(size_t i = 0; i < bufLen; ++i){
+                buf[i] ^= last[i];
+                last[i] = buf[i];
+            }
+        }
+};
+
+class NetLZ4Encoder
+{
+    private:
+        constexpr static size_t m_maxDictLen = 64 * 1024;
+
+    private:
+        LZ4_stream_t *m_stream;
+
+    private:
+        // history of the stream followed by the message being encoded
+        // message is copied in right after the history, then the stream runs in prefix mode and
+        // every message can refer to the last 64KB, not only to the previous message
+        std::vector<char> m_buf;
+        size_t m_bufLen;
+
+    public:
+        NetLZ4Encoder()
+            : m_stream(LZ4_createStream())
+            , m_buf(m_maxDictLen * 2)
+            , m_bufLen(0)
+        {
+            if(!m_stream){
+                throw fflerror("LZ4_createStream() failed");
+            }
+        }
+
+        ~NetLZ4Encoder()
+        {
+            LZ4_freeStream(m_stream);
+        }
+
+    public:
+        NetLZ4Encoder(const NetLZ4Encoder &) = delete;
+        NetLZ4Encoder &operator = (const NetLZ4Encoder &) = delete;
+
+    public:
+        void reset()
+        {
+            LZ4_resetStream_fast(m_stream);
+            m_bufLen = 0;
+        }
+
+    public:
+        static size_t maxEncodeLen(size_t srcLen)
+        {
+            return (size_t)(LZ4_compressBound((int)(srcLen)));
+        }
+
+        // returns compressed size
+        // dst should have at least maxEncodeLen(srcLen) bytes
+        size_t encode(uint8_t *dst, const uint8_t *src, size_t srcLen)
+        {
+            if(m_bufLen + srcLen > m_buf.size()){
+                // move last 64KB of history to buffer head
+                // LZ4_saveDict() uses memmove and points the stream dictionary to new place
+                m_bufLen = (size_t)(LZ4_saveDict(m_stream, m_buf.data(), (int)(m_maxDictLen)));
+
+                if(m_bufLen + srcLen > m_buf.size()){
+                    // message larger than 64KB, grow buffer and reload the dictionary
+                    std::vector<char> newBuf(m_bufLen + srcLen);
+                    std::memcpy(newBuf.data(), m_buf.data(), m_bufLen);
+
+                    m_buf.swap(newBuf);
+                    LZ4_loadDict(m_stream, m_buf.data(), (int)(m_bufLen));
+                }
+            }
+
+            char *msgBuf = m_buf.data() + m_bufLen;
+            std::memcpy(msgBuf, src, srcLen);
+
+            const int compSize = LZ4_compress_fast_continue(m_stream, msgBuf, (char *)(dst), (int)(srcLen), (int)(maxEncodeLen(srcLen)), 1);
+            if(compSize <= 0){
+                throw fflerror("LZ4_compress_fast_continue() return error code: %d", compSize);
+            }
+
+            m_bufLen += srcLen;
+            return (size_t)(compSize);
+        }
+};
+
+class NetLZ4Decoder
+{
+    private:
+        std::vector<char> m_dict;
+
+    public:
+        void reset()
+        {
+            m_dict.clear();
+        }
+
+    public:
+        // returns false if data is corrupted
+        bool decode(uint8_t *dst, size_t dstLen, const uint8_t *src, size_t srcLen)
+        {
+            const int decompSize = LZ4_decompress_safe_usingDict((const char *)(src), (char *)(dst), (int)(srcLen), (int)(dstLen), m_dict.data(), (int)(m_dict.size()));
+            if(decompSize < 0 || (size_t)(decompSize) != dstLen){
+                return false;
+            }
+
+            // keep last 64KB of history, encoder never refers beyond it
+            constexpr size_t maxDictLen = 64 * 1024;
+            if(dstLen >= maxDictLen){
+                m_dict.assign((const char *)(dst) + dstLen - maxDictLen, (const char *)(dst) + dstLen);
+            }
+            else{
+                m_dict.insert(m_dict.end(), (const char *)(dst), (const char *)(dst) + dstLen);
+                if(m_dict.size() > maxDictLen){
+                    m_dict.erase(m_dict.begin(), m_dict.begin() + (m_dict.size() - maxDictLen));
+                }
+            }
+            return true;
+        }
+};
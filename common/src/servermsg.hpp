@@ -48,6 +48,7 @@ enum SMType: uint8_t
     SM_GOLD,
     SM_SELLITEM,
     SM_TEXT,
+    SM_NETCAPS,
     SM_MAX,
 };
 
@@ -216,6 +217,13 @@ struct SMGold
 {
     uint32_t Gold;
 };
+
+struct SMNetCaps
+{
+    // NETCAP_XXX accepted by server
+    // all messages after this one are encoded in these modes
+    uint32_t caps;
+};
 #pragma pack(pop)
 
 class ServerMsg final: public MsgBase
@@ -257,6 +265,7 @@ class ServerMsg final: public MsgBase
                 _add_server_msg_type_case(SM_GOLD,             1, sizeof(SMGold)            )
                 _add_server_msg_type_case(SM_SELLITEM,         3, 0                         )
                 _add_server_msg_type_case(SM_TEXT,             3, 0                         )
+                _add_server_msg_type_case(SM_NETCAPS,          2, sizeof(SMNetCaps)         )
 #undef _add_server_msg_type_case
             };
 
@@ -266,6 +275,14 @@ class ServerMsg final: public MsgBase
             return s_msgAttributeTable.at(SM_NONE_0);
         }
 
+    public:
+        // message sent as XOR delta against the last one if NETCAP_DELTA is on
+        // they are high-frequency and most fields don't change between two messages
+        bool deltaEncode() const
+        {
+            return m_headCode == SM_ACTION || m_headCode == SM_UPDATEHP;
+        }
+
     public:
         template<typename T> static T conv(const uint8_t *buf, size_t bufLen = 0)
         {
@@ -286,7 +303,8 @@ class ServerMsg final: public MsgBase
                     || std::is_same_v<T, SMOffline>
                     || std::is_same_v<T, SMPickUpOK>
                     || std::is_same_v<T, SMRemoveGroundItem>
-                    || std::is_same_v<T, SMGold>);
+                    || std::is_same_v<T, SMGold>
+                    || std::is_same_v<T, SMNetCaps>);
 
             if(bufLen && bufLen != sizeof(T)){
                 throw fflerror("invalid buffer length");
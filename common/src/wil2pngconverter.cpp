@@ -0,0 +1,484 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: wil2pngconverter.cpp
+ *        Created: 10/18/2026 09:12:40
+ *    Description:
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#include <sstream>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+#include "pngf.hpp"
+#include "strf.hpp"
+#include "totype.hpp"
+#include "shadow.hpp"
+#include "filesys.hpp"
+#include "fflerror.hpp"
+#include "wil2pngconverter.hpp"
+
+// FNV-1a, only to detect changes of source frames
+static uint64_t fnvHash(uint64_t nHash, const void *pData, size_t nLength)
+{
+    const auto pBuf = (const uint8_t *)(pData);
+    for(size_t i = 0; i < nLength; ++i){
+        nHash ^= pBuf[i];
+        nHash *= 0X00000100000001B3ULL;
+    }
+    return nHash;
+}
+
+static bool validName(const std::string &szName)
+{
+    return !szName.empty() && std::none_of(szName.begin(), szName.end(), [](char ch)
+    {
+        return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+    });
+}
+
+Wil2PNGConverter::Wil2PNGConverter(const char *outDir, const char *tag, int threadNum)
+    : m_outDir(outDir ? outDir : "")
+    , m_tag(tag ? tag : "")
+{
+    if(m_outDir.empty() || !filesys::hasFile(m_outDir.c_str())){
+        throw fflerror("invalid output dir: %s", to_cstr(outDir));
+    }
+
+    if(threadNum <= 0){
+        threadNum = std::max<int>(1, std::thread::hardware_concurrency());
+    }
+
+    if(const auto szManifestDir = m_outDir + "/.wil2png"; !filesys::hasFile(szManifestDir.c_str()) && !filesys::makeDir(szManifestDir.c_str())){
+        throw fflerror("failed to create manifest dir: %s", szManifestDir.c_str());
+    }
+
+    loadManifest();
+    if(!(m_manifestFile = std::fopen(manifestPath().c_str(), "ab"))){
+        throw fflerror("failed to open manifest: %s", manifestPath().c_str());
+    }
+
+    m_pendingJobMax = (size_t)(threadNum) * 4;
+    for(int i = 0; i < threadNum; ++i){
+        m_threadList.emplace_back([this]()
+        {
+            workerLoop();
+        });
+    }
+}
+
+Wil2PNGConverter::~Wil2PNGConverter()
+{
+    {
+        std::unique_lock<std::mutex> stLock(m_jobLock);
+        m_doneCV.wait(stLock, [this]()
+        {
+            return m_pendingJob == 0;
+        });
+        m_stop = true;
+    }
+
+    m_jobCV.notify_all();
+    for(auto &thread: m_threadList){
+        thread.join();
+    }
+
+    if(m_manifestFile){
+        std::fclose(m_manifestFile);
+    }
+}
+
+void Wil2PNGConverter::addFrame(FrameJob job)
+{
+    if(!validName(job.key)){
+        throw fflerror("invalid frame key: \"%s\"", job.key.c_str());
+    }
+
+    if(!job.convert){
+        throw fflerror("frame has no convert function: %s", job.key.c_str());
+    }
+
+    {
+        std::unique_lock<std::mutex> stLock(m_jobLock);
+        if(m_stop){
+            throw fflerror("converter has finished");
+        }
+
+        m_doneCV.wait(stLock, [this]()
+        {
+            return m_error || m_pendingJob < m_pendingJobMax;
+        });
+
+        if(m_error){
+            std::rethrow_exception(m_error);
+        }
+    }
+
+    pushJob([this, job = std::move(job)]()
+    {
+        runFrame(job);
+    }, false);
+}
+
+Wil2PNGConverter::ConvertStat Wil2PNGConverter::finish()
+{
+    {
+        std::unique_lock<std::mutex> stLock(m_jobLock);
+        m_doneCV.wait(stLock, [this]()
+        {
+            return m_pendingJob == 0;
+        });
+        m_stop = true;
+    }
+
+    m_jobCV.notify_all();
+    for(auto &thread: m_threadList){
+        thread.join();
+    }
+    m_threadList.clear();
+
+    if(m_error){
+        std::rethrow_exception(m_error);
+    }
+
+    saveManifest();
+    return ConvertStat
+    {
+        .frameNum   = m_frameNum.load(),
+        .frameSkip  = m_frameSkip.load(),
+        .outputNum  = m_outputNum.load(),
+        .outputSize = m_outputSize.load(),
+    };
+}
+
+bool Wil2PNGConverter::readImage(WilImagePackage *pPackage, uint32_t nIndex, FrameImage *pImage)
+{
+    if(!pImage){
+        throw fflerror("invalid argument: pImage = %p", to_cvptr(pImage));
+    }
+
+    if(!(pPackage && pPackage->SetIndex(nIndex) && pPackage->CurrentImageValid())){
+        pImage->info = {};
+        pImage->data.clear();
+        return false;
+    }
+
+    pImage->info = pPackage->CurrentImageInfo();
+    pImage->data.assign(pPackage->CurrentImageBuffer(), pPackage->CurrentImageBuffer() + pImage->info.dwImageLength);
+    return true;
+}
+
+void Wil2PNGConverter::decodeImage(const FrameImage &rstImage, std::vector<uint32_t> *pBuf)
+{
+    if(!pBuf){
+        throw fflerror("invalid argument: pBuf = %p", to_cvptr(pBuf));
+    }
+
+    pBuf->resize((size_t)(std::max<int>(rstImage.info.shWidth, 0)) * (size_t)(std::max<int>(rstImage.info.shHeight, 0)));
+    if(!pBuf->empty()){
+        WilImagePackage::DecodeImage(pBuf->data(), rstImage.info, rstImage.data.data(), 0XFFFFFFFF, 0XFFFFFFFF, 0XFFFFFFFF);
+    }
+}
+
+bool Wil2PNGConverter::makeShadow(const uint32_t *pSrc, int nW, int nH, bool bProject, OutputImage *pImage)
+{
+    if(!(pSrc && nW > 0 && nH > 0 && pImage)){
+        throw fflerror("invalid argument: pSrc = %p, nW = %d, nH = %d, pImage = %p", to_cvptr(pSrc), nW, nH, to_cvptr(pImage));
+    }
+
+    // make a big buffer to hold the shadow as needed
+    // shadow buffer size depends on do project or not
+    //
+    //  project :  (nW + nH / 2) x (nH / 2 + 1)
+    //          :  (nW x nH)
+    //
+    const int nMaxW = (std::max<int>)(nW + nH / 2, nW) + 20;
+    const int nMaxH = (std::max<int>)(1  + nH / 2, nH) + 20;
+    pImage->buf.resize((size_t)(nMaxW) * (size_t)(nMaxH));
+
+    int nShadowW = 0;
+    int nShadowH = 0;
+    Shadow::MakeShadow(pImage->buf.data(), bProject, pSrc, nW, nH, &nShadowW, &nShadowH, 0XFF000000);
+
+    if(nShadowW <= 0 || nShadowH <= 0){
+        pImage->w = 0;
+        pImage->h = 0;
+        pImage->buf.clear();
+        return false;
+    }
+
+    pImage->w = nShadowW;
+    pImage->h = nShadowH;
+    pImage->buf.resize((size_t)(nShadowW) * (size_t)(nShadowH));
+    return true;
+}
+
+void Wil2PNGConverter::loadManifest()
+{
+    // one frame per line, later line overrides earlier one with the same key
+    //     <hash> <key> <file count> <file> <file> ...
+    std::ifstream f(manifestPath());
+    if(!f){
+        return;
+    }
+
+    std::string szLine;
+    while(std::getline(f, szLine)){
+        std::istringstream stLine(szLine);
+
+        std::string szHash;
+        std::string szKey;
+        size_t nFileCount = 0;
+
+        if(!(stLine >> szHash >> szKey >> nFileCount)){
+            continue;
+        }
+
+        ManifestEntry stEntry;
+        try{
+            stEntry.hash = std::stoull(szHash, nullptr, 16);
+        }
+        catch(...){
+            continue;
+        }
+
+        for(std::string szFileName; stEntry.fileList.size() < nFileCount && (stLine >> szFileName);){
+            stEntry.fileList.push_back(std::move(szFileName));
+        }
+
+        // truncated line from an interrupted run
+        if(stEntry.fileList.size() == nFileCount){
+            m_manifest[szKey] = std::move(stEntry);
+        }
+    }
+}
+
+void Wil2PNGConverter::saveManifest()
+{
+    std::lock_guard<std::mutex> stLockGuard(m_manifestLock);
+    if(m_manifestFile){
+        std::fclose(m_manifestFile);
+        m_manifestFile = nullptr;
+    }
+
+    // rewrite to drop overridden lines
+    // keep keys sorted then the manifest diffs well
+    std::vector<const decltype(m_manifest)::value_type *> stEntryList;
+    for(const auto &p: m_manifest){
+        stEntryList.push_back(&p);
+    }
+
+    std::sort(stEntryList.begin(), stEntryList.end(), [](const auto *p1, const auto *p2)
+    {
+        return p1->first < p2->first;
+    });
+
+    const auto szTmpPath = manifestPath() + ".tmp";
+    {
+        std::ofstream f(szTmpPath, std::ios::trunc);
+        for(const auto p: stEntryList){
+            f << str_printf("%016llX", to_llu(p->second.hash)) << ' ' << p->first << ' ' << p->second.fileList.size();
+            for(const auto &szFileName: p->second.fileList){
+                f << ' ' << szFileName;
+            }
+            f << '\n';
+        }
+
+        if(!f){
+            throw fflerror("failed to write manifest: %s", szTmpPath.c_str());
+        }
+    }
+    std::filesystem::rename(szTmpPath, manifestPath());
+}
+
+void Wil2PNGConverter::workerLoop()
+{
+    while(true){
+        std::function<void()> fnJob;
+        {
+            std::unique_lock<std::mutex> stLock(m_jobLock);
+            m_jobCV.wait(stLock, [this]()
+            {
+                return m_stop || !m_jobQueue.empty();
+            });
+
+            if(m_jobQueue.empty()){
+                return;
+            }
+
+            fnJob = std::move(m_jobQueue.front());
+            m_jobQueue.pop_front();
+
+            // drain the queue after any error
+            if(m_error){
+                fnJob = nullptr;
+            }
+        }
+
+        if(fnJob){
+            try{
+                fnJob();
+            }
+            catch(...){
+                std::lock_guard<std::mutex> stLockGuard(m_jobLock);
+                if(!m_error){
+                    m_error = std::current_exception();
+                }
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> stLockGuard(m_jobLock);
+            m_pendingJob--;
+        }
+        m_doneCV.notify_all();
+    }
+}
+
+void Wil2PNGConverter::pushJob(std::function<void()> fnJob, bool bPushHead)
+{
+    {
+        std::lock_guard<std::mutex> stLockGuard(m_jobLock);
+        if(bPushHead){
+            m_jobQueue.push_front(std::move(fnJob));
+        }
+        else{
+            m_jobQueue.push_back(std::move(fnJob));
+        }
+        m_pendingJob++;
+    }
+    m_jobCV.notify_one();
+}
+
+void Wil2PNGConverter::runFrame(const FrameJob &rstJob)
+{
+    m_frameNum++;
+    const auto nHash = frameHash(rstJob);
+
+    const auto stOldEntry = [&rstJob, this]() -> ManifestEntry
+    {
+        std::lock_guard<std::mutex> stLockGuard(m_manifestLock);
+        if(auto p = m_manifest.find(rstJob.key); p != m_manifest.end()){
+            return p->second;
+        }
+        return {};
+    }();
+
+    if(stOldEntry.hash == nHash && std::all_of(stOldEntry.fileList.begin(), stOldEntry.fileList.end(), [this](const auto &szFileName)
+    {
+        return filesys::hasFile((m_outDir + "/" + szFileName).c_str());
+    })){
+        m_frameSkip++;
+        return;
+    }
+
+    std::vector<OutputImage> stOutputList;
+    rstJob.convert(rstJob, &stOutputList);
+
+    auto pState = std::make_shared<FrameState>();
+    pState->key = rstJob.key;
+    pState->entry.hash = nHash;
+
+    for(const auto &rstOutput: stOutputList){
+        if(!validName(rstOutput.fileName)){
+            throw fflerror("invalid output file name: \"%s\"", rstOutput.fileName.c_str());
+        }
+        pState->entry.fileList.push_back(rstOutput.fileName);
+    }
+
+    if(stOutputList.empty()){
+        doneFrame(pState);
+        return;
+    }
+
+    // write jobs go to the queue head
+    // they release frame buffers before next frame gets decoded
+    pState->pending = (int)(stOutputList.size());
+    for(auto &rstOutput: stOutputList){
+        pushJob([this, pState, stOutput = std::move(rstOutput)]()
+        {
+            const auto szPath = m_outDir + "/" + stOutput.fileName;
+            const bool bSaved = pngf::saveRGBABuffer((const uint8_t *)(stOutput.buf.data()), stOutput.w, stOutput.h, szPath.c_str());
+
+            if(bSaved){
+                std::error_code stErrCode;
+                if(const auto nSize = std::filesystem::file_size(szPath, stErrCode); !stErrCode){
+                    m_outputSize += (size_t)(nSize);
+                }
+                m_outputNum++;
+            }
+            else{
+                pState->failed = true;
+            }
+
+            if(pState->pending.fetch_sub(1) == 1 && !pState->failed){
+                doneFrame(pState);
+            }
+
+            if(!bSaved){
+                throw fflerror("save PNG failed: %s", szPath.c_str());
+            }
+        }, true);
+    }
+}
+
+void Wil2PNGConverter::doneFrame(const std::shared_ptr<FrameState> &pState)
+{
+    std::lock_guard<std::mutex> stLockGuard(m_manifestLock);
+    if(auto p = m_manifest.find(pState->key); p != m_manifest.end()){
+        // file name contains image offset
+        // remove outputs the frame doesn't produce anymore, otherwise they get packed as well
+        for(const auto &szFileName: p->second.fileList){
+            if(std::find(pState->entry.fileList.begin(), pState->entry.fileList.end(), szFileName) == pState->entry.fileList.end()){
+                std::error_code stErrCode;
+                std::filesystem::remove(m_outDir + "/" + szFileName, stErrCode);
+            }
+        }
+    }
+
+    if(m_manifestFile){
+        std::string szLine = str_printf("%016llX %s %zu", to_llu(pState->entry.hash), pState->key.c_str(), pState->entry.fileList.size());
+        for(const auto &szFileName: pState->entry.fileList){
+            szLine += " ";
+            szLine += szFileName;
+        }
+        szLine += "\n";
+
+        std::fwrite(szLine.data(), 1, szLine.size(), m_manifestFile);
+        std::fflush(m_manifestFile);
+    }
+    m_manifest[pState->key] = pState->entry;
+}
+
+uint64_t Wil2PNGConverter::frameHash(const FrameJob &rstJob) const
+{
+    uint64_t nHash = 0XCBF29CE484222325ULL;
+    for(const auto &szField: {m_tag, rstJob.key, rstJob.param}){
+        nHash = fnvHash(nHash, szField.c_str(), szField.size() + 1);
+    }
+
+    for(const auto &rstImage: rstJob.imageList){
+        const uint64_t nLength = rstImage.data.size();
+        nHash = fnvHash(nHash, &rstImage.info, sizeof(rstImage.info));
+        nHash = fnvHash(nHash, &nLength, sizeof(nLength));
+        nHash = fnvHash(nHash, rstImage.data.data(), rstImage.data.size() * sizeof(uint16_t));
+    }
+    return nHash;
+}
+
+std::string Wil2PNGConverter::manifestPath() const
+{
+    // keep it in a sub dir
+    // zsdbmaker only packs regular files in the output dir
+    return m_outDir + "/.wil2png/manifest";
+}
@@ -0,0 +1,189 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: wil2pngconverter.hpp
+ *        Created: 10/18/2026 09:12:40
+ *    Description: shared converter of the *wil2png tools
+ *
+ *                 caller reads raw frames from wil packages in its own thread and submits
+ *                 one job per frame, converting the frame runs in a worker pool, every PNG
+ *                 the frame produces is written by a separate job, so PNG encoding of one
+ *                 frame overlaps with decoding of other frames
+ *
+ *                 a manifest under the output dir records content hash and output files of
+ *                 every finished frame, a re-run skips frames whose hash doesn't change and
+ *                 whose files all exist, entries are appended as soon as a frame finishes
+ *                 then an interrupted run can resume
+ *
+ *                 don't run two converters on one output dir at the same time
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#pragma once
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <unordered_map>
+#include <condition_variable>
+#include "wilimagepackage.hpp"
+
+class Wil2PNGConverter final
+{
+    public:
+        // raw image copied out of a package
+        struct FrameImage
+        {
+            WILIMAGEINFO info;
+            std::vector<uint16_t> data;
+        };
+
+        // one PNG file to write, fileName is relative to the output dir
+        struct OutputImage
+        {
+            std::string fileName;
+
+            int w = 0;
+            int h = 0;
+            std::vector<uint32_t> buf;
+        };
+
+        struct FrameJob
+        {
+            // unique name of the frame in the output dir, include tool name
+            std::string key;
+
+            // anything else changes outputs of the frame, only used to compute the content hash
+            std::string param;
+
+            // source images of the frame, may contain empty one if the frame refers to an invalid index
+            std::vector<FrameImage> imageList;
+
+            // runs in worker thread, can throw
+            std::function<void(const FrameJob &, std::vector<OutputImage> *)> convert;
+        };
+
+        struct ConvertStat
+        {
+            size_t frameNum   = 0;
+            size_t frameSkip  = 0;
+            size_t outputNum  = 0;
+            size_t outputSize = 0;
+        };
+
+    private:
+        struct ManifestEntry
+        {
+            uint64_t hash = 0;
+            std::vector<std::string> fileList;
+        };
+
+        struct FrameState
+        {
+            std::string key;
+            ManifestEntry entry;
+
+            std::atomic<int>  pending {0};
+            std::atomic<bool> failed  {false};
+        };
+
+    private:
+        const std::string m_outDir;
+        const std::string m_tag;
+
+    private:
+        std::mutex m_manifestLock;
+        std::unordered_map<std::string, ManifestEntry> m_manifest;
+        FILE *m_manifestFile = nullptr;
+
+    private:
+        std::mutex m_jobLock;
+        std::condition_variable m_jobCV;
+        std::condition_variable m_doneCV;
+
+    private:
+        // queued and running jobs
+        // producer waits if too many to bound memory of raw frames
+        size_t m_pendingJob = 0;
+        size_t m_pendingJobMax = 0;
+
+    private:
+        bool m_stop = false;
+        std::exception_ptr m_error;
+        std::deque<std::function<void()>> m_jobQueue;
+        std::vector<std::thread> m_threadList;
+
+    private:
+        std::atomic<size_t> m_frameNum   {0};
+        std::atomic<size_t> m_frameSkip  {0};
+        std::atomic<size_t> m_outputNum  {0};
+        std::atomic<size_t> m_outputSize {0};
+
+    public:
+        // tag goes into every content hash
+        // change it when the tool changes the way it converts, this invalidates the whole manifest
+        // threadNum = 0 means using all hardware threads
+        Wil2PNGConverter(const char *, const char *, int = 0);
+
+    public:
+        ~Wil2PNGConverter();
+
+    public:
+        Wil2PNGConverter(const Wil2PNGConverter &) = delete;
+        Wil2PNGConverter &operator = (const Wil2PNGConverter &) = delete;
+
+    public:
+        // blocks when too many frames are in flight
+        // rethrows the first error from workers
+        void addFrame(FrameJob);
+
+    public:
+        // wait all jobs done and compact the manifest
+        // rethrows the first error from workers
+        ConvertStat finish();
+
+    public:
+        // read image at given index in caller thread
+        // returns false and leaves an empty image if the index is invalid
+        static bool readImage(WilImagePackage *, uint32_t, FrameImage *);
+
+    public:
+        static void decodeImage(const FrameImage &, std::vector<uint32_t> *);
+
+    public:
+        // make shadow of a decoded image into dst buffer and size, dst file name is untouched
+        // returns false if no shadow pixel at all
+        static bool makeShadow(const uint32_t *, int, int, bool, OutputImage *);
+
+    private:
+        void loadManifest();
+        void saveManifest();
+
+    private:
+        void workerLoop();
+        void pushJob(std::function<void()>, bool);
+
+    private:
+        void runFrame(const FrameJob &);
+        void doneFrame(const std::shared_ptr<FrameState> &);
+
+    private:
+        uint64_t frameHash(const FrameJob &) const;
+        std::string manifestPath() const;
+};
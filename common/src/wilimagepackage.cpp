@@ -20,44 +20,178 @@
 #include <string>
 #include <cstdio>
 #include <cstring>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define WIL_DECODE_X86
+#include <immintrin.h>
+#endif
 
 #include "condcheck.hpp"
 #include "wilimagepackage.hpp"
 
-static uint32_t Color16To32Mapping(uint16_t srcColor, uint32_t chColor)
+// 16-bit color in wil is R5G6B5
+// output is 0XAABBGGRR, alpha comes from the mixing color
+static uint8_t ColorChannelMapping(uint8_t srcChannel, uint8_t chChannel)
+{
+    return (chChannel <= srcChannel) ? chChannel : (uint8_t)std::lround(255.0 * srcChannel / chChannel);
+}
+
+// mapping of one mixing color
+// mixing color other than white scales every channel, it's done by lookup table
+// white only expands bits, it's done by SIMD kernels if supported
+struct ColorMapping
+{
+    uint32_t Alpha;
+    bool     Mixed;
+
+    uint8_t R[32];
+    uint8_t G[64];
+    uint8_t B[32];
+
+    ColorMapping(uint32_t chColor)
+        : Alpha(chColor & 0XFF000000)
+        , Mixed((chColor & 0X00FFFFFF) != 0X00FFFFFF)
+    {
+        if(Mixed){
+            for(int i = 0; i < 32; ++i){
+                R[i] = ColorChannelMapping((uint8_t)(i << 3), (uint8_t)((chColor & 0X00FF0000) >> 16));
+                B[i] = ColorChannelMapping((uint8_t)(i << 3), (uint8_t)((chColor & 0X000000FF) >>  0));
+            }
+
+            for(int i = 0; i < 64; ++i){
+                G[i] = ColorChannelMapping((uint8_t)(i << 2), (uint8_t)((chColor & 0X0000FF00) >> 8));
+            }
+        }
+    }
+};
+
+static void Memcpy16To32Mixed(uint32_t *dst, const uint16_t *src, int32_t n, const ColorMapping &rstMapping)
+{
+    for(int32_t ptr = 0; ptr < n; ptr++){
+        const uint32_t r = rstMapping.R[(src[ptr] & 0XF800) >> 11];
+        const uint32_t g = rstMapping.G[(src[ptr] & 0X07E0) >>  5];
+        const uint32_t b = rstMapping.B[(src[ptr] & 0X001F) >>  0];
+        dst[ptr] = rstMapping.Alpha + (b << 16) + (g << 8) + r;
+    }
+}
+
+static void Memcpy16To32Scalar(uint32_t *dst, const uint16_t *src, int32_t n, uint32_t dwAlpha)
+{
+    for(int32_t ptr = 0; ptr < n; ptr++){
+        const uint32_t r = (src[ptr] & 0XF800) >> 8;
+        const uint32_t g = (src[ptr] & 0X07E0) >> 3;
+        const uint32_t b = (src[ptr] & 0X001F) << 3;
+        dst[ptr] = dwAlpha + (b << 16) + (g << 8) + r;
+    }
+}
+
+#if defined(WIL_DECODE_X86) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define WIL_DECODE_SSE2
+
+// 8 pixels per loop
+// lo16 = G << 8 | R, hi16 = A << 8 | B, then interleave to AABBGGRR
+static void Memcpy16To32SSE2(uint32_t *dst, const uint16_t *src, int32_t n, uint32_t dwAlpha)
+{
+    const __m128i maskR = _mm_set1_epi16(0X00F8);
+    const __m128i maskG = _mm_set1_epi16((short)(0XFC00));
+    const __m128i maskB = _mm_set1_epi16(0X00F8);
+    const __m128i alpha = _mm_set1_epi16((short)((dwAlpha >> 16) & 0XFF00));
+
+    int32_t ptr = 0;
+    for(; ptr + 8 <= n; ptr += 8){
+        const __m128i c = _mm_loadu_si128((const __m128i *)(src + ptr));
+        const __m128i r = _mm_and_si128(_mm_srli_epi16(c, 8), maskR);
+        const __m128i g = _mm_and_si128(_mm_slli_epi16(c, 5), maskG);
+        const __m128i b = _mm_and_si128(_mm_slli_epi16(c, 3), maskB);
+
+        const __m128i lo16 = _mm_or_si128(r, g);
+        const __m128i hi16 = _mm_or_si128(b, alpha);
+
+        _mm_storeu_si128((__m128i *)(dst + ptr + 0), _mm_unpacklo_epi16(lo16, hi16));
+        _mm_storeu_si128((__m128i *)(dst + ptr + 4), _mm_unpackhi_epi16(lo16, hi16));
+    }
+    Memcpy16To32Scalar(dst + ptr, src + ptr, n - ptr, dwAlpha);
+}
+#endif
+
+#if defined(WIL_DECODE_X86) && (defined(__GNUC__) || defined(__clang__) || defined(__AVX2__))
+#define WIL_DECODE_AVX2
+
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((target("avx2")))
+#endif
+static void Memcpy16To32AVX2(uint32_t *dst, const uint16_t *src, int32_t n, uint32_t dwAlpha)
+{
+    const __m256i maskR = _mm256_set1_epi16(0X00F8);
+    const __m256i maskG = _mm256_set1_epi16((short)(0XFC00));
+    const __m256i maskB = _mm256_set1_epi16(0X00F8);
+    const __m256i alpha = _mm256_set1_epi16((short)((dwAlpha >> 16) & 0XFF00));
+
+    int32_t ptr = 0;
+    for(; ptr + 16 <= n; ptr += 16){
+        const __m256i c = _mm256_loadu_si256((const __m256i *)(src + ptr));
+        const __m256i r = _mm256_and_si256(_mm256_srli_epi16(c, 8), maskR);
+        const __m256i g = _mm256_and_si256(_mm256_slli_epi16(c, 5), maskG);
+        const __m256i b = _mm256_and_si256(_mm256_slli_epi16(c, 3), maskB);
+
+        const __m256i lo16 = _mm256_or_si256(r, g);
+        const __m256i hi16 = _mm256_or_si256(b, alpha);
+
+        // unpack works in 128-bit lanes
+        // gives pixels [0, 4) + [8, 12) and [4, 8) + [12, 16)
+        const __m256i pixLo = _mm256_unpacklo_epi16(lo16, hi16);
+        const __m256i pixHi = _mm256_unpackhi_epi16(lo16, hi16);
+
+        _mm256_storeu_si256((__m256i *)(dst + ptr + 0), _mm256_permute2x128_si256(pixLo, pixHi, 0X20));
+        _mm256_storeu_si256((__m256i *)(dst + ptr + 8), _mm256_permute2x128_si256(pixLo, pixHi, 0X31));
+    }
+    Memcpy16To32Scalar(dst + ptr, src + ptr, n - ptr, dwAlpha);
+}
+
+static bool CPUSupportAVX2()
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_cpu_supports("avx2");
+#else
+    return true;
+#endif
+}
+#endif
+
+using Memcpy16To32Func = WilImagePackage::Memcpy16To32Func;
+static Memcpy16To32Func SelectMemcpy16To32()
 {
-    uint8_t r  = (uint8_t)((srcColor & 0XF800) >> 8);
-    uint8_t g  = (uint8_t)((srcColor & 0X07E0) >> 3);
-    uint8_t b  = (uint8_t)((srcColor & 0X001F) << 3);
-
-    if((chColor & 0X00FFFFFF) != 0X00FFFFFF){
-        uint8_t br = (uint8_t)((chColor & 0X00FF0000) >> 16);
-        uint8_t bg = (uint8_t)((chColor & 0X0000FF00) >>  8);
-        uint8_t bb = (uint8_t)((chColor & 0X000000FF) >>  0);
-
-        r = (br <= r) ? br : (uint8_t)std::lround(255.0 * r / br);
-        g = (bg <= g) ? bg : (uint8_t)std::lround(255.0 * g / bg);
-        b = (bb <= b) ? bb : (uint8_t)std::lround(255.0 * b / bb);
+#if defined(WIL_DECODE_AVX2)
+    if(CPUSupportAVX2()){
+        return Memcpy16To32AVX2;
     }
+#endif
 
-    return (chColor & 0XFF000000) + (((uint32_t)(b)) << 16) + (((uint32_t)(g)) << 8) + (uint32_t)(r);
+#if defined(WIL_DECODE_SSE2)
+    return Memcpy16To32SSE2;
+#else
+    return Memcpy16To32Scalar;
+#endif
 }
 
-static void Memcpy16To32(uint32_t *dst, const uint16_t *src, int32_t n, uint32_t dwColor)
+static void Memcpy16To32(uint32_t *dst, const uint16_t *src, int32_t n, const ColorMapping &rstMapping)
 {
-    if(src && dst){
-        for(int32_t ptr = 0; ptr < n; ptr++){
-            dst[ptr] = Color16To32Mapping(src[ptr], dwColor);
+    if(src && dst && n > 0){
+        if(rstMapping.Mixed){
+            Memcpy16To32Mixed(dst, src, n, rstMapping);
+        }
+        else{
+            const static auto s_memcpy16To32 = SelectMemcpy16To32();
+            s_memcpy16To32(dst, src, n, rstMapping.Alpha);
         }
     }
 }
 
 static void MemSet32(uint32_t *dst, int n, uint32_t src)
 {
-    if(dst){
-        for(int32_t ptr = 0; ptr < n; ptr++){
-            dst[ptr] = src;
-        }
+    if(dst && n > 0){
+        std::fill_n(dst, n, src);
     }
 }
 
@@ -217,9 +351,17 @@ const WILIMAGEINFO &WilImagePackage::CurrentImageInfo()
 
 void WilImagePackage::Decode(uint32_t *rectImageBuffer, uint32_t dwColor0, uint32_t dwColor1, uint32_t dwColor2)
 {
-    auto pwSrc   = &(m_currentImageBuffer[0]);
-    int  nWidth  = m_currentWilImageInfo.shWidth;
-    int  nHeight = m_currentWilImageInfo.shHeight;
+    DecodeImage(rectImageBuffer, m_currentWilImageInfo, m_currentImageBuffer.data(), dwColor0, dwColor1, dwColor2);
+}
+
+void WilImagePackage::DecodeImage(uint32_t *rectImageBuffer, const WILIMAGEINFO &rstInfo, const uint16_t *pwSrc, uint32_t dwColor0, uint32_t dwColor1, uint32_t dwColor2)
+{
+    const ColorMapping stMapping0(dwColor0);
+    const ColorMapping stMapping1(dwColor1);
+    const ColorMapping stMapping2(dwColor2);
+
+    int nWidth  = rstInfo.shWidth;
+    int nHeight = rstInfo.shHeight;
 
     size_t srcBeginPos    = 0;
     size_t srcEndPos      = 0;
@@ -240,15 +382,15 @@ void WilImagePackage::Decode(uint32_t *rectImageBuffer, uint32_t dwColor0, uint3
                     MemSet32(rectImageBuffer + nRow * nWidth + dstNowPosInRow, cntCopy, 0X00000000);
                     break;
                 case 0XC1:
-                    Memcpy16To32(rectImageBuffer + nRow * nWidth + dstNowPosInRow, pwSrc + srcNowPos, cntCopy, dwColor0);
+                    Memcpy16To32(rectImageBuffer + nRow * nWidth + dstNowPosInRow, pwSrc + srcNowPos, cntCopy, stMapping0);
                     srcNowPos += cntCopy;
                     break;
                 case 0XC2:
-                    Memcpy16To32(rectImageBuffer + nRow * nWidth + dstNowPosInRow, pwSrc + srcNowPos, cntCopy, dwColor1);
+                    Memcpy16To32(rectImageBuffer + nRow * nWidth + dstNowPosInRow, pwSrc + srcNowPos, cntCopy, stMapping1);
                     srcNowPos += cntCopy;
                     break;
                 case 0XC3:
-                    Memcpy16To32(rectImageBuffer + nRow * nWidth + dstNowPosInRow, pwSrc + srcNowPos, cntCopy, dwColor2);
+                    Memcpy16To32(rectImageBuffer + nRow * nWidth + dstNowPosInRow, pwSrc + srcNowPos, cntCopy, stMapping2);
                     srcNowPos += cntCopy;
                     break;
                 default:
@@ -265,6 +407,66 @@ void WilImagePackage::Decode(uint32_t *rectImageBuffer, uint32_t dwColor0, uint3
     }
 }
 
+bool WilImagePackage::DecodePackage(std::vector<uint32_t> *pBuf, std::vector<WilPackageImage> *pImageList, uint32_t dwColor0, uint32_t dwColor1, uint32_t dwColor2)
+{
+    if(!(pBuf && pImageList && m_wilFile)){
+        return false;
+    }
+
+    // keep capacity of both
+    // decoding the next package of similar size won't allocate
+    pBuf->clear();
+    pImageList->clear();
+
+    for(int32_t nIndex = 0; nIndex < IndexCount(); ++nIndex){
+        if(!(SetIndex(nIndex) && CurrentImageValid())){
+            continue;
+        }
+
+        const auto &rstInfo = CurrentImageInfo();
+        if(rstInfo.shWidth <= 0 || rstInfo.shHeight <= 0){
+            continue;
+        }
+
+        pImageList->push_back(WilPackageImage
+        {
+            .Index  = (uint32_t)(nIndex),
+            .Info   = rstInfo,
+            .Offset = pBuf->size(),
+        });
+
+        pBuf->resize(pBuf->size() + (size_t)(rstInfo.shWidth) * (size_t)(rstInfo.shHeight));
+        Decode(pBuf->data() + pImageList->back().Offset, dwColor0, dwColor1, dwColor2);
+    }
+    return true;
+}
+
+WilImagePackage::Memcpy16To32Func WilImagePackage::Memcpy16To32Kernel(int nKernel)
+{
+    switch(nKernel){
+        case 0:
+            {
+                return Memcpy16To32Scalar;
+            }
+#if defined(WIL_DECODE_SSE2)
+        case 1:
+            {
+                return Memcpy16To32SSE2;
+            }
+#endif
+#if defined(WIL_DECODE_AVX2)
+        case 2:
+            {
+                return CPUSupportAVX2() ? Memcpy16To32AVX2 : nullptr;
+            }
+#endif
+        default:
+            {
+                return nullptr;
+            }
+    }
+}
+
 int32_t WilImagePackage::ImageCount()
 {
     return m_wilFile ? m_wilFileHeader.nImageCount : 0;
@@ -53,6 +53,15 @@ struct WILIMAGEINFO
 
 #pragma pack(pop)
 
+// one image in the package decoded by DecodePackage()
+// pixels are at buffer + Offset, row by row with Info.shWidth pixels per row
+struct WilPackageImage
+{
+    uint32_t     Index;
+    WILIMAGEINFO Info;
+    size_t       Offset;
+};
+
 class WilImagePackage
 {
     private:
@@ -89,6 +98,16 @@ class WilImagePackage
         bool Load(const char *, const char *, const char *);
         void Decode(uint32_t *, uint32_t, uint32_t, uint32_t);
 
+    public:
+        // decode raw image data copied from CurrentImageBuffer()
+        // doesn't touch any package state, safe to call in multiple threads
+        static void DecodeImage(uint32_t *, const WILIMAGEINFO &, const uint16_t *, uint32_t, uint32_t, uint32_t);
+
+    public:
+        // decode all valid images into one buffer
+        // pass the same buffer and list for different packages to reuse their memory
+        bool DecodePackage(std::vector<uint32_t> *, std::vector<WilPackageImage> *, uint32_t, uint32_t, uint32_t);
+
     public:
         const WILFILEHEADER &HeaderInfo() const;
 
@@ -97,6 +116,12 @@ class WilImagePackage
         bool                 CurrentImageValid();
         const uint16_t      *CurrentImageBuffer();
 
+    public:
+        // kernels used by Decode() for white mixing color, 0 : scalar, 1 : SSE2, 2 : AVX2
+        // returns nullptr if the kernel is not built in or not supported by current CPU
+        using Memcpy16To32Func = void (*)(uint32_t *, const uint16_t *, int32_t, uint32_t);
+        static Memcpy16To32Func Memcpy16To32Kernel(int);
+
     public:
         static int WixOffset(int);
         static int WilOffset(int);
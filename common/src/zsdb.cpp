@@ -16,23 +16,28 @@
  * =====================================================================================
  */
 
+#include <map>
+#include <mutex>
 #include <regex>
+#include <atomic>
+#include <thread>
 #include <zstd.h>
+#include <zdict.h>
 #include <cstdio>
 #include <cstring>
 #include <stdexcept>
 #include <cinttypes>
 #include <algorithm>
+#include <exception>
 #include <filesystem>
 
 #include "zsdb.hpp"
+#include "hexstr.hpp"
 #include "fileptr.hpp"
 #include "fflerror.hpp"
 #include "totype.hpp"
 
-constexpr static int g_compLevel = 3;
-
-static std::vector<uint8_t> compressDataBuf(const uint8_t *pDataBuf, size_t nDataLen, ZSTD_CCtx *pCCtx, const ZSTD_CDict *pCDict)
+static std::vector<uint8_t> compressDataBuf(const uint8_t *pDataBuf, size_t nDataLen, ZSTD_CCtx *pCCtx, const ZSTD_CDict *pCDict, int nCompLevel)
 {
     if(!pDataBuf || !nDataLen){
         return {};
@@ -44,9 +49,9 @@ static std::vector<uint8_t> compressDataBuf(const uint8_t *pDataBuf, size_t nDat
     if(pCCtx && pCDict){
         nRC = ZSTD_compress_usingCDict(pCCtx, stRetBuf.data(), stRetBuf.size(), pDataBuf, nDataLen, pCDict);
     }else if(pCCtx){
-        nRC = ZSTD_compressCCtx(pCCtx, stRetBuf.data(), stRetBuf.size(), pDataBuf, nDataLen, g_compLevel);
+        nRC = ZSTD_compressCCtx(pCCtx, stRetBuf.data(), stRetBuf.size(), pDataBuf, nDataLen, nCompLevel);
     }else{
-        nRC = ZSTD_compress(stRetBuf.data(), stRetBuf.size(), pDataBuf, nDataLen, g_compLevel);
+        nRC = ZSTD_compress(stRetBuf.data(), stRetBuf.size(), pDataBuf, nDataLen, nCompLevel);
     }
 
     if(ZSTD_isError(nRC)){
@@ -57,40 +62,48 @@ static std::vector<uint8_t> compressDataBuf(const uint8_t *pDataBuf, size_t nDat
     return stRetBuf;
 }
 
-static std::vector<uint8_t> decompressDataBuf(const uint8_t *pDataBuf, size_t nDataLen, ZSTD_DCtx *pDCtx, const ZSTD_DDict *pDDict)
+static bool decompressDataBuf(const uint8_t *pDataBuf, size_t nDataLen, ZSTD_DCtx *pDCtx, const ZSTD_DDict *pDDict, std::vector<uint8_t> *pDstBuf)
 {
-    if(!pDataBuf || !nDataLen){
-        return {};
+    if(!pDataBuf || !nDataLen || !pDstBuf){
+        return false;
     }
 
-    std::vector<uint8_t> stRetBuf;
     switch(auto nDecompSize = ZSTD_getFrameContentSize(pDataBuf, nDataLen)){
         case ZSTD_CONTENTSIZE_ERROR:
         case ZSTD_CONTENTSIZE_UNKNOWN:
             {
-                return {};
+                return false;
             }
         default:
             {
-                stRetBuf.resize(nDecompSize);
+                pDstBuf->resize(nDecompSize);
                 break;
             }
     }
 
     size_t nRC = 0;
     if(pDCtx && pDDict){
-        nRC = ZSTD_decompress_usingDDict(pDCtx, stRetBuf.data(), stRetBuf.size(), pDataBuf, nDataLen, pDDict);
+        nRC = ZSTD_decompress_usingDDict(pDCtx, pDstBuf->data(), pDstBuf->size(), pDataBuf, nDataLen, pDDict);
     }else if(pDCtx){
-        nRC = ZSTD_decompressDCtx(pDCtx, stRetBuf.data(), stRetBuf.size(), pDataBuf, nDataLen);
+        nRC = ZSTD_decompressDCtx(pDCtx, pDstBuf->data(), pDstBuf->size(), pDataBuf, nDataLen);
     }else{
-        nRC = ZSTD_decompress(stRetBuf.data(), stRetBuf.size(), pDataBuf, nDataLen);
+        nRC = ZSTD_decompress(pDstBuf->data(), pDstBuf->size(), pDataBuf, nDataLen);
     }
 
     if(ZSTD_isError(nRC)){
-        return {};
+        return false;
     }
 
-    stRetBuf.resize(nRC);
+    pDstBuf->resize(nRC);
+    return true;
+}
+
+static std::vector<uint8_t> decompressDataBuf(const uint8_t *pDataBuf, size_t nDataLen, ZSTD_DCtx *pDCtx, const ZSTD_DDict *pDDict)
+{
+    std::vector<uint8_t> stRetBuf;
+    if(!decompressDataBuf(pDataBuf, nDataLen, pDCtx, pDDict, &stRetBuf)){
+        return {};
+    }
     return stRetBuf;
 }
 
@@ -144,6 +157,43 @@ static std::vector<uint8_t> decompFileOffData(std::FILE *fp, size_t nDataOff, si
     return decompressDataBuf(stCompBuf.data(), stCompBuf.size(), pDCtx, pDDict);
 }
 
+static std::vector<uint8_t> trainDictBuf(const std::vector<std::filesystem::path> &rstPathList, size_t nDictSize)
+{
+    if(rstPathList.empty() || !nDictSize){
+        return {};
+    }
+
+    // zstd suggests about 100x of dictionary size as samples
+    // pick files evenly over the sorted list so result is deterministic
+    const size_t nSampleBudget = nDictSize * 100;
+    const size_t nSampleStep = std::max<size_t>(1, rstPathList.size() / 4096);
+
+    std::vector<uint8_t> stSampleBuf;
+    std::vector<size_t> stSampleSizeList;
+
+    for(size_t i = 0; i < rstPathList.size() && stSampleBuf.size() < nSampleBudget; i += nSampleStep){
+        const auto stDataBuf = readFileData(reinterpret_cast<const char *>(rstPathList[i].u8string().c_str()));
+        if(stDataBuf.empty()){
+            continue;
+        }
+
+        stSampleBuf.insert(stSampleBuf.end(), stDataBuf.begin(), stDataBuf.end());
+        stSampleSizeList.push_back(stDataBuf.size());
+    }
+
+    std::vector<uint8_t> stDictBuf(nDictSize);
+    const auto nRC = ZDICT_trainFromBuffer(stDictBuf.data(), stDictBuf.size(), stSampleBuf.data(), stSampleSizeList.data(), (unsigned)(stSampleSizeList.size()));
+
+    // too few samples fails the training
+    // caller builds the database without dictionary
+    if(ZDICT_isError(nRC)){
+        return {};
+    }
+
+    stDictBuf.resize(nRC);
+    return stDictBuf;
+}
+
 const ZSDB::InnEntry &ZSDB::GetErrorEntry()
 {
     const static auto s_ErrorEntry = []() -> InnEntry
@@ -163,22 +213,42 @@ const ZSDB::InnEntry &ZSDB::GetErrorEntry()
 
 ZSDB::ZSDB(const char *szPath)
     : m_fp(nullptr)
+    , m_fileMap()
     , m_DCtx(nullptr)
     , m_DDict(nullptr)
     , m_header()
     , m_entryList()
     , m_fileNameBuf()
 {
-    m_fp = std::fopen(szPath, "rb");
-    if(!m_fp){
-        throw fflerror("failed to open database file");
-    }
+    const uint64_t nMagic = [szPath]() -> uint64_t
+    {
+        uint64_t nMagic = 0;
+        if(std::fread(&nMagic, sizeof(nMagic), 1, make_fileptr(szPath, "rb").get()) != 1){
+            throw fflerror("failed to load zsdb header");
+        }
+        return nMagic;
+    }();
 
     m_DCtx = ZSTD_createDCtx();
     if(!m_DCtx){
         throw fflerror("failed to create decompress context");
     }
 
+    if(nMagic == ZSDB_V2_MAGIC){
+        m_fileMap = std::make_unique<FileMap>(szPath);
+        LoadV2();
+    }
+    else{
+        m_fp = std::fopen(szPath, "rb");
+        if(!m_fp){
+            throw fflerror("failed to open database file");
+        }
+        LoadV1();
+    }
+}
+
+void ZSDB::LoadV1()
+{
     if(auto stHeaderData = readFileOffData(m_fp, 0, sizeof(ZSDBHeader)); stHeaderData.empty()){
         throw fflerror("failed to load izdb header");
     }else{
@@ -231,11 +301,88 @@ ZSDB::ZSDB(const char *szPath)
             m_fileNameBuf.insert(m_fileNameBuf.end(), pHead, pHead + stFileNameBuf.size());
         }
     }
+
+    m_entryHead    = m_entryList.data();
+    m_entryNum     = m_entryList.size();
+    m_fileNameHead = m_fileNameBuf.data();
+}
+
+void ZSDB::LoadV2()
+{
+    const auto pMapData = m_fileMap->data();
+    const auto nMapSize = m_fileMap->size();
+
+    if(nMapSize < sizeof(ZSDBHeaderV2)){
+        throw fflerror("zsdb database file corrupted");
+    }
+
+    ZSDBHeaderV2 stHeader;
+    std::memcpy(&stHeader, pMapData, sizeof(stHeader));
+
+    const auto fnCheckSection = [nMapSize](uint64_t nOffset, uint64_t nLength)
+    {
+        if(nOffset > nMapSize || nLength > nMapSize - nOffset){
+            throw fflerror("zsdb database file corrupted: (off = %llu, length = %llu)", to_llu(nOffset), to_llu(nLength));
+        }
+    };
+
+    fnCheckSection(stHeader.DictOffset,     stHeader.DictLength    );
+    fnCheckSection(stHeader.EntryOffset,    stHeader.EntryLength   );
+    fnCheckSection(stHeader.FileNameOffset, stHeader.FileNameLength);
+    fnCheckSection(stHeader.KeyOffset,      stHeader.KeyLength     );
+    fnCheckSection(stHeader.StreamOffset,   stHeader.StreamLength  );
+
+    if(false
+            || stHeader.EntryLength != stHeader.EntryNum * sizeof(InnEntry)
+            || stHeader.KeyLength   != stHeader.KeyNum   * sizeof(KeyEntry)
+            || (stHeader.FileNameLength && pMapData[stHeader.FileNameOffset + stHeader.FileNameLength - 1] != '\0')){
+        throw fflerror("zsdb database file corrupted");
+    }
+
+    if(stHeader.DictLength){
+        m_DDict = ZSTD_createDDict(pMapData + stHeader.DictOffset, check_cast<size_t>(stHeader.DictLength));
+        if(!m_DDict){
+            throw fflerror("create decompression dictory failed");
+        }
+    }
+
+    m_entryHead    = (const InnEntry *)(pMapData + stHeader.EntryOffset);
+    m_entryNum     = check_cast<size_t>(stHeader.EntryNum);
+    m_fileNameHead = (const char *)(pMapData + stHeader.FileNameOffset);
+
+    m_keyHead = (const KeyEntry *)(pMapData + stHeader.KeyOffset);
+    m_keyNum  = check_cast<size_t>(stHeader.KeyNum);
+
+    m_streamHead   = pMapData + stHeader.StreamOffset;
+    m_streamLength = check_cast<size_t>(stHeader.StreamLength);
+
+    // validate once at loading
+    // then lookup and decompression don't need to check offsets
+    for(size_t i = 0; i < m_entryNum; ++i){
+        if(false
+                || m_entryHead[i].FileName >= stHeader.FileNameLength
+                || m_entryHead[i].Offset > m_streamLength
+                || m_entryHead[i].Length > m_streamLength - m_entryHead[i].Offset){
+            throw fflerror("zsdb database file corrupted");
+        }
+    }
+
+    for(size_t i = 0; i < m_keyNum; ++i){
+        if(m_keyHead[i].Entry >= m_entryNum){
+            throw fflerror("zsdb database file corrupted");
+        }
+    }
+
+    m_header.ZStdVersion = stHeader.ZStdVersion;
+    m_header.EntryNum    = stHeader.EntryNum;
 }
 
 ZSDB::~ZSDB()
 {
-    std::fclose(m_fp);
+    if(m_fp){
+        std::fclose(m_fp);
+    }
+
     ZSTD_freeDCtx(m_DCtx);
     ZSTD_freeDDict(m_DDict);
 }
@@ -246,30 +393,50 @@ const char *ZSDB::Decomp(const char *szFileName, size_t nCheckLen, std::vector<u
         return nullptr;
     }
 
-    auto p = std::lower_bound(m_entryList.begin(), m_entryList.end(), szFileName, [this, nCheckLen](const InnEntry &lhs, const char *rhs) -> bool
+    auto p = std::lower_bound(m_entryHead, m_entryHead + m_entryNum, szFileName, [this, nCheckLen](const InnEntry &lhs, const char *rhs) -> bool
     {
         if(nCheckLen){
-            return std::strncmp(m_fileNameBuf.data() + lhs.FileName, rhs, nCheckLen) < 0;
+            return std::strncmp(m_fileNameHead + lhs.FileName, rhs, nCheckLen) < 0;
         }else{
-            return std::strcmp(m_fileNameBuf.data() + lhs.FileName, rhs) < 0;
+            return std::strcmp(m_fileNameHead + lhs.FileName, rhs) < 0;
         }
     });
 
-    if(p == m_entryList.end()){
+    if(p == m_entryHead + m_entryNum){
         return nullptr;
     }
 
     if(nCheckLen){
-        if(std::strncmp(szFileName, m_fileNameBuf.data() + p->FileName, nCheckLen)){
+        if(std::strncmp(szFileName, m_fileNameHead + p->FileName, nCheckLen)){
             return nullptr;
         }
     }else{
-        if(std::strcmp(szFileName, m_fileNameBuf.data() + p->FileName)){
+        if(std::strcmp(szFileName, m_fileNameHead + p->FileName)){
             return nullptr;
         }
     }
 
-    return ZSDB::DecompEntry(*p, pDstBuf) ? (m_fileNameBuf.data() + p->FileName) : nullptr;
+    return ZSDB::DecompEntry(*p, pDstBuf) ? (m_fileNameHead + p->FileName) : nullptr;
+}
+
+const char *ZSDB::Decomp(uint32_t nKey, std::vector<uint8_t> *pDstBuf)
+{
+    if(!m_fileMap){
+        char szKeyString[16];
+        return Decomp(hexstr::to_string<uint32_t, 4>(nKey, szKeyString, true), 8, pDstBuf);
+    }
+
+    auto p = std::lower_bound(m_keyHead, m_keyHead + m_keyNum, nKey, [](const KeyEntry &lhs, uint32_t rhs) -> bool
+    {
+        return lhs.Key < rhs;
+    });
+
+    if(p == m_keyHead + m_keyNum || p->Key != nKey){
+        return nullptr;
+    }
+
+    const auto &rstEntry = m_entryHead[p->Entry];
+    return ZSDB::DecompEntry(rstEntry, pDstBuf) ? (m_fileNameHead + rstEntry.FileName) : nullptr;
 }
 
 bool ZSDB::DecompEntry(const ZSDB::InnEntry &rstEntry, std::vector<uint8_t> *pDstBuf)
@@ -283,6 +450,20 @@ bool ZSDB::DecompEntry(const ZSDB::InnEntry &rstEntry, std::vector<uint8_t> *pDs
         return true;
     }
 
+    // v2 reads mapped pages directly
+    // no seek and no temporary buffer for compressed data
+    if(m_fileMap){
+        const auto pData = m_streamHead + rstEntry.Offset;
+        const auto nSize = check_cast<size_t>(rstEntry.Length);
+
+        if(rstEntry.Attribute & F_COMPRESSED){
+            return decompressDataBuf(pData, nSize, m_DCtx, m_DDict, pDstBuf);
+        }
+
+        pDstBuf->assign(pData, pData + nSize);
+        return true;
+    }
+
     std::vector<uint8_t> stRetBuf;
     if(rstEntry.Attribute & F_COMPRESSED){
         stRetBuf = decompFileOffData(m_fp, m_header.StreamOffset + rstEntry.Offset, rstEntry.Length, m_DCtx, m_DDict);
@@ -301,13 +482,13 @@ bool ZSDB::DecompEntry(const ZSDB::InnEntry &rstEntry, std::vector<uint8_t> *pDs
 std::vector<ZSDB::Entry> ZSDB::GetEntryList() const
 {
     std::vector<ZSDB::Entry> stRetBuf;
-    for(auto &rstEntry: m_entryList){
-        stRetBuf.emplace_back(m_fileNameBuf.data() + rstEntry.FileName, rstEntry.Length, rstEntry.Attribute);
+    for(size_t i = 0; i < m_entryNum; ++i){
+        stRetBuf.emplace_back(m_fileNameHead + m_entryHead[i].FileName, m_entryHead[i].Length, m_entryHead[i].Attribute);
     }
     return stRetBuf;
 }
 
-bool ZSDB::BuildDB(const char *szSaveFullName, const char *szFileNameRegex, const char *szDataPath, const char *szDictPath, double fCompRatio)
+bool ZSDB::BuildDB(const char *szSaveFullName, const char *szDataPath, const ZSDB::BuildOption &rstOption, ZSDB::BuildStat *pStat)
 {
     if(!szSaveFullName){
         return false;
@@ -317,124 +498,259 @@ bool ZSDB::BuildDB(const char *szSaveFullName, const char *szFileNameRegex, cons
         return false;
     }
 
-    ZSTD_CDict *pCDict = nullptr;
-    std::vector<uint8_t> stCDictBuf;
+    // collect and sort input first
+    // stream layout follows file name order, no matter which worker compresses it
+    std::vector<std::filesystem::path> stPathList;
+    {
+        std::regex stFileNameReg(rstOption.FileNameRegex ? rstOption.FileNameRegex : ".*");
+        for(auto &p: std::filesystem::directory_iterator(szDataPath)){
+            if(!p.is_regular_file()){
+                continue;
+            }
 
-    if(szDictPath){
-        stCDictBuf = readFileData(szDictPath);
-        if(stCDictBuf.empty()){
-            return false;
+            if(rstOption.FileNameRegex){
+                if(!std::regex_match(reinterpret_cast<const char *>(p.path().filename().u8string().c_str()), stFileNameReg)){
+                    continue;
+                }
+            }
+            stPathList.push_back(p.path());
         }
 
-        pCDict = ZSTD_createCDict(stCDictBuf.data(), stCDictBuf.size(), g_compLevel);
-        if(!pCDict){
+        std::sort(stPathList.begin(), stPathList.end(), [](const auto &lhs, const auto &rhs) -> bool
+        {
+            return lhs.filename().u8string() < rhs.filename().u8string();
+        });
+    }
+
+    std::vector<uint8_t> stCDictBuf;
+    if(rstOption.DictPath){
+        stCDictBuf = readFileData(rstOption.DictPath);
+        if(stCDictBuf.empty()){
             return false;
         }
     }
-
-    ZSTD_CCtx *pCCtx = ZSTD_createCCtx();
-    if(!pCCtx){
-        return false;
+    else if(rstOption.TrainDictSize){
+        stCDictBuf = trainDictBuf(stPathList, rstOption.TrainDictSize);
     }
 
-    std::vector<char> stFileNameBuf;
-    std::vector<uint8_t> stStreamBuf;
-    std::vector<InnEntry> stEntryList;
+    // decide levels in main thread
+    // std::regex is not meant to be shared by workers
+    std::vector<int> stLevelList;
+    {
+        std::vector<std::pair<std::regex, int>> stLevelRegList;
+        for(const auto &[szRegex, nLevel]: rstOption.CompLevelList){
+            stLevelRegList.emplace_back(std::regex(szRegex), nLevel);
+        }
 
-    size_t nCount = 0;
-    std::regex stFileNameReg(szFileNameRegex ? szFileNameRegex : ".*");
+        for(const auto &rstPath: stPathList){
+            const auto szFileName = rstPath.filename().u8string();
+            const auto p = std::find_if(stLevelRegList.begin(), stLevelRegList.end(), [&szFileName](const auto &rstLevelReg) -> bool
+            {
+                return std::regex_match(reinterpret_cast<const char *>(szFileName.c_str()), rstLevelReg.first);
+            });
+            stLevelList.push_back((p == stLevelRegList.end()) ? rstOption.CompLevel : p->second);
+        }
+    }
 
-    for(auto &p: std::filesystem::directory_iterator(szDataPath)){
-        if(!p.is_regular_file()){
-            continue;
+    // dictionary is digested with a fixed level
+    // create one read-only CDict per level, shared by all workers
+    const auto fnFreeCDict = [](std::map<int, ZSTD_CDict *> *pCDictList)
+    {
+        for(auto &p: *pCDictList){
+            ZSTD_freeCDict(p.second);
         }
+    };
+
+    std::map<int, ZSTD_CDict *> stCDictList;
+    std::unique_ptr<std::map<int, ZSTD_CDict *>, decltype(fnFreeCDict)> stCDictListGuard(&stCDictList, fnFreeCDict);
 
-        auto szFileName = p.path().filename().u8string();
-        if(szFileNameRegex){
-            if(!std::regex_match(reinterpret_cast<const char *>(szFileName.c_str()), stFileNameReg)){
+    if(!stCDictBuf.empty()){
+        for(const auto nLevel: stLevelList){
+            if(stCDictList.count(nLevel)){
                 continue;
             }
+
+            if(auto pCDict = ZSTD_createCDict(stCDictBuf.data(), stCDictBuf.size(), nLevel)){
+                stCDictList[nLevel] = pCDict;
+            }
+            else{
+                return false;
+            }
         }
+    }
 
-        auto stSrcBuf = readFileData(reinterpret_cast<const char *>(p.path().u8string().c_str()));
-        if(stSrcBuf.empty()){
-            continue;
+    struct CompResult
+    {
+        bool Compressed = false;
+        std::vector<uint8_t> DataBuf;
+        size_t SrcLength = 0;
+    };
+
+    std::vector<CompResult> stResultList(stPathList.size());
+    {
+        std::atomic<size_t> nNextIndex {0};
+        std::exception_ptr stException;
+        std::mutex stExceptionLock;
+
+        const auto fnWorker = [&]()
+        {
+            ZSTD_CCtx *pCCtx = ZSTD_createCCtx();
+            if(!pCCtx){
+                std::lock_guard<std::mutex> stLockGuard(stExceptionLock);
+                stException = std::make_exception_ptr(fflerror("failed to create compress context"));
+                return;
+            }
+
+            try{
+                for(size_t nIndex = nNextIndex++; nIndex < stPathList.size(); nIndex = nNextIndex++){
+                    auto stSrcBuf = readFileData(reinterpret_cast<const char *>(stPathList[nIndex].u8string().c_str()));
+                    if(stSrcBuf.empty()){
+                        continue;
+                    }
+
+                    const auto pCDict = stCDictList.empty() ? nullptr : stCDictList.at(stLevelList[nIndex]);
+                    auto stDstBuf = compressDataBuf(stSrcBuf.data(), stSrcBuf.size(), pCCtx, pCDict, stLevelList[nIndex]);
+                    if(stDstBuf.empty()){
+                        continue;
+                    }
+
+                    auto &rstResult = stResultList[nIndex];
+                    rstResult.SrcLength  = stSrcBuf.size();
+                    rstResult.Compressed = ((1.00 * stDstBuf.size() / stSrcBuf.size()) < rstOption.CompRatio);
+                    rstResult.DataBuf    = std::move(rstResult.Compressed ? stDstBuf : stSrcBuf);
+                }
+            }
+            catch(...){
+                std::lock_guard<std::mutex> stLockGuard(stExceptionLock);
+                stException = std::current_exception();
+            }
+            ZSTD_freeCCtx(pCCtx);
+        };
+
+        const int nThreadNum = (rstOption.ThreadNum > 0) ? rstOption.ThreadNum : std::max<int>(1, (int)(std::thread::hardware_concurrency()));
+        std::vector<std::thread> stThreadList;
+
+        for(int i = 1; i < nThreadNum; ++i){
+            stThreadList.emplace_back(fnWorker);
+        }
+
+        fnWorker();
+        for(auto &rstThread: stThreadList){
+            rstThread.join();
         }
 
-        auto stDstBuf = compressDataBuf(stSrcBuf.data(), stSrcBuf.size(), pCCtx, pCDict);
-        if(stDstBuf.empty()){
+        if(stException){
+            std::rethrow_exception(stException);
+        }
+    }
+
+    std::vector<char> stFileNameBuf;
+    std::vector<uint8_t> stStreamBuf;
+    std::vector<InnEntry> stEntryList;
+
+    size_t nCount = 0;
+    size_t nSrcLength = 0;
+
+    for(size_t i = 0; i < stPathList.size(); ++i){
+        const auto &rstResult = stResultList[i];
+        if(rstResult.DataBuf.empty()){
             continue;
         }
 
-        bool bCompressed = ((1.00 * stDstBuf.size() / stSrcBuf.size()) < fCompRatio);
-        auto &rstCurrBuf = bCompressed ? stDstBuf : stSrcBuf;
+        const auto szFileName = stPathList[i].filename().u8string();
 
         InnEntry stEntry;
         std::memset(&stEntry, 0, sizeof(stEntry));
 
         stEntry.Offset = stStreamBuf.size();
-        stEntry.Length = rstCurrBuf.size();
-        stStreamBuf.insert(stStreamBuf.end(), rstCurrBuf.begin(), rstCurrBuf.end());
+        stEntry.Length = rstResult.DataBuf.size();
+        stStreamBuf.insert(stStreamBuf.end(), rstResult.DataBuf.begin(), rstResult.DataBuf.end());
 
         stEntry.FileName = stFileNameBuf.size();
         stFileNameBuf.insert(stFileNameBuf.end(), szFileName.begin(), szFileName.end());
         stFileNameBuf.push_back('\0');
 
-        if(bCompressed){
+        if(rstResult.Compressed){
             stEntry.Attribute |= F_COMPRESSED;
         }
 
         stEntryList.push_back(stEntry);
+        nSrcLength += rstResult.SrcLength;
         nCount++;
     }
 
-    std::sort(stEntryList.begin(), stEntryList.end(), [&stFileNameBuf](const InnEntry &lhs, const InnEntry &rhs) -> bool
-    {
-        return std::strcmp(stFileNameBuf.data() + lhs.FileName, stFileNameBuf.data() + rhs.FileName) < 0;
-    });
+    if(pStat){
+        pStat->EntryNum   = nCount;
+        pStat->DictLength = stCDictBuf.size();
+        pStat->SrcLength  = nSrcLength;
+        pStat->DstLength  = stStreamBuf.size();
+    }
+
+    if(stEntryList.size() > UINT32_MAX){
+        return false;
+    }
 
-    stEntryList.push_back(GetErrorEntry());
+    // entries are sorted by file name
+    // then keys from the 8 hex digits prefix are sorted already, keep the first one for same key
+    std::vector<KeyEntry> stKeyList;
+    for(size_t i = 0; i < stEntryList.size(); ++i){
+        const char *szFileName = stFileNameBuf.data() + stEntryList[i].FileName;
+        if(!std::all_of(szFileName, szFileName + 8, [](char chByte) -> bool
+        {
+            return (chByte >= '0' && chByte <= '9') || (chByte >= 'A' && chByte <= 'F');
+        })){
+            continue;
+        }
+
+        const auto nKey = hexstr::to_hex<uint32_t, 4>(szFileName);
+        if(stKeyList.empty() || stKeyList.back().Key != nKey){
+            stKeyList.push_back({nKey, (uint32_t)(i)});
+        }
+    }
+
+    const auto fnAlign = [](uint64_t nOffset) -> uint64_t
+    {
+        return (nOffset + 7) / 8 * 8;
+    };
 
-    ZSDBHeader stHeader;
+    ZSDBHeaderV2 stHeader;
     std::memset(&stHeader, 0, sizeof(stHeader));
 
+    stHeader.Magic       = ZSDB_V2_MAGIC;
     stHeader.ZStdVersion = ZSTD_versionNumber();
     stHeader.EntryNum    = nCount;
+    stHeader.KeyNum      = stKeyList.size();
 
-    stHeader.DictOffset = sizeof(stHeader);
+    stHeader.DictOffset = fnAlign(sizeof(stHeader));
     stHeader.DictLength = stCDictBuf.size();
 
-    auto stEntryCompBuf = compressDataBuf((uint8_t *)(stEntryList.data()), stEntryList.size() * sizeof(InnEntry), pCCtx, nullptr);
-    stHeader.EntryOffset = stHeader.DictOffset + stHeader.DictLength;
-    stHeader.EntryLength = stEntryCompBuf.size();
+    stHeader.EntryOffset = fnAlign(stHeader.DictOffset + stHeader.DictLength);
+    stHeader.EntryLength = stEntryList.size() * sizeof(InnEntry);
 
-    auto stFileNameCompBuf = compressDataBuf((uint8_t *)(stFileNameBuf.data()), stFileNameBuf.size(), pCCtx, nullptr);
-    stHeader.FileNameOffset = stHeader.EntryOffset + stHeader.EntryLength;
-    stHeader.FileNameLength = stFileNameCompBuf.size();
+    stHeader.FileNameOffset = fnAlign(stHeader.EntryOffset + stHeader.EntryLength);
+    stHeader.FileNameLength = stFileNameBuf.size();
 
-    stHeader.StreamOffset = stHeader.FileNameOffset + stHeader.FileNameLength;
+    stHeader.KeyOffset = fnAlign(stHeader.FileNameOffset + stHeader.FileNameLength);
+    stHeader.KeyLength = stKeyList.size() * sizeof(KeyEntry);
+
+    stHeader.StreamOffset = fnAlign(stHeader.KeyOffset + stHeader.KeyLength);
     stHeader.StreamLength = stStreamBuf.size();
 
     auto fp = make_fileptr(szSaveFullName, "wb");
-    if(!fp){
-        return false;
-    }
-
-    if(std::fwrite(&stHeader, sizeof(stHeader), 1, fp.get()) != 1){
-        return false;
-    }
-
-    if(std::fwrite(stEntryCompBuf.data(), stEntryCompBuf.size(), 1, fp.get()) != 1){
-        return false;
-    }
-
-    if(std::fwrite(stFileNameCompBuf.data(), stFileNameCompBuf.size(), 1, fp.get()) != 1){
-        return false;
-    }
-
-    if(std::fwrite(stStreamBuf.data(), stStreamBuf.size(), 1, fp.get()) != 1){
-        return false;
-    }
-
-    return true;
+    const auto fnWriteSection = [&fp](uint64_t nOffset, const void *pData, size_t nLength) -> bool
+    {
+        if(std::fseek(fp.get(), check_cast<long>(nOffset), SEEK_SET)){
+            return false;
+        }
+        return !nLength || (std::fwrite(pData, nLength, 1, fp.get()) == 1);
+    };
+
+    // fseek beyond the end fills the gap with zeros
+    return true
+        && fnWriteSection(0,                       &stHeader,            sizeof(stHeader))
+        && fnWriteSection(stHeader.DictOffset,     stCDictBuf.data(),    stCDictBuf.size())
+        && fnWriteSection(stHeader.EntryOffset,    stEntryList.data(),   stHeader.EntryLength)
+        && fnWriteSection(stHeader.FileNameOffset, stFileNameBuf.data(), stFileNameBuf.size())
+        && fnWriteSection(stHeader.KeyOffset,      stKeyList.data(),     stHeader.KeyLength)
+        && fnWriteSection(stHeader.StreamOffset,   stStreamBuf.data(),   stStreamBuf.size());
 }
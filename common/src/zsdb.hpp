@@ -17,10 +17,14 @@
  */
 
 #pragma once
+#include <string>
+#include <memory>
 #include <vector>
 #include <cstdio>
 #include <cstdint>
+#include <utility>
 #include "zstd.h"
+#include "filemap.hpp"
 
 class ZSDB final
 {
@@ -44,6 +48,37 @@ class ZSDB final
             F_COMPRESSED = 1,
         };
 
+    public:
+        struct BuildOption
+        {
+            const char *FileNameRegex = nullptr;
+            const char *DictPath      = nullptr;
+
+            // keep raw data if compressed size / raw size >= CompRatio
+            double CompRatio = 0.90;
+
+            // 0 means std::thread::hardware_concurrency()
+            int ThreadNum = 0;
+
+            // train a dictionary of this size from sampled input if DictPath is null
+            // 0 disables training
+            size_t TrainDictSize = 0;
+
+            // level for file name matches CompLevelList[i].first, first match wins
+            // others use CompLevel
+            int CompLevel = 3;
+            std::vector<std::pair<std::string, int>> CompLevelList;
+        };
+
+        struct BuildStat
+        {
+            size_t EntryNum   = 0;
+            size_t DictLength = 0;
+
+            size_t SrcLength = 0;
+            size_t DstLength = 0;
+        };
+
     private:
 #pragma pack(push, 1)
         struct ZSDBHeader
@@ -71,10 +106,50 @@ class ZSDB final
             uint64_t FileName;
             uint64_t Attribute;
         };
+
+        // v2 keeps every section uncompressed and 8-byte aligned
+        // then the file can be mapped and used in place
+        struct ZSDBHeaderV2
+        {
+            uint64_t Magic;
+            uint64_t ZStdVersion;
+            uint64_t EntryNum;
+            uint64_t KeyNum;
+
+            uint64_t DictOffset;
+            uint64_t DictLength;
+
+            uint64_t EntryOffset;
+            uint64_t EntryLength;
+
+            uint64_t FileNameOffset;
+            uint64_t FileNameLength;
+
+            uint64_t KeyOffset;
+            uint64_t KeyLength;
+
+            uint64_t StreamOffset;
+            uint64_t StreamLength;
+        };
+
+        // file name starts with 8 hex digits gets an integer key
+        // sorted by key, same key keeps the first entry in name order
+        struct KeyEntry
+        {
+            uint32_t Key;
+            uint32_t Entry;
+        };
 #pragma pack(pop)
 
     private:
+        // "ZSDB2" in little endian
+        // v1 header starts with zstd version number which never reaches this value
+        constexpr static uint64_t ZSDB_V2_MAGIC = 0X000000324244535A;
+
+    private:
+        // v1 reads by m_fp, v2 maps the whole file
         std::FILE *m_fp;
+        std::unique_ptr<FileMap> m_fileMap;
 
     private:
         ZSTD_DCtx  *m_DCtx;
@@ -89,6 +164,21 @@ class ZSDB final
     private:
         std::vector<char> m_fileNameBuf;
 
+    private:
+        // point to v1 buffers or v2 mapped sections
+        const InnEntry *m_entryHead    = nullptr;
+        size_t          m_entryNum     = 0;
+        const char     *m_fileNameHead = nullptr;
+
+    private:
+        // v2 only
+        const KeyEntry *m_keyHead = nullptr;
+        size_t          m_keyNum  = 0;
+
+    private:
+        const uint8_t *m_streamHead   = nullptr;
+        size_t         m_streamLength = 0;
+
     public:
         ZSDB(const char *);
 
@@ -98,6 +188,15 @@ class ZSDB final
     public:
         const char *Decomp(const char *, size_t, std::vector<uint8_t> *);
 
+    public:
+        // same as Decomp(hexstr::to_string<uint32_t, 4>(key), 8, buf)
+        // v2 database uses the integer index, no string compare
+        const char *Decomp(uint32_t, std::vector<uint8_t> *);
+
+    private:
+        void LoadV1();
+        void LoadV2();
+
     private:
         bool DecompEntry(const InnEntry &, std::vector<uint8_t> *);
 
@@ -108,5 +207,7 @@ class ZSDB final
         std::vector<ZSDB::Entry> GetEntryList() const;
 
     public:
-        static bool BuildDB(const char *, const char *, const char *, const char *, double);
+        // always builds v2 database
+        // output only depends on input files and options, not on thread scheduling
+        static bool BuildDB(const char *, const char *, const BuildOption &, BuildStat * = nullptr);
 };
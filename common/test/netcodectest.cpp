@@ -0,0 +1,474 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: netcodectest.cpp
+ *        Created: 10/17/2026 16:10:42
+ *    Description: round trip test of netcodec.hpp
+ *
+ *                 encoder and decoder are driven the same way as ChannPackQ and NetIO:
+ *
+ *                     1. delta mode: XOR delta followed by zcompf::xorEncode()
+ *                     2. lz4 mode  : one stream per channel, small messages bypass it
+ *
+ *                 streams tested are random messages, messages built from real message
+ *                 structs and real text from server scripts, every decoded message has
+ *                 to match the original byte by byte
+ *
+ *                 message and script streams are also timed: the whole stream is encoded
+ *                 first like a sender running ahead, then decoded and compared as one
+ *                 round trip, encode and decode MB/s are counted by original bytes
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <iterator>
+#include <filesystem>
+#include "strf.hpp"
+#include "totype.hpp"
+#include "zcompf.hpp"
+#include "fflerror.hpp"
+#include "netcodec.hpp"
+#include "raiitimer.hpp"
+#include "servermsg.hpp"
+
+#define CHECK(expr) do{ if(!(expr)){ throw fflerror("check failed: %s", #expr); } }while(0)
+
+struct TestMessage
+{
+    uint8_t headCode = 0;
+    std::vector<uint8_t> data;
+};
+
+template<typename T> static TestMessage buildMessage(uint8_t headCode, const T &t)
+{
+    TestMessage msg;
+    msg.headCode = headCode;
+    msg.data.resize(sizeof(t));
+
+    std::memcpy(msg.data.data(), &t, sizeof(t));
+    return msg;
+}
+
+// returns bytes on wire
+static size_t deltaRoundTrip(const std::vector<TestMessage> &msgList)
+{
+    NetDeltaCodec encoder;
+    NetDeltaCodec decoder;
+
+    size_t wireLen = 0;
+    std::vector<uint8_t> deltaBuf;
+    std::vector<uint8_t> compBuf;
+    std::vector<uint8_t> decodeBuf;
+
+    for(const auto &msg: msgList){
+        deltaBuf.resize(msg.data.size());
+        encoder.encode(msg.headCode, deltaBuf.data(), msg.data.data(), msg.data.size());
+
+        compBuf.resize((msg.data.size() + 7) / 8 + msg.data.size());
+        const auto compCnt = zcompf::xorEncode(compBuf.data(), deltaBuf.data(), deltaBuf.size());
+        CHECK(compCnt >= 0);
+
+        const auto maskLen = (msg.data.size() + 7) / 8;
+        wireLen += 2 + maskLen + (size_t)(compCnt);
+
+        decodeBuf.resize(msg.data.size());
+        CHECK(zcompf::xorDecode(decodeBuf.data(), decodeBuf.size(), compBuf.data(), compBuf.data() + maskLen) == compCnt);
+
+        decoder.decode(msg.headCode, decodeBuf.data(), decodeBuf.size());
+        CHECK(decodeBuf == msg.data);
+    }
+    return wireLen;
+}
+
+// returns bytes on wire
+static size_t lz4RoundTrip(NetLZ4Encoder &encoder, NetLZ4Decoder &decoder, const std::vector<TestMessage> &msgList)
+{
+    size_t wireLen = 0;
+    std::vector<uint8_t> compBuf;
+    std::vector<uint8_t> decodeBuf;
+
+    for(const auto &msg: msgList){
+        if(msg.data.size() < NETCODEC_LZ4MINSIZE){
+            wireLen += 5 + msg.data.size();
+            continue;
+        }
+
+        compBuf.resize(NetLZ4Encoder::maxEncodeLen(msg.data.size()));
+        const auto compLen = encoder.encode(compBuf.data(), msg.data.data(), msg.data.size());
+        wireLen += 9 + compLen;
+
+        // encoder may not touch the source
+        // decoder gets exact compressed length and original length
+        decodeBuf.assign(msg.data.size(), 0XCC);
+        CHECK(decoder.decode(decodeBuf.data(), decodeBuf.size(), compBuf.data(), compLen));
+        CHECK(decodeBuf == msg.data);
+    }
+    return wireLen;
+}
+
+static size_t lz4RoundTrip(const std::vector<TestMessage> &msgList)
+{
+    NetLZ4Encoder encoder;
+    NetLZ4Decoder decoder;
+    return lz4RoundTrip(encoder, decoder, msgList);
+}
+
+static size_t rawLen(const std::vector<TestMessage> &msgList)
+{
+    size_t result = 0;
+    for(const auto &msg: msgList){
+        result += msg.data.size();
+    }
+    return result;
+}
+
+// best of some rounds, each round uses fresh codecs
+// encodes the whole stream before decoding any of it, then compares all decoded messages
+template<typename EncodeFunc, typename DecodeFunc> static void runThroughput(const char *name, const std::vector<TestMessage> &msgList, EncodeFunc fnEncode, DecodeFunc fnDecode)
+{
+    uint64_t encodeNsec = UINT64_MAX;
+    uint64_t decodeNsec = UINT64_MAX;
+
+    for(int round = 0; round < 5; ++round){
+        std::vector<std::vector<uint8_t>> wireList(msgList.size());
+        std::vector<std::vector<uint8_t>> decodeList(msgList.size());
+
+        const hres_timer encodeTimer;
+        fnEncode(wireList);
+        encodeNsec = std::min<uint64_t>(encodeNsec, encodeTimer.diff_nsec());
+
+        const hres_timer decodeTimer;
+        fnDecode(wireList, decodeList);
+        decodeNsec = std::min<uint64_t>(decodeNsec, decodeTimer.diff_nsec());
+
+        for(size_t i = 0; i < msgList.size(); ++i){
+            if(decodeList[i] != msgList[i].data){
+                throw fflerror("%s: message %zu doesn't match after round trip", name, i);
+            }
+        }
+    }
+
+    const double mbytes = rawLen(msgList) / (1024.0 * 1024.0);
+    std::printf("%s: encode %8.1f MB/s, decode %8.1f MB/s\n", name, mbytes * 1000000000.0 / std::max<uint64_t>(1, encodeNsec), mbytes * 1000000000.0 / std::max<uint64_t>(1, decodeNsec));
+}
+
+static void deltaThroughput(const char *name, const std::vector<TestMessage> &msgList)
+{
+    NetDeltaCodec encoder;
+    NetDeltaCodec decoder;
+
+    runThroughput(name, msgList, [&encoder, &msgList](auto &wireList)
+    {
+        encoder.reset();
+        std::vector<uint8_t> deltaBuf;
+
+        for(size_t i = 0; i < msgList.size(); ++i){
+            const auto &msg = msgList[i];
+            const auto maskLen = (msg.data.size() + 7) / 8;
+
+            deltaBuf.resize(msg.data.size());
+            encoder.encode(msg.headCode, deltaBuf.data(), msg.data.data(), msg.data.size());
+
+            wireList[i].resize(maskLen + msg.data.size());
+            const auto compCnt = zcompf::xorEncode(wireList[i].data(), deltaBuf.data(), deltaBuf.size());
+
+            CHECK(compCnt >= 0);
+            wireList[i].resize(maskLen + (size_t)(compCnt));
+        }
+    },
+
+    [&decoder, &msgList](const auto &wireList, auto &decodeList)
+    {
+        decoder.reset();
+        for(size_t i = 0; i < msgList.size(); ++i){
+            const auto &msg = msgList[i];
+            const auto maskLen = (msg.data.size() + 7) / 8;
+
+            decodeList[i].resize(msg.data.size());
+            CHECK(zcompf::xorDecode(decodeList[i].data(), decodeList[i].size(), wireList[i].data(), wireList[i].data() + maskLen) == (int)(wireList[i].size() - maskLen));
+            decoder.decode(msg.headCode, decodeList[i].data(), decodeList[i].size());
+        }
+    });
+}
+
+static void lz4Throughput(const char *name, const std::vector<TestMessage> &msgList)
+{
+    NetLZ4Encoder encoder;
+    NetLZ4Decoder decoder;
+
+    runThroughput(name, msgList, [&encoder, &msgList](auto &wireList)
+    {
+        encoder.reset();
+        for(size_t i = 0; i < msgList.size(); ++i){
+            const auto &msg = msgList[i];
+            if(msg.data.size() < NETCODEC_LZ4MINSIZE){
+                wireList[i] = msg.data;
+                continue;
+            }
+
+            wireList[i].resize(NetLZ4Encoder::maxEncodeLen(msg.data.size()));
+            wireList[i].resize(encoder.encode(wireList[i].data(), msg.data.data(), msg.data.size()));
+        }
+    },
+
+    [&decoder, &msgList](const auto &wireList, auto &decodeList)
+    {
+        decoder.reset();
+        for(size_t i = 0; i < msgList.size(); ++i){
+            if(msgList[i].data.size() < NETCODEC_LZ4MINSIZE){
+                decodeList[i] = wireList[i];
+                continue;
+            }
+
+            decodeList[i].resize(msgList[i].data.size());
+            CHECK(decoder.decode(decodeList[i].data(), decodeList[i].size(), wireList[i].data(), wireList[i].size()));
+        }
+    });
+}
+
+static void testDeltaRandom()
+{
+    // random bytes with few changes per message
+    // mostly hits the XOR path with non-zero bytes at random places
+
+    std::mt19937 rng(7);
+    std::vector<TestMessage> msgList;
+    std::vector<std::vector<uint8_t>> lastList(4);
+
+    for(int i = 0; i < 20000; ++i){
+        const uint8_t headCode = rng() % lastList.size();
+        auto &last = lastList[headCode];
+
+        // size of one head code is fixed in protocol
+        if(last.empty()){
+            last.resize(8 + headCode * 24);
+            for(auto &b: last){
+                b = rng();
+            }
+        }
+
+        for(int j = rng() % 4; j > 0; --j){
+            last[rng() % last.size()] = rng();
+        }
+        msgList.push_back({headCode, last});
+    }
+
+    const auto wireLen = deltaRoundTrip(msgList);
+    std::printf("delta random : %8zu -> %8zu bytes\n", rawLen(msgList), wireLen);
+}
+
+static void testDeltaMessage()
+{
+    // monsters walking around and taking damage
+    // built from real SMAction/SMUpdateHP
+
+    std::mt19937 rng(11);
+    std::vector<TestMessage> msgList;
+
+    for(int i = 0; i < 20000; ++i){
+        const uint64_t uid = 0X0300000000000000ULL + (rng() % 64);
+        if(rng() % 4){
+            SMAction smA;
+            std::memset(&smA, 0, sizeof(smA));
+
+            smA.UID = uid;
+            smA.MapID = 1;
+            smA.action.type = 1;
+            smA.action.speed = 100;
+            smA.action.direction = rng() % 8 + 1;
+            smA.action.x = 300 + (uid % 64) + rng() % 3;
+            smA.action.y = 200 + (uid % 64) + rng() % 3;
+            smA.action.aimX = smA.action.x + 1;
+            smA.action.aimY = smA.action.y;
+            msgList.push_back(buildMessage(SM_ACTION, smA));
+        }
+        else{
+            SMUpdateHP smUHP;
+            std::memset(&smUHP, 0, sizeof(smUHP));
+
+            smUHP.UID = uid;
+            smUHP.MapID = 1;
+            smUHP.HP = rng() % 100;
+            smUHP.HPMax = 100;
+            msgList.push_back(buildMessage(SM_UPDATEHP, smUHP));
+        }
+
+        CHECK(ServerMsg(msgList.back().headCode).deltaEncode());
+        CHECK(ServerMsg(msgList.back().headCode).dataLen() == msgList.back().data.size());
+    }
+
+    const auto wireLen = deltaRoundTrip(msgList);
+    std::printf("delta message: %8zu -> %8zu bytes\n", rawLen(msgList), wireLen);
+    deltaThroughput("delta message", msgList);
+}
+
+static void testLZ4Random()
+{
+    // random sizes, random and repeated content
+    // sizes cross 64KB and the encoder's internal buffer to hit all its paths
+
+    std::mt19937 rng(13);
+    std::vector<TestMessage> msgList;
+    std::vector<uint8_t> history;
+
+    for(int i = 0; i < 2000; ++i){
+        size_t msgLen = 0;
+        switch(rng() % 8){
+            case 0 : msgLen = 1 + rng() % NETCODEC_LZ4MINSIZE; break;
+            case 1 : msgLen = 64 * 1024 + rng() % (256 * 1024); break;
+            default: msgLen = NETCODEC_LZ4MINSIZE + rng() % 4096; break;
+        }
+
+        TestMessage msg;
+        msg.headCode = SM_TEXT;
+        msg.data.resize(msgLen);
+
+        for(size_t off = 0; off < msgLen;){
+            const size_t segLen = std::min<size_t>(msgLen - off, 1 + rng() % 512);
+            if(history.size() > segLen && rng() % 2){
+                // copy from earlier content, may be from far before 64KB
+                const size_t srcOff = rng() % (history.size() - segLen);
+                std::memcpy(msg.data.data() + off, history.data() + srcOff, segLen);
+            }
+            else{
+                for(size_t j = 0; j < segLen; ++j){
+                    msg.data[off + j] = (rng() % 4) ? ('a' + rng() % 8) : rng();
+                }
+            }
+            off += segLen;
+        }
+
+        history.insert(history.end(), msg.data.begin(), msg.data.end());
+        if(history.size() > 512 * 1024){
+            history.erase(history.begin(), history.begin() + (history.size() - 512 * 1024));
+        }
+        msgList.push_back(std::move(msg));
+    }
+
+    const auto wireLen = lz4RoundTrip(msgList);
+    std::printf("lz4 random   : %8zu -> %8zu bytes\n", rawLen(msgList), wireLen);
+    lz4Throughput("lz4 random   ", msgList);
+}
+
+static void testLZ4Script(const char *scriptDir)
+{
+    // real text sent as SM_NPCXMLLAYOUT / SM_TEXT is generated by server scripts
+    // cut script files into message sized pieces and send them twice in different order
+
+    std::vector<std::string> textList;
+    for(const auto &entry: std::filesystem::recursive_directory_iterator(scriptDir)){
+        if(entry.is_regular_file()){
+            std::ifstream f(entry.path(), std::ios::binary);
+            textList.emplace_back(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+        }
+    }
+    CHECK(!textList.empty());
+
+    std::mt19937 rng(17);
+    std::vector<TestMessage> msgList;
+
+    for(int round = 0; round < 2; ++round){
+        std::shuffle(textList.begin(), textList.end(), rng);
+        for(const auto &text: textList){
+            for(size_t off = 0; off < text.size();){
+                const size_t segLen = std::min<size_t>(text.size() - off, 16 + rng() % 2048);
+
+                TestMessage msg;
+                msg.headCode = SM_NPCXMLLAYOUT;
+                msg.data.assign(text.begin() + off, text.begin() + off + segLen);
+
+                msgList.push_back(std::move(msg));
+                off += segLen;
+            }
+        }
+    }
+
+    const auto wireLen = lz4RoundTrip(msgList);
+    std::printf("lz4 script   : %8zu -> %8zu bytes, %zu files\n", rawLen(msgList), wireLen, textList.size());
+    lz4Throughput("lz4 script   ", msgList);
+}
+
+static void testLZ4Dictionary()
+{
+    // dictionary has to carry over multiple messages, not only the last one
+    // a repeated incompressible message is nearly free if still within 64KB
+
+    std::mt19937 rng(19);
+    const auto fnRandomMessage = [&rng](size_t msgLen)
+    {
+        TestMessage msg;
+        msg.headCode = SM_TEXT;
+        msg.data.resize(msgLen);
+
+        for(auto &b: msg.data){
+            b = rng();
+        }
+        return msg;
+    };
+
+    const auto msgA = fnRandomMessage(4096);
+    const auto msgB = fnRandomMessage(4096);
+
+    NetLZ4Encoder encoder;
+    NetLZ4Decoder decoder;
+
+    const size_t lenA = lz4RoundTrip(encoder, decoder, {msgA});
+    const size_t lenB = lz4RoundTrip(encoder, decoder, {msgB});
+    const size_t lenAgain = lz4RoundTrip(encoder, decoder, {msgA});
+
+    std::printf("lz4 dict     : A = %zu, B = %zu, A again = %zu bytes\n", lenA, lenB, lenAgain);
+    CHECK(lenA > 4096);
+    CHECK(lenB > 4096);
+    CHECK(lenAgain < 128);
+
+    // push A out of the 64KB window
+    // then it's incompressible again, and decoding still works
+    for(int i = 0; i < 20; ++i){
+        lz4RoundTrip(encoder, decoder, {fnRandomMessage(4096)});
+    }
+    CHECK(lz4RoundTrip(encoder, decoder, {msgA}) > 4096);
+
+    // small message bypasses the stream, dictionary is kept
+    lz4RoundTrip(encoder, decoder, {fnRandomMessage(NETCODEC_LZ4MINSIZE - 1)});
+    CHECK(lz4RoundTrip(encoder, decoder, {msgA}) < 128);
+
+    // both ends reset at SM_NETCAPS, history before is dropped
+    encoder.reset();
+    decoder.reset();
+    CHECK(lz4RoundTrip(encoder, decoder, {msgA}) > 4096);
+    CHECK(lz4RoundTrip(encoder, decoder, {msgA}) < 128);
+}
+
+int main(int argc, char *argv[])
+{
+    try{
+        testDeltaRandom();
+        testDeltaMessage();
+        testLZ4Random();
+        testLZ4Script((argc > 1) ? argv[1] : MIR2X_TEST_SCRIPT_DIR);
+        testLZ4Dictionary();
+    }
+    catch(const std::exception &e){
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    std::printf("netcodectest passed\n");
+    return 0;
+}
@@ -43,6 +43,11 @@ struct ActorThreadMonitor
     uint64_t actorCount =  0;
     uint32_t liveTick   =  0;
     uint32_t busyTick   =  0;
+
+    // lateness of METRONOME sweep slots, in usec
+    // max is since last periodic report of the thread
+    uint32_t avgJitter  =  0;
+    uint32_t maxJitter  =  0;
 };
 
 struct AMProcMonitor
@@ -57,10 +62,17 @@ struct TriggerMonitor
     uint64_t procTick = 0;
 };
 
+struct WakeupMonitor
+{
+    uint64_t wakeupCount   = 0;
+    uint64_t resumeAvoided = 0;
+};
+
 struct ActorPodMonitor
 {
     uint64_t uid = 0;
     TriggerMonitor triggerMonitor;
+    WakeupMonitor  wakeupMonitor;
     std::array<AMProcMonitor, MPK_MAX> amProcMonitorList;
 
     operator bool () const
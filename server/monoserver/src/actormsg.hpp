@@ -33,6 +33,9 @@ enum MessagePackType: int
     MPK_PING,
     MPK_LOGIN,
     MPK_METRONOME,
+    MPK_WAKEUP,
+    MPK_HIBERNATE,
+    MPK_AWAKE,
     MPK_TRYMOVE,
     MPK_TRYSPACEMOVE,
     MPK_MOVEOK,
@@ -87,6 +90,10 @@ enum MessagePackType: int
     MPK_NPCQUERY,
     MPK_NPCEVENT,
     MPK_NPCERROR,
+    MPK_DBSAVEPLAYER,
+    MPK_DBQUERYLOGIN,
+    MPK_DBLOADPLAYER,
+    MPK_DBPLAYERDATA,
     MPK_MAX,
 };
 
@@ -550,3 +557,40 @@ struct AMNPCError
 {
     int errorID;
 };
+
+enum DBSavePlayerFieldType: uint32_t
+{
+    DBSPF_EXP   = 1 << 0,
+    DBSPF_GOLD  = 1 << 1,
+    DBSPF_LEVEL = 1 << 2,
+};
+
+struct AMDBSavePlayer
+{
+    uint32_t DBID;
+
+    // mask of DBSPF_XXX
+    // only fields in the mask get written
+    uint32_t dirty;
+
+    uint32_t exp;
+    uint32_t gold;
+    uint32_t level;
+};
+
+struct AMDBQueryLogin
+{
+    char ID[64];
+    char Password[128];
+};
+
+struct AMDBLoadPlayer
+{
+    uint32_t DBID;
+};
+
+struct AMDBPlayerData
+{
+    uint32_t DBID;
+    char name[64];
+};
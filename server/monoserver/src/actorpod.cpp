@@ -48,9 +48,8 @@ ActorPod::ActorPod(uint64_t nUID,
       }())
     , m_trigger(std::move(fnTrigger))
     , m_operation(std::move(fnOperation))
-    , m_validID(0)
     , m_expireTime(nExpireTime)
-    , m_respondHandlerGroup()
+    , m_respondHandlerTable()
 {}
 
 ActorPod::~ActorPod()
@@ -76,26 +75,16 @@ void ActorPod::innHandler(const MessagePack &rstMPK)
     }
 
     if(m_expireTime){
-        while(!m_respondHandlerGroup.empty()){
-            if(g_monoServer->getCurrTick() >= m_respondHandlerGroup.begin()->second.ExpireTime){
-                // everytime when we received the new MPK we check if there is handler the timeout
-                // also this time get counted into the monitor entry
-                m_podMonitor.amProcMonitorList[MPK_TIMEOUT].recvCount++;
-                {
-                    raii_timer stTimer(&(m_podMonitor.amProcMonitorList[MPK_TIMEOUT].procTick));
-                    m_respondHandlerGroup.begin()->second.Operation(MPK_TIMEOUT);
-                }
-                m_respondHandlerGroup.erase(m_respondHandlerGroup.begin());
-                continue;
+        // everytime when we received the new MPK we check if there is handler the timeout
+        // only visits wheel slots passed since last check, also this time get counted into the monitor entry
+        m_respondHandlerTable.expire(g_monoServer->getCurrTick(), [this](RespondHandler fnOPR)
+        {
+            m_podMonitor.amProcMonitorList[MPK_TIMEOUT].recvCount++;
+            {
+                raii_timer stTimer(&(m_podMonitor.amProcMonitorList[MPK_TIMEOUT].procTick));
+                fnOPR(MPK_TIMEOUT);
             }
-
-            // std::map<ID, Handler> keeps order in ID number
-            // ID number is the Resp() of the responding messages
-            //
-            // and we guarantee "ID1 < ID2" => "ExpireTime1 <= ExpireTime2"
-            // so if we get first non-expired handler, means the rest are all not expired
-            break;
-        }
+        });
     }
 
     if(rstMPK.Respond()){
@@ -103,18 +92,15 @@ void ActorPod::innHandler(const MessagePack &rstMPK)
         // 1.     find it, good
         // 2. not find it: 1. didn't register for it, we must prevent this at sending
         //                 2. repsonse is too late ooops and the handler has already be deleted
-        if(auto p = m_respondHandlerGroup.find(rstMPK.Respond()); p != m_respondHandlerGroup.end()){
-            if(p->second.Operation){
-                m_podMonitor.amProcMonitorList[rstMPK.Type()].recvCount++;
-                {
-                    raii_timer stTimer(&(m_podMonitor.amProcMonitorList[rstMPK.Type()].procTick));
-                    p->second.Operation(rstMPK);
-                }
-            }
-            else{
-                throw fflerror("%s <- %s : (Type: %s, ID: %llu, Resp: %llu): Response handler not executable", uidf::getUIDString(UID()).c_str(), uidf::getUIDString(rstMPK.from()).c_str(), mpkName(rstMPK.Type()), to_llu(rstMPK.ID()), to_llu(rstMPK.Respond()));
+        //
+        // handler is moved out of the table before calling
+        // it can send new messages expecting response
+        if(auto fnOPR = m_respondHandlerTable.take(rstMPK.Respond())){
+            m_podMonitor.amProcMonitorList[rstMPK.Type()].recvCount++;
+            {
+                raii_timer stTimer(&(m_podMonitor.amProcMonitorList[rstMPK.Type()].procTick));
+                fnOPR(rstMPK);
             }
-            m_respondHandlerGroup.erase(p);
         }else{
             // should only caused by deletion of timeout
             // do nothing for this case, don't take this as an error
@@ -144,27 +130,6 @@ void ActorPod::innHandler(const MessagePack &rstMPK)
     }
 }
 
-uint32_t ActorPod::GetValidID()
-{
-    // previously I use g_serverArgParser->traceActorMessage to select use this one
-    // this is dangerous since if we can change g_serverArgParser->traceActorMessage during runtime then it's dead
-    if(1){
-        static std::atomic<uint32_t> s_ValidID(1);
-        auto nNewValidID = s_ValidID.fetch_add(1);
-
-        if(nNewValidID){
-            return nNewValidID;
-        }
-        throw fflerror("running out of message ID, exiting...");
-    }
-
-    m_validID = (m_respondHandlerGroup.empty() ? 1 : (m_validID + 1));
-    if(auto p = m_respondHandlerGroup.find(m_validID); p == m_respondHandlerGroup.end()){
-        return m_validID;
-    }
-    throw fflerror("running out of message ID, exiting...");
-}
-
 bool ActorPod::forward(uint64_t nUID, const MessageBuf &rstMB, uint32_t nRespond)
 {
     if(!nUID){
@@ -187,7 +152,7 @@ bool ActorPod::forward(uint64_t nUID, const MessageBuf &rstMB, uint32_t nRespond
     return g_actorPool->postMessage(nUID, {rstMB, UID(), 0, nRespond});
 }
 
-bool ActorPod::forward(uint64_t nUID, const MessageBuf &rstMB, uint32_t nRespond, std::function<void(const MessagePack &)> fnOPR)
+bool ActorPod::forward(uint64_t nUID, const MessageBuf &rstMB, uint32_t nRespond, RespondHandler fnOPR)
 {
     if(!nUID){
         throw fflerror("%s -> NONE: (Type: %s, ID: 0, Resp: %llu): Try to send message to an empty address", uidf::getUIDString(UID()).c_str(), mpkName(rstMB.Type()), to_llu(nRespond));
@@ -205,34 +170,62 @@ bool ActorPod::forward(uint64_t nUID, const MessageBuf &rstMB, uint32_t nRespond
         throw fflerror("%s -> %s: (Type: %s, ID: NA, Resp: %llu): Response handler not executable", uidf::getUIDString(UID()).c_str(), uidf::getUIDString(nUID).c_str(), mpkName(rstMB.Type()), to_llu(nRespond));
     }
 
-    const auto nID = GetValidID();
+    // register before posting, the message carries the ID
+    // response can't come before we return, it's handled by current thread later
+    const auto nID = m_respondHandlerTable.add(m_expireTime ? (g_monoServer->getCurrTick() + m_expireTime) : 0, std::move(fnOPR));
     if(g_serverArgParser->traceActorMessage){
         g_monoServer->addLog(LOGTYPE_DEBUG, "%s -> %s: (Type: %s, ID: %llu, Resp: %llu)", uidf::getUIDString(UID()).c_str(), uidf::getUIDString(nUID).c_str(), mpkName(rstMB.Type()), to_llu(nID), to_llu(nRespond));
     }
 
     m_podMonitor.amProcMonitorList[rstMB.Type()].sendCount++;
     if(g_actorPool->postMessage(nUID, {rstMB, UID(), nID, nRespond})){
-        if(m_respondHandlerGroup.try_emplace(nID, g_monoServer->getCurrTick() + m_expireTime, std::move(fnOPR)).second){
-            return true;
-        }
-        throw fflerror("failed to register response handler for posted message: %s", mpkName(rstMB.Type()));
+        return true;
     }else{
         // respond the response handler here
         // if post failed, it can only be the UID is detached
-        if(fnOPR){
+        if(auto fnBadPodOPR = m_respondHandlerTable.take(nID)){
             m_podMonitor.amProcMonitorList[MPK_BADACTORPOD].recvCount++;
             {
                 raii_timer stTimer(&(m_podMonitor.amProcMonitorList[MPK_BADACTORPOD].procTick));
-                fnOPR(MPK_BADACTORPOD);
+                fnBadPodOPR(MPK_BADACTORPOD);
             }
         }
         return false;
     }
 }
 
-void ActorPod::attach(std::function<void()> fnAtStart)
+size_t ActorPod::forward(std::span<const uint64_t> uidList, const MessageBuf &rstMB)
+{
+    if(!rstMB){
+        throw fflerror("%s -> MULTICAST: (Type: MPK_NONE, ID: 0, Resp: 0): Try to send an empty message", uidf::getUIDString(UID()).c_str());
+    }
+
+    for(const auto nUID: uidList){
+        if(!nUID){
+            throw fflerror("%s -> NONE: (Type: %s, ID: 0, Resp: 0): Try to send message to an empty address", uidf::getUIDString(UID()).c_str(), mpkName(rstMB.Type()));
+        }
+
+        if(nUID == UID()){
+            throw fflerror("%s -> %s: (Type: %s, ID: 0, Resp: 0): Try to send message to itself", uidf::getUIDString(UID()).c_str(), uidf::getUIDString(nUID).c_str(), mpkName(rstMB.Type()));
+        }
+
+        if(g_serverArgParser->traceActorMessage){
+            g_monoServer->addLog(LOGTYPE_DEBUG, "%s -> %s: (Type: %s, ID: 0, Resp: 0)", uidf::getUIDString(UID()).c_str(), uidf::getUIDString(nUID).c_str(), mpkName(rstMB.Type()));
+        }
+    }
+
+    if(uidList.empty()){
+        return 0;
+    }
+
+    const auto sentCount = g_actorPool->postMulticast(uidList, {rstMB, UID(), 0, 0});
+    m_podMonitor.amProcMonitorList[rstMB.Type()].sendCount += sentCount;
+    return sentCount;
+}
+
+void ActorPod::attach(std::function<void()> fnAtStart, uint64_t affinityUID)
 {
-    g_actorPool->attach(this, std::move(fnAtStart));
+    g_actorPool->attach(this, std::move(fnAtStart), affinityUID);
 }
 
 void ActorPod::detach(std::function<void()> fnAtExit) const
@@ -264,6 +257,25 @@ bool ActorPod::checkUIDValid(uint64_t uid)
     return g_actorPool->checkUIDValid(uid);
 }
 
+void ActorPod::addWakeup(uint64_t msec)
+{
+    m_podMonitor.wakeupMonitor.wakeupCount++;
+    g_actorPool->addWakeup(UID(), msec);
+}
+
+void ActorPod::setParked(bool parked)
+{
+    g_actorPool->setParked(UID(), parked);
+}
+
+void ActorPod::setUpdateInterval(uint64_t msec)
+{
+    if(m_updateInterval != msec){
+        m_updateInterval = msec;
+        g_actorPool->setUpdateInterval(UID(), msec);
+    }
+}
+
 void ActorPod::PrintMonitor() const
 {
     for(size_t nIndex = 0; nIndex < m_podMonitor.amProcMonitorList.size(); ++nIndex){
@@ -18,6 +18,7 @@
 #pragma once
 
 #include <map>
+#include <span>
 #include <array>
 #include <string>
 #include <functional>
@@ -25,24 +26,13 @@
 #include "messagebuf.hpp"
 #include "messagepack.hpp"
 #include "actormonitor.hpp"
+#include "respondhandlertable.hpp"
 
 class ActorPod final
 {
     private:
         friend class ActorPool;
 
-    private:
-        struct RespondHandler
-        {
-            uint32_t ExpireTime;
-            std::function<void(const MessagePack &)> Operation;
-
-            RespondHandler(uint32_t nExpireTime, std::function<void(const MessagePack &)> stOperation)
-                : ExpireTime(nExpireTime)
-                , Operation(std::move(stOperation))
-            {}
-        };
-
     private:
         const uint64_t m_UID;
 
@@ -66,30 +56,23 @@ class ActorPod final
         const std::function<void(const MessagePack &)> m_operation;
 
     private:
-        // used by ValidID()
-        // to create unique proper ID for an message expcecting response
-        uint32_t m_validID;
-
         // for expire time check
         // zero expire time means we never expire any handler for current pod
         // we can put argument to specify the expire time of each handler but not necessary
         const uint32_t m_expireTime;
 
-        // use std::map instead of std::unordered_map
-        //
-        // 1. we have to scan the map every time when new message comes to remove expired ones
-        //    std::unordered_map is slow for scan the entire map
-        //    I can maintain another std::priority_queue based on expire time
-        //    but it's hard to remove those entry which executed before expire from the queue
-        //
-        // 2. std::map keeps entries in order by Resp number
-        //    Resp number gives strict order of expire time, excellent feature by std::map
-        //    then when checking expired ones, we start from std::map::begin() and stop at the fist non-expired one
-        std::map<uint32_t, RespondHandler> m_respondHandlerGroup;
+        // pending response handlers
+        // message ID expecting response is allocated by this table, it's unique in current pod only
+        RespondHandlerTable m_respondHandlerTable;
 
     private:
         ActorPodMonitor m_podMonitor;
 
+    private:
+        // last METRONOME interval set to the pool
+        // then actor can set it at every METRONOME without touching the pool
+        uint64_t m_updateInterval = 0;
+
     public:
         explicit ActorPod(uint64_t,                         // UID
                 std::function<void()>,                      // trigger
@@ -99,9 +82,6 @@ class ActorPod final
     public:
         ~ActorPod();
 
-    private:
-        uint32_t GetValidID();
-
     private:
         void innHandler(const MessagePack &);
 
@@ -112,14 +92,19 @@ class ActorPod final
         }
 
     public:
-        bool forward(uint64_t nUID, const MessageBuf &rstMB, std::function<void(const MessagePack &)> fnOPR)
+        bool forward(uint64_t nUID, const MessageBuf &rstMB, RespondHandler fnOPR)
         {
             return forward(nUID, rstMB, 0, std::move(fnOPR));
         }
 
     public:
         bool forward(uint64_t, const MessageBuf &, uint32_t);
-        bool forward(uint64_t, const MessageBuf &, uint32_t, std::function<void(const MessagePack &)>);
+        bool forward(uint64_t, const MessageBuf &, uint32_t, RespondHandler);
+
+    public:
+        // multicast without response
+        // receivers share one message payload, returns number of receivers posted
+        size_t forward(std::span<const uint64_t>, const MessageBuf &);
 
     public:
         uint64_t UID() const
@@ -128,12 +113,34 @@ class ActorPod final
         }
 
     public:
-        void attach(std::function<void()>);
+        // affinityUID: actor this pod mostly talks to, pool places the mailbox at its actor thread
+        void attach(std::function<void()>, uint64_t = 0);
         void detach(std::function<void()>) const;
 
     public:
         static bool checkUIDValid(uint64_t);
 
+    public:
+        // request an MPK_WAKEUP after given msec
+        // delivered by the timer wheel of the actor thread, not by METRONOME
+        void addWakeup(uint64_t);
+
+    public:
+        // parked actor is skipped by METRONOME
+        // it still handles all messages sent to it
+        void setParked(bool);
+
+    public:
+        // METRONOME interval in msec, 0 means every tick, rounded up to ticks
+        // it still handles all messages sent to it immediately
+        void setUpdateInterval(uint64_t);
+
+    public:
+        void countResumeAvoided()
+        {
+            m_podMonitor.wakeupMonitor.resumeAvoided++;
+        }
+
     public:
         void PrintMonitor() const;
 
@@ -16,9 +16,12 @@
  * =====================================================================================
  */
 
+#include <bit>
 #include <mutex>
+#include <tuple>
 #include <thread>
 #include <cstdint>
+#include <algorithm>
 #include "log.hpp"
 #include "uidf.hpp"
 #include "totype.hpp"
@@ -45,6 +48,9 @@ extern MonoServer *g_monoServer;
 // and when a mailboxPtr is detached from its actor in one thread, other threads can still holding this mailboxPtr and not aware of the schedLock flip
 // this is the dangerous part, and this is the reason why I strictly restrict the {uid, mailboxPtr} removal should be in runOneMailboxBucket()
 
+// same for moving {uid, mailboxPtr} to another bucket, only the dedicated actor thread of the source bucket can do it
+// mailbox not in its home bucket uid % N gets a route entry in the home sub-bucket, see tryGetRLockedMailbox()
+
 // anytime when we get a raw mailboPtr from the sub-bucket
 // we need to add r-lock because other thread can spawn new actors to the sub-bucket concurrently
 
@@ -57,13 +63,15 @@ static int getWorkerID()
     return t_workerID;
 }
 
-ActorPool::Mailbox::Mailbox(ActorPod *actorPtr, std::function<void()> atStartTrigger)
+ActorPool::Mailbox::Mailbox(ActorPod *actorPtr, std::function<void()> atStartTrigger, size_t bucketCount)
     : uid(actorPtr->UID())
     , actor(actorPtr)
     , atStart(std::move(atStartTrigger))
+    , recvCountList(std::make_unique<std::atomic<uint32_t>[]>(bucketCount))
+    , migrateCooldown(m_migrateCooldown)
 {}
 
-ActorPool::ActorPool(int bucketCount, int logicFPS)
+ActorPool::ActorPool(int bucketCount, int logicFPS, bool enableAffinity)
     : m_logicFPS([logicFPS]() -> uint32_t
       {
           if(logicFPS <= 0){
@@ -75,6 +83,7 @@ ActorPool::ActorPool(int bucketCount, int logicFPS)
           }
           return logicFPS;
       }())
+    , m_enableAffinity(enableAffinity)
     , m_bucketList([bucketCount]() -> uint32_t
       {
           if(bucketCount <= 0){
@@ -107,7 +116,7 @@ ActorPool::~ActorPool()
     }
 }
 
-void ActorPool::attach(ActorPod *actorPtr, std::function<void()> atStart)
+void ActorPool::attach(ActorPod *actorPtr, std::function<void()> atStart, uint64_t affinityUID)
 {
     logProfiler();
     if(!(actorPtr && actorPtr->UID())){
@@ -125,10 +134,18 @@ void ActorPool::attach(ActorPod *actorPtr, std::function<void()> atStart)
     // 1. to make sure any other reading thread done
     // 2. current thread won't accquire the lock in read mode
 
+    // placement hint
+    // put the mailbox in the bucket of the affinity actor, most messages of them are between each other
+    // then they run in the same actor thread and don't need to wake up other threads
+
     const auto uid = actorPtr->UID();
-    auto mailboxPtr = std::make_unique<Mailbox>(actorPtr, std::move(atStart));
+    const auto homeBucketId = getHomeBucketID(uid);
+    const auto subBucketId = getSubBucketID(uid);
+    const auto bucketId = (m_enableAffinity && affinityUID && !uidf::isReceiver(affinityUID)) ? getBucketID(affinityUID) : homeBucketId;
+
+    auto mailboxPtr = std::make_unique<Mailbox>(actorPtr, std::move(atStart), m_bucketList.size());
     auto mailboxRawPtr = mailboxPtr.get();
-    auto &subBucketRef = getSubBucket(uid);
+    auto &subBucketRef = getSubBucket(bucketId, subBucketId);
     {
         // always place the w-lock-protection
         // this is the only place that can grow a subbucket
@@ -141,15 +158,21 @@ void ActorPool::attach(ActorPod *actorPtr, std::function<void()> atStart)
         //   1. in the actor message handler: should be OK, we always call message handler without sub-bucket lock accqured
         //   2. out of   the message handler: in actorpool.cpp, we shouldn't call attach() out of actor message hander in actor threads
 
-        MailboxSubBucket::WLockGuard lockGuard(subBucketRef.lock);
-        if(!(subBucketRef.mailboxList.emplace(uid, std::move(mailboxPtr)).second)){
+        const auto lockGuardList = wlockSubBucket({bucketId, homeBucketId}, subBucketId);
+        auto &homeSubBucketRef = getSubBucket(homeBucketId, subBucketId);
+
+        if(homeSubBucketRef.mailboxList.contains(uid) || homeSubBucketRef.routeList.contains(uid)){
             throw fflerror("actor UID %llu exists in bucket already", to_llu(uid));
         }
+
+        subBucketRef.mailboxList.emplace(uid, std::move(mailboxPtr));
+        if(bucketId != homeBucketId){
+            homeSubBucketRef.routeList.emplace(uid, bucketId);
+        }
     }
 
     // attached actor has startup trigger
     // schedule it ASAP, currently only try its decicated bucket
-    const int bucketId = getBucketID(uid);
     m_bucketList.at(bucketId).uidQPending.push(uid);
 
     // the mailboxListCache is accessed by index rather than using iterator
@@ -193,22 +216,11 @@ void ActorPool::detach(const ActorPod *actorPtr, std::function<void()> fnAtExit)
 
     const auto uid = actorPtr->UID();
     const auto workerId = getWorkerID();
-    const auto bucketId = getBucketID(uid);
 
     // if not in dedicated actor thread we need to r-lock the sub-bucket
     // otherwise the dedicated actor thread may detach and remove {uid, mailboxPtr} from the sub-bucket
 
-    Mailbox *mailboxPtr = nullptr;
-    MailboxSubBucket::RLockGuard lockGuard;
-    if(workerId == bucketId){
-        mailboxPtr = tryGetMailboxPtr(uid);
-    }
-    else{
-        auto rlockedMailboxPtr = tryGetRLockedMailboxPtr(uid);
-        lockGuard = std::move(rlockedMailboxPtr.first);
-        mailboxPtr = rlockedMailboxPtr.second;
-    }
-
+    auto [lockGuard, mailboxPtr, bucketId] = findMailbox(uid);
     if(!mailboxPtr){
         return;
     }
@@ -384,63 +396,22 @@ bool ActorPool::postMessage(uint64_t uid, MessagePack msg)
         return false;
     }
 
-    const auto bucketId = getBucketID(uid);
-    const auto fnPostMessage = [uid](Mailbox *mailboxPtr, MessagePack msg) -> bool
-    {
-        logScopedProfiler("pushMailbox");
-
-        // just a cheat and can remove it
-        // try return earlier without acquiring the nextQLock
-        if(mailboxPtr->schedLock.detached()){
-            return false;
-        }
-
-        // still here the mailbox can freely switch to detached status
-        // need the actor thread do fully clear job
-
-        // profiler helper
-        // measure the delay that when the message reaches actorpool and it gets executed
-        const uint64_t nowTime = mailboxPtr->monitor.liveTimer.diff_nsec();
-        {
-            std::lock_guard<std::mutex> lockGuard(mailboxPtr->nextQLock);
-            if(mailboxPtr->schedLock.detached()){
-                return false;
-            }
-
-            // during the push other thread can still flip the actor to detached status
-            // we can't guarantee, the only thing we can do is:
-            //   1. don't run an already detached actor
-            //   2. clear all pending message in a detached actor by clearOneMailbox()
-            mailboxPtr->nextQ.push_back(std::pair<MessagePack, uint64_t>(std::move(msg), nowTime));
-        }
-        return true;
-    };
-
     // if not in dedicated actor thread we have to grab the r-lock when posting
     // otherwise the {uid, mailboxPtr} can be removed from the sub-bucket by dedicated actor-thread when we are posting it
     //
     // another way is grab the schedLoc when posting
     // but this is exclusive, r-lock is shared and then preferred
+    int bucketId = -1;
     {
-        Mailbox *mailboxPtr = nullptr;
-        MailboxSubBucket::RLockGuard lockGuard;
-
-        if(getWorkerID() == bucketId){
-            mailboxPtr = tryGetMailboxPtr(uid);
-        }
-        else{
-            auto rlockedMailboxPtr = tryGetRLockedMailboxPtr(uid);
-            lockGuard = std::move(rlockedMailboxPtr.first);
-            mailboxPtr = rlockedMailboxPtr.second;
-        }
-
+        const auto [lockGuard, mailboxPtr, mailboxBucketId] = findMailbox(uid);
         if(!mailboxPtr){
             return false;
         }
 
-        if(!fnPostMessage(mailboxPtr, std::move(msg))){
+        if(!pushMailbox(mailboxPtr, mailboxBucketId, std::move(msg))){
             return false;
         }
+        bucketId = mailboxBucketId;
     }
 
     // done posting
@@ -463,6 +434,130 @@ bool ActorPool::postMessage(uint64_t uid, MessagePack msg)
     }
 }
 
+size_t ActorPool::postMulticast(std::span<const uint64_t> uidList, MessagePack msg)
+{
+    logProfiler();
+    if(!msg){
+        throw fflerror("multicasting empty message");
+    }
+
+    // sort receivers by {bucket, sub-bucket}
+    // then each sub-bucket gets r-locked only once for all its receivers
+    // and each bucket's uidQPending gets locked only once to schedule them
+
+    // {bucket, sub-bucket, uid}
+    // bucket is where the mailbox lives when sorting, it can move before we post
+    std::vector<std::tuple<int, int, uint64_t>> sortedUIDList;
+    sortedUIDList.reserve(uidList.size());
+
+    size_t doneCount = 0;
+    for(const auto uid: uidList){
+        if(!uid){
+            throw fflerror("multicasting %s to zero UID", mpkName(msg.Type()));
+        }
+
+        // receiver is not in mailbox bucket
+        // rarely used in multicast, post one by one
+        if(uidf::isReceiver(uid)){
+            doneCount += postMessage(uid, msg) ? 1 : 0;
+        }
+        else{
+            sortedUIDList.emplace_back(getBucketID(uid), getSubBucketID(uid), uid);
+        }
+    }
+
+    std::sort(sortedUIDList.begin(), sortedUIDList.end());
+    sortedUIDList.erase(std::unique(sortedUIDList.begin(), sortedUIDList.end()), sortedUIDList.end());
+
+    // message payload is shared between copies
+    // posting to each mailbox copies the header only if payload is in dynamic buffer
+
+    std::vector<uint64_t> pendingUIDList;
+    pendingUIDList.reserve(sortedUIDList.size());
+
+    // mailbox moved to other bucket after sorting
+    // post them one by one
+    std::vector<uint64_t> movedUIDList;
+
+    for(auto p = sortedUIDList.begin(); p != sortedUIDList.end();){
+        const auto bucketId = std::get<0>(*p);
+        pendingUIDList.clear();
+
+        while(p != sortedUIDList.end() && std::get<0>(*p) == bucketId){
+            const auto subBucketId = std::get<1>(*p);
+            auto &subBucketRef = getSubBucket(bucketId, subBucketId);
+            {
+                // always r-lock here even in dedicated actor thread
+                // we are not in runOneMailboxBucket() and it's safe to share-lock the sub-bucket
+                MailboxSubBucket::RLockGuard lockGuard(subBucketRef.lock);
+                for(; p != sortedUIDList.end() && std::get<0>(*p) == bucketId && std::get<1>(*p) == subBucketId; ++p){
+                    const auto uid = std::get<2>(*p);
+                    if(auto q = subBucketRef.mailboxList.find(uid); q != subBucketRef.mailboxList.end()){
+                        if(pushMailbox(q->second.get(), bucketId, msg)){
+                            pendingUIDList.push_back(uid);
+                        }
+                    }
+                    else{
+                        movedUIDList.push_back(uid);
+                    }
+                }
+            }
+        }
+
+        if(!pendingUIDList.empty()){
+            logScopedProfiler("pushUIDQPending");
+            m_bucketList.at(bucketId).uidQPending.push(pendingUIDList);
+            doneCount += pendingUIDList.size();
+        }
+    }
+
+    for(const auto uid: movedUIDList){
+        doneCount += postMessage(uid, msg) ? 1 : 0;
+    }
+    return doneCount;
+}
+
+bool ActorPool::pushMailbox(Mailbox *mailboxPtr, int bucketId, MessagePack msg)
+{
+    logScopedProfiler("pushMailbox");
+
+    // just a cheat and can remove it
+    // try return earlier without touching the nextQ
+    if(mailboxPtr->schedLock.detached()){
+        return false;
+    }
+
+    // still here the mailbox can freely switch to detached status
+    // need the actor thread do fully clear job
+
+    // profiler helper
+    // measure the delay that when the message reaches actorpool and it gets executed
+    const uint64_t nowTime = mailboxPtr->monitor.liveTimer.diff_nsec();
+
+    // during the push other thread can still flip the actor to detached status
+    // we can't guarantee, the only thing we can do is:
+    //   1. don't run an already detached actor
+    //   2. clear all pending message in a detached actor by clearOneMailbox()
+    const bool pushed = mailboxPtr->nextQ.push(std::pair<MessagePack, uint64_t>(std::move(msg), nowTime), [mailboxPtr]() -> bool
+    {
+        return mailboxPtr->schedLock.detached();
+    });
+
+    // traffic stats for migration and report
+    // counters of a bucket are only updated by its dedicated thread
+    if(const auto workerId = getWorkerID(); pushed && isActorThread(workerId)){
+        mailboxPtr->recvCountList[workerId].fetch_add(1, std::memory_order_relaxed);
+
+        auto &workerBucketRef = m_bucketList[workerId];
+        workerBucketRef.postCount.fetch_add(1, std::memory_order_relaxed);
+
+        if(workerId != bucketId){
+            workerBucketRef.crossPostCount.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    return pushed;
+}
+
 void ActorPool::runOneUID(uint64_t uid)
 {
     const auto workerId = getWorkerID();
@@ -470,17 +565,7 @@ void ActorPool::runOneUID(uint64_t uid)
         throw fflerror("running actor UID %llu by public thread", to_llu(uid));
     }
 
-    Mailbox *mailboxPtr = nullptr;
-    MailboxSubBucket::RLockGuard lockGuard;
-    if(workerId == getBucketID(uid)){
-        mailboxPtr = tryGetMailboxPtr(uid);
-    }
-    else{
-        auto rlockedMailboxPtr = tryGetRLockedMailboxPtr(uid);
-        lockGuard = std::move(rlockedMailboxPtr.first);
-        mailboxPtr = rlockedMailboxPtr.second;
-    }
-
+    auto [lockGuard, mailboxPtr, bucketId] = findMailbox(uid);
     if(!mailboxPtr){
         return;
     }
@@ -537,8 +622,9 @@ bool ActorPool::runOneMailbox(Mailbox *mailboxPtr, bool useMetronome)
         }                                       // means it's in grabbed status rather than detached status if we can reach here
 
         {
-            raii_timer procTimer(&(mailboxPtr->monitor.procTick));
+            const hres_timer procTimer;
             mailboxPtr->actor->innHandler({MPK_METRONOME, 0, 0});
+            addProcTime(mailboxPtr, procTimer.diff_nsec());
         }
 
         mailboxPtr->monitor.messageDone.fetch_add(1);
@@ -552,11 +638,9 @@ bool ActorPool::runOneMailbox(Mailbox *mailboxPtr, bool useMetronome)
 
     while(true){
         if(mailboxPtr->currQ.empty()){
-            std::lock_guard<std::mutex> lockGuard(mailboxPtr->nextQLock);
-            if(mailboxPtr->nextQ.empty()){
+            if(!mailboxPtr->nextQ.take(mailboxPtr->currQ)){
                 return true;
             }
-            std::swap(mailboxPtr->currQ, mailboxPtr->nextQ);
         }
 
         // this is a good place to store the pending message size
@@ -581,8 +665,9 @@ bool ActorPool::runOneMailbox(Mailbox *mailboxPtr, bool useMetronome)
 
             mailboxPtr->monitor.avgDelay.store((mailboxPtr->monitor.avgDelay.load() * 7 + (timeNow - p->second)) / 8);
             {
-                raii_timer procTimer(&(mailboxPtr->monitor.procTick));
+                const hres_timer procTimer;
                 mailboxPtr->actor->innHandler(p->first);
+                addProcTime(mailboxPtr, procTimer.diff_nsec());
             }
             mailboxPtr->monitor.messageDone.fetch_add(1);
         }
@@ -636,13 +721,15 @@ void ActorPool::clearOneMailbox(Mailbox *mailboxPtr)
     // so we conclude if in thread-2 clearOneMailbox() returns
     // we are sure there is no message is posting or to post message to nextQ
 
+    // for lock-free nextQ there is no lock, line 2~5 and 3~4 are replaced by
+    //
+    //     thread-1: CAS(nextQ.head, head, node) fails if head is the sealed sentinel
+    //     thread-2: exchange(nextQ.head, sealed) takes all nodes pushed before
+    //
+    // one push either lands before the exchange and gets taken, or sees the sentinel and fails
+
     logProfiler();
-    {
-        std::lock_guard<std::mutex> lockGuard(mailboxPtr->nextQLock);
-        if(!mailboxPtr->nextQ.empty()){
-            mailboxPtr->currQ.insert(mailboxPtr->currQ.end(), mailboxPtr->nextQ.begin(), mailboxPtr->nextQ.end());
-        }
-    }
+    mailboxPtr->nextQ.seal(mailboxPtr->currQ);
 
     for(const auto &p: mailboxPtr->currQ){
         if(!p.first.from()){
@@ -662,7 +749,7 @@ void ActorPool::clearOneMailbox(Mailbox *mailboxPtr)
     mailboxPtr->currQ.clear();
 }
 
-void ActorPool::runOneMailboxBucket(int bucketId)
+void ActorPool::runOneMailboxBucket(int bucketId, int subBucketId)
 {
     logProfiler();
     const int workerId = getWorkerID();
@@ -690,7 +777,10 @@ void ActorPool::runOneMailboxBucket(int bucketId)
 
                     // don't try clean it
                     // since we can't guarentee to clean it complately
-                    return runOneMailbox(mailboxPtr, true);
+
+                    // parked actor doesn't get METRONOME, neither does actor not due by its update interval
+                    // but still flush its queue, the sweep picks messages missed by runOneUID()
+                    return runOneMailbox(mailboxPtr, !mailboxPtr->parked.load() && checkMetronome(mailboxPtr));
                 }
             case MAILBOX_ACCESS_PUB:
                 {
@@ -723,8 +813,18 @@ void ActorPool::runOneMailboxBucket(int bucketId)
         }
     };
 
+    // one call sweeps one sub-bucket
+    // a round sweeps all sub-buckets once by slots in one tick, migration check and report are done per round
+
     auto &bucketRef = m_bucketList.at(bucketId);
-    for(int subBucketId = 0; subBucketId < m_subBucketCount; ++subBucketId){
+    if(subBucketId == 0){
+        bucketRef.checkMigrate = m_enableAffinity && (m_bucketList.size() > 1) && (bucketRef.migrateTimer.diff_msec() >= m_migrateWindow);
+        if(bucketRef.checkMigrate){
+            bucketRef.migrateTimer.reset();
+        }
+    }
+
+    {
         auto &subBucketRef = bucketRef.subBucketList.at(subBucketId);
         auto &listCacheRef = subBucketRef.mailboxListCache;
         {
@@ -745,6 +845,14 @@ void ActorPool::runOneMailboxBucket(int bucketId)
         for(size_t mailboxIndex = 0; mailboxIndex < listCacheRef.size(); ++mailboxIndex){
             auto mailboxPtr = listCacheRef.at(mailboxIndex);
             if(fnRunMailbox(mailboxPtr)){
+                // move mailbox out of current bucket breaks the cache as removal
+                // do it after the mailbox is done and released its schedLock
+                if(bucketRef.checkMigrate){
+                    if(const auto dstBucketId = pickMigrateBucket(mailboxPtr, bucketId); dstBucketId >= 0){
+                        migrateMailbox(mailboxPtr, bucketId, dstBucketId);
+                        hasDeletedMailbox = true;
+                    }
+                }
                 continue;
             }
 
@@ -759,8 +867,14 @@ void ActorPool::runOneMailboxBucket(int bucketId)
 
             clearOneMailbox(mailboxPtr);
             {
-                MailboxSubBucket::WLockGuard lockGuard(subBucketRef.lock);
-                subBucketRef.mailboxList.erase(mailboxPtr->uid);
+                const auto uid = mailboxPtr->uid;
+                const auto homeBucketId = getHomeBucketID(uid);
+                const auto lockGuardList = wlockSubBucket({bucketId, homeBucketId}, subBucketId);
+
+                subBucketRef.mailboxList.erase(uid);
+                if(homeBucketId != bucketId){
+                    getSubBucket(homeBucketId, subBucketId).routeList.erase(uid);
+                }
                 hasDeletedMailbox = true;
             }
         }
@@ -773,6 +887,184 @@ void ActorPool::runOneMailboxBucket(int bucketId)
             listCacheRef.clear();
         }
     }
+
+    if(subBucketId + 1 == m_subBucketCount && bucketRef.reportTimer.diff_msec() >= m_reportInterval){
+        reportBucket(bucketId);
+        bucketRef.reportTimer.reset();
+    }
+}
+
+bool ActorPool::checkMetronome(Mailbox *mailboxPtr) const
+{
+    // sub-bucket is swept once per tick
+    // give half tick slack, a slot can come slightly earlier than due time of the mailbox
+
+    const uint64_t tickTime = 1000ULL / m_logicFPS;
+    const uint64_t currTime = m_tickTimer.diff_msec();
+
+    auto nextUpdateTime = mailboxPtr->nextUpdateTime.load();
+    if(currTime + tickTime / 2 < nextUpdateTime){
+        return false;
+    }
+
+    // setUpdateInterval() can shrink the interval while we advance the due time
+    // if it does, the CAS fails and its earlier due time is kept, or we re-check the interval below
+
+    const auto updateInterval = mailboxPtr->updateInterval.load();
+    if(mailboxPtr->nextUpdateTime.compare_exchange_strong(nextUpdateTime, currTime + std::max<uint64_t>(updateInterval, tickTime))){
+        if(const auto newInterval = mailboxPtr->updateInterval.load(); newInterval < updateInterval){
+            pullNextUpdateTime(mailboxPtr, currTime + newInterval);
+        }
+    }
+    return true;
+}
+
+void ActorPool::pullNextUpdateTime(Mailbox *mailboxPtr, uint64_t nextUpdateTime) const
+{
+    // only moves due time earlier, never later
+    for(auto currNextUpdateTime = mailboxPtr->nextUpdateTime.load(); nextUpdateTime < currNextUpdateTime;){
+        if(mailboxPtr->nextUpdateTime.compare_exchange_weak(currNextUpdateTime, nextUpdateTime)){
+            break;
+        }
+    }
+}
+
+int ActorPool::pickMigrateBucket(Mailbox *mailboxPtr, int bucketId)
+{
+    // always reset counters for next window
+    // even the mailbox is in cooldown
+
+    uint64_t totalCount = 0;
+    uint64_t maxCount = 0;
+    int maxBucketId = -1;
+
+    for(int i = 0; i < (int)(m_bucketList.size()); ++i){
+        const uint64_t count = mailboxPtr->recvCountList[i].exchange(0, std::memory_order_relaxed);
+        totalCount += count;
+
+        if(i != bucketId && count > maxCount){
+            maxCount = count;
+            maxBucketId = i;
+        }
+    }
+
+    if(mailboxPtr->migrateCooldown > 0){
+        mailboxPtr->migrateCooldown--;
+        return -1;
+    }
+
+    if(mailboxPtr->schedLock.detached()){
+        return -1;
+    }
+
+    // only move when one other actor thread dominates the traffic
+    // actors talking to many buckets evenly, like maps, stay
+    if(totalCount >= m_migrateMinCount && maxCount * 3 >= totalCount * 2){
+        return maxBucketId;
+    }
+    return -1;
+}
+
+void ActorPool::migrateMailbox(Mailbox *mailboxPtr, int srcBucketId, int dstBucketId)
+{
+    // only called by the dedicated actor thread of source bucket, as removal
+    // mailbox object itself doesn't move, any thread still holding the pointer by schedLock can continue
+    //
+    // after this function the destination thread owns it
+    // messages posted during moving get retried by tryGetRLockedMailbox()
+
+    if(getWorkerID() != srcBucketId){
+        throw fflerror("migrate mailbox of bucket %d by thread %d", srcBucketId, getWorkerID());
+    }
+
+    const auto uid = mailboxPtr->uid;
+    const auto homeBucketId = getHomeBucketID(uid);
+    const auto subBucketId = getSubBucketID(uid);
+    {
+        const auto lockGuardList = wlockSubBucket({srcBucketId, dstBucketId, homeBucketId}, subBucketId);
+
+        auto &srcSubBucketRef = getSubBucket(srcBucketId, subBucketId);
+        auto &dstSubBucketRef = getSubBucket(dstBucketId, subBucketId);
+
+        auto p = srcSubBucketRef.mailboxList.find(uid);
+        if(p == srcSubBucketRef.mailboxList.end() || p->second.get() != mailboxPtr){
+            throw fflerror("migrate mailbox not in bucket %d: uid = %llu", srcBucketId, to_llu(uid));
+        }
+
+        if(dstSubBucketRef.mailboxList.contains(uid)){
+            throw fflerror("actor UID %llu exists in bucket %d already", to_llu(uid), dstBucketId);
+        }
+
+        // set before inserting
+        // destination thread can access it immediately after we unlock
+        mailboxPtr->migrateCooldown = m_migrateCooldown;
+
+        dstSubBucketRef.mailboxList.emplace(uid, std::move(p->second));
+        srcSubBucketRef.mailboxList.erase(p);
+
+        if(dstBucketId == homeBucketId){
+            getSubBucket(homeBucketId, subBucketId).routeList.erase(uid);
+        }
+        else{
+            getSubBucket(homeBucketId, subBucketId).routeList.insert_or_assign(uid, dstBucketId);
+        }
+    }
+
+    m_bucketList.at(srcBucketId).migrateCount.fetch_add(1, std::memory_order_relaxed);
+    m_bucketList.at(dstBucketId).uidQPending.push(uid);
+}
+
+void ActorPool::addProcTime(Mailbox *mailboxPtr, uint64_t procTime)
+{
+    mailboxPtr->monitor.procTick.fetch_add(procTime);
+
+    // histogram bin is floor(log2(nsec))
+    // only updated by current actor thread
+    auto &procTimeHist = m_bucketList.at(getWorkerID()).procTimeHist;
+    const size_t bin = procTime ? std::min<size_t>(std::bit_width(procTime) - 1, procTimeHist.size() - 1) : 0;
+    procTimeHist[bin].fetch_add(1, std::memory_order_relaxed);
+}
+
+void ActorPool::reportBucket(int bucketId)
+{
+    auto &bucketRef = m_bucketList.at(bucketId);
+    const auto postCount      = bucketRef.postCount     .exchange(0, std::memory_order_relaxed);
+    const auto crossPostCount = bucketRef.crossPostCount.exchange(0, std::memory_order_relaxed);
+    const auto migrateCount   = bucketRef.migrateCount  .exchange(0, std::memory_order_relaxed);
+
+    uint64_t procCount = 0;
+    std::array<uint64_t, std::tuple_size_v<decltype(bucketRef.procTimeHist)>> procTimeHist;
+
+    for(size_t i = 0; i < procTimeHist.size(); ++i){
+        procTimeHist[i] = bucketRef.procTimeHist[i].exchange(0, std::memory_order_relaxed);
+        procCount += procTimeHist[i];
+    }
+
+    // p99 is upper bound of the bin reaching 99% of handled messages
+    uint64_t p99ProcTime = 0;
+    for(uint64_t i = 0, sum = 0; i < procTimeHist.size(); ++i){
+        if(sum += procTimeHist[i]; sum * 100 >= procCount * 99){
+            p99ProcTime = (2ULL << i);
+            break;
+        }
+    }
+
+    const auto busyTime = bucketRef.busyTime.load(std::memory_order_relaxed);
+    const auto reportTime = bucketRef.reportTimer.diff_nsec();
+    const auto maxJitter = bucketRef.maxJitter.exchange(0, std::memory_order_relaxed);
+
+    g_monoServer->addLog(LOGTYPE_INFO, "Actor thread %d: posted %llu, cross-thread %.2f%%, migrated %llu, handled %llu, p99 handler time %.2f us, busy %.2f%%, sweep jitter avg %llu us, max %llu us",
+            bucketId,
+            to_llu(postCount),
+            postCount ? (100.0 * crossPostCount / postCount) : 0.0,
+            to_llu(migrateCount),
+            to_llu(procCount),
+            procCount ? (p99ProcTime / 1000.0) : 0.0,
+            reportTime ? (100.0 * (busyTime - bucketRef.reportBusyTime) / reportTime) : 0.0,
+            to_llu(bucketRef.avgJitter.load(std::memory_order_relaxed)),
+            to_llu(maxJitter));
+
+    bucketRef.reportBusyTime = busyTime;
 }
 
 void ActorPool::launchPool()
@@ -787,25 +1079,65 @@ void ActorPool::launchPool()
             // for any other thread this will NOT get assigned
             t_workerID = bucketId;
             try{
-                raii_timer timer;
-                uint64_t lastUpdateTime = 0;
-                const uint64_t maxUpdateWaitTime = 1000ULL / m_logicFPS;
+                auto &bucketRef = m_bucketList[bucketId];
+
+                // sweep one sub-bucket per slot, slots evenly spread over the tick
+                // mailboxes are distributed to sub-buckets by UID, then METRONOME doesn't come in one burst
+                const hres_timer timer;
+                const uint64_t tickTime = 1000000ULL / m_logicFPS; // usec
+
+                uint64_t sweepRound = 0;
+                int      sweepSlot  = 0;
+
+                const auto fnSweepTime = [tickTime, &sweepRound, &sweepSlot]() -> uint64_t
+                {
+                    return sweepRound * tickTime + tickTime * sweepSlot / m_subBucketCount;
+                };
 
                 std::vector<uint64_t> uidList;
                 uidList.reserve(2048);
 
                 while(true){
+                    {
+                        // deliver expired wakeups as targeted messages
+                        // actor can be gone already, then postMessage() fails quietly
+                        bucketRef.wakeupWheel.advance(bucketRef.wakeupTimer.diff_msec(), [this](uint64_t uid)
+                        {
+                            postMessage(uid, {MPK_WAKEUP, 0, 0});
+                        });
+                    }
+
                     if(!uidList.empty()){
+                        const hres_timer busyTimer;
                         for(const auto uid: uidList){
                             runOneUID(uid);
                         }
+
                         uidList.clear();
+                        bucketRef.busyTime.fetch_add(busyTimer.diff_nsec(), std::memory_order_relaxed);
                     }
                     else{
-                        const uint64_t currTime = timer.diff_msec();
-                        if(currTime >= lastUpdateTime + maxUpdateWaitTime){
-                            runOneMailboxBucket(bucketId);
-                            lastUpdateTime = currTime;
+                        if(const uint64_t currTime = timer.diff_usec(), sweepTime = fnSweepTime(); currTime >= sweepTime){
+                            const uint64_t jitter = currTime - sweepTime;
+                            bucketRef.avgJitter.store((bucketRef.avgJitter.load(std::memory_order_relaxed) * 7 + jitter) / 8, std::memory_order_relaxed);
+                            if(jitter > bucketRef.maxJitter.load(std::memory_order_relaxed)){
+                                bucketRef.maxJitter.store(jitter, std::memory_order_relaxed);
+                            }
+
+                            const hres_timer busyTimer;
+                            runOneMailboxBucket(bucketId, sweepSlot);
+                            bucketRef.busyTime.fetch_add(busyTimer.diff_nsec(), std::memory_order_relaxed);
+
+                            if(++sweepSlot >= m_subBucketCount){
+                                sweepSlot = 0;
+                                sweepRound++;
+                            }
+
+                            // fell behind by more than one tick
+                            // skip missed rounds instead of sweeping back to back to catch up
+                            if(const uint64_t doneTime = timer.diff_usec(); doneTime > fnSweepTime() + tickTime){
+                                sweepRound = (doneTime - tickTime * sweepSlot / m_subBucketCount) / tickTime;
+                            }
                         }
 
                         for(int i = 0; i < (int)(m_bucketList.size()) * 32; ++i){
@@ -818,9 +1150,8 @@ void ActorPool::launchPool()
 
                         if(uidList.empty()){
                             int ec = 0;
-                            const uint64_t exptUpdateTime = lastUpdateTime + maxUpdateWaitTime;
-                            if(currTime < exptUpdateTime){
-                                m_bucketList[bucketId].uidQPending.pop(uidList, 0, exptUpdateTime - currTime, ec);
+                            if(const uint64_t currTime = timer.diff_usec(), sweepTime = fnSweepTime(); currTime < sweepTime){
+                                bucketRef.uidQPending.pop(uidList, 0, sweepTime - currTime, ec);
                             }
                             else{
                                 ec = E_TIMEOUT;
@@ -831,7 +1162,7 @@ void ActorPool::launchPool()
                             }
                             else if(ec == E_TIMEOUT){
                                 // didn't get any pending UID
-                                // and when reach here we are sure the thread needs to update the whole mailbox by METRONOME
+                                // and when reach here we are sure the thread needs to sweep next sub-bucket by METRONOME
 
                                 // do nothing here
                                 // hold for next loop
@@ -856,17 +1187,48 @@ void ActorPool::launchPool()
     }
 }
 
+void ActorPool::addWakeup(uint64_t uid, uint64_t msec)
+{
+    // register to the wheel of current actor thread, not the actor's dedicated thread
+    // then the wheel is only accessed by one thread, wakeup message gets routed by postMessage()
+
+    if(!isActorThread()){
+        throw fflerror("adding wakeup timer outside of actor threads: WorkerID = %d, UID = %llu", getWorkerID(), to_llu(uid));
+    }
+
+    auto &bucketRef = m_bucketList.at(getWorkerID());
+    bucketRef.wakeupWheel.add(uid, bucketRef.wakeupTimer.diff_msec() + msec);
+}
+
+void ActorPool::setParked(uint64_t uid, bool parked)
+{
+    if(auto [lockGuard, mailboxPtr, bucketId] = tryGetRLockedMailbox(uid); mailboxPtr){
+        mailboxPtr->parked.store(parked);
+    }
+}
+
+void ActorPool::setUpdateInterval(uint64_t uid, uint64_t msec)
+{
+    if(auto [lockGuard, mailboxPtr, bucketId] = tryGetRLockedMailbox(uid); mailboxPtr){
+        const auto newInterval = to_u32(std::min<uint64_t>(msec, UINT32_MAX));
+        const auto oldInterval = mailboxPtr->updateInterval.exchange(newInterval);
+
+        // next METRONOME was scheduled by the old interval
+        // when interval shrinks, e.g. monster gets attacked, don't wait out the old long interval
+        if(newInterval < oldInterval){
+            pullNextUpdateTime(mailboxPtr, m_tickTimer.diff_msec() + newInterval);
+        }
+    }
+}
+
 bool ActorPool::checkUIDValid(uint64_t uid) const
 {
     // always need to r-lock the sub-bucket even in dedicated actor thread
     // other bucket can spawn new actor to current sub-bucket
 
     logProfiler();
-    const auto &subBucketCRef = getSubBucket(uid);
-    MailboxSubBucket::RLockGuard lockGuard(subBucketCRef.lock);
-
-    const auto p = subBucketCRef.mailboxList.find(uid);
-    return p != subBucketCRef.mailboxList.end() && !(p->second->schedLock.detached());
+    const auto [lockGuard, mailboxPtr, bucketId] = tryGetRLockedMailbox(uid);
+    return mailboxPtr && !mailboxPtr->schedLock.detached();
 }
 
 bool ActorPool::isActorThread() const
@@ -885,12 +1247,8 @@ ActorMonitor ActorPool::getActorMonitor(uint64_t uid) const
         throw fflerror("querying actor monitor inside actor thread: WorkerID = %d, UID = %llu", getWorkerID(), to_llu(uid));
     }
 
-    const auto &subBucketCRef = getSubBucket(uid);
-    {
-        MailboxSubBucket::RLockGuard lockGuard(subBucketCRef.lock);
-        if(const auto p = subBucketCRef.mailboxList.find(uid); p != subBucketCRef.mailboxList.end() && !p->second->schedLock.detached()){
-            return p->second->dumpMonitor();
-        }
+    if(const auto [lockGuard, mailboxPtr, bucketId] = tryGetRLockedMailbox(uid); mailboxPtr && !mailboxPtr->schedLock.detached()){
+        return mailboxPtr->dumpMonitor();
     }
     return {};
 }
@@ -926,34 +1284,114 @@ std::vector<ActorMonitor> ActorPool::getActorMonitor() const
     return result;
 }
 
-ActorPool::Mailbox *ActorPool::tryGetMailboxPtr(uint64_t uid)
+std::vector<ActorThreadMonitor> ActorPool::getThreadMonitor() const
 {
-    // find the mailboxPtr without grabbing its schedLock
-    // if not in dedicated actor thread, calling this function likely is a bug
+    std::vector<ActorThreadMonitor> result;
+    result.reserve(m_bucketList.size());
 
-    // because immediately when we release the r-lock
-    // the dedicated actor thread can grab the schedLock and remove the {uid, mailboxPtr} pair form the sub-bucket
+    for(int bucketId = 0; bucketId < (int)(m_bucketList.size()); ++bucketId){
+        const auto &bucketCRef = m_bucketList[bucketId];
 
-    logProfiler();
-    auto &subBucketRef = getSubBucket(uid);
-    MailboxSubBucket::RLockGuard lockGuard(subBucketRef.lock);
-    if(auto p = subBucketRef.mailboxList.find(uid); p != subBucketRef.mailboxList.end()){
-        // should I check if it's detached here?
-        // it's not mandatory
-        return p->second.get();
+        uint64_t actorCount = 0;
+        for(const auto &subBucketCRef: bucketCRef.subBucketList){
+            MailboxSubBucket::RLockGuard lockGuard(subBucketCRef.lock);
+            actorCount += subBucketCRef.mailboxList.size();
+        }
+
+        result.push_back(ActorThreadMonitor
+        {
+            .threadId   = bucketId,
+            .actorCount = actorCount,
+            .liveTick   = to_u32(m_tickTimer.diff_msec()),
+            .busyTick   = to_u32(bucketCRef.busyTime.load(std::memory_order_relaxed) / 1000000ULL),
+            .avgJitter  = to_u32(bucketCRef.avgJitter.load(std::memory_order_relaxed)),
+            .maxJitter  = to_u32(bucketCRef.maxJitter.load(std::memory_order_relaxed)),
+        });
     }
-    return nullptr;
+    return result;
 }
 
-std::pair<ActorPool::MailboxSubBucket::RLockGuard, ActorPool::Mailbox *> ActorPool::tryGetRLockedMailboxPtr(uint64_t uid)
+int ActorPool::getBucketID(uint64_t uid) const
 {
+    const auto homeBucketId = getHomeBucketID(uid);
+    const auto &homeSubBucketCRef = getSubBucket(homeBucketId, getSubBucketID(uid));
+
+    MailboxSubBucket::RLockGuard lockGuard(homeSubBucketCRef.lock);
+    if(const auto p = homeSubBucketCRef.routeList.find(uid); p != homeSubBucketCRef.routeList.end()){
+        return p->second;
+    }
+    return homeBucketId;
+}
+
+std::vector<ActorPool::MailboxSubBucket::WLockGuard> ActorPool::wlockSubBucket(std::initializer_list<int> bucketIdList, int subBucketId)
+{
+    // lock in order of bucket ID
+    // all multi-lock places follow this order, no deadlock
+    std::vector<int> sortedBucketIdList(bucketIdList);
+    std::sort(sortedBucketIdList.begin(), sortedBucketIdList.end());
+    sortedBucketIdList.erase(std::unique(sortedBucketIdList.begin(), sortedBucketIdList.end()), sortedBucketIdList.end());
+
+    std::vector<MailboxSubBucket::WLockGuard> lockGuardList;
+    lockGuardList.reserve(sortedBucketIdList.size());
+
+    for(const auto bucketId: sortedBucketIdList){
+        lockGuardList.emplace_back(getSubBucket(bucketId, subBucketId).lock);
+    }
+    return lockGuardList;
+}
+
+std::tuple<ActorPool::MailboxSubBucket::RLockGuard, ActorPool::Mailbox *, int> ActorPool::tryGetRLockedMailbox(uint64_t uid) const
+{
+    // home sub-bucket either holds the mailbox or its route
+    // route and mailbox are changed together with both sub-buckets w-locked
+    //
+    // if route says bucket X but X doesn't have it, the mailbox moved after we read the route, retry
+    // if home has neither mailbox nor route, the mailbox doesn't exist at this point
+
     logProfiler();
-    auto &subBucketRef = getSubBucket(uid);
-    MailboxSubBucket::RLockGuard lockGuard(subBucketRef.lock);
-    if(auto p = subBucketRef.mailboxList.find(uid); p != subBucketRef.mailboxList.end()){
-        return {std::move(lockGuard), p->second.get()};
+    const auto subBucketId = getSubBucketID(uid);
+    const auto homeBucketId = getHomeBucketID(uid);
+    const auto &homeSubBucketCRef = getSubBucket(homeBucketId, subBucketId);
+
+    while(true){
+        int bucketId = homeBucketId;
+        {
+            MailboxSubBucket::RLockGuard lockGuard(homeSubBucketCRef.lock);
+            if(const auto p = homeSubBucketCRef.mailboxList.find(uid); p != homeSubBucketCRef.mailboxList.end()){
+                return {std::move(lockGuard), p->second.get(), homeBucketId};
+            }
+
+            if(const auto p = homeSubBucketCRef.routeList.find(uid); p != homeSubBucketCRef.routeList.end()){
+                bucketId = p->second;
+            }
+            else{
+                return {MailboxSubBucket::RLockGuard(), nullptr, -1};
+            }
+        }
+
+        const auto &subBucketCRef = getSubBucket(bucketId, subBucketId);
+        MailboxSubBucket::RLockGuard lockGuard(subBucketCRef.lock);
+
+        if(const auto p = subBucketCRef.mailboxList.find(uid); p != subBucketCRef.mailboxList.end()){
+            return {std::move(lockGuard), p->second.get(), bucketId};
+        }
     }
-    return {};
+    throw bad_reach();
+}
+
+std::tuple<ActorPool::MailboxSubBucket::RLockGuard, ActorPool::Mailbox *, int> ActorPool::findMailbox(uint64_t uid) const
+{
+    // find the mailboxPtr without grabbing its schedLock
+    // if in dedicated actor thread of the bucket holding the mailbox, don't keep the r-lock
+    //
+    // no other thread can remove or move the mailbox out of the bucket
+    // in other threads immediately when we release the r-lock the dedicated actor thread can grab the schedLock and remove it
+
+    auto [lockGuard, mailboxPtr, bucketId] = tryGetRLockedMailbox(uid);
+    if(mailboxPtr && bucketId == getWorkerID()){
+        lockGuard.unlock();
+    }
+    return {std::move(lockGuard), mailboxPtr, bucketId};
 }
 
 ActorPodMonitor ActorPool::getPodMonitor(uint64_t uid) const
@@ -962,12 +1400,8 @@ ActorPodMonitor ActorPool::getPodMonitor(uint64_t uid) const
         throw fflerror("querying actor pod monitor inside actor thread: WorkerID = %d, UID = %llu", getWorkerID(), to_llu(uid));
     }
 
-    const auto &subBucketCRef = getSubBucket(uid);
-    {
-        MailboxSubBucket::RLockGuard lockGuard(subBucketCRef.lock);
-        if(const auto p = subBucketCRef.mailboxList.find(uid); p != subBucketCRef.mailboxList.end() && !p->second->schedLock.detached()){
-            return p->second->actor->dumpPodMonitor();
-        }
+    if(const auto [lockGuard, mailboxPtr, bucketId] = tryGetRLockedMailbox(uid); mailboxPtr && !mailboxPtr->schedLock.detached()){
+        return mailboxPtr->actor->dumpPodMonitor();
     }
     return {};
 }
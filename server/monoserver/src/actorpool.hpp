@@ -27,13 +27,17 @@
 #include <vector>
 #include <thread>
 #include <memory>
+#include <span>
+#include <tuple>
 #include <cstdint>
 #include <shared_mutex>
 #include <unordered_map>
 #include "uidf.hpp"
 #include "condcheck.hpp"
 #include "raiitimer.hpp"
+#include "timerwheel.hpp"
 #include "messagepack.hpp"
+#include "mailboxqueue.hpp"
 #include "actormonitor.hpp"
 #include "parallel_hashmap/phmap.h"
 
@@ -223,11 +227,28 @@ class ActorPool final
                     }
                 }
 
-                void pop(std::vector<uint64_t> &uidList, size_t maxPop, uint64_t msec, int &ec)
+                void push(const std::vector<uint64_t> &uidList)
+                {
+                    // push a group of UIDs with one lock
+                    // used by multicast, only the dedicated actor thread waits on the condition
+                    bool added = false;
+                    {
+                        std::lock_guard<decltype(m_lock)> lockGuard(m_lock);
+                        for(const auto uid: uidList){
+                            added = m_uidQ.push(uid) || added;
+                        }
+                    }
+
+                    if(added){
+                        m_cond.notify_one();
+                    }
+                }
+
+                void pop(std::vector<uint64_t> &uidList, size_t maxPop, uint64_t usec, int &ec)
                 {
                     std::unique_lock<decltype(m_lock)> lockGuard(m_lock);
-                    if(msec > 0){
-                        const bool wait_res = m_cond.wait_for(lockGuard, std::chrono::milliseconds(msec), [this]() -> bool
+                    if(usec > 0){
+                        const bool wait_res = m_cond.wait_for(lockGuard, std::chrono::microseconds(usec), [this]() -> bool
                         {
                             return m_closed || !m_uidQ.empty();
                         });
@@ -401,14 +422,35 @@ class ActorPool final
             ActorPod    *actor = 0;
 
             MailboxMutex schedLock;
-            std::mutex   nextQLock;
 
+            // currQ is only accessed by the thread grabbing schedLock
+            // nextQ is lock-free if built with MIR2X_LOCKFREE_MAILBOX
             std::vector<std::pair<MessagePack, uint64_t>> currQ;
-            std::vector<std::pair<MessagePack, uint64_t>> nextQ;
+            MailboxQueue<std::pair<MessagePack, uint64_t>> nextQ;
 
             std::function<void()> atStart;
             std::function<void()> atExit;
 
+            // parked mailbox is skipped by METRONOME sweep
+            // messages still get handled when posted
+            std::atomic<bool> parked{false};
+
+            // METRONOME interval in msec set by the actor, 0 means every sweep
+            // sweep reaches one mailbox once per tick, the interval is rounded up to ticks
+            std::atomic<uint32_t> updateInterval{0};
+
+            // when to deliver next METRONOME, by m_tickTimer
+            // advanced by the thread grabbing schedLock, pulled earlier by setUpdateInterval() when interval shrinks
+            std::atomic<uint64_t> nextUpdateTime{0};
+
+            // messages posted to this mailbox by each actor thread in current migration window
+            // public threads are not counted, they have no affinity to any bucket
+            std::unique_ptr<std::atomic<uint32_t>[]> recvCountList;
+
+            // windows to skip before next migration, prevents mailbox bouncing between buckets
+            // only accessed by dedicated actor thread of the bucket holding this mailbox
+            int migrateCooldown = 0;
+
             // put a monitor structure and always maintain it
             // then no need to acquire schedLock to dump the monitor
             struct MailboxMonitor
@@ -435,7 +477,7 @@ class ActorPool final
 
             // put ctor in actorpool.cpp
             // ActorPod is incomplete type in actorpool.hpp
-            Mailbox(ActorPod *, std::function<void()>);
+            Mailbox(ActorPod *, std::function<void()>, size_t);
         };
 
         struct MailboxSubBucket
@@ -460,6 +502,13 @@ class ActorPool final
             mutable std::shared_mutex lock;
             phmap::flat_hash_map<uint64_t, std::unique_ptr<Mailbox>> mailboxList;
 
+            // mailbox of a UID can live in a bucket other than its home bucket, by placement hint or migration
+            // its home sub-bucket keeps where it lives, protected by the same lock
+            //
+            // moving a mailbox w-locks the sub-buckets of source, destination and home together
+            // always lock them in order of bucket ID, they have the same sub-bucket ID
+            phmap::flat_hash_map<uint64_t, int> routeList;
+
             using RLockGuard = std::shared_lock<std::shared_mutex>;
             using WLockGuard = std::unique_lock<std::shared_mutex>;
         };
@@ -471,12 +520,51 @@ class ActorPool final
             std::future<void> runThread;
             UIDQueue uidQPending;
             std::array<MailboxSubBucket, m_subBucketCount> subBucketList;
+
+            // wakeup timers registered by actors running in this thread
+            // only accessed by the dedicated actor thread, no lock needed
+            hres_timer wakeupTimer;
+            TimerWheel wakeupWheel;
+
+            // messages posted and handled by this actor thread
+            // only updated by this thread, reset after every report
+            std::atomic<uint64_t> postCount{0};
+            std::atomic<uint64_t> crossPostCount{0};
+            std::atomic<uint64_t> migrateCount{0};
+            std::array<std::atomic<uint64_t>, 40> procTimeHist{}; // handler time in log2(nsec)
+
+            hres_timer migrateTimer;
+            hres_timer reportTimer;
+
+            // sweep of sub-buckets is spread over the tick, one slot per sub-bucket
+            // jitter is lateness of a slot, in usec, busy time includes sweeps and runOneUID()
+            std::atomic<uint64_t> busyTime{0};
+            std::atomic<uint64_t> avgJitter{0};
+            std::atomic<uint64_t> maxJitter{0};
+
+            // only accessed by the dedicated actor thread
+            bool checkMigrate = false;
+            uint64_t reportBusyTime = 0;
         };
 
+    private:
+        // migration checks traffic of every mailbox once per window
+        // mailbox moves to the bucket posting at least 2/3 of its messages
+        constexpr static uint64_t m_migrateWindow   = 2000;
+        constexpr static uint32_t m_migrateMinCount = 32;
+        constexpr static int      m_migrateCooldown = 5;
+        constexpr static uint64_t m_reportInterval  = 60 * 1000;
+
     private:
         const uint32_t m_logicFPS;
+        const bool m_enableAffinity;
         std::vector<MailboxBucket> m_bucketList;
 
+    private:
+        // shared clock of METRONOME due time
+        // mailbox can move between buckets
+        const hres_timer m_tickTimer;
+
     private:
         static void backOff(uint64_t &nBackoff)
         {
@@ -536,7 +624,9 @@ class ActorPool final
         std::unordered_map<uint64_t, Receiver *> m_receiverList;
 
     public:
-        ActorPool(int, int);
+        // enableAffinity enables placement hint and migration
+        // otherwise mailbox always lives in its home bucket
+        ActorPool(int, int, bool = true);
 
     public:
         ~ActorPool();
@@ -547,7 +637,7 @@ class ActorPool final
 
     private:
         void attach(Receiver *);
-        void attach(ActorPod *, std::function<void()>);
+        void attach(ActorPod *, std::function<void()>, uint64_t);
 
     private:
         void detach(const Receiver *);
@@ -562,15 +652,38 @@ class ActorPool final
 
     private:
         bool postMessage(uint64_t, MessagePack);
+        size_t postMulticast(std::span<const uint64_t>, MessagePack);
+
+    private:
+        bool pushMailbox(Mailbox *, int, MessagePack);
+
+    private:
+        void addWakeup(uint64_t, uint64_t);
+
+    private:
+        void setParked(uint64_t, bool);
+        void setUpdateInterval(uint64_t, uint64_t);
 
     private:
         void runOneUID(uint64_t);
         bool runOneMailbox(Mailbox *, bool);
-        void runOneMailboxBucket(int);
+        void runOneMailboxBucket(int, int);
+
+    private:
+        bool checkMetronome(Mailbox *) const;
+        void pullNextUpdateTime(Mailbox *, uint64_t) const;
 
     private:
         void clearOneMailbox(Mailbox *);
 
+    private:
+        int  pickMigrateBucket(Mailbox *, int);
+        void migrateMailbox(Mailbox *, int, int);
+
+    private:
+        void addProcTime(Mailbox *, uint64_t);
+        void reportBucket(int);
+
     public:
         ActorMonitor getActorMonitor(uint64_t) const;
         std::vector<ActorMonitor> getActorMonitor() const;
@@ -579,11 +692,18 @@ class ActorPool final
         ActorPodMonitor getPodMonitor(uint64_t) const;
 
     public:
-        int getBucketID(uint64_t uid) const
+        std::vector<ActorThreadMonitor> getThreadMonitor() const;
+
+    public:
+        int getHomeBucketID(uint64_t uid) const
         {
             return static_cast<int>(uid % (uint64_t)(m_bucketList.size()));
         }
 
+        // bucket where the mailbox lives now
+        // returns home bucket if not placed elsewhere, or not exist
+        int getBucketID(uint64_t) const;
+
         int getSubBucketID(uint64_t uid) const
         {
             return static_cast<int>((uid / (uint64_t)(m_bucketList.size())) % (uint64_t)(m_subBucketCount));
@@ -600,18 +720,15 @@ class ActorPool final
             return m_bucketList.at(bucketId).subBucketList.at(subBucketId);
         }
 
-    public:
-        const MailboxSubBucket & getSubBucket(uint64_t uid) const
-        {
-            return const_cast<ActorPool *>(this)->getSubBucket(uid);
-        }
-
-        MailboxSubBucket & getSubBucket(uint64_t uid)
-        {
-            return getSubBucket(getBucketID(uid), getSubBucketID(uid));
-        }
+    private:
+        std::vector<MailboxSubBucket::WLockGuard> wlockSubBucket(std::initializer_list<int>, int);
 
     private:
-        Mailbox *tryGetMailboxPtr(uint64_t);
-        std::pair<MailboxSubBucket::RLockGuard, Mailbox *> tryGetRLockedMailboxPtr(uint64_t);
+        // returns r-locked sub-bucket holding the mailbox, the mailbox and its bucket ID
+        // follows route in home sub-bucket and retries if the mailbox moves during lookup
+        std::tuple<MailboxSubBucket::RLockGuard, Mailbox *, int> tryGetRLockedMailbox(uint64_t) const;
+
+        // same as above but doesn't keep the r-lock in dedicated actor thread of the bucket
+        // only that thread can remove or move a mailbox out of the bucket
+        std::tuple<MailboxSubBucket::RLockGuard, Mailbox *, int> findMailbox(uint64_t) const;
 };
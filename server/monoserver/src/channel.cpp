@@ -23,6 +23,7 @@
 #include "condcheck.hpp"
 #include "monoserver.hpp"
 #include "messagepack.hpp"
+#include "serverargparser.hpp"
 
 Channel::Channel(uint32_t nChannID, asio::ip::tcp::socket stSocket)
     : m_ID(nChannID)
@@ -43,6 +44,11 @@ Channel::Channel(uint32_t nChannID, asio::ip::tcp::socket stSocket)
     , m_sendPackQ1()
     , m_currSendQ(&(m_sendPackQ0))
     , m_nextSendQ(&(m_sendPackQ1))
+    , m_sendBufList()
+    , m_sendPackCount(0)
+    , m_sendCallCount(0)
+    , m_sendPendingBytes(0)
+    , m_packCodec()
 {}
 
 Channel::~Channel()
@@ -70,7 +76,10 @@ void Channel::DoReadPackHC()
                     extern MonoServer *g_monoServer;
                     g_monoServer->addLog(LOGTYPE_WARNING, "Last ClientMsg::HC      = %s", (ClientMsg(pThis->m_readHC).name().c_str()));
                     g_monoServer->addLog(LOGTYPE_WARNING, "              ::Type    = %d", (int)(ClientMsg(pThis->m_readHC).type()));
-                    g_monoServer->addLog(LOGTYPE_WARNING, "              ::MaskLen = %d", (int)(ClientMsg(pThis->m_readHC).maskLen()));
+                    if(ClientMsg(pThis->m_readHC).type() == 1){
+                        // maskLen() throws for other types, this runs in asio main loop
+                        g_monoServer->addLog(LOGTYPE_WARNING, "              ::MaskLen = %d", (int)(ClientMsg(pThis->m_readHC).maskLen()));
+                    }
                     g_monoServer->addLog(LOGTYPE_WARNING, "              ::DataLen = %d", (int)(ClientMsg(pThis->m_readHC).dataLen()));
                 };
 
@@ -228,7 +237,10 @@ void Channel::DoReadPackBody(size_t nMaskLen, size_t nBodyLen)
                     extern MonoServer *g_monoServer;
                     g_monoServer->addLog(LOGTYPE_WARNING, "Current serverMsg::HC      = %d", (int)(pThis->m_readHC));
                     g_monoServer->addLog(LOGTYPE_WARNING, "                 ::Type    = %d", (int)(ClientMsg(pThis->m_readHC).type()));
-                    g_monoServer->addLog(LOGTYPE_WARNING, "                 ::MaskLen = %d", (int)(ClientMsg(pThis->m_readHC).maskLen()));
+                    if(ClientMsg(pThis->m_readHC).type() == 1){
+                        // maskLen() throws for other types, this runs in asio main loop
+                        g_monoServer->addLog(LOGTYPE_WARNING, "                 ::MaskLen = %d", (int)(ClientMsg(pThis->m_readHC).maskLen()));
+                    }
                     g_monoServer->addLog(LOGTYPE_WARNING, "                 ::DataLen = %d", (int)(ClientMsg(pThis->m_readHC).dataLen()));
                 };
 
@@ -399,7 +411,29 @@ void Channel::DoSendPack()
                 }
 
                 condcheck(!m_currSendQ->Empty());
-                auto fnDoSendBuf = [pThis = shared_from_this()](std::error_code stEC, size_t)
+
+                // gather all contiguous packs in m_currSendQ into one async_write
+                // stop at the byte cap, always take at least one pack even if it's larger than the cap
+                // asio issues at most 64 buffers per writev(), more than that costs extra syscalls
+
+                m_sendBufList.clear();
+                {
+                    extern ServerArgParser *g_serverArgParser;
+                    const auto nGatherSize = (size_t)(g_serverArgParser->channelGatherSize);
+
+                    size_t nGatherLen = 0;
+                    for(size_t nIndex = 0; nIndex < m_currSendQ->Size() && m_sendBufList.size() < 64; ++nIndex){
+                        const auto stPack = m_currSendQ->GetChannPack(nIndex);
+                        if(!m_sendBufList.empty() && (nGatherLen + stPack.DataLen > nGatherSize)){
+                            break;
+                        }
+
+                        nGatherLen += stPack.DataLen;
+                        m_sendBufList.emplace_back(stPack.Data, stPack.DataLen);
+                    }
+                }
+
+                auto fnDoSendBuf = [pThis = shared_from_this(), nPackCount = m_sendBufList.size()](std::error_code stEC, size_t)
                 {
                     if(stEC){
                         // immediately shutdown the channel
@@ -411,20 +445,27 @@ void Channel::DoSendPack()
                         return;
                     }
 
-                    // send the first pack without error
-                    // invoke the callback and register the next round
+                    // all gathered packs sent without error
+                    // invoke the callbacks in post order and register the next round
 
-                    auto stCurrPack = pThis->m_currSendQ->GetChannPack();
-                    if(stCurrPack.DoneCB){
-                        stCurrPack.DoneCB();
+                    size_t nSentBytes = 0;
+                    for(size_t nIndex = 0; nIndex < nPackCount; ++nIndex){
+                        auto stCurrPack = pThis->m_currSendQ->GetChannPack(nIndex);
+                        if(stCurrPack.DoneCB){
+                            stCurrPack.DoneCB();
+                        }
+                        nSentBytes += stCurrPack.DataLen;
                     }
 
-                    pThis->m_currSendQ->RemoveChannPack();
+                    pThis->m_sendPackCount += nPackCount;
+                    pThis->m_sendCallCount += 1;
+                    pThis->m_sendPendingBytes -= nSentBytes;
+
+                    pThis->m_currSendQ->RemoveChannPack(nPackCount);
                     pThis->DoSendPack();
                 };
 
-                auto stCurrPack = m_currSendQ->GetChannPack();
-                asio::async_write(m_socket, asio::buffer(stCurrPack.Data, stCurrPack.DataLen), fnDoSendBuf);
+                asio::async_write(m_socket, m_sendBufList, fnDoSendBuf);
                 return;
             }
         default:
@@ -472,14 +513,50 @@ bool Channel::Post(uint8_t nHC, const uint8_t *pData, size_t nDataLen, std::func
 {
     // post current message to NextSendQ
     // this function is called by one server thread
+    size_t nPendingBytes = 0;
     {
         std::lock_guard<std::mutex> stLockGuard(m_nextQLock);
-        m_nextSendQ->AddChannPack(nHC, pData, nDataLen, std::move(fnDone));
+        const auto nPackBytes = m_nextSendQ->PackBytes();
+
+        m_nextSendQ->AddChannPack(&m_packCodec, nHC, pData, nDataLen, std::move(fnDone));
+        nPendingBytes = (m_sendPendingBytes += (m_nextSendQ->PackBytes() - nPackBytes));
+    }
+
+    // client doesn't drain the channel
+    // drop it rather than letting the send queue grow without bound
+
+    extern ServerArgParser *g_serverArgParser;
+    if(g_serverArgParser->channelSendHWM > 0 && nPendingBytes > (size_t)(g_serverArgParser->channelSendHWM)){
+        extern MonoServer *g_monoServer;
+        g_monoServer->addLog(LOGTYPE_WARNING, "Channel %d exceeds send high-water mark: %zu bytes pending", (int)(ID()), nPendingBytes);
+
+        Shutdown(false);
+        return false;
     }
 
     return FlushSendQ();
 }
 
+bool Channel::PostNetCaps(uint32_t nCaps)
+{
+    // SM_NETCAPS itself is sent without codec
+    // all packs added to m_nextSendQ after it get encoded in nCaps
+    {
+        SMNetCaps smNC;
+        std::memset(&smNC, 0, sizeof(smNC));
+        smNC.caps = nCaps;
+
+        std::lock_guard<std::mutex> stLockGuard(m_nextQLock);
+        if(!m_nextSendQ->AddChannPack(nullptr, SM_NETCAPS, (const uint8_t *)(&smNC), sizeof(smNC), {})){
+            return false;
+        }
+
+        m_sendPendingBytes += m_nextSendQ->GetChannPack(m_nextSendQ->Size() - 1).DataLen;
+        m_packCodec.enable(nCaps);
+    }
+    return FlushSendQ();
+}
+
 bool Channel::forwardActorMessage(uint8_t nHC, const uint8_t *pData, size_t nDataLen)
 {
     auto fnReportBadArgs = [nHC, pData, nDataLen]()
@@ -528,6 +605,14 @@ bool Channel::forwardActorMessage(uint8_t nHC, const uint8_t *pData, size_t nDat
             }
     }
 
+    // codec negotiation is channel level
+    // reply SM_NETCAPS and don't bother the bind actor
+    if(nHC == CM_NETCAPS){
+        extern ServerArgParser *g_serverArgParser;
+        const auto cmNC = ClientMsg::conv<CMNetCaps>(pData, nDataLen);
+        return PostNetCaps(g_serverArgParser->disableNetCodec ? NETCAP_NONE : (cmNC.caps & (NETCAP_DELTA | NETCAP_LZ4)));
+    }
+
     AMRecvPackage amRP;
     std::memset(&amRP, 0, sizeof(amRP));
 
@@ -557,6 +642,9 @@ void Channel::Shutdown(bool bForce)
                     pThis->m_dispatcher.forward(pThis->m_bindUID, {MPK_BADCHANNEL, amBC});
                     pThis->m_bindUID = 0;
 
+                    extern MonoServer *g_monoServer;
+                    g_monoServer->addLog(LOGTYPE_DEBUG, "Channel %d closed: %llu packs sent in %llu writes", (int)(pThis->ID()), to_llu(pThis->m_sendPackCount), to_llu(pThis->m_sendCallCount));
+
                     // if we call shutdown() here
                     // we need to use try-catch since if connection has already
                     // been broken, it throws exception
@@ -84,6 +84,24 @@ class Channel final: public std::enable_shared_from_this<Channel>
         ChannPackQ *m_currSendQ;
         ChannPackQ *m_nextSendQ;
 
+    private:
+        // gather mode of DoSendPack()
+        // buffers of all packs in flight of the current async_write, only asio main loop accesses
+        // m_sendPackCount / m_sendCallCount gives the syscalls-per-packet ratio when channel closes
+        std::vector<asio::const_buffer> m_sendBufList;
+        uint64_t m_sendPackCount;
+        uint64_t m_sendCallCount;
+
+    private:
+        // bytes posted but not sent yet in both queues
+        // server thread increases it in Post(), asio main loop decreases it after async_write
+        std::atomic<size_t> m_sendPendingBytes;
+
+    private:
+        // delta / lz4 state of packs posted to this channel
+        // enabled by CM_NETCAPS, protected by m_nextQLock
+        ChannPackCodec m_packCodec;
+
     public:
         // only asio main loop calls the constructor
         // in NetDriver::ChannBuild() called by std::make_shared<Channel>()
@@ -206,6 +224,11 @@ class Channel final: public std::enable_shared_from_this<Channel>
         // only called in Channel::Post(server_message)
         bool FlushSendQ();
 
+    private:
+        // called by asio main loop only
+        // reply CM_NETCAPS and switch codec of following packs
+        bool PostNetCaps(uint32_t);
+
     public:
         // called by asio main loop thread and server thread
         // it atomically set the channel state, which would disable everything
@@ -214,6 +237,19 @@ class Channel final: public std::enable_shared_from_this<Channel>
     public:
         bool Launch(uint64_t);
 
+    public:
+        // only asio main loop updates the counters
+        // read them when the loop doesn't run, or in a handler posted to it
+        uint64_t sendPackCount() const
+        {
+            return m_sendPackCount;
+        }
+
+        uint64_t sendCallCount() const
+        {
+            return m_sendCallCount;
+        }
+
     public:
         void BindActor(uint64_t nUID)
         {
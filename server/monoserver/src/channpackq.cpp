@@ -16,11 +16,44 @@
  * =====================================================================================
  */
 
+#include <atomic>
 #include "zcompf.hpp"
 #include "monoserver.hpp"
 #include "channpackq.hpp"
+#include "memorychunkpn.hpp"
 
-bool ChannPackQ::AddChannPack(uint8_t nHC, const uint8_t *pData, size_t nDataLen, std::function<void()> &&rstDoneCB)
+// pack buffer pool shared by all channels
+// 64B unit, 16KB per pool, 8 branches since server threads and asio main loop allocate/free concurrently
+// packs larger than 16KB fall back to new[] inside MemoryChunkPN
+static MemoryChunkPN<64, 256, 8> s_packPool;
+
+static std::atomic<uint64_t> s_packPoolUsedBytes  {0};
+static std::atomic<uint64_t> s_packPoolPeakBytes  {0};
+static std::atomic<uint64_t> s_packPoolChunkCount {0};
+
+static uint8_t *allocPackBuf(size_t nBufLen)
+{
+    const auto nUsedBytes = (s_packPoolUsedBytes += nBufLen);
+    for(auto nPeakBytes = s_packPoolPeakBytes.load(); nUsedBytes > nPeakBytes;){
+        if(s_packPoolPeakBytes.compare_exchange_weak(nPeakBytes, nUsedBytes)){
+            break;
+        }
+    }
+
+    s_packPoolChunkCount++;
+    return (uint8_t *)(s_packPool.Get(nBufLen));
+}
+
+static void freePackBuf(uint8_t *pBuf, size_t nBufLen)
+{
+    if(pBuf){
+        s_packPoolUsedBytes -= nBufLen;
+        s_packPoolChunkCount--;
+        s_packPool.Free(pBuf);
+    }
+}
+
+bool ChannPackQ::AddChannPack(ChannPackCodec *pCodec, uint8_t nHC, const uint8_t *pData, size_t nDataLen, std::function<void()> &&rstDoneCB)
 {
     auto fnReportError = [nHC, pData, nDataLen](const char *pErrorMessage)
     {
@@ -42,7 +75,7 @@ bool ChannPackQ::AddChannPack(uint8_t nHC, const uint8_t *pData, size_t nDataLen
                 auto pDst = GetPostBuf(1);
 
                 pDst[0] = nHC;
-                AddPackMark(GetBufOff(pDst), 1, std::move(rstDoneCB));
+                AddPackMark(pDst, 1, std::move(rstDoneCB));
 
                 return true;
             }
@@ -63,7 +96,16 @@ bool ChannPackQ::AddChannPack(uint8_t nHC, const uint8_t *pData, size_t nDataLen
                 // 2. if compressed length more than 254 we need two bytes
                 // 3. we support range in [0, 255 + 255]
 
-                auto pCompBuf = GetPostBuf(smSG.maskLen() + ((nDataLen + 7) / 8) + 16);
+                // delta mode: send XOR against last message of the same type
+                // fields not changed become zero bytes and get masked out by xorEncode()
+                if(pCodec && (pCodec->caps & NETCAP_DELTA) && smSG.deltaEncode()){
+                    pCodec->deltaBuf.resize(nDataLen);
+                    pCodec->delta.encode(nHC, pCodec->deltaBuf.data(), pData, nDataLen);
+                    pData = pCodec->deltaBuf.data();
+                }
+
+                // worst case: no zero byte in pData, compressed data is as long as the raw data
+                auto pCompBuf = GetPostBuf(4 + smSG.maskLen() + nDataLen);
                 auto nCompCnt = zcompf::xorEncode(pCompBuf + 4, pData, nDataLen);
 
                 if(nCompCnt < 0){
@@ -73,13 +115,13 @@ bool ChannPackQ::AddChannPack(uint8_t nHC, const uint8_t *pData, size_t nDataLen
                     pCompBuf[2] = nHC;
                     pCompBuf[3] = (uint8_t)(nCompCnt);
 
-                    return AddPackMark(GetBufOff(pCompBuf + 2), 2 + smSG.maskLen() + (size_t)(nCompCnt), std::move(rstDoneCB));
+                    return AddPackMark(pCompBuf + 2, 2 + smSG.maskLen() + (size_t)(nCompCnt), std::move(rstDoneCB));
                 }else if(nCompCnt <= (255 + 255)){
                     pCompBuf[1] = nHC;
                     pCompBuf[2] = 255;
                     pCompBuf[3] = (uint8_t)(nCompCnt - 255);
 
-                    return AddPackMark(GetBufOff(pCompBuf + 1), 3 + smSG.maskLen() + (size_t)(nCompCnt), std::move(rstDoneCB));
+                    return AddPackMark(pCompBuf + 1, 3 + smSG.maskLen() + (size_t)(nCompCnt), std::move(rstDoneCB));
                 }else{
                     fnReportError("Compressed data too long");
                     return false;
@@ -101,14 +143,15 @@ bool ChannPackQ::AddChannPack(uint8_t nHC, const uint8_t *pData, size_t nDataLen
                 auto pDst = GetPostBuf(smSG.dataLen() + 1);
                 pDst[0] = nHC;
                 std::memcpy(pDst + 1, pData, nDataLen);
-                return AddPackMark(GetBufOff(pDst), 1 + smSG.dataLen(), std::move(rstDoneCB));
+                return AddPackMark(pDst, 1 + smSG.dataLen(), std::move(rstDoneCB));
             }
         case 3:
             {
                 // not empty, not fixed size, not compressed
 
                 if(pData){
-                    if((nDataLen == 0) || (nDataLen > 0XFFFFFFFF)){
+                    // highest bit of the length is reserved for NETCODEC_LZ4FLAG
+                    if((nDataLen == 0) || (nDataLen >= NETCODEC_LZ4FLAG)){
                         fnReportError("Invalid argument");
                         return false;
                     }
@@ -119,6 +162,21 @@ bool ChannPackQ::AddChannPack(uint8_t nHC, const uint8_t *pData, size_t nDataLen
                     }
                 }
 
+                // lz4 mode: compress by the channel LZ4 stream
+                // [HC][compLen + 4 | NETCODEC_LZ4FLAG][origLen][LZ4 data]
+                if(pCodec && (pCodec->caps & NETCAP_LZ4) && pData && (nDataLen >= NETCODEC_LZ4MINSIZE) && (nDataLen <= LZ4_MAX_INPUT_SIZE)){
+                    auto pDst = GetPostBuf(NetLZ4Encoder::maxEncodeLen(nDataLen) + 9);
+                    pDst[0] = nHC;
+
+                    const auto nCompLen = pCodec->lz4.encode(pDst + 9, pData, nDataLen);
+                    const auto nBodyLenU32 = (uint32_t)(nCompLen + 4) | NETCODEC_LZ4FLAG;
+                    const auto nOrigLenU32 = (uint32_t)(nDataLen);
+
+                    std::memcpy(pDst + 1, &nBodyLenU32, sizeof(nBodyLenU32));
+                    std::memcpy(pDst + 5, &nOrigLenU32, sizeof(nOrigLenU32));
+                    return AddPackMark(pDst, nCompLen + 9, std::move(rstDoneCB));
+                }
+
                 auto pDst = GetPostBuf(nDataLen + 5);
                 pDst[0] = nHC;
 
@@ -128,7 +186,7 @@ bool ChannPackQ::AddChannPack(uint8_t nHC, const uint8_t *pData, size_t nDataLen
                 if(pData){
                     std::memcpy(pDst + 5, pData, nDataLen);
                 }
-                return AddPackMark(GetBufOff(pDst), nDataLen + 5, std::move(rstDoneCB));
+                return AddPackMark(pDst, nDataLen + 5, std::move(rstDoneCB));
             }
         default:
             {
@@ -138,29 +196,59 @@ bool ChannPackQ::AddChannPack(uint8_t nHC, const uint8_t *pData, size_t nDataLen
     }
 }
 
-bool ChannPackQ::AddPackMark(size_t nLoc, size_t nLength, std::function<void()> &&rstDoneCB)
+bool ChannPackQ::AddPackMark(const uint8_t *pData, size_t nLength, std::function<void()> &&rstDoneCB)
 {
-    if(!m_packMarkQ.empty()){
-        if(nLoc < m_packMarkQ.back().Loc + m_packMarkQ.back().Length){
-            return false;
-        }
+    // pack must be inside the buffer of last GetPostBuf()
+    // the mark takes the ownership of the buffer
+    if(!(m_postBuf && pData >= m_postBuf && pData + nLength <= m_postBuf + m_postBufLen)){
+        return false;
     }
 
-    m_packMarkQ.emplace_back(nLoc, nLength, std::move(rstDoneCB));
+    m_packBytes += nLength;
+    m_packMarkQ.emplace_back(m_postBuf, m_postBufLen, pData, nLength, std::move(rstDoneCB));
+
+    m_postBuf    = nullptr;
+    m_postBufLen = 0;
     return true;
 }
 
 uint8_t *ChannPackQ::GetPostBuf(size_t nNextLen)
 {
-    // find the first byte of the new buffer to allocate
-    // make sure current buffer can hold more nNextLen bytes for the new one
+    // allocate buffer for the next pack from the shared pool
+    // memory used by a queue grows with the bytes actually queued
+
+    freePackBuf(m_postBuf, m_postBufLen);
 
-    size_t nNextLoc0 = 0;
+    m_postBufLen = nNextLen + 16;
+    m_postBuf    = allocPackBuf(m_postBufLen);
+    return m_postBuf;
+}
 
-    if(!m_packMarkQ.empty()){
-        nNextLoc0 = m_packMarkQ.back().Loc + m_packMarkQ.back().Length;
+void ChannPackQ::RemoveChannPack(size_t nCount)
+{
+    for(size_t nIndex = 0; nIndex < nCount && !m_packMarkQ.empty(); ++nIndex){
+        auto &rstHead = m_packMarkQ.front();
+        m_packBytes -= rstHead.Length;
+
+        freePackBuf(rstHead.Buf, rstHead.BufLen);
+        m_packMarkQ.pop_front();
     }
+}
+
+void ChannPackQ::Clear()
+{
+    RemoveChannPack(m_packMarkQ.size());
 
-    m_packBuf.resize(nNextLoc0 + nNextLen + 16);
-    return &(m_packBuf[0]) + nNextLoc0;
+    freePackBuf(m_postBuf, m_postBufLen);
+    m_postBuf    = nullptr;
+    m_postBufLen = 0;
+}
+
+ChannPackPoolMonitor ChannPackQ::getPoolMonitor()
+{
+    ChannPackPoolMonitor stMonitor;
+    stMonitor.usedBytes  = s_packPoolUsedBytes.load();
+    stMonitor.peakBytes  = s_packPoolPeakBytes.load();
+    stMonitor.chunkCount = s_packPoolChunkCount.load();
+    return stMonitor;
 }
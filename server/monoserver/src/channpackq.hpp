@@ -18,7 +18,10 @@
 
 #pragma once
 #include <deque>
+#include <vector>
 #include <cstdint>
+#include <functional>
+#include "netcodec.hpp"
 
 struct ChannPack
 {
@@ -47,34 +50,75 @@ struct ChannPack
 
 struct PackMark
 {
-    size_t Loc;
-    size_t Length;
+    // Buf is the chunk from the shared pack pool, owned by the mark
+    // Data points into Buf since compressed packs have a variable header offset
+    uint8_t *Buf;
+    size_t   BufLen;
+
+    const uint8_t *Data;
+    size_t         Length;
 
     std::function<void()> DoneCB;
 
-    PackMark(size_t nLoc, size_t nLength, std::function<void()> &&rstDoneCB)
-        : Loc(nLoc)
+    PackMark(uint8_t *pBuf, size_t nBufLen, const uint8_t *pData, size_t nLength, std::function<void()> &&rstDoneCB)
+        : Buf(pBuf)
+        , BufLen(nBufLen)
+        , Data(pData)
         , Length(nLength)
         , DoneCB(std::move(rstDoneCB))
     {}
 };
 
+struct ChannPackPoolMonitor
+{
+    uint64_t usedBytes  = 0;
+    uint64_t peakBytes  = 0;
+    uint64_t chunkCount = 0;
+};
+
+// codec state of one channel
+// only accessed by the queue taking new packs, protected by Channel::m_nextQLock
+struct ChannPackCodec
+{
+    uint32_t caps = NETCAP_NONE;
+
+    NetDeltaCodec delta;
+    NetLZ4Encoder lz4;
+    std::vector<uint8_t> deltaBuf;
+
+    void enable(uint32_t nCaps)
+    {
+        caps = nCaps;
+        delta.reset();
+        lz4.reset();
+    }
+};
+
 class ChannPackQ
 {
     private:
-        std::vector<uint8_t> m_packBuf;
+        // buffer returned by last GetPostBuf()
+        // taken by AddPackMark() or recycled by next GetPostBuf()
+        uint8_t *m_postBuf;
+        size_t   m_postBufLen;
+
+    private:
+        size_t m_packBytes;
         std::deque<PackMark> m_packMarkQ;
 
     public:
         ChannPackQ()
-            : m_packBuf()
+            : m_postBuf(nullptr)
+            , m_postBufLen(0)
+            , m_packBytes(0)
             , m_packMarkQ()
-        {
-            m_packBuf.reserve(1024 * 1024 * 1024);
-        }
+        {}
 
     public:
-        ~ChannPackQ() = default;
+        ~ChannPackQ()
+        {
+            Clear();
+        }
 
     public:
         bool Empty() const
@@ -83,38 +127,39 @@ class ChannPackQ
         }
 
     public:
-        void Clear()
+        size_t Size() const
         {
-            m_packBuf.clear();
-            m_packMarkQ.clear();
+            return m_packMarkQ.size();
         }
 
-    public:
-        ChannPack GetChannPack()
+        size_t PackBytes() const
         {
-            auto &rstHead = m_packMarkQ.front();
-            return ChannPack(&(m_packBuf[rstHead.Loc]), rstHead.Length, rstHead.DoneCB);
+            return m_packBytes;
         }
 
-        void RemoveChannPack()
+    public:
+        void Clear();
+
+    public:
+        ChannPack GetChannPack(size_t nIndex = 0)
         {
-            if(!Empty()){
-                m_packMarkQ.pop_front();
-            }
+            auto &rstMark = m_packMarkQ.at(nIndex);
+            return ChannPack(rstMark.Data, rstMark.Length, rstMark.DoneCB);
         }
 
+        void RemoveChannPack(size_t nCount = 1);
+
     public:
         uint8_t *GetPostBuf(size_t);
 
     public:
-        bool AddChannPack(uint8_t, const uint8_t *, size_t, std::function<void()> &&);
+        bool AddChannPack(ChannPackCodec *, uint8_t, const uint8_t *, size_t, std::function<void()> &&);
 
     private:
-        bool AddPackMark(size_t, size_t, std::function<void()> &&);
+        bool AddPackMark(const uint8_t *, size_t, std::function<void()> &&);
 
-    private:
-        size_t GetBufOff(const uint8_t *pDst) const
-        {
-            return pDst - &(m_packBuf[0]);
-        }
+    public:
+        // usage of the pack pool shared by all channels
+        // thread safe, called by monitor windows
+        static ChannPackPoolMonitor getPoolMonitor();
 };
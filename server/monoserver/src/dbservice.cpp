@@ -0,0 +1,59 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: dbservice.cpp
+ *        Created: 10/16/2026 10:40:11
+ *    Description:
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#include "dbservice.hpp"
+#include "monoserver.hpp"
+
+extern MonoServer *g_monoServer;
+
+DBService::DBService()
+    : Dispatcher()
+    , m_receiver()
+    , m_worker
+      {
+          {
+              [this](uint32_t timeout) -> size_t
+              {
+                  return m_receiver.Wait(timeout);
+              },
+
+              [this]() -> std::vector<MessagePack>
+              {
+                  return m_receiver.Pop();
+              },
+          },
+
+          [this](const MessagePack &mpk, const MessageBuf &mb)
+          {
+              forward(mpk.from(), mb, mpk.ID());
+          },
+
+          [](bool warning, const std::string &msg)
+          {
+              g_monoServer->addLog(warning ? LOGTYPE_WARNING : LOGTYPE_INFO, "%s", msg.c_str());
+          },
+      }
+{}
+
+void DBService::launch(const char *dbName)
+{
+    m_worker.launch(dbName, []()
+    {
+        g_monoServer->propagateException();
+    });
+}
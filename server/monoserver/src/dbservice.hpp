@@ -0,0 +1,84 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: dbservice.hpp
+ *        Created: 10/16/2026 10:12:40
+ *    Description: write-behind database service, runs SQLite statements in its own thread
+ *                 actors talk to it by message, i.e.
+ *
+ *                     m_actorPod->forward(g_dbService->UID(), {MPK_DBSAVEPLAYER, amDBSP});
+ *
+ *                 if a response handler is provided it gets MPK_OK / MPK_ERROR when the
+ *                 transaction including the request is committed
+ *
+ *                 reads are async as well, MPK_DBLOADPLAYER responds MPK_DBPLAYERDATA
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#pragma once
+#include <cstdint>
+#include "receiver.hpp"
+#include "dbworker.hpp"
+#include "dispatcher.hpp"
+
+class DBService final: public Dispatcher
+{
+    private:
+        Receiver m_receiver;
+
+    private:
+        // owns a separate connection from g_dbPod
+        // then actor threads can still read DB while this thread is writing
+        DBWorker m_worker;
+
+    public:
+        DBService();
+
+    public:
+        ~DBService()
+        {
+            shutdown();
+        }
+
+    public:
+        uint64_t UID() const
+        {
+            return m_receiver.UID();
+        }
+
+    public:
+        void launch(const char *);
+
+    public:
+        // drains requests posted so far and stops the DB thread
+        // server exits by std::exit() and never deletes g_dbService, main() registers this by std::atexit()
+        void shutdown()
+        {
+            m_worker.stop();
+        }
+
+    public:
+        uint64_t requestCount() const
+        {
+            return m_worker.requestCount();
+        }
+
+        uint64_t commitCount() const
+        {
+            return m_worker.commitCount();
+        }
+
+        uint64_t statementCount() const
+        {
+            return m_worker.statementCount();
+        }
+};
@@ -0,0 +1,435 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: dbworker.cpp
+ *        Created: 10/17/2026 14:20:36
+ *    Description:
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#include <map>
+#include <chrono>
+#include <cstring>
+#include <sqlite3.h>
+#include "strf.hpp"
+#include "totype.hpp"
+#include "dbcomid.hpp"
+#include "fflerror.hpp"
+#include "dbworker.hpp"
+
+DBWorker::DBWorker(DBWorker::RequestSource source, DBWorker::RespondFunc fnRespond, DBWorker::LogFunc fnLog)
+    : m_source(std::move(source))
+    , m_respond(std::move(fnRespond))
+    , m_log(std::move(fnLog))
+    , m_thread()
+    , m_exit(false)
+    , m_dbPtr()
+    , m_stmtCache()
+    , m_retrySaveList()
+    , m_requestCount(0)
+    , m_commitCount(0)
+    , m_statementCount(0)
+    , m_retryCount(0)
+{
+    if(!(m_source.wait && m_source.pop)){
+        throw fflerror("DBWorker requires a request source");
+    }
+}
+
+DBWorker::~DBWorker()
+{
+    stop();
+}
+
+void DBWorker::launch(const char *dbName, std::function<void()> fnOnError)
+{
+    if(m_thread.joinable()){
+        throw fflerror("launch DBWorker twice");
+    }
+
+    m_dbPtr = std::make_unique<SQLite::Database>(dbName, SQLite::OPEN_READWRITE);
+    m_dbPtr->setBusyTimeout(1000);
+
+    m_thread = std::thread([this, fnOnError = std::move(fnOnError)]()
+    {
+        try{
+            runLoop();
+        }
+        catch(...){
+            if(fnOnError){
+                fnOnError();
+            }
+        }
+    });
+}
+
+void DBWorker::stop()
+{
+    m_exit = true;
+    if(m_thread.joinable()){
+        m_thread.join();
+    }
+}
+
+void DBWorker::runLoop()
+{
+    while(true){
+        // read exit flag before popping
+        // requests posted before stop() are always drained
+        const bool needExit = m_exit.load();
+
+        if(!needExit){
+            // wait for the first request of next window
+            // wake up by timeout to check the exit flag, stop() doesn't post anything
+            const auto waitStart = std::chrono::steady_clock::now();
+            if(!m_source.wait(m_flushWindow)){
+                // no new request in this window
+                // failed saves still get retried
+                if(!m_retrySaveList.empty()){
+                    flush({});
+                }
+                continue;
+            }
+
+            // window opens at the first request, not at last flush
+            // sleep till it expires, requests arriving meanwhile pile up in the source
+            //
+            // wait() returns at timeout if requests arrived during last flush
+            // their window is already expired, flush them immediately
+            if(std::chrono::steady_clock::now() - waitStart < std::chrono::milliseconds(m_flushWindow)){
+                std::this_thread::sleep_for(std::chrono::milliseconds(m_flushWindow));
+            }
+        }
+
+        // in exit mode keep popping till nothing left
+        // actor threads can still post while the last windows get flushed
+        while(true){
+            const auto mpkList = m_source.pop();
+            if(mpkList.empty()){
+                break;
+            }
+
+            flush(mpkList);
+            if(!needExit){
+                break;
+            }
+        }
+
+        if(needExit){
+            // last try for saves failed in the drain
+            // anything still failing is lost, report it
+            if(!m_retrySaveList.empty()){
+                flush({});
+            }
+            dropRetrySave();
+            return;
+        }
+    }
+}
+
+void DBWorker::mergeSave(AMDBSavePlayer &dst, const AMDBSavePlayer &src)
+{
+    if(dst.DBID && dst.DBID != src.DBID){
+        throw fflerror("merge saves of different players: %llu, %llu", to_llu(dst.DBID), to_llu(src.DBID));
+    }
+
+    dst.DBID = src.DBID;
+    if(src.dirty & DBSPF_EXP  ){ dst.exp   = src.exp  ; }
+    if(src.dirty & DBSPF_GOLD ){ dst.gold  = src.gold ; }
+    if(src.dirty & DBSPF_LEVEL){ dst.level = src.level; }
+
+    dst.dirty |= src.dirty;
+}
+
+void DBWorker::flush(const std::vector<MessagePack> &mpkList)
+{
+    // coalesce all save requests by DBID
+    // only the last written value of each field is needed
+    // saves failed in last flush come first, new saves are merged on top of them
+
+    std::map<uint32_t, PendingSave> saveList;
+    std::swap(saveList, m_retrySaveList);
+    std::vector<const MessagePack *> queryList;
+
+    for(const auto &mpk: mpkList){
+        m_requestCount++;
+        switch(mpk.Type()){
+            case MPK_DBSAVEPLAYER:
+                {
+                    const auto amDBSP = mpk.conv<AMDBSavePlayer>();
+                    auto &saveRef = saveList[amDBSP.DBID];
+
+                    mergeSave(saveRef.save, amDBSP);
+                    if(mpk.from() && mpk.ID()){
+                        saveRef.requestList.push_back(mpk);
+                    }
+                    break;
+                }
+            case MPK_DBQUERYLOGIN:
+            case MPK_DBLOADPLAYER:
+                {
+                    queryList.push_back(&mpk);
+                    break;
+                }
+            default:
+                {
+                    m_log(true, str_printf("Unsupported message to DBService: %s", mpkName(mpk.Type())));
+                    respond(mpk, MPK_ERROR);
+                    break;
+                }
+        }
+    }
+
+    if(!saveList.empty()){
+        writeSave(std::move(saveList));
+    }
+
+    // read requests are done after writes
+    // then they can see all previous writes from same requester
+    for(const auto mpkPtr: queryList){
+        if(mpkPtr->Type() == MPK_DBQUERYLOGIN){
+            queryLogin(*mpkPtr);
+        }
+        else{
+            loadPlayer(*mpkPtr);
+        }
+    }
+}
+
+void DBWorker::writeSave(std::map<uint32_t, PendingSave> saveList)
+{
+    try{
+        SQLite::Transaction dbTrans(*m_dbPtr);
+        for(const auto &[dbid, pendingSave]: saveList){
+            savePlayer(dbid, pendingSave.save);
+        }
+
+        dbTrans.commit();
+        m_commitCount++;
+
+        for(const auto &[dbid, pendingSave]: saveList){
+            for(const auto &mpk: pendingSave.requestList){
+                respond(mpk, MPK_OK);
+            }
+        }
+        return;
+    }
+    catch(const std::exception &e){
+        m_log(true, str_printf("DBService failed to commit %llu players, save one by one: %s", to_llu(saveList.size()), e.what()));
+    }
+
+    // transaction is rolled back, try every save in its own implicit transaction
+    // then one bad save doesn't take others down
+    //
+    // stop at the first busy or locked error, following saves would wait for the busy timeout and fail the same way
+    bool dbBusy = false;
+    for(auto &[dbid, pendingSave]: saveList){
+        if(!dbBusy){
+            try{
+                savePlayer(dbid, pendingSave.save);
+                for(const auto &mpk: pendingSave.requestList){
+                    respond(mpk, MPK_OK);
+                }
+                continue;
+            }
+            catch(const SQLite::Exception &e){
+                const auto errCode = e.getErrorCode() & 0XFF;
+                dbBusy = (errCode == SQLITE_BUSY) || (errCode == SQLITE_LOCKED);
+                m_log(true, str_printf("DBService failed to save player %llu: %s", to_llu(dbid), e.what()));
+            }
+            catch(const std::exception &e){
+                // not a database error, retry won't help
+                m_log(true, str_printf("DBService drops bad save of player %llu: %s", to_llu(dbid), e.what()));
+                for(const auto &mpk: pendingSave.requestList){
+                    respond(mpk, MPK_ERROR);
+                }
+                continue;
+            }
+        }
+        m_retrySaveList.emplace(dbid, std::move(pendingSave));
+    }
+
+    if(!m_retrySaveList.empty()){
+        m_retryCount++;
+        m_log(true, str_printf("DBService keeps %llu players for retry", to_llu(m_retrySaveList.size())));
+    }
+}
+
+void DBWorker::dropRetrySave()
+{
+    for(const auto &[dbid, pendingSave]: m_retrySaveList){
+        m_log(true, str_printf("DBService lost save of player %llu: exp = %llu, gold = %llu, level = %llu, dirty = 0x%08x",
+                    to_llu(dbid),
+                    to_llu(pendingSave.save.exp),
+                    to_llu(pendingSave.save.gold),
+                    to_llu(pendingSave.save.level),
+                    to_u32(pendingSave.save.dirty)));
+
+        for(const auto &mpk: pendingSave.requestList){
+            respond(mpk, MPK_ERROR);
+        }
+    }
+    m_retrySaveList.clear();
+}
+
+void DBWorker::respond(const MessagePack &mpk, const MessageBuf &mb)
+{
+    // only respond if the requester registered a response handler
+    // otherwise the request is fire-and-forget
+    if(mpk.from() && mpk.ID()){
+        m_respond(mpk, mb);
+    }
+}
+
+SQLite::Statement &DBWorker::getStatement(const std::string &sqlCmd)
+{
+    auto p = m_stmtCache.find(sqlCmd);
+    if(p == m_stmtCache.end()){
+        p = m_stmtCache.emplace(sqlCmd, std::make_unique<SQLite::Statement>(*m_dbPtr, sqlCmd)).first;
+    }
+
+    // statement can be left in bad state if last execution failed
+    // always reset before use, tryReset() won't throw for previous error
+
+    p->second->tryReset();
+    p->second->clearBindings();
+
+    m_statementCount++;
+    return *(p->second);
+}
+
+void DBWorker::savePlayer(uint32_t dbid, const AMDBSavePlayer &amDBSP)
+{
+    if(!amDBSP.dirty){
+        return;
+    }
+
+    // statement text only depends on the dirty mask
+    // at most 2^N statements are prepared and cached
+
+    std::string sqlCmd = "update tbl_dbid set ";
+    std::vector<uint32_t> bindList;
+
+    const auto fnAddField = [&sqlCmd, &bindList](const char *fieldName, uint32_t value)
+    {
+        if(!bindList.empty()){
+            sqlCmd += ", ";
+        }
+
+        sqlCmd += fieldName;
+        sqlCmd += " = ?";
+        bindList.push_back(value);
+    };
+
+    if(amDBSP.dirty & DBSPF_EXP  ){ fnAddField("fld_exp"  , amDBSP.exp  ); }
+    if(amDBSP.dirty & DBSPF_GOLD ){ fnAddField("fld_gold" , amDBSP.gold ); }
+    if(amDBSP.dirty & DBSPF_LEVEL){ fnAddField("fld_level", amDBSP.level); }
+
+    if(bindList.empty()){
+        throw fflerror("invalid dirty mask: 0x%08x", to_u32(amDBSP.dirty));
+    }
+
+    sqlCmd += " where fld_dbid = ?";
+    bindList.push_back(dbid);
+
+    auto &stmt = getStatement(sqlCmd);
+    for(int i = 0; i < (int)(bindList.size()); ++i){
+        stmt.bind(i + 1, bindList[i]);
+    }
+    stmt.exec();
+}
+
+void DBWorker::queryLogin(const MessagePack &mpk)
+{
+    const auto amDBQL = mpk.conv<AMDBQueryLogin>();
+    const std::string account (amDBQL.ID,       strnlen(amDBQL.ID,       sizeof(amDBQL.ID      )));
+    const std::string password(amDBQL.Password, strnlen(amDBQL.Password, sizeof(amDBQL.Password)));
+
+    try{
+        auto &queryID = getStatement("select fld_id from tbl_account where fld_account = ? and fld_password = ?");
+        queryID.bind(1, account);
+        queryID.bind(2, password);
+
+        if(!queryID.executeStep()){
+            m_log(false, str_printf("can't find account: (%s:%s)", account.c_str(), "******"));
+            respond(mpk, MPK_ERROR);
+            return;
+        }
+
+        const int id = queryID.getColumn("fld_id");
+        queryID.tryReset();
+
+        auto &queryDBID = getStatement("select * from tbl_dbid where fld_id = ?");
+        queryDBID.bind(1, id);
+
+        if(!queryDBID.executeStep()){
+            m_log(false, str_printf("no dbid created for this account: (%s:%s)", account.c_str(), "******"));
+            respond(mpk, MPK_ERROR);
+            return;
+        }
+
+        AMLoginQueryDB amLQDB;
+        std::memset(&amLQDB, 0, sizeof(amLQDB));
+
+        amLQDB.DBID      = queryDBID.getColumn("fld_dbid");
+        amLQDB.MapID     = DBCOM_MAPID(to_u8cstr((const char *)(queryDBID.getColumn("fld_mapname"))));
+        amLQDB.MapX      = queryDBID.getColumn("fld_mapx");
+        amLQDB.MapY      = queryDBID.getColumn("fld_mapy");
+        amLQDB.Level     = queryDBID.getColumn("fld_level");
+        amLQDB.JobID     = queryDBID.getColumn("fld_jobid");
+        amLQDB.Direction = queryDBID.getColumn("fld_direction");
+
+        // level not written yet because last save failed
+        if(auto p = m_retrySaveList.find(amLQDB.DBID); p != m_retrySaveList.end() && (p->second.save.dirty & DBSPF_LEVEL)){
+            amLQDB.Level = (int)(p->second.save.level);
+        }
+
+        // reset read statement immediately
+        // an active statement keeps the read lock and blocks writers of other connections
+        queryDBID.tryReset();
+
+        respond(mpk, {MPK_LOGINQUERYDB, amLQDB});
+    }
+    catch(const std::exception &e){
+        m_log(true, str_printf("DBService failed to query login for %s: %s", account.c_str(), e.what()));
+        respond(mpk, MPK_ERROR);
+    }
+}
+
+void DBWorker::loadPlayer(const MessagePack &mpk)
+{
+    const auto amDBLP = mpk.conv<AMDBLoadPlayer>();
+    try{
+        auto &queryPlayer = getStatement("select fld_name from tbl_dbid where fld_dbid = ?");
+        queryPlayer.bind(1, amDBLP.DBID);
+
+        if(!queryPlayer.executeStep()){
+            m_log(true, str_printf("no player found for dbid: %llu", to_llu(amDBLP.DBID)));
+            respond(mpk, MPK_ERROR);
+            return;
+        }
+
+        AMDBPlayerData amDBPD;
+        std::memset(&amDBPD, 0, sizeof(amDBPD));
+
+        amDBPD.DBID = amDBLP.DBID;
+        const std::string name = queryPlayer.getColumn("fld_name");
+        std::strncpy(amDBPD.name, name.c_str(), sizeof(amDBPD.name) - 1);
+
+        queryPlayer.tryReset();
+        respond(mpk, {MPK_DBPLAYERDATA, amDBPD});
+    }
+    catch(const std::exception &e){
+        m_log(true, str_printf("DBService failed to load player %llu: %s", to_llu(amDBLP.DBID), e.what()));
+        respond(mpk, MPK_ERROR);
+    }
+}
@@ -0,0 +1,162 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: dbworker.hpp
+ *        Created: 10/17/2026 14:20:36
+ *    Description: thread running SQLite statements for DBService
+ *
+ *                 requests are taken from a source, a window opens at the first request and
+ *                 stays open for m_flushWindow msec, everything arriving inside the window
+ *                 is collected, saves of one player get coalesced and all saves in a window
+ *                 are done in one transaction, reads are done after the writes
+ *
+ *                 if the transaction fails, saves are tried one by one, saves that still fail
+ *                 are kept and merged into the next window, they are only dropped at exit
+ *
+ *                 source and response are callbacks, no actor or GUI dependency, then it can
+ *                 be driven by a test without the actor pool
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#pragma once
+#include <map>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <SQLiteCpp/SQLiteCpp.h>
+#include "messagepack.hpp"
+
+class DBWorker final
+{
+    public:
+        struct RequestSource
+        {
+            // blocks till a new request comes or timeout in msec
+            // returns number of pending requests, same as Receiver::Wait()
+            std::function<size_t(uint32_t)> wait;
+
+            // takes all pending requests
+            std::function<std::vector<MessagePack>()> pop;
+        };
+
+        // respond to the requester of a message
+        using RespondFunc = std::function<void(const MessagePack &, const MessageBuf &)>;
+
+        // log a message, bool is true for warnings
+        using LogFunc = std::function<void(bool, const std::string &)>;
+
+    public:
+        constexpr static uint32_t m_flushWindow = 50;
+
+    private:
+        // coalesced save of one player
+        // requests are kept to respond after the save is written
+        struct PendingSave
+        {
+            AMDBSavePlayer save {};
+            std::vector<MessagePack> requestList;
+        };
+
+    private:
+        const RequestSource m_source;
+        const RespondFunc m_respond;
+        const LogFunc m_log;
+
+    private:
+        std::thread m_thread;
+        std::atomic<bool> m_exit;
+
+    private:
+        std::unique_ptr<SQLite::Database> m_dbPtr;
+
+    private:
+        // prepared statements keyed by SQL text
+        // always reset a statement after execution
+        std::unordered_map<std::string, std::unique_ptr<SQLite::Statement>> m_stmtCache;
+
+    private:
+        // saves failed in last flush, retried by next flush
+        // reads check it for fields not written yet
+        std::map<uint32_t, PendingSave> m_retrySaveList;
+
+    private:
+        std::atomic<uint64_t> m_requestCount;
+        std::atomic<uint64_t> m_commitCount;
+        std::atomic<uint64_t> m_statementCount;
+        std::atomic<uint64_t> m_retryCount;
+
+    public:
+        DBWorker(RequestSource, RespondFunc, LogFunc);
+
+    public:
+        ~DBWorker();
+
+    public:
+        // fnOnError runs in worker thread when worker exits by exception
+        void launch(const char *, std::function<void()>);
+
+    public:
+        // drains all pending requests and joins the worker thread
+        // requests posted after it returns are not handled
+        void stop();
+
+    public:
+        uint64_t requestCount() const
+        {
+            return m_requestCount.load();
+        }
+
+        uint64_t commitCount() const
+        {
+            return m_commitCount.load();
+        }
+
+        uint64_t statementCount() const
+        {
+            return m_statementCount.load();
+        }
+
+        // number of flushes which kept failed saves for retry
+        uint64_t retryCount() const
+        {
+            return m_retryCount.load();
+        }
+
+    public:
+        // merge a later save into an earlier one of the same player
+        // only fields in the later dirty mask are taken
+        static void mergeSave(AMDBSavePlayer &, const AMDBSavePlayer &);
+
+    private:
+        void runLoop();
+        void flush(const std::vector<MessagePack> &);
+
+    private:
+        void writeSave(std::map<uint32_t, PendingSave>);
+        void dropRetrySave();
+
+    private:
+        void respond(const MessagePack &, const MessageBuf &);
+
+    private:
+        SQLite::Statement &getStatement(const std::string &);
+
+    private:
+        void savePlayer(uint32_t, const AMDBSavePlayer &);
+        void queryLogin(const MessagePack &);
+        void loadPlayer(const MessagePack &);
+};
@@ -0,0 +1,310 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: mailboxqueue.hpp
+ *        Created: 10/16/2026 22:05:37
+ *    Description: pending message queue of ActorPool::Mailbox
+ *                 many threads push, only the thread grabbing the schedLock takes messages out
+ *
+ *                 two implementations, build with MIR2X_LOCKFREE_MAILBOX to use the lock-free
+ *                 version as MailboxQueue, tests and benchmark use both by name
+ *
+ *                 LockFreeMailboxQueue:
+ *
+ *                     push : CAS the node to the list head, LIFO order
+ *                     take : exchange the head with nullptr and reverse the list, FIFO order
+ *                     seal : exchange the head with a sentinel, all following push fail
+ *
+ *                 a node is allocated by the pushing thread and freed by the taking thread,
+ *                 freed nodes are sent back to the pool of the pushing thread and reused by
+ *                 its next push, see NodePool
+ *
+ *                 MutexMailboxQueue:
+ *
+ *                     mutex-protected std::vector, the default
+ *
+ *                 the lock-free version isn't faster without contention, see mailboxqueuebench
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#pragma once
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+template<typename T> class LockFreeMailboxQueue
+{
+    private:
+        struct NodePool;
+        struct QueueNode
+        {
+            T data;
+            QueueNode *next = nullptr;
+            NodePool  *pool = nullptr;
+        };
+
+        // nodes freed by other threads go back to the pool of the thread who allocated them
+        // only the owner thread takes them out, by exchanging the whole list, so no ABA
+        // after the owner thread exits the return list is sealed, nodes come back later are deleted
+        // and the last one deletes the pool
+        struct NodePool
+        {
+            std::atomic<QueueNode *> returnHead {nullptr};
+            std::atomic<long> orphanCount {0};
+        };
+
+    private:
+        class NodeCache
+        {
+            private:
+                NodePool *m_pool;
+
+            private:
+                long m_liveCount = 0;
+                std::vector<QueueNode *> m_nodeList;
+
+            public:
+                NodeCache()
+                    : m_pool(new NodePool())
+                {}
+
+                ~NodeCache()
+                {
+                    for(auto p: m_nodeList){
+                        delete p;
+                        m_liveCount--;
+                    }
+
+                    for(auto p = m_pool->returnHead.exchange(sealedNode(), std::memory_order_acquire); p;){
+                        auto next = p->next;
+                        delete p;
+                        m_liveCount--;
+                        p = next;
+                    }
+
+                    // nodes still in queues or being recycled by other threads
+                    // orphanCount can already be negative if some of them came back after the seal
+                    if(m_pool->orphanCount.fetch_add(m_liveCount, std::memory_order_acq_rel) + m_liveCount == 0){
+                        delete m_pool;
+                    }
+                }
+
+            public:
+                QueueNode *get(T &&data)
+                {
+                    if(m_nodeList.empty()){
+                        for(auto p = m_pool->returnHead.exchange(nullptr, std::memory_order_acquire); p; p = p->next){
+                            m_nodeList.push_back(p);
+                        }
+                    }
+
+                    if(m_nodeList.empty()){
+                        m_liveCount++;
+                        return new QueueNode{std::move(data), nullptr, m_pool};
+                    }
+
+                    auto p = m_nodeList.back();
+                    m_nodeList.pop_back();
+
+                    p->data = std::move(data);
+                    p->next = nullptr;
+                    return p;
+                }
+
+                // data should be moved out or reset by caller
+                void recycle(QueueNode *p)
+                {
+                    if(p->pool != m_pool){
+                        returnNode(p);
+                    }
+                    else if(m_nodeList.size() < 4096){
+                        m_nodeList.push_back(p);
+                    }
+                    else{
+                        delete p;
+                        m_liveCount--;
+                    }
+                }
+        };
+
+    private:
+        std::atomic<QueueNode *> m_head;
+
+    public:
+        LockFreeMailboxQueue()
+            : m_head(nullptr)
+        {}
+
+        ~LockFreeMailboxQueue()
+        {
+            // don't touch the thread_local cache here
+            // queue can be destroyed after it during thread exit
+            for(auto p = m_head.exchange(sealedNode()); p && p != sealedNode();){
+                auto next = p->next;
+                p->data = T();
+                returnNode(p);
+                p = next;
+            }
+        }
+
+    private:
+        static QueueNode *sealedNode()
+        {
+            // never dereferenced, only the address is used as a sentinel
+            static char s_sealed;
+            return reinterpret_cast<QueueNode *>(&s_sealed);
+        }
+
+        static NodeCache &nodeCache()
+        {
+            thread_local NodeCache s_nodeCache;
+            return s_nodeCache;
+        }
+
+        static void returnNode(QueueNode *p)
+        {
+            auto pool = p->pool;
+            auto head = pool->returnHead.load(std::memory_order_relaxed);
+
+            do{
+                if(head == sealedNode()){
+                    delete p;
+                    if(pool->orphanCount.fetch_sub(1, std::memory_order_acq_rel) == 1){
+                        delete pool;
+                    }
+                    return;
+                }
+                p->next = head;
+            }while(!pool->returnHead.compare_exchange_weak(head, p, std::memory_order_release, std::memory_order_relaxed));
+        }
+
+    public:
+        // fnClosed is a cheat to return earlier
+        // the real guard is the sentinel set by seal()
+        template<typename F> bool push(T data, F &&fnClosed)
+        {
+            if(fnClosed()){
+                return false;
+            }
+
+            auto node = nodeCache().get(std::move(data));
+            auto head = m_head.load(std::memory_order_relaxed);
+
+            do{
+                if(head == sealedNode()){
+                    node->data = T();
+                    nodeCache().recycle(node);
+                    return false;
+                }
+                node->next = head;
+            }while(!m_head.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+            return true;
+        }
+
+    private:
+        static void takeList(QueueNode *head, std::vector<T> &dst)
+        {
+            // list is in LIFO order
+            // reverse it to keep the posting order
+
+            QueueNode *prev = nullptr;
+            while(head){
+                auto next = head->next;
+                head->next = prev;
+                prev = head;
+                head = next;
+            }
+
+            while(prev){
+                auto next = prev->next;
+                dst.push_back(std::move(prev->data));
+                nodeCache().recycle(prev);
+                prev = next;
+            }
+        }
+
+    public:
+        // append all pending messages to dst
+        // return false if nothing is pending
+        bool take(std::vector<T> &dst)
+        {
+            auto head = m_head.load(std::memory_order_relaxed);
+            do{
+                if(!head || head == sealedNode()){
+                    return false;
+                }
+            }while(!m_head.compare_exchange_weak(head, nullptr, std::memory_order_acquire, std::memory_order_relaxed));
+
+            takeList(head, dst);
+            return true;
+        }
+
+        // append all pending messages to dst
+        // after this call all push() fail, see ActorPool::clearOneMailbox()
+        void seal(std::vector<T> &dst)
+        {
+            if(auto head = m_head.exchange(sealedNode(), std::memory_order_acq_rel); head != sealedNode()){
+                takeList(head, dst);
+            }
+        }
+};
+
+template<typename T> class MutexMailboxQueue
+{
+    private:
+        std::mutex m_lock;
+        std::vector<T> m_queue;
+
+    public:
+        // fnClosed is checked with the lock
+        // it's the guard against clearOneMailbox()
+        template<typename F> bool push(T data, F &&fnClosed)
+        {
+            std::lock_guard<std::mutex> lockGuard(m_lock);
+            if(fnClosed()){
+                return false;
+            }
+
+            m_queue.push_back(std::move(data));
+            return true;
+        }
+
+        bool take(std::vector<T> &dst)
+        {
+            std::lock_guard<std::mutex> lockGuard(m_lock);
+            if(m_queue.empty()){
+                return false;
+            }
+
+            if(dst.empty()){
+                std::swap(dst, m_queue);
+            }
+            else{
+                dst.insert(dst.end(), std::make_move_iterator(m_queue.begin()), std::make_move_iterator(m_queue.end()));
+                m_queue.clear();
+            }
+            return true;
+        }
+
+        void seal(std::vector<T> &dst)
+        {
+            take(dst);
+        }
+};
+
+#ifdef MIR2X_LOCKFREE_MAILBOX
+template<typename T> using MailboxQueue = LockFreeMailboxQueue<T>;
+#else
+template<typename T> using MailboxQueue = MutexMailboxQueue<T>;
+#endif
@@ -19,7 +19,8 @@
 #include <asio.hpp>
 #include "log.hpp"
 #include "dbpod.hpp"
-#include "mapbindb.hpp"
+#include "dbservice.hpp"
+#include "mapdataregistry.hpp"
 #include "actorpool.hpp"
 #include "netdriver.hpp"
 #include "argparser.hpp"
@@ -35,8 +36,9 @@ Log                      *g_log;
 ActorPool                *g_actorPool;
 NetDriver                *g_netDriver;
 DBPod                    *g_dbPod;
+DBService                *g_dbService;
 
-MapBinDB                 *g_mapBinDB;
+MapDataRegistry          *g_mapDataRegistry;
 ScriptWindow             *g_scriptWindow;
 ProfilerWindow           *g_profilerWindow;
 MainWindow               *g_mainWindow;
@@ -64,10 +66,11 @@ int main(int argc, char *argv[])
         g_profilerWindow        = new ProfilerWindow();
         g_mainWindow            = new MainWindow();
         g_monoServer            = new MonoServer();
-        g_mapBinDB              = new MapBinDB();
+        g_mapDataRegistry       = new MapDataRegistry();
         g_serverConfigureWindow = new ServerConfigureWindow();
-        g_actorPool             = new ActorPool(g_serverArgParser->actorPoolThread, 10);
+        g_actorPool             = new ActorPool(g_serverArgParser->actorPoolThread, 10, !g_serverArgParser->disableActorAffinity);
         g_dbPod                 = new DBPod();
+        g_dbService             = new DBService();
         g_netDriver             = new NetDriver();
         g_podMonitorWindow      = new PodMonitorWindow();
         g_actorMonitorWindow    = new ActorMonitorWindow();
@@ -79,6 +82,11 @@ int main(int argc, char *argv[])
                 std::printf("%s", s.c_str());
             });
         });
+
+        std::atexit(+[]()
+        {
+            g_dbService->shutdown();
+        });
         g_mainWindow->showAll();
 
         while(Fl::wait() > 0){
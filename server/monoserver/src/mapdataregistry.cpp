@@ -0,0 +1,196 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: mapdataregistry.cpp
+ *        Created: 10/18/2026 15:20:06
+ *    Description:
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+#include <cstdio>
+#include <filesystem>
+#include "strf.hpp"
+#include "totype.hpp"
+#include "filemap.hpp"
+#include "fileptr.hpp"
+#include "raiitimer.hpp"
+#include "mapdataregistry.hpp"
+
+bool MapDataRegistry::load(const char *dbPath, const char *cacheDir)
+{
+    if(!dbPath){
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lockGuard(m_lock);
+    try{
+        m_zsdbPtr = std::make_unique<ZSDB>(dbPath);
+    }
+    catch(...){
+        m_zsdbPtr.reset();
+        return false;
+    }
+
+    m_dbPath = dbPath;
+    m_cacheDir = (cacheDir && cacheDir[0]) ? std::string(cacheDir) : (m_dbPath + ".cache");
+    m_mapDataList.clear();
+    return true;
+}
+
+std::shared_ptr<const Mir2xMapData> MapDataRegistry::retrieve(uint32_t mapID, LoadStat *statPtr)
+{
+    std::lock_guard<std::mutex> lockGuard(m_lock);
+    if(auto p = m_mapDataList.find(mapID); p != m_mapDataList.end()){
+        return p->second;
+    }
+
+    LoadStat stat;
+    const hres_timer timer;
+
+    auto mapDataPtr = loadMapData(mapID, &stat);
+    stat.loaded = true;
+    stat.loadTime = timer.diff_usec();
+    stat.dataSize = mapDataPtr ? mapDataPtr->DataLen() : 0;
+
+    if(statPtr){
+        *statPtr = stat;
+    }
+    return m_mapDataList[mapID] = std::move(mapDataPtr);
+}
+
+std::shared_ptr<const Mir2xMapData> MapDataRegistry::loadMapData(uint32_t mapID, LoadStat *statPtr)
+{
+    if(!m_zsdbPtr){
+        return nullptr;
+    }
+
+    const auto fileName = cachePath(mapID);
+    if(cacheValid(fileName)){
+        if(auto mapDataPtr = mapCache(fileName)){
+            statPtr->cacheHit = true;
+            statPtr->mapped = true;
+            return mapDataPtr;
+        }
+    }
+
+    std::vector<uint8_t> buf;
+    if(!m_zsdbPtr->Decomp(mapID, &buf)){
+        return nullptr;
+    }
+
+    // cache file may be corrupted or invalid map data
+    // if mapping it fails, load the decompressed buffer anyway
+    if(writeCache(fileName, buf)){
+        if(auto mapDataPtr = mapCache(fileName)){
+            statPtr->mapped = true;
+            return mapDataPtr;
+        }
+    }
+
+    auto mapDataPtr = std::make_shared<Mir2xMapData>();
+    if(!mapDataPtr->Load(buf.data(), buf.size())){
+        return nullptr;
+    }
+    return mapDataPtr;
+}
+
+std::string MapDataRegistry::cachePath(uint32_t mapID) const
+{
+    return str_printf("%s/%08llX.bin", m_cacheDir.c_str(), to_llu(mapID));
+}
+
+bool MapDataRegistry::cacheValid(const std::string &fileName) const
+{
+    std::error_code ec;
+    if(!std::filesystem::is_regular_file(fileName, ec)){
+        return false;
+    }
+
+    const auto cacheTime = std::filesystem::last_write_time(fileName, ec);
+    if(ec){
+        return false;
+    }
+
+    const auto dbTime = std::filesystem::last_write_time(m_dbPath, ec);
+    if(ec){
+        return false;
+    }
+    return cacheTime >= dbTime;
+}
+
+bool MapDataRegistry::writeCache(const std::string &fileName, const std::vector<uint8_t> &buf) const
+{
+    std::error_code ec;
+    std::filesystem::create_directories(m_cacheDir, ec);
+    if(ec){
+        return false;
+    }
+
+    // write to a temp file and rename
+    // readers never see a partial cache file
+    const auto tmpFileName = fileName + ".tmp";
+    try{
+        auto fptr = make_fileptr(tmpFileName.c_str(), "wb");
+        if(std::fwrite(buf.data(), buf.size(), 1, fptr.get()) != 1){
+            throw fflerror("failed to write cache file: %s", tmpFileName.c_str());
+        }
+    }
+    catch(...){
+        std::filesystem::remove(tmpFileName, ec);
+        return false;
+    }
+
+    std::filesystem::rename(tmpFileName, fileName, ec);
+    if(ec){
+        std::filesystem::remove(tmpFileName, ec);
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<const Mir2xMapData> MapDataRegistry::mapCache(const std::string &fileName)
+{
+    try{
+        auto mapDataPtr = std::make_shared<Mir2xMapData>();
+        if(mapDataPtr->Load(std::make_shared<const FileMap>(fileName.c_str()))){
+            return mapDataPtr;
+        }
+    }
+    catch(...){
+        // failed to map the cache file
+        // caller rebuilds it
+    }
+    return nullptr;
+}
+
+size_t MapDataRegistry::processRSS()
+{
+#if defined(__linux__)
+    // statm: size resident shared text lib data dt, in pages
+    if(auto fp = std::fopen("/proc/self/statm", "r")){
+        unsigned long long pageSize = 0;
+        unsigned long long pageResident = 0;
+
+        const int count = std::fscanf(fp, "%llu %llu", &pageSize, &pageResident);
+        std::fclose(fp);
+
+        if(count == 2){
+            return (size_t)(pageResident) * (size_t)(sysconf(_SC_PAGESIZE));
+        }
+    }
+#endif
+    return 0;
+}
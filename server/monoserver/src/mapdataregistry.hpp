@@ -0,0 +1,90 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: mapdataregistry.hpp
+ *        Created: 10/18/2026 15:20:06
+ *    Description: process-wide read-only map data
+ *
+ *                 every map gets decompressed from the map ZSDB only once, into a cache
+ *                 file under the cache dir, then the cache file is mapped and shared by all
+ *                 server maps with the same map ID, pages of the mapping are backed by the
+ *                 file, kernel can drop them and they are shared between server processes
+ *
+ *                 cache file older than the ZSDB is rebuilt
+ *                 if cache dir is not writable the map data is loaded into memory, still shared
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#pragma once
+#include <mutex>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <unordered_map>
+#include "zsdb.hpp"
+#include "mir2xmapdata.hpp"
+
+class MapDataRegistry final
+{
+    public:
+        struct LoadStat
+        {
+            // false if map data has already been loaded by previous call
+            bool loaded = false;
+
+            // cacheHit : reuse cache file, no decompression
+            // mapped   : data refers to the mapped cache file, otherwise copied into memory
+            bool cacheHit = false;
+            bool mapped   = false;
+
+            size_t   dataSize = 0;
+            uint64_t loadTime = 0; // usec
+        };
+
+    private:
+        std::mutex m_lock;
+
+    private:
+        std::string m_dbPath;
+        std::string m_cacheDir;
+        std::unique_ptr<ZSDB> m_zsdbPtr;
+
+    private:
+        // failed map keeps a null entry, don't retry
+        std::unordered_map<uint32_t, std::shared_ptr<const Mir2xMapData>> m_mapDataList;
+
+    public:
+        MapDataRegistry() = default;
+
+    public:
+        // empty cache dir means dbPath + ".cache"
+        bool load(const char *, const char * = nullptr);
+
+    public:
+        // thread-safe, returns null if map ID is invalid
+        std::shared_ptr<const Mir2xMapData> retrieve(uint32_t, LoadStat * = nullptr);
+
+    public:
+        // resident set size in bytes, always returns 0 if not supported
+        static size_t processRSS();
+
+    private:
+        std::shared_ptr<const Mir2xMapData> loadMapData(uint32_t, LoadStat *);
+
+    private:
+        std::string cachePath(uint32_t) const;
+        bool cacheValid(const std::string &) const;
+        bool writeCache(const std::string &, const std::vector<uint8_t> &) const;
+
+    private:
+        static std::shared_ptr<const Mir2xMapData> mapCache(const std::string &);
+};
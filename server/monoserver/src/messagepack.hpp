@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <memory>
 #include <cstring>
 #include <cstdint>
 #include <utility>
@@ -43,8 +44,10 @@ template<size_t StaticBufferLength = 64> class InnMessagePack final
         size_t   m_SBufLen;
 
     private:
-        uint8_t *m_DBuf;
-        size_t   m_DBufLen;
+        // dynamic buffer is never changed after construction
+        // copies share it, then multicast won't duplicate large payload for every receiver
+        std::shared_ptr<uint8_t[]> m_DBuf;
+        size_t m_DBufLen;
 
     public:
         InnMessagePack(int nType = MPK_NONE, const uint8_t *pData = nullptr, size_t nDataLen = 0, uint64_t nFrom = 0, uint32_t nID = 0, uint32_t nRespond = 0)
@@ -61,9 +64,9 @@ template<size_t StaticBufferLength = 64> class InnMessagePack final
                     m_DBuf = nullptr;
                     m_DBufLen = 0;
                 }else{
-                    m_DBuf = new uint8_t[nDataLen];
+                    m_DBuf.reset(new uint8_t[nDataLen]);
                     m_DBufLen = nDataLen;
-                    std::memcpy(m_DBuf, pData, nDataLen);
+                    std::memcpy(m_DBuf.get(), pData, nDataLen);
 
                     m_SBufLen = 0;
                 }
@@ -80,8 +83,20 @@ template<size_t StaticBufferLength = 64> class InnMessagePack final
         {}
 
         InnMessagePack(const InnMessagePack &rstMPK)
-            : InnMessagePack(rstMPK.Type(), rstMPK.Data(), rstMPK.DataLen(), rstMPK.from(), rstMPK.ID(), rstMPK.Respond())
-        {}
+            : m_type(rstMPK.Type())
+            , m_from(rstMPK.from())
+            , m_ID(rstMPK.ID())
+            , m_respond(rstMPK.Respond())
+            , m_SBufLen(rstMPK.m_SBufLen)
+            , m_DBuf(rstMPK.m_DBuf)
+            , m_DBufLen(rstMPK.m_DBufLen)
+        {
+            // static buffer is copied
+            // dynamic buffer is shared with rstMPK
+            if(m_SBufLen){
+                std::memcpy(m_SBuf, rstMPK.m_SBuf, m_SBufLen);
+            }
+        }
 
         InnMessagePack(InnMessagePack &&rstMPK)
             : m_type(rstMPK.Type())
@@ -101,7 +116,7 @@ template<size_t StaticBufferLength = 64> class InnMessagePack final
             // case-1: use dynamic buffer, steal the buffer
             //         after this call rstMPK should be destructed immediately
             if(rstMPK.m_DBuf && rstMPK.m_DBufLen){
-                m_DBuf = rstMPK.m_DBuf;
+                m_DBuf = std::move(rstMPK.m_DBuf);
                 m_DBufLen = rstMPK.m_DBufLen;
 
                 m_SBufLen = 0;
@@ -135,12 +150,6 @@ template<size_t StaticBufferLength = 64> class InnMessagePack final
             }
         }
 
-    public:
-        ~InnMessagePack()
-        {
-            delete [] m_DBuf;
-        }
-
     public:
        InnMessagePack & operator = (InnMessagePack stMPK)
        {
@@ -190,7 +199,7 @@ template<size_t StaticBufferLength = 64> class InnMessagePack final
 
         const uint8_t *Data() const
         {
-            return m_SBufLen ? m_SBuf : m_DBuf;
+            return m_SBufLen ? m_SBuf : m_DBuf.get();
         }
 
         size_t DataLen() const
@@ -233,6 +242,9 @@ inline const char *mpkName(int type)
         _add_mpk_type_case(MPK_PING            )
         _add_mpk_type_case(MPK_LOGIN           )
         _add_mpk_type_case(MPK_METRONOME       )
+        _add_mpk_type_case(MPK_WAKEUP          )
+        _add_mpk_type_case(MPK_HIBERNATE       )
+        _add_mpk_type_case(MPK_AWAKE           )
         _add_mpk_type_case(MPK_TRYMOVE         )
         _add_mpk_type_case(MPK_TRYSPACEMOVE    )
         _add_mpk_type_case(MPK_MOVEOK          )
@@ -285,6 +297,10 @@ inline const char *mpkName(int type)
         _add_mpk_type_case(MPK_MASTERKILL      )
         _add_mpk_type_case(MPK_NPCEVENT        )
         _add_mpk_type_case(MPK_NPCERROR        )
+        _add_mpk_type_case(MPK_DBSAVEPLAYER    )
+        _add_mpk_type_case(MPK_DBQUERYLOGIN    )
+        _add_mpk_type_case(MPK_DBLOADPLAYER    )
+        _add_mpk_type_case(MPK_DBPLAYERDATA    )
         default: return "MPK_UNKNOWN";
     }
 #undef _add_mpk_type_case
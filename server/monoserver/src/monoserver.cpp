@@ -27,11 +27,12 @@
 
 #include "log.hpp"
 #include "dbpod.hpp"
+#include "dbservice.hpp"
 #include "totype.hpp"
 #include "taskhub.hpp"
 #include "message.hpp"
 #include "monster.hpp"
-#include "mapbindb.hpp"
+#include "mapdataregistry.hpp"
 #include "fflerror.hpp"
 #include "actorpool.hpp"
 #include "syncdriver.hpp"
@@ -44,7 +45,8 @@
 
 extern Log *g_log;
 extern DBPod *g_dbPod;
-extern MapBinDB *g_mapBinDB;
+extern DBService *g_dbService;
+extern MapDataRegistry *g_mapDataRegistry;
 extern ActorPool *g_actorPool;
 extern NetDriver *g_netDriver;
 extern MonoServer *g_monoServer;
@@ -208,13 +210,18 @@ void MonoServer::CreateDBConnection()
     if(!g_dbPod->createQuery("select name from sqlite_master where type=\'table\'").executeStep()){
         CreateDefaultDatabase();
     }
+
+    // launch after tables created
+    // DBService opens its own connection to the same database file
+    g_dbService->launch(dbName);
+    addLog(LOGTYPE_INFO, "DBService launched");
 }
 
 void MonoServer::LoadMapBinDB()
 {
     std::string szMapPath = g_serverConfigureWindow->GetMapPath();
 
-    if(!g_mapBinDB->Load(szMapPath.c_str())){
+    if(!g_mapDataRegistry->load(szMapPath.c_str())){
         throw fflerror("Failed to load mapbindb");
     }
 }
@@ -498,9 +498,21 @@ bool Monster::update()
         return goDie();
     }
 
+    if(m_updateCoroWaitWakeup){
+        m_actorPod->countResumeAvoided();
+        return true;
+    }
+
     if(!m_updateCoro.valid() || m_updateCoro.poll_one()){
         m_updateCoro = updateCoroFunc();
     }
+
+    // coroutine is sleeping by timer
+    // resume it before timeout only suspends it again
+    if(const auto waitMsec = m_updateCoro.wait_msec(); waitMsec > 0){
+        m_updateCoroWaitWakeup = true;
+        m_actorPod->addWakeup(waitMsec);
+    }
     return true;
 }
 
@@ -512,6 +524,21 @@ void Monster::operateAM(const MessagePack &rstMPK)
                 on_MPK_METRONOME(rstMPK);
                 break;
             }
+        case MPK_WAKEUP:
+            {
+                on_MPK_WAKEUP(rstMPK);
+                break;
+            }
+        case MPK_HIBERNATE:
+            {
+                on_MPK_HIBERNATE(rstMPK);
+                break;
+            }
+        case MPK_AWAKE:
+            {
+                on_MPK_AWAKE(rstMPK);
+                break;
+            }
         case MPK_CHECKMASTER:
             {
                 on_MPK_CHECKMASTER(rstMPK);
@@ -79,6 +79,16 @@ class Monster: public CharObject
     protected:
         corof::long_jmper m_updateCoro;
 
+    protected:
+        // m_updateCoro is sleeping in corof::async_wait()
+        // don't resume it by METRONOME, wait for MPK_WAKEUP
+        bool m_updateCoroWaitWakeup = false;
+
+    protected:
+        // no player nearby, map parks this monster
+        // it gets no METRONOME and doesn't run m_updateCoro
+        bool m_hibernated = false;
+
     public:
         Monster(uint32_t,               // monster id
                 ServiceCore *,          // service core
@@ -91,6 +101,14 @@ class Monster: public CharObject
     public:
         ~Monster() = default;
 
+    public:
+        // map calls it before activate() if the spawn region is hibernated
+        // then the monster gets parked in its attach trigger and never runs unparked
+        void setSpawnHibernated(bool hibernated)
+        {
+            m_hibernated = hibernated && !masterUID();
+        }
+
     public:
        uint32_t monsterID() const
        {
@@ -148,6 +166,9 @@ class Monster: public CharObject
         void on_MPK_OFFLINE         (const MessagePack &);
         void on_MPK_UPDATEHP        (const MessagePack &);
         void on_MPK_METRONOME       (const MessagePack &);
+        void on_MPK_WAKEUP          (const MessagePack &);
+        void on_MPK_HIBERNATE       (const MessagePack &);
+        void on_MPK_AWAKE           (const MessagePack &);
         void on_MPK_MAPSWITCH       (const MessagePack &);
         void on_MPK_MASTERKILL      (const MessagePack &);
         void on_MPK_MASTERHITTED    (const MessagePack &);
@@ -205,6 +226,9 @@ class Monster: public CharObject
         {
             CharObject::onActivate();
             if(!masterUID()){
+                if(m_hibernated){
+                    m_actorPod->setParked(true);
+                }
                 return;
             }
 
@@ -30,6 +30,43 @@ extern MonoServer *g_monoServer;
 void Monster::on_MPK_METRONOME(const MessagePack &)
 {
     update();
+
+    // pet without target only follows its master
+    // other monsters always run at full rate, or get parked by hibernation
+    if(masterUID()){
+        setUpdateInterval(m_target.UID ? 0 : 1000);
+    }
+}
+
+void Monster::on_MPK_WAKEUP(const MessagePack &)
+{
+    // timer can expire during hibernation
+    // then m_updateCoro gets polled by METRONOME after awake
+    m_updateCoroWaitWakeup = false;
+    if(!m_hibernated){
+        update();
+    }
+}
+
+void Monster::on_MPK_HIBERNATE(const MessagePack &)
+{
+    // pet follows its master, never hibernate
+    if(masterUID()){
+        return;
+    }
+
+    m_hibernated = true;
+    m_actorPod->setParked(true);
+}
+
+void Monster::on_MPK_AWAKE(const MessagePack &)
+{
+    if(!m_hibernated){
+        return;
+    }
+
+    m_hibernated = false;
+    m_actorPod->setParked(false);
 }
 
 void Monster::on_MPK_MISS(const MessagePack &rstMPK)
@@ -175,6 +212,7 @@ void Monster::on_MPK_ATTACK(const MessagePack &rstMPK)
         }
 
         addOffenderDamage(amAK.UID, amAK.Damage);
+        setUpdateInterval(0);
         dispatchAction(ActionHitted
         {
             .x = X(),
@@ -301,6 +339,7 @@ void Monster::on_MPK_MASTERKILL(const MessagePack &rstMPK)
 void Monster::on_MPK_MASTERHITTED(const MessagePack &rstMPK)
 {
     if(masterUID() && (rstMPK.from() == masterUID())){
+        setUpdateInterval(0);
         if(monsterName() == u8"神兽"){
             dynamic_cast<TaoDog *>(this)->setStandMode(true);
         }
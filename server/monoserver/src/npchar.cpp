@@ -527,8 +527,14 @@ void NPChar::operateAM(const MessagePack &mpk)
 {
     switch(mpk.Type()){
         case MPK_OFFLINE:
+            {
+                break;
+            }
         case MPK_METRONOME:
             {
+                // NPC does nothing by METRONOME
+                // keep 1Hz to poll delayed commands and state triggers
+                setUpdateInterval(1000);
                 break;
             }
         case MPK_ACTION:
@@ -16,7 +16,7 @@
  * =====================================================================================
  */
 #include <cinttypes>
-#include "dbpod.hpp"
+#include "dbservice.hpp"
 #include "player.hpp"
 #include "uidf.hpp"
 #include "mathf.hpp"
@@ -28,7 +28,7 @@
 #include "protocoldef.hpp"
 #include "dbcomrecord.hpp"
 
-extern DBPod *g_dbPod;
+extern DBService *g_dbService;
 extern NetDriver *g_netDriver;
 extern MonoServer *g_monoServer;
 
@@ -46,16 +46,7 @@ Player::Player(uint32_t nDBID,
     , m_level(0)        // after bind
     , m_gold(0)
     , m_inventory()
-    , m_name([this]() -> std::string
-      {
-          std::string result;
-          dbAccess("tbl_dbid", "fld_name", [&result](std::string name) -> std::string
-          {
-              result = std::move(name);
-              return {};
-          });
-          return result;
-      }())
+    , m_name()          // loaded by DBLoadPlayer() after activation
 {
     m_HP    = 10;
     m_HPMax = 10;
@@ -73,9 +64,7 @@ Player::Player(uint32_t nDBID,
 }
 
 Player::~Player()
-{
-    DBSavePlayer();
-}
+{}
 
 void Player::operateAM(const MessagePack &rstMPK)
 {
@@ -549,6 +538,7 @@ void Player::onCMActionMove(CMAction stCMA)
 
 void Player::onCMActionAttack(CMAction stCMA)
 {
+    markCombat();
     retrieveLocation(stCMA.action.aimUID, [this, stCMA](const COLocation &rstLocation)
     {
         int nX0 = stCMA.action.x;
@@ -615,6 +605,7 @@ void Player::onCMActionSpell(CMAction cmA)
         throw fflerror("invalid action type: %s", actionName(cmA.action));
     }
 
+    markCombat();
     int nX = cmA.action.x;
     int nY = cmA.action.y;
     int nMagicID = cmA.action.extParam.spell.magicID;
@@ -853,51 +844,51 @@ bool Player::CanPickUp(uint32_t, uint32_t)
     return true;
 }
 
-size_t Player::dbUpdate(const char *tableName, const char *fieldList, ...)
+bool Player::DBLoadPlayer()
 {
-    if(true
-            && (tableName && tableName[0] != '\0')
-            && (fieldList && fieldList[0] != '\0')){
+    // query runs in DBService thread
+    // actor thread never blocks on SQLite
 
-        std::string sqlCmd;
-        str_format(fieldList, sqlCmd);
-        return g_dbPod->exec("update %s set %s where fld_dbid = %llu", tableName, sqlCmd.c_str(), to_llu(DBID()));
-    }
-    throw fflerror("invalid arguments: tableName = %s, fieldList = %s", to_cstr(tableName), to_cstr(fieldList));
-}
-
-size_t Player::dbAccess(const char *tableName, const char *fieldName, std::function<std::string(std::string)> op)
-{
-    if(true
-            && op
-            && (tableName && tableName[0] != '\0')
-            && (fieldName && fieldName[0] != '\0')){
+    AMDBLoadPlayer amDBLP;
+    std::memset(&amDBLP, 0, sizeof(amDBLP));
 
-        // if need to return a string we should do:
-        //     return "\"xxxx\"";
-        // then empty string should be "\"\"", not result.empty()
+    amDBLP.DBID = DBID();
+    return m_actorPod->forward(g_dbService->UID(), {MPK_DBLOADPLAYER, amDBLP}, [this](const MessagePack &rstRMPK)
+    {
+        switch(rstRMPK.Type()){
+            case MPK_DBPLAYERDATA:
+                {
+                    const auto amDBPD = rstRMPK.conv<AMDBPlayerData>();
+                    if(amDBPD.DBID != DBID()){
+                        throw fflerror("load player %llu gets data of player %llu", to_llu(DBID()), to_llu(amDBPD.DBID));
+                    }
 
-        size_t execCount = 0;
-        auto query = g_dbPod->createQuery("select %s from %s where fld_dbid = %llu", fieldName, tableName, to_llu(DBID()));
-        while(query.executeStep()){
-            if(const auto result = op((std::string)(query.getColumn(0))); !result.empty()){
-                g_dbPod->exec("update %s set %s = %s where fld_dbid = %llu", tableName, fieldName, result.c_str(), to_llu(DBID()));
-            }
-            execCount++;
+                    m_name.assign(amDBPD.name, strnlen(amDBPD.name, sizeof(amDBPD.name)));
+                    return;
+                }
+            default:
+                {
+                    g_monoServer->addLog(LOGTYPE_WARNING, "Failed to load player: DBID = %llu", to_llu(DBID()));
+                    return;
+                }
         }
-        return execCount;
-    }
-    throw fflerror("invalid arguments: tableName = %s, fieldName = %s, op = %s", to_cstr(tableName), to_cstr(fieldName), op ? "invocable" : "null");
-}
-
-bool Player::DBLoadPlayer()
-{
-    return true;
+    });
 }
 
 bool Player::DBSavePlayer()
 {
-    return dbUpdate("tbl_dbid", "fld_gold = %d, fld_level = %d", Gold(), Level());
+    // write-behind by DBService
+    // multiple saves of same player in one flush window get coalesced
+
+    AMDBSavePlayer amDBSP;
+    std::memset(&amDBSP, 0, sizeof(amDBSP));
+
+    amDBSP.DBID  = DBID();
+    amDBSP.dirty = DBSPF_GOLD | DBSPF_LEVEL;
+    amDBSP.gold  = Gold();
+    amDBSP.level = Level();
+
+    return m_actorPod->forward(g_dbService->UID(), {MPK_DBSAVEPLAYER, amDBSP});
 }
 
 void Player::reportGold()
@@ -969,6 +960,12 @@ void Player::RequestKillPets()
     m_slaveList.clear();
 }
 
+void Player::markCombat()
+{
+    m_combatTimer.reset();
+    setUpdateInterval(0);
+}
+
 bool Player::sendNetBuf(uint8_t hc, const uint8_t *buf, size_t bufLen)
 {
     return g_netDriver->Post(ChannID(), hc, buf, bufLen);
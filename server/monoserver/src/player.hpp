@@ -45,11 +45,16 @@ class Player final: public CharObject
         std::vector<CommonItem> m_inventory;
 
     protected:
-        const std::string m_name;
+        std::string m_name;
 
     protected:
         std::set<uint64_t> m_slaveList;
 
+    protected:
+        // last time attacking or being attacked
+        // player out of combat gets METRONOME at low rate
+        hres_timer m_combatTimer;
+
     public:
         Player(uint32_t,                // DBID
                 ServiceCore *,          //
@@ -61,6 +66,20 @@ class Player final: public CharObject
     public:
         ~Player();
 
+    public:
+        void onActivate() override
+        {
+            CharObject::onActivate();
+            DBLoadPlayer();
+        }
+
+    protected:
+        void onDeactivate() override
+        {
+            DBSavePlayer();
+            CharObject::onDeactivate();
+        }
+
     protected:
         uint32_t Exp() const
         {
@@ -173,6 +192,9 @@ class Player final: public CharObject
     protected:
         void RequestKillPets();
 
+    protected:
+        void markCombat();
+
     protected:
         DamageNode GetAttackDamage(int);
 
@@ -217,10 +239,6 @@ class Player final: public CharObject
     protected:
         uint32_t GetLevelExp();
 
-    protected:
-        size_t dbUpdate(const char *, const char *, ...);
-        size_t dbAccess(const char *, const char *, std::function<std::string(std::string)>);
-
     protected:
         void GainExp(int);
 
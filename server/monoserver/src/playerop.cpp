@@ -34,6 +34,10 @@ extern MonoServer *g_monoServer;
 void Player::on_MPK_METRONOME(const MessagePack &)
 {
     update();
+
+    // health recovery is fine with 1Hz
+    // combat actions get handled by messages, not METRONOME
+    setUpdateInterval((m_combatTimer.diff_sec() < 10) ? 0 : 1000);
 }
 
 void Player::on_MPK_BADACTORPOD(const MessagePack &rstMPK)
@@ -235,6 +239,7 @@ void Player::on_MPK_ATTACK(const MessagePack &rstMPK)
         }
     }
 
+    markCombat();
     for(auto slaveUID: m_slaveList){
         m_actorPod->forward(slaveUID, MPK_MASTERHITTED);
     }
@@ -187,5 +187,7 @@ PodMonitorTable::PodMonitorDrawHelper PodMonitorTable::getPodMonitorDrawHelper(c
         }
         amType++;
     }
+
+    result.wakeupMonitor = podMonitor.wakeupMonitor;
     return result;
 }
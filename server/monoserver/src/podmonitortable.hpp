@@ -39,6 +39,7 @@ class PodMonitorTable: public Fl_TableImpl
                 AMProcMonitor procMonitor;
             };
             std::vector<PodMonitorHelper> amProcMonitorList;
+            WakeupMonitor wakeupMonitor;
         };
 
     private:
@@ -104,6 +105,12 @@ class PodMonitorTable: public Fl_TableImpl
     public:
         void setPodUID(uint64_t);
 
+    public:
+        const WakeupMonitor &getWakeupMonitor() const
+        {
+            return m_podDrawHelper.wakeupMonitor;
+        }
+
     public:
         int getRowCount() const override
         {
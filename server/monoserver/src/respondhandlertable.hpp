@@ -0,0 +1,387 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: respondhandlertable.hpp
+ *        Created: 10/17/2026 10:26:14
+ *    Description: pending response handlers of one actor pod
+ *
+ *                 handlers live in a slot array, message ID encodes slot index and a
+ *                 generation of the slot, then register and complete are O(1) and a late
+ *                 response to a reused slot is dropped by the generation check
+ *
+ *                 freed slots are reused in FIFO order and only when at least 16 are free,
+ *                 a slot ID comes back after 16 * 2^14 handlers registered by the actor, a
+ *                 late response can't match a new handler before that
+ *
+ *                 expiry uses a coarse hashed wheel, each wheel slot is a linked list of
+ *                 handler slots, completed handler is unlinked immediately, expired ones
+ *                 get found by visiting only wheel slots passed since last check
+ *
+ *                 handler is a move-only callable with inline buffer, most lambdas of
+ *                 ActorPod::forward() fit it and don't allocate
+ *
+ *                 only accessed by the thread running the actor, no lock
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#pragma once
+#include <array>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <concepts>
+#include <type_traits>
+#include "fflerror.hpp"
+#include "messagepack.hpp"
+
+class RespondHandler final
+{
+    private:
+        constexpr static size_t m_bufSize = 56;
+
+    private:
+        struct HandlerOps
+        {
+            void (*invoke )(void *, const MessagePack &);
+            void (*move   )(void *, void *);
+            void (*destroy)(void *);
+        };
+
+        template<typename F> struct InlineOps
+        {
+            constexpr static HandlerOps ops
+            {
+                [](void *p, const MessagePack &mpk){ (*static_cast<F *>(p))(mpk); },
+                [](void *dst, void *src)
+                {
+                    ::new (dst) F(std::move(*static_cast<F *>(src)));
+                    static_cast<F *>(src)->~F();
+                },
+                [](void *p){ static_cast<F *>(p)->~F(); },
+            };
+        };
+
+        template<typename F> struct HeapOps
+        {
+            constexpr static HandlerOps ops
+            {
+                [](void *p, const MessagePack &mpk){ (**static_cast<F **>(p))(mpk); },
+                [](void *dst, void *src){ *static_cast<F **>(dst) = *static_cast<F **>(src); },
+                [](void *p){ delete *static_cast<F **>(p); },
+            };
+        };
+
+    private:
+        alignas(std::max_align_t) std::byte m_buf[m_bufSize];
+        const HandlerOps *m_ops = nullptr;
+
+    public:
+        RespondHandler() = default;
+
+        template<typename F> requires (!std::is_same_v<std::decay_t<F>, RespondHandler> && std::is_invocable_v<std::decay_t<F> &, const MessagePack &>)
+        RespondHandler(F &&f)
+        {
+            using T = std::decay_t<F>;
+            if constexpr (std::is_constructible_v<bool, const T &>){
+                // empty std::function or null function pointer
+                if(!static_cast<bool>(f)){
+                    return;
+                }
+            }
+
+            if constexpr (sizeof(T) <= m_bufSize && alignof(T) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<T>){
+                ::new (m_buf) T(std::forward<F>(f));
+                m_ops = &InlineOps<T>::ops;
+            }
+            else{
+                ::new (m_buf) T *(new T(std::forward<F>(f)));
+                m_ops = &HeapOps<T>::ops;
+            }
+        }
+
+    public:
+        RespondHandler(RespondHandler &&other) noexcept
+        {
+            if(other.m_ops){
+                other.m_ops->move(m_buf, other.m_buf);
+                m_ops = std::exchange(other.m_ops, nullptr);
+            }
+        }
+
+        RespondHandler &operator = (RespondHandler &&other) noexcept
+        {
+            if(this != &other){
+                reset();
+                if(other.m_ops){
+                    other.m_ops->move(m_buf, other.m_buf);
+                    m_ops = std::exchange(other.m_ops, nullptr);
+                }
+            }
+            return *this;
+        }
+
+    public:
+        RespondHandler(const RespondHandler &) = delete;
+        RespondHandler &operator = (const RespondHandler &) = delete;
+
+    public:
+        ~RespondHandler()
+        {
+            reset();
+        }
+
+    public:
+        explicit operator bool () const
+        {
+            return m_ops != nullptr;
+        }
+
+        void operator () (const MessagePack &mpk)
+        {
+            if(!m_ops){
+                throw fflerror("invoke empty response handler");
+            }
+            m_ops->invoke(m_buf, mpk);
+        }
+
+    public:
+        void reset()
+        {
+            if(m_ops){
+                m_ops->destroy(m_buf);
+                m_ops = nullptr;
+            }
+        }
+};
+
+class RespondHandlerTable final
+{
+    private:
+        // ID = (generation << m_indexBits) | slot index
+        // generation never be zero, then ID is never zero
+        // 2^18 pending handlers per actor, 14-bit generation
+        constexpr static int      m_indexBits = 18;
+        constexpr static uint32_t m_indexMask = (1U << m_indexBits) - 1;
+        constexpr static uint32_t m_genMask   = (1U << (32 - m_indexBits)) - 1;
+
+    private:
+        // wheel slot covers 128 msec, 512 slots cover ~65 seconds per round
+        // handler expiring in later rounds stays in its wheel slot and gets skipped
+        constexpr static int      m_wheelTickBits = 7;
+        constexpr static uint32_t m_wheelSize     = 512;
+
+    private:
+        constexpr static uint32_t m_npos = UINT32_MAX;
+
+    private:
+        // table grows instead of reusing a slot if fewer slots are free
+        constexpr static size_t m_minFree = 16;
+
+    private:
+        struct HandlerSlot
+        {
+            uint32_t gen = 0;
+            bool     used = false;
+            bool     timed = false;
+
+            uint64_t expireTime = 0;
+
+            // links in wheel slot if used, or next in free list
+            uint32_t prev = m_npos;
+            uint32_t next = m_npos;
+
+            RespondHandler handler;
+        };
+
+    private:
+        size_t   m_size = 0;
+        size_t   m_freeCount = 0;
+        uint32_t m_freeHead = m_npos;
+        uint32_t m_freeTail = m_npos;
+        std::vector<HandlerSlot> m_slotList;
+
+    private:
+        uint64_t m_wheelTick = 0;
+        std::array<uint32_t, m_wheelSize> m_wheel;
+
+    public:
+        RespondHandlerTable()
+        {
+            m_wheel.fill(m_npos);
+        }
+
+    public:
+        size_t size() const
+        {
+            return m_size;
+        }
+
+        bool empty() const
+        {
+            return m_size == 0;
+        }
+
+    public:
+        // zero expire time means never expire
+        uint32_t add(uint64_t expireTime, RespondHandler handler)
+        {
+            if(!handler){
+                throw fflerror("register empty response handler");
+            }
+
+            uint32_t index = m_npos;
+            if(m_freeCount >= m_minFree || (m_freeCount > 0 && m_slotList.size() > m_indexMask)){
+                index = m_freeHead;
+                m_freeHead = m_slotList[index].next;
+                if(m_freeHead == m_npos){
+                    m_freeTail = m_npos;
+                }
+                m_freeCount--;
+            }
+            else{
+                if(m_slotList.size() > m_indexMask){
+                    throw fflerror("too many pending response handlers: %zu", m_slotList.size());
+                }
+
+                index = static_cast<uint32_t>(m_slotList.size());
+                m_slotList.emplace_back();
+            }
+
+            auto &slotRef = m_slotList[index];
+            slotRef.gen = ((slotRef.gen + 1) & m_genMask) ? ((slotRef.gen + 1) & m_genMask) : 1;
+            slotRef.used = true;
+            slotRef.timed = (expireTime != 0);
+            slotRef.expireTime = expireTime;
+            slotRef.prev = m_npos;
+            slotRef.next = m_npos;
+            slotRef.handler = std::move(handler);
+
+            if(slotRef.timed){
+                linkWheel(index);
+            }
+
+            m_size++;
+            return (slotRef.gen << m_indexBits) | index;
+        }
+
+    public:
+        // returns empty handler if ID is not pending, i.e. already expired or completed
+        RespondHandler take(uint32_t id)
+        {
+            const uint32_t index = id & m_indexMask;
+            if(index >= m_slotList.size()){
+                return {};
+            }
+
+            auto &slotRef = m_slotList[index];
+            if(!slotRef.used || slotRef.gen != (id >> m_indexBits)){
+                return {};
+            }
+            return release(index);
+        }
+
+    public:
+        // calls f(RespondHandler) for every handler expired by currTime
+        // f can register new handlers
+        template<std::invocable<RespondHandler> F> size_t expire(uint64_t currTime, F f)
+        {
+            const uint64_t currTick = currTime >> m_wheelTickBits;
+            if(m_size == 0 || currTick < m_wheelTick){
+                m_wheelTick = std::max<uint64_t>(m_wheelTick, currTick);
+                return 0;
+            }
+
+            // one round visits all wheel slots
+            if(currTick - m_wheelTick >= m_wheelSize){
+                m_wheelTick = currTick - m_wheelSize + 1;
+            }
+
+            size_t expired = 0;
+            while(true){
+                // current wheel slot is visited again next time
+                // its handlers can expire later in the same tick
+
+                for(uint32_t index = m_wheel[m_wheelTick % m_wheelSize]; index != m_npos;){
+                    const uint32_t next = m_slotList[index].next;
+                    if(m_slotList[index].expireTime <= currTime){
+                        expired++;
+                        f(release(index));
+                    }
+                    index = next;
+                }
+
+                if(m_wheelTick == currTick){
+                    break;
+                }
+                m_wheelTick++;
+            }
+            return expired;
+        }
+
+    private:
+        RespondHandler release(uint32_t index)
+        {
+            auto &slotRef = m_slotList[index];
+            if(slotRef.timed){
+                unlinkWheel(index);
+            }
+
+            auto handler = std::move(slotRef.handler);
+            slotRef.used = false;
+            slotRef.timed = false;
+            slotRef.prev = m_npos;
+            slotRef.next = m_npos;
+
+            if(m_freeTail != m_npos){
+                m_slotList[m_freeTail].next = index;
+            }
+            else{
+                m_freeHead = index;
+            }
+
+            m_freeTail = index;
+            m_freeCount++;
+            m_size--;
+            return handler;
+        }
+
+    private:
+        void linkWheel(uint32_t index)
+        {
+            auto &slotRef = m_slotList[index];
+            auto &headRef = m_wheel[(slotRef.expireTime >> m_wheelTickBits) % m_wheelSize];
+
+            slotRef.prev = m_npos;
+            slotRef.next = headRef;
+
+            if(headRef != m_npos){
+                m_slotList[headRef].prev = index;
+            }
+            headRef = index;
+        }
+
+        void unlinkWheel(uint32_t index)
+        {
+            auto &slotRef = m_slotList[index];
+            if(slotRef.prev != m_npos){
+                m_slotList[slotRef.prev].next = slotRef.next;
+            }
+            else{
+                m_wheel[(slotRef.expireTime >> m_wheelTickBits) % m_wheelSize] = slotRef.next;
+            }
+
+            if(slotRef.next != m_npos){
+                m_slotList[slotRef.next].prev = slotRef.prev;
+            }
+        }
+};
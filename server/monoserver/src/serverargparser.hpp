@@ -18,6 +18,7 @@
 
 #pragma once
 #include <thread>
+#include <algorithm>
 #include <cstdint>
 #include "totype.hpp"
 #include "fflerror.hpp"
@@ -31,8 +32,13 @@ struct ServerArgParser
     const bool traceActorMessageCount;  // "--trace-actor-message-count"
     const bool disablePetSpawn;         // "--disable-pet-spawn"
     const bool disableMonsterSpawn;     // "--disable-monster-spawn"
+    const bool disableMonsterHibernate; // "--disable-monster-hibernate"
     const bool preloadMap;              // "--preload-map"
+    const bool disableNetCodec;         // "--disable-net-codec"
+    const bool disableActorAffinity;    // "--disable-actor-affinity"
     const int  actorPoolThread;         // "--actor-pool-thread"
+    const int  channelGatherSize;       // "--channel-gather-size"
+    const int  channelSendHWM;          // "--channel-send-hwm"
 
     ServerArgParser(const argh::parser &cmdParser)
         : disableProfiler(cmdParser["disable-profiler"])
@@ -41,7 +47,10 @@ struct ServerArgParser
         , traceActorMessageCount(cmdParser["trace-actor-message-count"])
         , disablePetSpawn(cmdParser["disable-pet-spawn"])
         , disableMonsterSpawn(cmdParser["disable-monster-spawn"])
+        , disableMonsterHibernate(cmdParser["disable-monster-hibernate"])
         , preloadMap(cmdParser["preload-map"])
+        , disableNetCodec(cmdParser["disable-net-codec"])
+        , disableActorAffinity(cmdParser["disable-actor-affinity"])
         , actorPoolThread([&cmdParser]() -> int
           {
               if(const auto numStr = cmdParser("actor-pool-thread").str(); !numStr.empty()){
@@ -59,5 +68,33 @@ struct ServerArgParser
                   return 4;
               }
           }())
+        , channelGatherSize([&cmdParser]() -> int
+          {
+              // max bytes coalesced into one async_write in Channel::DoSendPack()
+              // 0 disables gather mode and sends one pack per write
+              if(const auto numStr = cmdParser("channel-gather-size").str(); !numStr.empty()){
+                  try{
+                      return std::max<int>(0, std::stoi(numStr));
+                  }
+                  catch(...){
+                      return 64 * 1024;
+                  }
+              }
+              return 64 * 1024;
+          }())
+        , channelSendHWM([&cmdParser]() -> int
+          {
+              // max bytes queued but not sent in one channel
+              // channel gets disconnected when client can't drain it, 0 means no limit
+              if(const auto numStr = cmdParser("channel-send-hwm").str(); !numStr.empty()){
+                  try{
+                      return std::max<int>(0, std::stoi(numStr));
+                  }
+                  catch(...){
+                      return 4 * 1024 * 1024;
+                  }
+              }
+              return 4 * 1024 * 1024;
+          }())
     {}
 };
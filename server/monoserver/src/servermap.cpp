@@ -31,7 +31,7 @@
 #include "mathf.hpp"
 #include "sysconst.hpp"
 #include "fflerror.hpp"
-#include "mapbindb.hpp"
+#include "mapdataregistry.hpp"
 #include "condcheck.hpp"
 #include "servermap.hpp"
 #include "charobject.hpp"
@@ -41,7 +41,7 @@
 #include "serverargparser.hpp"
 #include "serverconfigurewindow.hpp"
 
-extern MapBinDB *g_mapBinDB;
+extern MapDataRegistry *g_mapDataRegistry;
 extern MonoServer *g_monoServer;
 extern ServerArgParser *g_serverArgParser;
 extern ServerConfigureWindow *g_serverConfigureWindow;
@@ -150,6 +150,50 @@ ServerMap::ServerMapLuaModule::ServerMapLuaModule(ServerMap *mapPtr)
         return -1;
     });
 
+    getLuaState().set_function("getRectMonsterCount", [mapPtr](int x, int y, int w, int h, sol::variadic_args args) -> int
+    {
+        // getRectMonsterCount(x, y, w, h)
+        // getRectMonsterCount(x, y, w, h, monID or monName)
+
+        const std::vector<sol::object> argList(args.begin(), args.end());
+        switch(argList.size()){
+            case 0:
+                {
+                    return mapPtr->GetMonsterCount(0, x, y, w, h);
+                }
+            case 1:
+                {
+                    if(argList[0].is<int>()){
+                        if(const int monID = argList[0].as<int>(); monID >= 0){
+                            return mapPtr->GetMonsterCount(monID, x, y, w, h);
+                        }
+                    }
+
+                    else if(argList[0].is<std::string>()){
+                        if(const int monID = DBCOM_MONSTERID(to_u8cstr(argList[0].as<std::string>().c_str())); monID >= 0){
+                            return mapPtr->GetMonsterCount(monID, x, y, w, h);
+                        }
+                    }
+                    break;
+                }
+            default:
+                {
+                    break;
+                }
+        }
+        return -1;
+    });
+
+    getLuaState().set_function("getMonsterCensus", [mapPtr](sol::this_state thisLua)
+    {
+        // monster name -> count of all monster types alive on the map
+        std::unordered_map<std::string, int> census;
+        for(const auto &[monID, count]: mapPtr->m_monsterCountList){
+            census[std::string(to_cstr(DBCOM_MONSTERRECORD(monID).name))] = count;
+        }
+        return sol::make_object(sol::state_view(thisLua), census);
+    });
+
     getLuaState().set_function("addMonster", [mapPtr](sol::object monInfo, sol::variadic_args args) -> bool
     {
         const uint32_t monID = [&monInfo]() -> uint32_t
@@ -349,31 +393,39 @@ ServerMap::ServerPathFinder::ServerPathFinder(const ServerMap *pMap, int nMaxSte
 ServerMap::ServerMap(ServiceCore *pServiceCore, uint32_t nMapID)
     : ServerObject(uidf::buildMapUID(nMapID))
     , m_ID(nMapID)
-    , m_mir2xMapData(*([nMapID]() -> Mir2xMapData *
+    , m_mir2xMapDataPtr([nMapID]()
       {
-          // server is multi-thread
-          // but creating server map is always in service core
-
-          if(auto pMir2xMapData = g_mapBinDB->Retrieve(nMapID)){
-              return pMir2xMapData;
-          }
-
           // when constructing a servermap
           // servicecore should test if current nMapID valid
+          if(auto mapDataPtr = g_mapDataRegistry->retrieve(nMapID)){
+              return mapDataPtr;
+          }
           throw fflerror("load map failed: ID = %d, Name = %s", nMapID, to_cstr(DBCOM_MAPRECORD(nMapID).name));
-      }()))
+      }())
+    , m_mir2xMapData(*m_mir2xMapDataPtr)
     , m_serviceCore(pServiceCore)
 {
     if(!m_mir2xMapData.Valid()){
         throw fflerror("load map failed: ID = %d, Name = %s", nMapID, to_cstr(DBCOM_MAPRECORD(nMapID).name));
     }
 
-    m_cellVec2D.resize(W());
-    m_cellVec2D.shrink_to_fit();
+    m_cellFlagList.resize(W() * H(), 0);
+    for(int nY = 0; nY < H(); ++nY){
+        for(int nX = 0; nX < W(); ++nX){
+            if(m_mir2xMapData.Cell(nX, nY).CanThrough()){
+                m_cellFlagList[nX + nY * W()] |= CELL_CANTHROUGH;
+            }
+        }
+    }
 
-    for(auto &rstStateLine: m_cellVec2D){
-        rstStateLine.resize(H());
-        rstStateLine.shrink_to_fit();
+    m_aoiRegionW = (W() + m_aoiRegionSize - 1) / m_aoiRegionSize;
+    m_aoiRegionH = (H() + m_aoiRegionSize - 1) / m_aoiRegionSize;
+    m_aoiRegionList.resize(m_aoiRegionW * m_aoiRegionH);
+
+    // no player when map gets loaded
+    // monsters spawned in regions get hibernated when added to grid
+    for(auto &region: m_aoiRegionList){
+        region.hibernated = !g_serverArgParser->disableMonsterHibernate;
     }
 
     for(const auto &entry: DBCOM_MAPRECORD(nMapID).linkArray){
@@ -382,11 +434,20 @@ ServerMap::ServerMap(ServiceCore *pServiceCore, uint32_t nMapID)
                 && entry.h > 0
                 && ValidC(entry.x, entry.y)){
 
+            const auto switchMapID = DBCOM_MAPID(entry.endName);
+            if(!switchMapID){
+                continue;
+            }
+
             for(int nW = 0; nW < entry.w; ++nW){
                 for(int nH = 0; nH < entry.h; ++nH){
-                    getCell(entry.x + nW, entry.y + nH).mapID   = DBCOM_MAPID(entry.endName);
-                    getCell(entry.x + nW, entry.y + nH).switchX = entry.endX;
-                    getCell(entry.x + nW, entry.y + nH).switchY = entry.endY;
+                    m_cellSwitchList[cellIndex(entry.x + nW, entry.y + nH)] = CellSwitch
+                    {
+                        .mapID = switchMapID,
+                        .x     = entry.endX,
+                        .y     = entry.endY,
+                    };
+                    setCellFlag(entry.x + nW, entry.y + nH, CELL_HASSWITCH, true);
                 }
             }
         }else{
@@ -488,31 +549,28 @@ void ServerMap::operateAM(const MessagePack &rstMPK)
 
 bool ServerMap::groundValid(int nX, int nY) const
 {
-    return true
-        && m_mir2xMapData.Valid()
-        && m_mir2xMapData.ValidC(nX, nY)
-        && m_mir2xMapData.Cell(nX, nY).CanThrough();
+    return ValidC(nX, nY) && (m_cellFlagList[nX + nY * W()] & CELL_CANTHROUGH);
 }
 
 bool ServerMap::canMove(bool bCheckCO, bool bCheckLock, int nX, int nY) const
 {
-    if(groundValid(nX, nY)){
-        if(bCheckCO){
-            for(auto nUID: getUIDList(nX, nY)){
-                if(auto nType = uidf::getUIDType(nUID); nType == UID_PLY || nType == UID_MON){
-                    return false;
-                }
-            }
-        }
+    if(!ValidC(nX, nY)){
+        return false;
+    }
 
-        if(bCheckLock){
-            if(getCell(nX, nY).Locked){
-                return false;
-            }
-        }
-        return true;
+    const auto flag = m_cellFlagList[nX + nY * W()];
+    if(!(flag & CELL_CANTHROUGH)){
+        return false;
     }
-    return false;
+
+    if(bCheckCO && (flag & CELL_HASCO)){
+        return false;
+    }
+
+    if(bCheckLock && (flag & CELL_LOCKED)){
+        return false;
+    }
+    return true;
 }
 
 double ServerMap::OneStepCost(int nCheckCO, int nCheckLock, int nX0, int nY0, int nX1, int nY1) const
@@ -639,6 +697,17 @@ double ServerMap::OneStepCost(int nCheckCO, int nCheckLock, int nX0, int nY0, in
     return 1.00 + nMaxIndex * 0.10 + fExtraPen;
 }
 
+PathFind::HPAGraph &ServerMap::getHPAGraph()
+{
+    if(!m_hpaGraph){
+        m_hpaGraph = std::make_unique<PathFind::HPAGraph>(W(), H(), [this](int nX, int nY) -> bool
+        {
+            return groundValid(nX, nY);
+        });
+    }
+    return *m_hpaGraph;
+}
+
 std::tuple<bool, int, int> ServerMap::GetValidGrid(bool bCheckCO, bool bCheckLock, int nCheckCount) const
 {
     for(int nIndex = 0; (nCheckCount <= 0) || (nIndex < nCheckCount); ++nIndex){
@@ -683,7 +752,42 @@ void ServerMap::addGridUID(uint64_t uid, int nX, int nY, bool bForce)
 
     if(bForce || groundValid(nX, nY)){
         if(!hasGridUID(uid, nX, nY)){
-            getUIDList(nX, nY).push_back(uid);
+            m_cellUIDList[cellIndex(nX, nY)].push_back(uid);
+            setCellFlag(nX, nY, CELL_HASUID, true);
+
+            if(const auto uidType = uidf::getUIDType(uid); uidType == UID_PLY || uidType == UID_MON){
+                setCellFlag(nX, nY, CELL_HASCO, true);
+            }
+
+            getAOIRegion(nX, nY).entryList.push_back(AOIEntry
+            {
+                .uid = uid,
+                .x   = nX,
+                .y   = nY,
+            });
+
+            switch(uidf::getUIDType(uid)){
+                case UID_PLY:
+                    {
+                        updateAOIPlayerCount(nX, nY, 1);
+                        break;
+                    }
+                case UID_MON:
+                    {
+                        // monster gets here by ACTION_SPAWN or moving, its pod is attached in both cases
+                        // spawned monster already took region state at activation, this only catches the region
+                        // flipping to hibernated while ACTION_SPAWN was in flight, see on_MPK_ACTION() for the other way
+                        if(getAOIRegion(nX, nY).hibernated){
+                            m_actorPod->forward(uid, {MPK_HIBERNATE});
+                        }
+                        break;
+                    }
+                default:
+                    {
+                        break;
+                    }
+            }
+            updateCensus(uid, nX, nY, 1);
         }
     }
 }
@@ -704,7 +808,12 @@ void ServerMap::removeGridUID(uint64_t uid, int nX, int nY)
         throw fflerror("invalid location: (%d, %d)", nX, nY);
     }
 
-    auto &uidList = getUIDList(nX, nY);
+    auto uidListIter = m_cellUIDList.find(cellIndex(nX, nY));
+    if(uidListIter == m_cellUIDList.end()){
+        return;
+    }
+
+    auto &uidList = uidListIter->second;
     auto p = std::find(uidList.begin(), uidList.end(), uid);
 
     if(p == uidList.end()){
@@ -714,8 +823,129 @@ void ServerMap::removeGridUID(uint64_t uid, int nX, int nY)
     std::swap(uidList.back(), *p);
     uidList.pop_back();
 
-    if(uidList.size() * 2 < uidList.capacity()){
-        uidList.shrink_to_fit();
+    if(uidList.empty()){
+        m_cellUIDList.erase(uidListIter);
+        setCellFlag(nX, nY, CELL_HASUID, false);
+        setCellFlag(nX, nY, CELL_HASCO,  false);
+    }
+    else{
+        if(uidList.size() * 2 < uidList.capacity()){
+            uidList.shrink_to_fit();
+        }
+
+        setCellFlag(nX, nY, CELL_HASCO, std::any_of(uidList.begin(), uidList.end(), [](uint64_t uid)
+        {
+            const auto uidType = uidf::getUIDType(uid);
+            return uidType == UID_PLY || uidType == UID_MON;
+        }));
+    }
+
+    auto &entryList = getAOIRegion(nX, nY).entryList;
+    auto q = std::find_if(entryList.begin(), entryList.end(), [uid, nX, nY](const auto &entry)
+    {
+        return entry.uid == uid && entry.x == nX && entry.y == nY;
+    });
+
+    if(q == entryList.end()){
+        throw fflerror("AOI region missing UID: uid = %llu, x = %d, y = %d", to_llu(uid), nX, nY);
+    }
+
+    std::swap(entryList.back(), *q);
+    entryList.pop_back();
+
+    if(uidf::getUIDType(uid) == UID_PLY){
+        updateAOIPlayerCount(nX, nY, -1);
+    }
+    updateCensus(uid, nX, nY, -1);
+}
+
+void ServerMap::updateCensus(uint64_t uid, int nX, int nY, int diff)
+{
+    const auto uidType = uidf::getUIDType(uid);
+    if((m_uidTypeCount.at(uidType) += diff) < 0){
+        throw fflerror("negative UID count: type = %s", uidf::getUIDTypeString(uid));
+    }
+
+    if(uidType != UID_MON){
+        return;
+    }
+
+    const auto fnUpdate = [monID = uidf::getMonsterID(uid), diff](std::unordered_map<uint32_t, int> &countList)
+    {
+        auto p = countList.try_emplace(monID, 0).first;
+        if((p->second += diff) < 0){
+            throw fflerror("negative monster count: monsterID = %llu", to_llu(monID));
+        }
+
+        if(p->second == 0){
+            countList.erase(p);
+        }
+    };
+
+    auto &region = getAOIRegion(nX, nY);
+    region.monsterCount += diff;
+
+    fnUpdate(region.monsterCountList);
+    fnUpdate(m_monsterCountList);
+}
+
+void ServerMap::updateAOIPlayerCount(int nX, int nY, int diff)
+{
+    const int rx = nX / m_aoiRegionSize;
+    const int ry = nY / m_aoiRegionSize;
+
+    for(int nry = std::max<int>(ry - 1, 0); nry <= std::min<int>(ry + 1, m_aoiRegionH - 1); ++nry){
+        for(int nrx = std::max<int>(rx - 1, 0); nrx <= std::min<int>(rx + 1, m_aoiRegionW - 1); ++nrx){
+            const int regionIndex = nrx + nry * m_aoiRegionW;
+            auto &region = m_aoiRegionList[regionIndex];
+
+            region.nearbyPlayerCount += diff;
+            if(region.nearbyPlayerCount < 0){
+                throw fflerror("negative nearby player count: region = (%d, %d)", nrx, nry);
+            }
+
+            // awake monsters immediately when player comes
+            // but delay hibernation to next METRONOME
+            if(region.nearbyPlayerCount > 0){
+                if(region.hibernated){
+                    setAOIRegionHibernated(region, false);
+                }
+            }
+            else{
+                m_aoiHibernateCheckList.push_back(regionIndex);
+            }
+        }
+    }
+}
+
+void ServerMap::checkAOIHibernate()
+{
+    if(g_serverArgParser->disableMonsterHibernate){
+        m_aoiHibernateCheckList.clear();
+        return;
+    }
+
+    for(const auto regionIndex: m_aoiHibernateCheckList){
+        if(auto &region = m_aoiRegionList.at(regionIndex); !region.hibernated && region.nearbyPlayerCount == 0){
+            setAOIRegionHibernated(region, true);
+        }
+    }
+    m_aoiHibernateCheckList.clear();
+}
+
+void ServerMap::setAOIRegionHibernated(AOIRegion &region, bool hibernated)
+{
+    region.hibernated = hibernated;
+
+    std::vector<uint64_t> uidList;
+    for(const auto &entry: region.entryList){
+        if(uidf::getUIDType(entry.uid) == UID_MON){
+            uidList.push_back(entry.uid);
+        }
+    }
+
+    if(!uidList.empty()){
+        m_actorPod->forward(uidList, {hibernated ? MPK_HIBERNATE : MPK_AWAKE});
     }
 }
 
@@ -796,7 +1026,7 @@ bool ServerMap::DoCenterSquare(int nCX, int nCY, int nW, int nH, bool bPriority,
     return false;
 }
 
-int ServerMap::FindGroundItem(const CommonItem &rstCommonItem, int nX, int nY)
+int ServerMap::FindGroundItem(const CommonItem &rstCommonItem, int nX, int nY) const
 {
     if(ValidC(nX, nY)){
         auto &rstGroundItemList = GetGroundItemList(nX, nY);
@@ -809,7 +1039,7 @@ int ServerMap::FindGroundItem(const CommonItem &rstCommonItem, int nX, int nY)
     return -1;
 }
 
-int ServerMap::GroundItemCount(const CommonItem &rstCommonItem, int nX, int nY)
+int ServerMap::GroundItemCount(const CommonItem &rstCommonItem, int nX, int nY) const
 {
     if(ValidC(nX, nY)){
         auto &rstGroundItemList = GetGroundItemList(nX, nY);
@@ -828,11 +1058,12 @@ void ServerMap::RemoveGroundItem(const CommonItem &rstCommonItem, int nX, int nY
 {
     auto nFind = FindGroundItem(rstCommonItem, nX, nY);
     if(nFind >= 0){
-        auto &rstGroundItemList = GetGroundItemList(nX, nY);
+        auto &rstGroundItemList = groundItemListRef(nX, nY);
         for(int nIndex = nFind; nIndex < ((int)(rstGroundItemList.Length()) - 1); ++nIndex){
             rstGroundItemList[nIndex] = rstGroundItemList[nIndex + 1];
         }
         rstGroundItemList.PopBack();
+        shrinkGroundItemList(nX, nY);
     }
 }
 
@@ -845,63 +1076,135 @@ bool ServerMap::AddGroundItem(const CommonItem &rstCommonItem, int nX, int nY)
         // check if item is valid
         // then push back and report, would override if already full
 
-        auto &rstGroundItemList = GetGroundItemList(nX, nY);
+        auto &rstGroundItemList = groundItemListRef(nX, nY);
         rstGroundItemList.PushBack(rstCommonItem);
 
-        AMShowDropItem amSDI;
-        std::memset(&amSDI, 0, sizeof(amSDI));
+        std::vector<uint64_t> uidList;
+        doCircleUID(nX, nY, 10, [&uidList](uint64_t nUID) -> bool
+        {
+            if(uidf::getUIDType(nUID) == UID_PLY){
+                uidList.push_back(nUID);
+            }
+            return false;
+        });
+        reportGroundItem(uidList, nX, nY);
+        return true;
+    }
+    return false;
+}
+
+void ServerMap::reportGroundItem(const std::vector<uint64_t> &uidList, int nX, int nY)
+{
+    if(uidList.empty()){
+        return;
+    }
 
-        amSDI.X = nX;
-        amSDI.Y = nY;
+    AMShowDropItem amSDI;
+    std::memset(&amSDI, 0, sizeof(amSDI));
 
-        size_t nCurrLoc = 0;
-        for(size_t nIndex = 0; nIndex < rstGroundItemList.Length(); ++nIndex){
-            if(rstGroundItemList[nIndex]){
-                if(nCurrLoc < std::extent<decltype(amSDI.IDList)>::value){
-                    amSDI.IDList[nCurrLoc].ID   = rstGroundItemList[nIndex].ID();
-                    amSDI.IDList[nCurrLoc].DBID = rstGroundItemList[nIndex].DBID();
-                    nCurrLoc++;
-                }else{
-                    break;
-                }
+    amSDI.X = nX;
+    amSDI.Y = nY;
+
+    size_t nCurrLoc = 0;
+    const auto &rstGroundItemList = GetGroundItemList(nX, nY);
+
+    for(size_t nIndex = 0; nIndex < rstGroundItemList.Length(); ++nIndex){
+        if(rstGroundItemList[nIndex]){
+            if(nCurrLoc < std::extent<decltype(amSDI.IDList)>::value){
+                amSDI.IDList[nCurrLoc].ID   = rstGroundItemList[nIndex].ID();
+                amSDI.IDList[nCurrLoc].DBID = rstGroundItemList[nIndex].DBID();
+                nCurrLoc++;
+            }else{
+                break;
             }
         }
+    }
+    m_actorPod->forward(uidList, {MPK_SHOWDROPITEM, amSDI});
+}
 
-        auto fnNotifyDropItem = [this, amSDI](int nX, int nY) -> bool
+void ServerMap::reportGroundItemCircle(uint64_t nUID, int cx0, int cy0, int r)
+{
+    // cells with ground item are rare, usually walking the sparse item table is cheaper than the circle
+    // fall back to doCircle() if the map has more item cells than the circle has cells
+    const std::vector<uint64_t> uidList {nUID};
+    if(m_cellGroundItemList.size() > (size_t)((2 * r - 1) * (2 * r - 1))){
+        doCircle(cx0, cy0, r, [this, &uidList](int nX, int nY) -> bool
         {
-            if(true || ValidC(nX, nY)){
-                for(auto nUID: getUIDList(nX, nY)){
-                    if(uidf::getUIDType(nUID) == UID_PLY){
-                        m_actorPod->forward(nUID, {MPK_SHOWDROPITEM, amSDI});
-                    }
-                }
+            if(cellFlag(nX, nY, CELL_HASITEM)){
+                reportGroundItem(uidList, nX, nY);
             }
             return false;
-        };
+        });
+        return;
+    }
 
-        doCircle(nX, nY, 10, fnNotifyDropItem);
-        return true;
+    for(const auto &[nCellIndex, rstGroundItemList]: m_cellGroundItemList){
+        const int nX = nCellIndex % W();
+        const int nY = nCellIndex / W();
+
+        if(!rstGroundItemList.Empty() && mathf::LDistance2(nX, nY, cx0, cy0) <= (r - 1) * (r - 1)){
+            reportGroundItem(uidList, nX, nY);
+        }
     }
-    return false;
 }
 
-int ServerMap::GetMonsterCount(uint32_t nMonsterID)
+int ServerMap::GetMonsterCount(uint32_t monID) const
 {
-    int nCount = 0;
-    for(int nX = 0; nX < W(); ++nX){
-        for(int nY = 0; nY < H(); ++nY){
-            for(auto nUID: getUIDList(nX, nY)){
-                if(uidf::getUIDType(nUID) == UID_MON){
-                    if(nMonsterID){
-                        nCount += ((uidf::getMonsterID(nUID) == nMonsterID) ? 1 : 0);
-                    }else{
-                        nCount++;
-                    }
+    if(!monID){
+        return m_uidTypeCount[UID_MON];
+    }
+
+    if(auto p = m_monsterCountList.find(monID); p != m_monsterCountList.end()){
+        return p->second;
+    }
+    return 0;
+}
+
+int ServerMap::GetMonsterCount(uint32_t monID, int x0, int y0, int w, int h) const
+{
+    if(!((w > 0) && (h > 0) && mathf::rectangleOverlapRegion(0, 0, W(), H(), &x0, &y0, &w, &h))){
+        return 0;
+    }
+
+    int count = 0;
+    const int rx0 = x0 / m_aoiRegionSize;
+    const int ry0 = y0 / m_aoiRegionSize;
+    const int rx1 = (x0 + w - 1) / m_aoiRegionSize;
+    const int ry1 = (y0 + h - 1) / m_aoiRegionSize;
+
+    for(int ry = ry0; ry <= ry1; ++ry){
+        for(int rx = rx0; rx <= rx1; ++rx){
+            const auto &region = m_aoiRegionList[rx + ry * m_aoiRegionW];
+            if(region.monsterCount == 0){
+                continue;
+            }
+
+            if(true
+                    && rx * m_aoiRegionSize >= x0
+                    && ry * m_aoiRegionSize >= y0
+                    && std::min<int>((rx + 1) * m_aoiRegionSize, W()) <= x0 + w
+                    && std::min<int>((ry + 1) * m_aoiRegionSize, H()) <= y0 + h){
+
+                if(!monID){
+                    count += region.monsterCount;
+                }
+                else if(auto p = region.monsterCountList.find(monID); p != region.monsterCountList.end()){
+                    count += p->second;
+                }
+                continue;
+            }
+
+            for(const auto &entry: region.entryList){
+                if(true
+                        && uidf::getUIDType(entry.uid) == UID_MON
+                        && (!monID || uidf::getMonsterID(entry.uid) == monID)
+                        && mathf::pointInRectangle(entry.x, entry.y, x0, y0, w, h)){
+                    count++;
                 }
             }
         }
     }
-    return nCount;
+    return count;
 }
 
 std::vector<std::u8string> ServerMap::getMonsterList() const
@@ -921,19 +1224,15 @@ void ServerMap::notifyNewCO(uint64_t nUID, int nX, int nY)
     std::memset(&amNNCO, 0, sizeof(amNNCO));
 
     amNNCO.UID = nUID;
-    doCircle(nX, nY, 20, [this, amNNCO](int nX, int nY) -> bool
+    std::vector<uint64_t> uidList;
+    doCircleUID(nX, nY, 20, [&uidList, amNNCO](uint64_t nUID) -> bool
     {
-        if(true || ValidC(nX, nY)){
-            doUIDList(nX, nY, [this, amNNCO](uint64_t nUID)
-            {
-                if(nUID != amNNCO.UID){
-                    m_actorPod->forward(nUID, {MPK_NOTIFYNEWCO, amNNCO});
-                }
-                return false;
-            });
+        if(nUID != amNNCO.UID){
+            uidList.push_back(nUID);
         }
         return false;
     });
+    m_actorPod->forward(uidList, {MPK_NOTIFYNEWCO, amNNCO});
 }
 
 Monster *ServerMap::addMonster(uint32_t nMonsterID, uint64_t nMasterUID, int nHintX, int nHintY, bool bStrictLoc)
@@ -1002,7 +1301,10 @@ Monster *ServerMap::addMonster(uint32_t nMonsterID, uint64_t nMasterUID, int nHi
                 }
         }
 
-        monsterPtr->activate();
+        // read region state in map thread before the monster attaches
+        // monster parks itself in its attach trigger, no message is posted to an unattached pod
+        monsterPtr->setSpawnHibernated(getAOIRegion(nDstX, nDstY).hibernated);
+        monsterPtr->activate(UID());
         return monsterPtr;
     }
     return nullptr;
@@ -1029,7 +1331,7 @@ NPChar *ServerMap::addNPChar(uint16_t npcID, int hintX, int hintY, bool strictLo
             dstY,
         };
 
-        npcPtr->activate();
+        npcPtr->activate(UID());
         return npcPtr;
     }
     return nullptr;
@@ -1057,7 +1359,7 @@ Player *ServerMap::addPlayer(uint32_t nDBID, int nHintX, int nHintY, int nDirect
             nDirection,
         };
 
-        playerPtr->activate();
+        playerPtr->activate(UID());
         return playerPtr;
     }
     return nullptr;
@@ -1065,25 +1367,23 @@ Player *ServerMap::addPlayer(uint32_t nDBID, int nHintX, int nHintY, int nDirect
 
 int ServerMap::CheckPathGrid(int nX, int nY) const
 {
-    if(!m_mir2xMapData.ValidC(nX, nY)){
+    if(!ValidC(nX, nY)){
         return PathFind::INVALID;
     }
 
-    if(!m_mir2xMapData.Cell(nX, nY).CanThrough()){
+    const auto flag = m_cellFlagList[nX + nY * W()];
+    if(!(flag & CELL_CANTHROUGH)){
         return PathFind::OBSTACLE;
     }
 
-    // for(auto nUID: getUIDList(nX, nY)){
-    //     if(auto nType = uidf::getUIDType(nUID); nType == UID_PLY || nType == UID_MON){
-    //         return PatFind::OCCUPIED;
-    //     }
-    // }
+    // any UID makes it occupied, not only player and monster
+    // use CELL_HASCO if only need to check them
 
-    if(!getUIDList(nX, nY).empty()){
+    if(flag & CELL_HASUID){
         return PathFind::OCCUPIED;
     }
 
-    if(getCell(nX, nY).Locked){
+    if(flag & CELL_LOCKED){
         return PathFind::LOCKED;
     }
 
@@ -18,15 +18,18 @@
 
 #pragma once
 
+#include <array>
 #include <tuple>
 #include <memory>
 #include <vector>
 #include <cstdint>
 #include <concepts>
+#include <unordered_map>
 
 #include "mathf.hpp"
 #include "totype.hpp"
 #include "sysconst.hpp"
+#include "jpsfinder.hpp"
 #include "querytype.hpp"
 #include "commonitem.hpp"
 #include "pathfinder.hpp"
@@ -53,6 +56,11 @@ class ServerMap final: public ServerObject
                 ServerMapLuaModule(ServerMap *);
 
             public:
+                bool scriptRunning() const
+                {
+                    return (bool)(m_coHandler);
+                }
+
                 void resumeLoop()
                 {
                     if(!m_coHandler){
@@ -99,47 +107,103 @@ class ServerMap final: public ServerObject
         friend class ServerPathFinder;
 
     private:
-        struct MapCell
+        // cell states are stored as structure of arrays, cell index is x + y * W()
+        // hot flags are packed in one byte per cell, canMove() / groundValid() / CheckPathGrid() only read them
+        // UID lists, ground items and map switches are rare, they live in sparse tables keyed by cell index
+        enum CellFlagType: uint8_t
         {
-            bool Locked;
-            std::vector<uint64_t> UIDList;
+            CELL_CANTHROUGH = (1 << 0), // copy of Mir2xMapData::Cell().CanThrough()
+            CELL_LOCKED     = (1 << 1),
+            CELL_HASUID     = (1 << 2),
+            CELL_HASCO      = (1 << 3), // has player or monster
+            CELL_HASITEM    = (1 << 4),
+            CELL_HASSWITCH  = (1 << 5),
+        };
 
-            uint32_t mapID;
-            int      switchX;
-            int      switchY;
+        struct CellSwitch
+        {
+            uint32_t mapID = 0;
+            int x = -1;
+            int y = -1;
+        };
 
-            CacheQueue<CommonItem, SYS_MAXDROPITEM> GroundItemQueue;
+        using GroundItemQueue = CacheQueue<CommonItem, SYS_MAXDROPITEM>;
 
-            MapCell()
-                : Locked(false)
-                , mapID(0)
-                , switchX(-1)
-                , switchY(-1)
-                , GroundItemQueue()
-            {}
+    private:
+        // coarse area-of-interest index over the map
+        // map is split into square regions, each region keeps a copy of all UIDs located in its cells
+        // fan-out handlers visit the few regions overlapping the broadcast radius instead of every cell in it
+        //
+        // this is a mirror of the cell UID lists
+        // only change it through addGridUID() and removeGridUID()
+        struct AOIEntry
+        {
+            uint64_t uid;
+            int x;
+            int y;
+        };
 
-            bool empty() const
-            {
-                return !Locked && UIDList.empty() && (mapID == 0) && GroundItemQueue.Empty();
-            }
+        struct AOIRegion
+        {
+            std::vector<AOIEntry> entryList;
+
+            // players in this region and its 8 neighbors
+            // monsters in region without any nearby player hibernate, they don't get METRONOME
+            int  nearbyPlayerCount = 0;
+            bool hibernated = false;
+
+            // monsters in this region, total and by monster ID
+            int monsterCount = 0;
+            std::unordered_map<uint32_t, int> monsterCountList;
         };
 
+        // region size is chosen as the radius of action and HP broadcasts, 10 or 20 cells
+        // such a circle visits at most 3x3 regions, larger areas like the view square of MPK_PULLCOINFO visit more
+        constexpr static int m_aoiRegionSize = 20;
+
     private:
-        template<typename T> using Vec2D = std::vector<std::vector<T>>;
+        const uint32_t m_ID;
 
     private:
-        const uint32_t     m_ID;
-        const Mir2xMapData m_mir2xMapData;
+        // map data is read-only and shared by all server maps with the same map ID
+        const std::shared_ptr<const Mir2xMapData> m_mir2xMapDataPtr;
+        const Mir2xMapData &m_mir2xMapData;
 
     private:
         ServiceCore *m_serviceCore;
 
     private:
-        Vec2D<MapCell> m_cellVec2D;
+        std::vector<uint8_t> m_cellFlagList;
+
+    private:
+        std::unordered_map<int, CellSwitch> m_cellSwitchList;
+        std::unordered_map<int, GroundItemQueue> m_cellGroundItemList;
+        std::unordered_map<int, std::vector<uint64_t>> m_cellUIDList;
+
+    private:
+        int m_aoiRegionW = 0;
+        int m_aoiRegionH = 0;
+        std::vector<AOIRegion> m_aoiRegionList;
+
+    private:
+        // census of UIDs on the grid, updated with the AOI index in addGridUID() and removeGridUID()
+        // a dead monster leaves the grid when it fades out
+        std::array<int, UID_MAX> m_uidTypeCount {};
+        std::unordered_map<uint32_t, int> m_monsterCountList;
+
+    private:
+        // regions lost its last nearby player
+        // they hibernate at next METRONOME if still no player, then a player moving inside one region won't flip it
+        std::vector<int> m_aoiHibernateCheckList;
 
     private:
         std::unique_ptr<ServerMapLuaModule> m_luaModulePtr;
 
+    private:
+        // built at first MPK_PATHFIND
+        // static walkability of server map never changes
+        std::unique_ptr<PathFind::HPAGraph> m_hpaGraph;
+
     private:
         void operateAM(const MessagePack &);
 
@@ -165,6 +229,9 @@ class ServerMap final: public ServerObject
     protected:
         double OneStepCost(int, int, int, int, int, int) const;
 
+    private:
+        PathFind::HPAGraph &getHPAGraph();
+
     public:
         const Mir2xMapData &GetMir2xMapData() const
         {
@@ -212,6 +279,11 @@ class ServerMap final: public ServerObject
         [[maybe_unused]] std::tuple<bool, int, int> GetValidGrid(bool, bool, int) const;
         [[maybe_unused]] std::tuple<bool, int, int> GetValidGrid(bool, bool, int, int, int) const;
 
+    private:
+        void updateAOIPlayerCount(int, int, int);
+        void checkAOIHibernate();
+        void setAOIRegionHibernated(AOIRegion &, bool);
+
     private:
         void notifyNewCO(uint64_t, int, int);
 
@@ -221,57 +293,112 @@ class ServerMap final: public ServerObject
         Monster *addMonster(uint32_t, uint64_t, int, int, bool);
 
     private:
-        int GetMonsterCount(uint32_t);
+        void updateCensus(uint64_t, int, int, int);
+
+    private:
+        // monster ID 0 means all monsters
+        // rectangle count reads counters of regions fully inside, only scans entries of regions on the border
+        int GetMonsterCount(uint32_t) const;
+        int GetMonsterCount(uint32_t, int, int, int, int) const;
         std::vector<std::u8string> getMonsterList() const;
 
     private:
-        auto &getCell(int nX, int nY)
+        int cellIndex(int nX, int nY) const
         {
             if(!ValidC(nX, nY)){
                 throw fflerror("invalid location: x = %d, y = %d", nX, nY);
             }
-            return m_cellVec2D[nX][nY];
+            return nX + nY * W();
         }
 
-        const auto &getCell(int nX, int nY) const
+        bool cellFlag(int nX, int nY, uint8_t flag) const
         {
-            if(!ValidC(nX, nY)){
-                throw fflerror("invalid location: x = %d, y = %d", nX, nY);
+            return m_cellFlagList[cellIndex(nX, nY)] & flag;
+        }
+
+        void setCellFlag(int nX, int nY, uint8_t flag, bool set)
+        {
+            if(set){
+                m_cellFlagList[cellIndex(nX, nY)] |= flag;
             }
-            return m_cellVec2D[nX][nY];
+            else{
+                m_cellFlagList[cellIndex(nX, nY)] &= (uint8_t)(~flag);
+            }
+        }
+
+    private:
+        bool cellLocked(int nX, int nY) const
+        {
+            return cellFlag(nX, nY, CELL_LOCKED);
+        }
+
+        void setCellLocked(int nX, int nY, bool locked)
+        {
+            setCellFlag(nX, nY, CELL_LOCKED, locked);
         }
 
     private:
-        auto &getUIDList(int nX, int nY)
+        const CellSwitch *getCellSwitch(int nX, int nY) const
         {
-            return getCell(nX, nY).UIDList;
+            if(cellFlag(nX, nY, CELL_HASSWITCH)){
+                return &m_cellSwitchList.at(cellIndex(nX, nY));
+            }
+            return nullptr;
         }
 
-        const auto &getUIDList(int nX, int nY) const
+    private:
+        // returns an empty list for cell without UID
+        // only change it through addGridUID() and removeGridUID()
+        const std::vector<uint64_t> &getUIDList(int nX, int nY) const
         {
-            return getCell(nX, nY).UIDList;
+            if(cellFlag(nX, nY, CELL_HASUID)){
+                return m_cellUIDList.at(cellIndex(nX, nY));
+            }
+
+            const static std::vector<uint64_t> s_emptyUIDList;
+            return s_emptyUIDList;
         }
 
     private:
-        auto &GetGroundItemList(int nX, int nY)
+        const GroundItemQueue &GetGroundItemList(int nX, int nY) const
         {
-            return getCell(nX, nY).GroundItemQueue;
+            if(cellFlag(nX, nY, CELL_HASITEM)){
+                return m_cellGroundItemList.at(cellIndex(nX, nY));
+            }
+
+            const static GroundItemQueue s_emptyGroundItemList;
+            return s_emptyGroundItemList;
         }
 
-        const auto &GetGroundItemList(int nX, int nY) const
+        // create the queue if cell has no item
+        // caller should call shrinkGroundItemList() if it removes items
+        GroundItemQueue &groundItemListRef(int nX, int nY)
         {
-            return getCell(nX, nY).GroundItemQueue;
+            setCellFlag(nX, nY, CELL_HASITEM, true);
+            return m_cellGroundItemList[cellIndex(nX, nY)];
+        }
+
+        void shrinkGroundItemList(int nX, int nY)
+        {
+            if(auto p = m_cellGroundItemList.find(cellIndex(nX, nY)); p != m_cellGroundItemList.end() && p->second.Empty()){
+                m_cellGroundItemList.erase(p);
+                setCellFlag(nX, nY, CELL_HASITEM, false);
+            }
         }
 
     private:
-        int FindGroundItem(const CommonItem &, int, int);
-        int GroundItemCount(const CommonItem &, int, int);
+        int FindGroundItem(const CommonItem &, int, int) const;
+        int GroundItemCount(const CommonItem &, int, int) const;
 
         bool AddGroundItem(const CommonItem &, int, int);
         void RemoveGroundItem(const CommonItem &, int, int);
 
         void ClearGroundItem(int, int);
 
+    private:
+        void reportGroundItem(const std::vector<uint64_t> &, int, int);
+        void reportGroundItemCircle(uint64_t, int, int, int);
+
     private:
         int CheckPathGrid(int, int) const;
 
@@ -331,6 +458,66 @@ class ServerMap final: public ServerObject
             return false;
         }
 
+    private:
+        auto &getAOIRegion(int nX, int nY)
+        {
+            return m_aoiRegionList.at(nX / m_aoiRegionSize + (nY / m_aoiRegionSize) * m_aoiRegionW);
+        }
+
+        const auto &getAOIRegion(int nX, int nY) const
+        {
+            return m_aoiRegionList.at(nX / m_aoiRegionSize + (nY / m_aoiRegionSize) * m_aoiRegionW);
+        }
+
+        template<std::predicate<const AOIEntry &> F> bool doAOIRegion(int x0, int y0, int doW, int doH, const F &f)
+        {
+            // visit all entries in regions overlapping the square
+            // region can be larger than the square, caller needs to filter entries by location
+
+            if((doW > 0) && (doH > 0) && mathf::rectangleOverlapRegion(0, 0, W(), H(), &x0, &y0, &doW, &doH)){
+                const int rx0 = x0 / m_aoiRegionSize;
+                const int ry0 = y0 / m_aoiRegionSize;
+                const int rx1 = (x0 + doW - 1) / m_aoiRegionSize;
+                const int ry1 = (y0 + doH - 1) / m_aoiRegionSize;
+
+                for(int ry = ry0; ry <= ry1; ++ry){
+                    for(int rx = rx0; rx <= rx1; ++rx){
+                        for(const auto &entry: m_aoiRegionList[rx + ry * m_aoiRegionW].entryList){
+                            if(f(entry)){
+                                return true;
+                            }
+                        }
+                    }
+                }
+            }
+            return false;
+        }
+
+        template<std::predicate<uint64_t> F> bool doCircleUID(int cx0, int cy0, int r, const F &f)
+        {
+            // visit same UIDs as doCircle() + doUIDList()
+            // but only touches cells which have UID inside
+            return doAOIRegion(cx0 - r + 1, cy0 - r + 1, 2 * r - 1, 2 * r - 1, [cx0, cy0, r, &f](const AOIEntry &entry) -> bool
+            {
+                if(mathf::LDistance2(entry.x, entry.y, cx0, cy0) <= (r - 1) * (r - 1)){
+                    return f(entry.uid);
+                }
+                return false;
+            });
+        }
+
+        template<std::predicate<uint64_t> F> bool doSquareUID(int x0, int y0, int doW, int doH, const F &f)
+        {
+            return doAOIRegion(x0, y0, doW, doH, [x0, y0, doW, doH, &f](const AOIEntry &entry) -> bool
+            {
+                if(mathf::pointInRectangle(entry.x, entry.y, x0, y0, doW, doH)){
+                    return f(entry.uid);
+                }
+                return false;
+            });
+        }
+
+    private:
         bool DoCenterCircle(int, int, int,      bool, const std::function<bool(int, int)> &);
         bool DoCenterSquare(int, int, int, int, bool, const std::function<bool(int, int)> &);
 
@@ -34,8 +34,16 @@ extern ServerArgParser *g_serverArgParser;
 
 void ServerMap::on_MPK_METRONOME(const MessagePack &)
 {
-    if(m_luaModulePtr && !g_serverArgParser->DisableMapScript){
+    checkAOIHibernate();
+    if(m_luaModulePtr && !g_serverArgParser->DisableMapScript && m_luaModulePtr->scriptRunning()){
+        // script finishing in this resume is seen next tick, then interval goes back to 1000
         m_luaModulePtr->resumeLoop();
+        setUpdateInterval(0);
+    }
+    else{
+        // only hibernation check left
+        // monsters wait at most one more second to hibernate
+        setUpdateInterval(1000);
     }
 }
 
@@ -55,33 +63,35 @@ void ServerMap::on_MPK_ACTION(const MessagePack &rstMPK)
 
     if(amA.action.type == ACTION_SPAWN){
         addGridUID(amA.UID, amA.action.x, amA.action.y, true);
+
+        // monster spawned in a hibernated region parked itself at activation
+        // region can get awake before its ACTION_SPAWN arrives, it's not in the region entry list then
+        if(uidf::getUIDType(amA.UID) == UID_MON && !g_serverArgParser->disableMonsterHibernate && !getAOIRegion(amA.action.x, amA.action.y).hibernated){
+            m_actorPod->forward(amA.UID, {MPK_AWAKE});
+        }
     }
 
-    doCircle(amA.action.x, amA.action.y, 10, [this, amA](int nX, int nY) -> bool
+    std::vector<uint64_t> uidList;
+    doCircleUID(amA.action.x, amA.action.y, 10, [&uidList, amA](uint64_t nUID) -> bool
     {
-        if(true || ValidC(nX, nY)){
-            doUIDList(nX, nY, [this, amA](uint64_t nUID) -> bool
-            {
-                if(nUID != amA.UID){
-                    switch(uidf::getUIDType(nUID)){
-                        case UID_PLY:
-                        case UID_MON:
-                        case UID_NPC:
-                            {
-                                m_actorPod->forward(nUID, {MPK_ACTION, amA});
-                                break;
-                            }
-                        default:
-                            {
-                                break;
-                            }
+        if(nUID != amA.UID){
+            switch(uidf::getUIDType(nUID)){
+                case UID_PLY:
+                case UID_MON:
+                case UID_NPC:
+                    {
+                        uidList.push_back(nUID);
+                        break;
                     }
-                }
-                return false;
-            });
+                default:
+                    {
+                        break;
+                    }
+            }
         }
         return false;
     });
+    m_actorPod->forward(uidList, {MPK_ACTION, amA});
 }
 
 void ServerMap::on_MPK_ADDCHAROBJECT(const MessagePack &rstMPK)
@@ -115,13 +125,9 @@ void ServerMap::on_MPK_ADDCHAROBJECT(const MessagePack &rstMPK)
                     m_actorPod->forward(rstMPK.from(), MPK_OK, rstMPK.ID());
                     m_actorPod->forward(pPlayer->UID(), {MPK_BINDCHANNEL, nChannID});
 
-                    doCircle(nX, nY, 20, [this, nChannID](int nX, int nY) -> bool
-                    {
-                        if(true || ValidC(nX, nY)){
-                            // ReportGroundItem(nChannID, nX, nY);
-                        }
-                        return false;
-                    });
+                    // player forwards MPK_SHOWDROPITEM to its channel
+                    // it gets them after MPK_BINDCHANNEL since both are from this map
+                    reportGroundItemCircle(pPlayer->UID(), pPlayer->X(), pPlayer->Y(), 20);
                     return;
                 }
 
@@ -137,13 +143,6 @@ void ServerMap::on_MPK_ADDCHAROBJECT(const MessagePack &rstMPK)
 
                 if(addNPChar(npcID, x, y, strictLoc)){
                     m_actorPod->forward(rstMPK.from(), MPK_OK, rstMPK.ID());
-                    doCircle(nX, nY, 20, [this](int nX, int nY) -> bool
-                    {
-                        if(true || ValidC(nX, nY)){
-                            // ReportGroundItem(nChannID, nX, nY);
-                        }
-                        return false;
-                    });
                     return;
                 }
 
@@ -346,7 +345,7 @@ void ServerMap::on_MPK_TRYMOVE(const MessagePack &rstMPK)
         return;
     }
 
-    if(getCell(nMostX, nMostY).Locked){
+    if(cellLocked(nMostX, nMostY)){
         m_actorPod->forward(rstMPK.from(), MPK_ERROR, rstMPK.ID());
         return;
     }
@@ -361,13 +360,13 @@ void ServerMap::on_MPK_TRYMOVE(const MessagePack &rstMPK)
     amMOK.EndX  = nMostX;
     amMOK.EndY  = nMostY;
 
-    getCell(nMostX, nMostY).Locked = true;
+    setCellLocked(nMostX, nMostY, true);
     m_actorPod->forward(rstMPK.from(), {MPK_MOVEOK, amMOK}, rstMPK.ID(), [this, amTM, nMostX, nMostY](const MessagePack &rstRMPK)
     {
-        if(!getCell(nMostX, nMostY).Locked){
+        if(!cellLocked(nMostX, nMostY)){
             throw fflerror("cell lock released before MOVEOK get responsed: MapUID = %" PRIu64, UID());
         }
-        getCell(nMostX, nMostY).Locked = false;
+        setCellLocked(nMostX, nMostY, false);
 
         switch(rstRMPK.Type()){
             case MPK_OK:
@@ -376,33 +375,23 @@ void ServerMap::on_MPK_TRYMOVE(const MessagePack &rstMPK)
                     // and it's internal state has changed
 
                     // 1. leave last cell
-                    bool bFindCO = false;
-                    auto &rstUIDList = getUIDList(amTM.X, amTM.Y);
-
-                    for(auto &nUID: rstUIDList){
-                        if(nUID == amTM.UID){
-                            bFindCO = true;
-                            std::swap(nUID, rstUIDList.back());
-                            rstUIDList.pop_back();
-                            break;
-                        }
-                    }
-
-                    if(!bFindCO){
+                    //    use removeGridUID() to keep the AOI index synced
+                    if(!hasGridUID(amTM.UID, amTM.X, amTM.Y)){
                         throw fflerror("CO location error: (UID = %llu, X = %d, Y = %d)", to_llu(amTM.UID), amTM.X, amTM.Y);
                     }
+                    removeGridUID(amTM.UID, amTM.X, amTM.Y);
 
                     // 2. push to the new cell
                     //    check if it should switch the map
                     addGridUID(amTM.UID, nMostX, nMostY, true);
-                    if(uidf::getUIDType(amTM.UID) == UID_PLY && getCell(nMostX, nMostY).mapID){
+                    if(const auto switchPtr = getCellSwitch(nMostX, nMostY); switchPtr && uidf::getUIDType(amTM.UID) == UID_PLY){
                         AMMapSwitch amMS;
                         std::memset(&amMS, 0, sizeof(amMS));
 
-                        amMS.UID   = uidf::buildMapUID(getCell(nMostX, nMostY).mapID); // TODO
-                        amMS.MapID = getCell(nMostX, nMostY).mapID;
-                        amMS.X     = getCell(nMostX, nMostY).switchX;
-                        amMS.Y     = getCell(nMostX, nMostY).switchY;
+                        amMS.UID   = uidf::buildMapUID(switchPtr->mapID); // TODO
+                        amMS.MapID = switchPtr->mapID;
+                        amMS.X     = switchPtr->x;
+                        amMS.Y     = switchPtr->y;
                         m_actorPod->forward(amTM.UID, {MPK_MAPSWITCH, amMS});
                     }
                     break;
@@ -436,25 +425,21 @@ void ServerMap::on_MPK_PULLCOINFO(const MessagePack &rstMPK)
     AMPullCOInfo amPCOI;
     std::memcpy(&amPCOI, rstMPK.Data(), sizeof(amPCOI));
 
-    DoCenterSquare(amPCOI.X, amPCOI.Y, amPCOI.W, amPCOI.H, false, [this, amPCOI](int nX, int nY) -> bool
-    {
-        if(true || ValidC(nX, nY)){
-            doUIDList(nX, nY, [this, amPCOI](uint64_t nUID) -> bool
-            {
-                if(nUID != amPCOI.UID){
-                    if(uidf::getUIDType(nUID) == UID_PLY || uidf::getUIDType(nUID) == UID_MON){
-                        AMQueryCORecord amQCOR;
-                        std::memset(&amQCOR, 0, sizeof(amQCOR));
+    AMQueryCORecord amQCOR;
+    std::memset(&amQCOR, 0, sizeof(amQCOR));
 
-                        amQCOR.UID = amPCOI.UID;
-                        m_actorPod->forward(nUID, {MPK_QUERYCORECORD, amQCOR});
-                    }
-                }
-                return false;
-            });
+    amQCOR.UID = amPCOI.UID;
+    std::vector<uint64_t> uidList;
+    doSquareUID(amPCOI.X - amPCOI.W / 2, amPCOI.Y - amPCOI.H / 2, amPCOI.W, amPCOI.H, [&uidList, &amQCOR](uint64_t nUID) -> bool
+    {
+        if(nUID != amQCOR.UID){
+            if(uidf::getUIDType(nUID) == UID_PLY || uidf::getUIDType(nUID) == UID_MON){
+                uidList.push_back(nUID);
+            }
         }
         return false;
     });
+    m_actorPod->forward(uidList, {MPK_QUERYCORECORD, amQCOR});
 }
 
 void ServerMap::on_MPK_TRYMAPSWITCH(const MessagePack &mpk)
@@ -474,14 +459,14 @@ void ServerMap::on_MPK_TRYMAPSWITCH(const MessagePack &mpk)
     amMSOK.X   = amTMS.X;
     amMSOK.Y   = amTMS.Y;
 
-    getCell(amTMS.X, amTMS.Y).Locked = true;
+    setCellLocked(amTMS.X, amTMS.Y, true);
     m_actorPod->forward(mpk.from(), {MPK_MAPSWITCHOK, amMSOK}, mpk.ID(), [this, reqUID, amMSOK](const MessagePack &rmpk)
     {
-        if(!getCell(amMSOK.X, amMSOK.Y).Locked){
+        if(!cellLocked(amMSOK.X, amMSOK.Y)){
             throw fflerror("cell lock released before MAPSWITCHOK get responsed: MapUID = %lld", to_llu(UID()));
         }
 
-        getCell(amMSOK.X, amMSOK.Y).Locked = false;
+        setCellLocked(amMSOK.X, amMSOK.Y, false);
         switch(rmpk.Type()){
             case MPK_OK:
                 {
@@ -535,6 +520,60 @@ void ServerMap::on_MPK_PATHFIND(const MessagePack &rstMPK)
         g_monoServer->addLog(LOGTYPE_WARNING, "Invalid MaxStep: %d, should be (1, 2, 3)", amPF.MaxStep);
     }
 
+    // try the JPS/HPA* path first for long distance, it only knows the static walkability
+    // check creatures and locks on the steps sent back, fallback to A* if any of them is not free
+    // short path goes to A* directly, it's cheap and handles creatures in one pass
+    // A* is also the fallback when HPA* gives nothing, HPA* caps its search window and can miss a far detour
+
+    // about one HPA* cluster, inside it HPA* does a plain JPS anyway
+    constexpr int nShortPathDistance = 16;
+
+    std::vector<PathFind::PathNode> stPathList;
+    if(std::max<int>(std::abs(nX1 - nX0), std::abs(nY1 - nY0)) > nShortPathDistance){
+        stPathList = getHPAGraph().search(nX0, nY0, nX1, nY1);
+    }
+
+    const auto nSendCount = std::min<size_t>(stPathList.size(), nPathCount);
+    const auto fnStepFree = [this, &amPF, &stPathList](size_t nIndex) -> bool
+    {
+        // skip the start and end point
+        // they are taken by the requestor and its target
+        if(nIndex == 0 || nIndex + 1 == stPathList.size()){
+            return true;
+        }
+
+        switch(CheckPathGrid(stPathList[nIndex].X, stPathList[nIndex].Y)){
+            case PathFind::FREE:
+                {
+                    return true;
+                }
+            case PathFind::OCCUPIED:
+            case PathFind::LOCKED:
+                {
+                    return amPF.CheckCO == 0;
+                }
+            default:
+                {
+                    return false;
+                }
+        }
+    };
+
+    bool bStepFree = !stPathList.empty();
+    for(size_t nIndex = 0; bStepFree && nIndex < nSendCount; ++nIndex){
+        bStepFree = fnStepFree(nIndex);
+    }
+
+    if(bStepFree){
+        for(size_t nIndex = 0; nIndex < nSendCount; ++nIndex){
+            amPFOK.Point[nIndex].X = stPathList[nIndex].X;
+            amPFOK.Point[nIndex].Y = stPathList[nIndex].Y;
+        }
+
+        m_actorPod->forward(rstMPK.from(), {MPK_PATHFINDOK, amPFOK}, rstMPK.ID());
+        return;
+    }
+
     ServerPathFinder stPathFinder(this, amPF.MaxStep, amPF.CheckCO);
     if(!stPathFinder.Search(nX0, nY0, nX1, nY1)){
         m_actorPod->forward(rstMPK.from(), MPK_ERROR, rstMPK.ID());
@@ -588,19 +627,17 @@ void ServerMap::on_MPK_UPDATEHP(const MessagePack &rstMPK)
     std::memcpy(&amUHP, rstMPK.Data(), sizeof(amUHP));
 
     if(ValidC(amUHP.X, amUHP.Y)){
-        doCircle(amUHP.X, amUHP.Y, 20, [this, amUHP](int nX, int nY) -> bool
+        std::vector<uint64_t> uidList;
+        doCircleUID(amUHP.X, amUHP.Y, 20, [&uidList, amUHP](uint64_t nUID) -> bool
         {
-            if(true || ValidC(nX, nY)){
-                for(auto nUID: getUIDList(nX, nY)){
-                    if(nUID != amUHP.UID){
-                        if(uidf::getUIDType(nUID) == UID_PLY || uidf::getUIDType(nUID) == UID_MON){
-                            m_actorPod->forward(nUID, {MPK_UPDATEHP, amUHP});
-                        }
-                    }
+            if(nUID != amUHP.UID){
+                if(uidf::getUIDType(nUID) == UID_PLY || uidf::getUIDType(nUID) == UID_MON){
+                    uidList.push_back(nUID);
                 }
             }
             return false;
         });
+        m_actorPod->forward(uidList, {MPK_UPDATEHP, amUHP});
     }
 }
 
@@ -611,22 +648,20 @@ void ServerMap::on_MPK_DEADFADEOUT(const MessagePack &rstMPK)
 
     if(ValidC(amDFO.X, amDFO.Y)){
         removeGridUID(amDFO.UID, amDFO.X, amDFO.Y);
-        doCircle(amDFO.X, amDFO.Y, 20, [this, amDFO](int nX, int nY) -> bool
+        std::vector<uint64_t> uidList;
+        doCircleUID(amDFO.X, amDFO.Y, 20, [&uidList, amDFO](uint64_t nUID) -> bool
         {
-            if(true || ValidC(nX, nY)){
-                for(auto nUID: getUIDList(nX, nY)){
-                    if(nUID != amDFO.UID){
-                        if(uidf::getUIDType(nUID) == UID_PLY){
-                            m_actorPod->forward(nUID, {MPK_DEADFADEOUT, amDFO});
-                        }
-                        else if(uidf::getUIDType(nUID) == UID_MON && DBCOM_MONSTERRECORD(uidf::getMonsterID(nUID)).deadFadeOut){
-                            m_actorPod->forward(nUID, {MPK_DEADFADEOUT, amDFO});
-                        }
-                    }
+            if(nUID != amDFO.UID){
+                if(uidf::getUIDType(nUID) == UID_PLY){
+                    uidList.push_back(nUID);
+                }
+                else if(uidf::getUIDType(nUID) == UID_MON && DBCOM_MONSTERRECORD(uidf::getMonsterID(nUID)).deadFadeOut){
+                    uidList.push_back(nUID);
                 }
             }
             return false;
         });
+        m_actorPod->forward(uidList, {MPK_DEADFADEOUT, amDFO});
     }
 }
 
@@ -641,16 +676,16 @@ void ServerMap::on_MPK_QUERYCOCOUNT(const MessagePack &rstMPK)
     }
 
     int nCOCount = 0;
-    for(int nX = 0; nX < W(); ++nX){
-        for(int nY = 0; nY < H(); ++nY){
-            std::for_each(getUIDList(nX, nY).begin(), getUIDList(nX, nY).end(), [amQCOC, &nCOCount](uint64_t nUID){
-                if(uidf::getUIDType(nUID) == UID_PLY || uidf::getUIDType(nUID) == UID_MON){
-                    if(amQCOC.Check.NPC    ){ nCOCount++; return; }
-                    if(amQCOC.Check.Player ){ nCOCount++; return; }
-                    if(amQCOC.Check.Monster){ nCOCount++; return; }
-                }
-            });
-        }
+    if(amQCOC.Check.NPC){
+        nCOCount += m_uidTypeCount[UID_NPC];
+    }
+
+    if(amQCOC.Check.Player){
+        nCOCount += m_uidTypeCount[UID_PLY];
+    }
+
+    if(amQCOC.Check.Monster){
+        nCOCount += GetMonsterCount(amQCOC.CheckParam.MonsterID);
     }
 
     AMCOCount amCOC;
@@ -737,17 +772,15 @@ void ServerMap::on_MPK_OFFLINE(const MessagePack &rstMPK)
     // because player may get offline at try move
     removeGridUID(amO.UID, amO.X, amO.Y);
 
-    doCircle(amO.X, amO.Y, 10, [amO, this](int nX, int nY) -> bool
+    std::vector<uint64_t> uidList;
+    doCircleUID(amO.X, amO.Y, 10, [&uidList, amO](uint64_t nUID) -> bool
     {
-        if(true || ValidC(nX, nY)){
-            for(auto nUID: getUIDList(nX, nY)){
-                if(nUID != amO.UID){
-                    m_actorPod->forward(nUID, {MPK_OFFLINE, amO});
-                }
-            }
+        if(nUID != amO.UID){
+            uidList.push_back(nUID);
         }
         return false;
     });
+    m_actorPod->forward(uidList, {MPK_OFFLINE, amO});
 }
 
 void ServerMap::on_MPK_PICKUP(const MessagePack &rstMPK)
@@ -762,27 +795,24 @@ void ServerMap::on_MPK_PICKUP(const MessagePack &rstMPK)
 
     if(auto nIndex = FindGroundItem(CommonItem(amPU.ID, 0), amPU.X, amPU.Y); nIndex >= 0){
         RemoveGroundItem(CommonItem(amPU.ID, 0), amPU.X, amPU.Y);
-        doCircle(amPU.X, amPU.Y, 10, [this, amPU](int nX, int nY) -> bool
-        {
-            if(true || ValidC(nX, nY)){
-                AMRemoveGroundItem amRGI;
-                std::memset(&amRGI, 0, sizeof(amRGI));
 
-                amRGI.X      = nX;
-                amRGI.Y      = nY;
-                amRGI.DBID   = amPU.DBID;
-                amRGI.ID = amPU.ID;
+        AMRemoveGroundItem amRGI;
+        std::memset(&amRGI, 0, sizeof(amRGI));
 
-                doUIDList(nX, nY, [this, &amRGI](uint64_t nUID) -> bool
-                {
-                    if(uidf::getUIDType(nUID) == UID_PLY){
-                        m_actorPod->forward(nUID, {MPK_REMOVEGROUNDITEM, amRGI});
-                    }
-                    return false;
-                });
+        amRGI.X    = amPU.X;
+        amRGI.Y    = amPU.Y;
+        amRGI.DBID = amPU.DBID;
+        amRGI.ID   = amPU.ID;
+
+        std::vector<uint64_t> uidList;
+        doCircleUID(amPU.X, amPU.Y, 10, [&uidList](uint64_t nUID) -> bool
+        {
+            if(uidf::getUIDType(nUID) == UID_PLY){
+                uidList.push_back(nUID);
             }
             return false;
         });
+        m_actorPod->forward(uidList, {MPK_REMOVEGROUNDITEM, amRGI});
 
         AMPickUpOK amPUOK;
         std::memset(&amPUOK, 0, sizeof(amPUOK));
@@ -72,7 +72,7 @@ ServerObject::~ServerObject()
 //
 // And if we really want to change the address of current object, maybe we need to
 // delete current object totally and create a new one instead
-uint64_t ServerObject::activate()
+uint64_t ServerObject::activate(uint64_t affinityUID)
 {
     if(m_actorPod){
         throw fflerror("activation twice: %s", uidf::getUIDString(UID()).c_str());
@@ -101,13 +101,14 @@ uint64_t ServerObject::activate()
     m_actorPod->attach([this]()
     {
         onActivate();
-    });
+    }, affinityUID);
     return UID();
 }
 
 void ServerObject::deactivate()
 {
     if(m_actorPod){
+        onDeactivate();
         m_actorPod->detach([this](){ delete this; });
     }
 }
@@ -116,4 +117,15 @@ void ServerObject::addDelay(uint32_t delayTick, std::function<void()> cmd)
 {
     m_delayCmdIndex = m_delayCmdQ.empty() ? 0 : (m_delayCmdIndex + 1);
     m_delayCmdQ.emplace(delayTick + g_monoServer->getCurrTick(), m_delayCmdIndex, std::move(cmd));
+
+    if(checkActorPod()){
+        m_actorPod->setUpdateInterval(0);
+    }
+}
+
+void ServerObject::setUpdateInterval(uint64_t msec)
+{
+    if(checkActorPod()){
+        m_actorPod->setUpdateInterval(m_delayCmdQ.empty() ? msec : 0);
+    }
 }
@@ -76,11 +76,17 @@ class ServerObject
         }
 
     public:
-        uint64_t activate();
+        // objects on a map pass the map UID, their actors start on the map's actor thread
+        uint64_t activate(uint64_t = 0);
 
     protected:
         virtual void onActivate() {}
 
+    protected:
+        // called before the actor pod gets detached
+        // last chance to send messages, dtor can't since the pod is gone
+        virtual void onDeactivate() {}
+
     protected:
         void deactivate();
 
@@ -102,4 +108,9 @@ class ServerObject
 
     public:
         void addDelay(uint32_t, std::function<void()>);
+
+    protected:
+        // METRONOME interval the object wants, 0 means every tick
+        // delayed commands are polled by METRONOME, always full rate till they all fire
+        void setUpdateInterval(uint64_t);
 };
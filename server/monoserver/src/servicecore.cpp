@@ -21,13 +21,14 @@
 #include "player.hpp"
 #include "totype.hpp"
 #include "actorpod.hpp"
-#include "mapbindb.hpp"
+#include "raiitimer.hpp"
+#include "mapdataregistry.hpp"
 #include "monoserver.hpp"
 #include "dbcomrecord.hpp"
 #include "servicecore.hpp"
 #include "serverargparser.hpp"
 
-extern MapBinDB *g_mapBinDB;
+extern MapDataRegistry *g_mapDataRegistry;
 extern MonoServer *g_monoServer;
 extern ServerArgParser *g_serverArgParser;
 
@@ -122,13 +123,27 @@ void ServiceCore::loadMap(uint32_t mapID)
         return;
     }
 
-    if(!g_mapBinDB->Retrieve(mapID)){
+    const auto rssBefore = MapDataRegistry::processRSS();
+    MapDataRegistry::LoadStat loadStat;
+
+    if(!g_mapDataRegistry->retrieve(mapID, &loadStat)){
         return;
     }
 
+    const hres_timer timer;
     auto mapPtr = new ServerMap(this, mapID);
     mapPtr->activate();
     m_mapList[mapID] = mapPtr;
+
+    const auto rssAfter = MapDataRegistry::processRSS();
+    g_monoServer->addLog(LOGTYPE_INFO, "Load map %s: data %s, %.2fms, %zuKB, server map %.2fms, RSS %zuKB -> %zuKB",
+            to_cstr(DBCOM_MAPRECORD(mapID).name),
+            loadStat.loaded ? (loadStat.cacheHit ? "cached" : (loadStat.mapped ? "decompressed" : "decompressed in memory")) : "shared",
+            loadStat.loadTime / 1000.0,
+            loadStat.dataSize / 1024,
+            timer.diff_usec() / 1000.0,
+            rssBefore / 1024,
+            rssAfter  / 1024);
 }
 
 const ServerMap *ServiceCore::retrieveMap(uint32_t mapID)
@@ -16,6 +16,8 @@
  * =====================================================================================
  */
 #include "dbpod.hpp"
+#include "dbservice.hpp"
+#include "totype.hpp"
 #include "dbcomid.hpp"
 #include "servermap.hpp"
 #include "monoserver.hpp"
@@ -23,6 +25,7 @@
 #include "servicecore.hpp"
 
 extern DBPod *g_dbPod;
+extern DBService *g_dbService;
 extern NetDriver *g_netDriver;
 extern MonoServer *g_monoServer;
 
@@ -39,66 +42,62 @@ void ServiceCore::net_CM_Login(uint32_t nChannID, uint8_t, const uint8_t *pData,
     };
 
     g_monoServer->addLog(LOGTYPE_INFO, "Login requested: (%s:%s)", stCML.ID, "******");
-    auto queryID = g_dbPod->createQuery("select fld_id from tbl_account where fld_account = '%s' and fld_password = '%s'", stCML.ID, stCML.Password);
 
-    if(!queryID.executeStep()){
-        g_monoServer->addLog(LOGTYPE_INFO, "can't find account: (%s:%s)", stCML.ID, "******");
-        fnLoginFail();
-        return;
-    }
+    AMDBQueryLogin amDBQL;
+    std::memset(&amDBQL, 0, sizeof(amDBQL));
 
-    const int id = queryID.getColumn("fld_id");
-    auto queryDBID = g_dbPod->createQuery("select * from tbl_dbid where fld_id = %d", id);
+    static_assert(sizeof(amDBQL.ID) == sizeof(stCML.ID));
+    static_assert(sizeof(amDBQL.Password) == sizeof(stCML.Password));
 
-    if(!queryDBID.executeStep()){
-        g_monoServer->addLog(LOGTYPE_INFO, "no dbid created for this account: (%s:%s)", stCML.ID, "******");
-        fnLoginFail();
-        return;
-    }
+    std::memcpy(amDBQL.ID, stCML.ID, sizeof(amDBQL.ID));
+    std::memcpy(amDBQL.Password, stCML.Password, sizeof(amDBQL.Password));
 
-    AMLoginQueryDB amLQDBOK;
-    std::memset(&amLQDBOK, 0, sizeof(amLQDBOK));
+    // query by DBService, don't block the service core thread
+    // DBService responds MPK_ERROR if account not found
+    m_actorPod->forward(g_dbService->UID(), {MPK_DBQUERYLOGIN, amDBQL}, [this, nChannID, fnLoginFail](const MessagePack &rstRMPK)
+    {
+        if(rstRMPK.Type() != MPK_LOGINQUERYDB){
+            fnLoginFail();
+            return;
+        }
 
-    const uint32_t nDBID      = queryDBID.getColumn("fld_dbid");
-    const uint32_t nMapID     = DBCOM_MAPID(to_u8cstr((const char *)(queryDBID.getColumn("fld_mapname"))));
-    const int      nMapX      = queryDBID.getColumn("fld_mapx");
-    const int      nMapY      = queryDBID.getColumn("fld_mapy");
-    const int      nDirection = queryDBID.getColumn("fld_direction");
+        const auto amLQDB = rstRMPK.conv<AMLoginQueryDB>();
+        auto pMap = retrieveMap(amLQDB.MapID);
 
-    auto pMap = retrieveMap(nMapID);
-    if(false
-            || !pMap
-            || !pMap->In(nMapID, nMapX, nMapY)){
-        g_monoServer->addLog(LOGTYPE_WARNING, "Invalid db record found: (map, x, y) = (%d, %d, %d)", nMapID, nMapX, nMapY);
+        if(false
+                || !pMap
+                || !pMap->In(amLQDB.MapID, amLQDB.MapX, amLQDB.MapY)){
+            g_monoServer->addLog(LOGTYPE_WARNING, "Invalid db record found: (map, x, y) = (%llu, %d, %d)", to_llu(amLQDB.MapID), amLQDB.MapX, amLQDB.MapY);
 
-        fnLoginFail();
-        return;
-    }
+            fnLoginFail();
+            return;
+        }
 
-    AMAddCharObject amACO;
-    std::memset(&amACO, 0, sizeof(amACO));
+        AMAddCharObject amACO;
+        std::memset(&amACO, 0, sizeof(amACO));
 
-    amACO.type             = UID_PLY;
-    amACO.x                = nMapX;
-    amACO.y                = nMapY;
-    amACO.mapID            = nMapID;
-    amACO.strictLoc        = false;
-    amACO.player.DBID      = nDBID;
-    amACO.player.direction = nDirection;
-    amACO.player.channID   = nChannID;
+        amACO.type             = UID_PLY;
+        amACO.x                = amLQDB.MapX;
+        amACO.y                = amLQDB.MapY;
+        amACO.mapID            = amLQDB.MapID;
+        amACO.strictLoc        = false;
+        amACO.player.DBID      = amLQDB.DBID;
+        amACO.player.direction = amLQDB.Direction;
+        amACO.player.channID   = nChannID;
 
-    m_actorPod->forward(pMap->UID(), {MPK_ADDCHAROBJECT, amACO}, [this, fnLoginFail](const MessagePack &rstRMPK)
-    {
-        switch(rstRMPK.Type()){
-            case MPK_OK:
-                {
-                    break;
-                }
-            default:
-                {
-                    fnLoginFail();
-                    break;
-                }
-        }
+        m_actorPod->forward(pMap->UID(), {MPK_ADDCHAROBJECT, amACO}, [fnLoginFail](const MessagePack &rstRMPK)
+        {
+            switch(rstRMPK.Type()){
+                case MPK_OK:
+                    {
+                        break;
+                    }
+                default:
+                    {
+                        fnLoginFail();
+                        break;
+                    }
+            }
+        });
     });
 }
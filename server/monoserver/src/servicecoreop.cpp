@@ -42,6 +42,7 @@ void ServiceCore::on_MPK_RECVPACKAGE(const MessagePack &mpk)
 
 void ServiceCore::on_MPK_METRONOME(const MessagePack &)
 {
+    setUpdateInterval(1000);
 }
 
 void ServiceCore::on_MPK_ADDCHAROBJECT(const MessagePack &rstMPK)
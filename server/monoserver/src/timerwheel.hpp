@@ -0,0 +1,153 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: timerwheel.hpp
+ *        Created: 10/16/2026 14:02:37
+ *    Description: hierarchical timer wheel for actor wakeups
+ *                 each actor thread owns one, never shared between threads
+ *
+ *                 tick is in msec, 4 levels and 64 slots for each level
+ *                 covers 2^24 msec (~4.6 hours), longer timer gets clamped
+ *
+ *                 no cancel support, receiver should tolerate stale wakeups
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#pragma once
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <concepts>
+
+class TimerWheel final
+{
+    private:
+        constexpr static int m_slotBits   = 6;
+        constexpr static int m_slotCount  = 1 << m_slotBits;
+        constexpr static int m_levelCount = 4;
+
+    private:
+        constexpr static uint64_t m_maxTick = (1ULL << (m_slotBits * m_levelCount)) - 1;
+
+    private:
+        struct TimerEntry
+        {
+            uint64_t uid;
+            uint64_t expire;
+        };
+
+    private:
+        uint64_t m_currTick = 0;
+        size_t   m_size     = 0;
+
+    private:
+        std::array<std::array<std::vector<TimerEntry>, m_slotCount>, m_levelCount> m_wheel;
+
+    public:
+        TimerWheel() = default;
+
+    public:
+        size_t size() const
+        {
+            return m_size;
+        }
+
+        uint64_t currTick() const
+        {
+            return m_currTick;
+        }
+
+    public:
+        void add(uint64_t uid, uint64_t expire)
+        {
+            // expired timer fires at next advance()
+            // don't put it into current slot, which has been flushed already
+
+            expire = std::max<uint64_t>(expire, m_currTick + 1);
+            expire = std::min<uint64_t>(expire, m_currTick + m_maxTick);
+
+            insert({uid, expire});
+            m_size++;
+        }
+
+    public:
+        template<std::invocable<uint64_t> F> size_t advance(uint64_t tick, F f)
+        {
+            if(tick <= m_currTick){
+                return 0;
+            }
+
+            if(m_size == 0){
+                m_currTick = tick;
+                return 0;
+            }
+
+            size_t fired = 0;
+            while(m_currTick < tick){
+                m_currTick++;
+
+                // cascade when lower level wraps
+                // entries in cascaded slot always go to lower levels
+                for(int level = 1; level < m_levelCount; ++level){
+                    if(slotIndex(m_currTick, level - 1)){
+                        break;
+                    }
+
+                    const auto slot = slotIndex(m_currTick, level);
+                    const auto entryList = std::move(m_wheel[level][slot]);
+
+                    m_wheel[level][slot].clear();
+                    for(const auto &entry: entryList){
+                        insert(entry);
+                    }
+                }
+
+                // all entries in current level-0 slot expire exactly at m_currTick
+                // move out first since f() may add new timers
+                if(auto &slotRef = m_wheel[0][slotIndex(m_currTick, 0)]; !slotRef.empty()){
+                    const auto entryList = std::move(slotRef);
+                    slotRef.clear();
+
+                    for(const auto &entry: entryList){
+                        m_size--;
+                        fired++;
+                        f(entry.uid);
+                    }
+                }
+
+                if(m_size == 0){
+                    m_currTick = tick;
+                    break;
+                }
+            }
+            return fired;
+        }
+
+    private:
+        static size_t slotIndex(uint64_t tick, int level)
+        {
+            return (tick >> (m_slotBits * level)) & (m_slotCount - 1);
+        }
+
+        void insert(const TimerEntry &entry)
+        {
+            const auto diff = entry.expire - m_currTick;
+            for(int level = 0; level < m_levelCount; ++level){
+                if(diff < (1ULL << (m_slotBits * (level + 1)))){
+                    m_wheel[level][slotIndex(entry.expire, level)].push_back(entry);
+                    return;
+                }
+            }
+            m_wheel[m_levelCount - 1][slotIndex(entry.expire, m_levelCount - 1)].push_back(entry);
+        }
+};
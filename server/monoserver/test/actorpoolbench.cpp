@@ -0,0 +1,574 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: actorpoolbench.cpp
+ *        Created: 10/17/2026 20:05:31
+ *    Description: message locality, delivery delay and METRONOME timing of ActorPool
+ *
+ *                 synthetic server: map actors, monsters spawned by maps and players
+ *                 attached without a hint, same as ServerMap and ServiceCore do
+ *
+ *                     monster : METRONOME, TRYMOVE to its map at 1/2 of ticks
+ *                     player  : METRONOME, TRYMOVE to its map at every tick
+ *                     map     : TRYMOVE, ACTION to 4 monsters or players of the map
+ *
+ *                 every handler spins for a fixed time, timing is measured from the actors
+ *                 not from ActorPool counters, then works with any version of the pool
+ *
+ *                 cross-bucket ratio is only known by the pool, it's in the report line
+ *                 each actor thread logs every 60s, use --bench-time=60 or longer to get it
+ *
+ *                     $ actorpoolbench [--actor-pool-thread=4] [--disable-actor-affinity]
+ *                                      [--bench-map=8] [--bench-monster=400] [--bench-player=8]
+ *                                      [--bench-warmup=6] [--bench-time=20]
+ *
+ *                 reports per actor thread
+ *
+ *                     handled    : messages handled in the measure window
+ *                     delay      : p50/p99 of post to handler start
+ *                     busy       : handler CPU time / measure window
+ *                     p99/max 10ms busy : handler CPU time share in 10ms windows, shows bursts
+ *
+ *                 and p50/p99/max of METRONOME interval deviation from the tick
+ *
+ *                 then ping/pong pairs run on the same pool, ping sends MPK_PING with a
+ *                 response handler, pong replies MPK_OK, ping sends next one in the handler,
+ *                 no spin in handlers, reports round trips per second per actor thread
+ *
+ *                     $ actorpoolbench [--bench-pingpong-pair=16] [--bench-pingpong-time=5]
+ *
+ *                 to compare with an older pool, build this file against actorpool.cpp and
+ *                 actorpod.cpp of that version, the pool constructor has to match
+ *                 run with --actor-pool-thread=1 to see the sweep without job stealing
+ *
+ *                 not run by ctest, numbers depend on the machine
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#include <deque>
+#include <mutex>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <exception>
+#include "uidf.hpp"
+#include "totype.hpp"
+#include "fflerror.hpp"
+#include "actorpod.hpp"
+#include "actorpool.hpp"
+#include "raiitimer.hpp"
+#include "monoserver.hpp"
+#include "serverargparser.hpp"
+
+ActorPool       *g_actorPool       = nullptr;
+MonoServer      *g_monoServer      = nullptr;
+ServerArgParser *g_serverArgParser = nullptr;
+
+// bench doesn't link monoserver.cpp
+// ActorPool and ActorPod only need logging and exception propagation from MonoServer
+MonoServer::MonoServer()
+    : m_logLock()
+    , m_logBuf()
+    , m_serviceCore(nullptr)
+    , m_currException()
+    , m_hrtimer()
+{}
+
+void MonoServer::addLog(const std::array<std::string, 4> &logDesc, const char *format, ...)
+{
+    va_list ap;
+    va_start(ap, format);
+
+    const std::lock_guard<std::mutex> lockGuard(m_logLock);
+    std::printf("[%s] ", logDesc[0].c_str());
+    std::vprintf(format, ap);
+    std::printf("\n");
+    va_end(ap);
+}
+
+void MonoServer::propagateException() noexcept
+{
+    try{
+        throw;
+    }
+    catch(const std::exception &e){
+        std::fprintf(stderr, "exception in actor thread: %s\n", e.what());
+    }
+    catch(...){
+        std::fprintf(stderr, "exception in actor thread: unknown\n");
+    }
+    std::abort();
+}
+
+struct BenchMsg
+{
+    uint64_t sendTime;
+};
+
+constexpr uint64_t g_busyWindow = 10000000ULL; // nsec
+struct ThreadStat
+{
+    int index = 0;
+
+    uint64_t handleCount    = 0;
+    uint64_t busyTime       = 0;
+    uint64_t roundTripCount = 0;
+
+    std::vector<uint64_t> delayList;
+    std::vector<uint64_t> windowBusyList;
+};
+
+static const hres_timer g_clock;
+static std::atomic<bool> g_record {false};
+static std::atomic<bool> g_recordPing {false};
+static std::atomic<uint64_t> g_recordStart {0};
+
+static std::mutex g_statLock;
+static std::deque<ThreadStat> g_statList;
+
+static std::mutex g_tickLock;
+static std::vector<uint64_t> g_tickDeviationList;
+
+static uint64_t g_tickTime = 100000000ULL; // nsec
+
+static ThreadStat &threadStat()
+{
+    // actor threads are created by ActorPool
+    // register when a thread runs its first handler, index is not the bucket ID
+    thread_local ThreadStat *t_statPtr = nullptr;
+    if(!t_statPtr){
+        const std::lock_guard<std::mutex> lockGuard(g_statLock);
+        t_statPtr = &g_statList.emplace_back();
+        t_statPtr->index = (int)(g_statList.size()) - 1;
+    }
+    return *t_statPtr;
+}
+
+// actor threads can be preempted in a handler if there are more threads than cores
+// CPU time of current thread excludes that, falls back to wall time if not supported
+static uint64_t threadTime()
+{
+#if defined(_WIN32)
+    return g_clock.diff_nsec();
+#else
+    struct timespec ts;
+    if(clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts)){
+        return 0;
+    }
+    return (uint64_t)(ts.tv_sec) * 1000000000ULL + (uint64_t)(ts.tv_nsec);
+#endif
+}
+
+static void spin(uint64_t nsec)
+{
+    const hres_timer timer;
+    while(timer.diff_nsec() < nsec){
+        continue;
+    }
+}
+
+class BenchActor
+{
+    protected:
+        std::unique_ptr<ActorPod> m_actorPod;
+
+    protected:
+        std::minstd_rand m_rng;
+        uint64_t m_lastTick = 0;
+
+    public:
+        BenchActor(uint64_t uid)
+            : m_actorPod(std::make_unique<ActorPod>(uid, nullptr, [this](const MessagePack &mpk){ handle(mpk); }, 0))
+            , m_rng((uint32_t)(uid))
+        {}
+
+        virtual ~BenchActor() = default;
+
+    public:
+        uint64_t UID() const
+        {
+            return m_actorPod->UID();
+        }
+
+        void activate(uint64_t affinityUID)
+        {
+            m_actorPod->attach(nullptr, affinityUID);
+        }
+
+        void deactivate()
+        {
+            // detach waits for a running handler, it may still use m_actorPod
+            m_actorPod->detach(nullptr);
+            m_actorPod.reset();
+        }
+
+    protected:
+        virtual uint64_t operate(const MessagePack &) = 0;
+
+    protected:
+        static BenchMsg buildMsg()
+        {
+            return {g_clock.diff_nsec()};
+        }
+
+    private:
+        void handle(const MessagePack &mpk)
+        {
+            auto &stat = threadStat();
+            const auto startTime = g_clock.diff_nsec();
+            const auto startCPUTime = threadTime();
+            const auto workTime = operate(mpk);
+
+            spin(workTime);
+            const auto lastTick = m_lastTick;
+
+            if(mpk.Type() == MPK_METRONOME){
+                m_lastTick = startTime;
+            }
+
+            if(!g_record.load(std::memory_order_relaxed)){
+                return;
+            }
+
+            const auto cpuTime = threadTime() - startCPUTime;
+            stat.handleCount++;
+            stat.busyTime += cpuTime;
+
+            // handler can start just before g_recordStart gets published
+            if(const auto recordStart = g_recordStart.load(std::memory_order_relaxed); startTime >= recordStart){
+                const auto window = (startTime - recordStart) / g_busyWindow;
+                if(window >= stat.windowBusyList.size()){
+                    stat.windowBusyList.resize(window + 1, 0);
+                }
+                stat.windowBusyList[window] += cpuTime;
+            }
+
+            if(mpk.Type() == MPK_METRONOME){
+                if(lastTick){
+                    const auto interval = startTime - lastTick;
+                    const std::lock_guard<std::mutex> lockGuard(g_tickLock);
+                    g_tickDeviationList.push_back((interval > g_tickTime) ? (interval - g_tickTime) : (g_tickTime - interval));
+                }
+            }
+            else{
+                stat.delayList.push_back(startTime - mpk.conv<BenchMsg>().sendTime);
+            }
+        }
+};
+
+class BenchMap: public BenchActor
+{
+    private:
+        std::vector<uint64_t> m_targetList;
+
+    public:
+        BenchMap(uint32_t mapID)
+            : BenchActor(uidf::buildMapUID(mapID))
+        {}
+
+    public:
+        void addTarget(uint64_t uid)
+        {
+            m_targetList.push_back(uid);
+        }
+
+    protected:
+        uint64_t operate(const MessagePack &mpk) override
+        {
+            if(mpk.Type() == MPK_TRYMOVE && !m_targetList.empty()){
+                std::array<uint64_t, 4> uidList;
+                for(auto &uid: uidList){
+                    uid = m_targetList[m_rng() % m_targetList.size()];
+                }
+                m_actorPod->forward(uidList, {MPK_ACTION, buildMsg()});
+            }
+            return 2000;
+        }
+};
+
+class BenchMonster: public BenchActor
+{
+    private:
+        const uint64_t m_mapUID;
+        const bool     m_isPlayer;
+
+    public:
+        BenchMonster(uint64_t uid, uint64_t mapUID, bool isPlayer)
+            : BenchActor(uid)
+            , m_mapUID(mapUID)
+            , m_isPlayer(isPlayer)
+        {}
+
+    protected:
+        uint64_t operate(const MessagePack &mpk) override
+        {
+            if(mpk.Type() == MPK_METRONOME){
+                if(m_isPlayer || (m_rng() % 2)){
+                    m_actorPod->forward(m_mapUID, {MPK_TRYMOVE, buildMsg()});
+                }
+                return 4000;
+            }
+            return 1000;
+        }
+};
+
+class BenchPing: public BenchActor
+{
+    private:
+        const uint64_t m_peerUID;
+
+    private:
+        bool m_started = false;
+
+    public:
+        BenchPing(uint64_t uid, uint64_t peerUID)
+            : BenchActor(uid)
+            , m_peerUID(peerUID)
+        {}
+
+    protected:
+        uint64_t operate(const MessagePack &mpk) override
+        {
+            // actor can only send in its own handler, first METRONOME starts it
+            if(mpk.Type() == MPK_METRONOME && !m_started){
+                m_started = true;
+                sendPing();
+            }
+            return 0;
+        }
+
+    private:
+        void sendPing()
+        {
+            m_actorPod->forward(m_peerUID, {MPK_PING}, [this](const MessagePack &rmpk)
+            {
+                // pong detached gives MPK_BADACTORPOD, stop there
+                if(rmpk.Type() != MPK_OK){
+                    return;
+                }
+
+                if(g_recordPing.load(std::memory_order_relaxed)){
+                    threadStat().roundTripCount++;
+                }
+                sendPing();
+            });
+        }
+};
+
+class BenchPong: public BenchActor
+{
+    public:
+        BenchPong(uint64_t uid)
+            : BenchActor(uid)
+        {}
+
+    protected:
+        uint64_t operate(const MessagePack &mpk) override
+        {
+            if(mpk.Type() == MPK_PING){
+                m_actorPod->forward(mpk.from(), {MPK_OK}, mpk.ID());
+            }
+            return 0;
+        }
+};
+
+static uint64_t percentile(std::vector<uint64_t> &valList, int percent)
+{
+    if(valList.empty()){
+        return 0;
+    }
+
+    const auto p = valList.begin() + (valList.size() - 1) * percent / 100;
+    std::nth_element(valList.begin(), p, valList.end());
+    return *p;
+}
+
+static int parseInt(const argh::parser &cmdParser, const char *name, int defVal)
+{
+    if(const auto numStr = cmdParser(name).str(); !numStr.empty()){
+        try{
+            return std::max<int>(1, std::stoi(numStr));
+        }
+        catch(...){
+            return defVal;
+        }
+    }
+    return defVal;
+}
+
+int main(int argc, char *argv[])
+{
+    try{
+        const argh::parser cmdParser(argc, argv);
+        const int mapCount     = parseInt(cmdParser, "bench-map"    ,   8);
+        const int monsterCount = parseInt(cmdParser, "bench-monster", 400);
+        const int playerCount  = parseInt(cmdParser, "bench-player" ,   8);
+        const int warmupTime   = parseInt(cmdParser, "bench-warmup" ,   6);
+        const int measureTime  = parseInt(cmdParser, "bench-time"   ,  20);
+        const int pingPairCount = parseInt(cmdParser, "bench-pingpong-pair", 16);
+        const int pingTime      = parseInt(cmdParser, "bench-pingpong-time",  5);
+        const int logicFPS     = 10;
+
+        g_tickTime = 1000000000ULL / logicFPS;
+        g_monoServer = new MonoServer();
+        g_serverArgParser = new ServerArgParser(cmdParser);
+        g_actorPool = new ActorPool(g_serverArgParser->actorPoolThread, logicFPS, !g_serverArgParser->disableActorAffinity);
+        g_actorPool->launchPool();
+
+        std::printf("threads: %d, affinity: %s, maps: %d, monsters: %d, players: %d, warmup: %ds, measure: %ds\n",
+                g_serverArgParser->actorPoolThread,
+                g_serverArgParser->disableActorAffinity ? "off" : "on",
+                mapCount,
+                mapCount * monsterCount,
+                mapCount * playerCount,
+                warmupTime,
+                measureTime);
+
+        // monsters are spawned by their map with a placement hint
+        // players are attached by service core without a hint
+        std::vector<std::unique_ptr<BenchActor>> actorList;
+        for(int mapIndex = 0; mapIndex < mapCount; ++mapIndex){
+            auto mapPtr = new BenchMap(mapIndex + 1);
+            actorList.emplace_back(mapPtr);
+            mapPtr->activate(0);
+
+            for(int i = 0; i < monsterCount; ++i){
+                auto monsterPtr = new BenchMonster(uidf::buildMonsterUID(mapIndex + 1), mapPtr->UID(), false);
+                actorList.emplace_back(monsterPtr);
+
+                mapPtr->addTarget(monsterPtr->UID());
+                monsterPtr->activate(mapPtr->UID());
+            }
+
+            for(int i = 0; i < playerCount; ++i){
+                auto playerPtr = new BenchMonster(uidf::buildPlayerUID(mapIndex * playerCount + i + 1), mapPtr->UID(), true);
+                actorList.emplace_back(playerPtr);
+
+                mapPtr->addTarget(playerPtr->UID());
+                playerPtr->activate(0);
+            }
+        }
+
+        std::this_thread::sleep_for(std::chrono::seconds(warmupTime));
+        g_recordStart = g_clock.diff_nsec();
+        g_record = true;
+
+        const hres_timer measureTimer;
+        std::this_thread::sleep_for(std::chrono::seconds(measureTime));
+
+        g_record = false;
+        const auto measureNS = measureTimer.diff_nsec();
+
+        // detach all before destroying the pool
+        // pool threads are joined in its dtor, stats are not touched after that
+        for(auto &actorPtr: actorList){
+            actorPtr->deactivate();
+        }
+
+        // pairs attached without a hint like players, ping and pong can be in different buckets
+        // one second for all pings to start
+        std::vector<std::unique_ptr<BenchActor>> pingList;
+        std::vector<std::unique_ptr<BenchActor>> pongList;
+
+        for(int i = 0; i < pingPairCount; ++i){
+            auto pongPtr = new BenchPong(uidf::buildMonsterUID(mapCount + 1));
+            auto pingPtr = new BenchPing(uidf::buildMonsterUID(mapCount + 1), pongPtr->UID());
+
+            pongList.emplace_back(pongPtr);
+            pingList.emplace_back(pingPtr);
+
+            pongPtr->activate(0);
+            pingPtr->activate(0);
+        }
+
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        g_recordPing = true;
+
+        const hres_timer pingTimer;
+        std::this_thread::sleep_for(std::chrono::seconds(pingTime));
+
+        g_recordPing = false;
+        const auto pingNS = pingTimer.diff_nsec();
+
+        // ping first, then a pong doesn't reply to a detached ping
+        for(auto actorListPtr: {&pingList, &pongList}){
+            for(auto &actorPtr: *actorListPtr){
+                actorPtr->deactivate();
+            }
+        }
+
+        delete g_actorPool;
+        g_actorPool = nullptr;
+
+        std::printf("%6s %10s %12s %12s %8s %14s %14s\n", "thread", "handled", "p50 delay", "p99 delay", "busy", "p99 10ms busy", "max 10ms busy");
+
+        std::vector<uint64_t> totalDelayList;
+        for(auto &stat: g_statList){
+            if(!stat.handleCount){
+                continue;
+            }
+
+            // windows without any handler count as idle
+            stat.windowBusyList.resize(measureNS / g_busyWindow, 0);
+            const auto maxWindowBusy = stat.windowBusyList.empty() ? 0 : *std::max_element(stat.windowBusyList.begin(), stat.windowBusyList.end());
+
+            totalDelayList.insert(totalDelayList.end(), stat.delayList.begin(), stat.delayList.end());
+            std::printf("%6d %10llu %10.1fus %10.1fus %7.2f%% %13.2f%% %13.2f%%\n",
+                    stat.index,
+                    to_llu(stat.handleCount),
+                    percentile(stat.delayList, 50) / 1000.0,
+                    percentile(stat.delayList, 99) / 1000.0,
+                    100.0 * stat.busyTime / measureNS,
+                    100.0 * percentile(stat.windowBusyList, 99) / g_busyWindow,
+                    100.0 * maxWindowBusy / g_busyWindow);
+        }
+
+        std::printf("%6s %10s %10.1fus %10.1fus\n",
+                "all",
+                "",
+                percentile(totalDelayList, 50) / 1000.0,
+                percentile(totalDelayList, 99) / 1000.0);
+
+        const auto maxDeviation = g_tickDeviationList.empty() ? 0 : *std::max_element(g_tickDeviationList.begin(), g_tickDeviationList.end());
+        std::printf("METRONOME interval deviation: p50 %.1fus, p99 %.1fus, max %.1fus, %zu intervals\n",
+                percentile(g_tickDeviationList, 50) / 1000.0,
+                percentile(g_tickDeviationList, 99) / 1000.0,
+                maxDeviation / 1000.0,
+                g_tickDeviationList.size());
+
+        std::printf("ping/pong pairs: %d, measure: %ds\n", pingPairCount, pingTime);
+        std::printf("%6s %14s\n", "thread", "round trip/s");
+
+        uint64_t totalRoundTrip = 0;
+        for(const auto &stat: g_statList){
+            if(stat.roundTripCount){
+                totalRoundTrip += stat.roundTripCount;
+                std::printf("%6d %14.0f\n", stat.index, 1000000000.0 * stat.roundTripCount / pingNS);
+            }
+        }
+        std::printf("%6s %14.0f\n", "all", 1000000000.0 * totalRoundTrip / pingNS);
+    }
+    catch(const std::exception &e){
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
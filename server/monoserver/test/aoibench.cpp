@@ -0,0 +1,266 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: aoibench.cpp
+ *        Created: 10/17/2026 21:40:12
+ *    Description: actions per second of ServerMap fan-out, cell scan vs AOI region index
+ *
+ *                 N movers on one map, each action moves one mover a step and collects the
+ *                 UIDs within the broadcast radius, same as on_MPK_ACTION does
+ *
+ *                     cell : doCircle() + doUIDList() over one UID list per cell, the way
+ *                            ServerMap kept cells before the AOI index
+ *                     aoi  : sparse cell UID table plus region entry lists, updated and
+ *                            queried as addGridUID() / removeGridUID() / doCircleUID()
+ *
+ *                 both paths see the same moves and must collect the same receivers
+ *
+ *                     $ aoibench [map size] [radius]
+ *
+ *                 not run by ctest, numbers depend on the machine
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#include <vector>
+#include <random>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <unordered_map>
+#include "mathf.hpp"
+#include "totype.hpp"
+#include "fflerror.hpp"
+#include "raiitimer.hpp"
+
+struct Mover
+{
+    uint64_t uid;
+    int x;
+    int y;
+};
+
+class CellMap
+{
+    private:
+        const int m_w;
+        const int m_h;
+
+    private:
+        std::vector<std::vector<uint64_t>> m_cellList;
+
+    public:
+        CellMap(int w, int h)
+            : m_w(w)
+            , m_h(h)
+            , m_cellList((size_t)(w) * h)
+        {}
+
+    public:
+        void add(uint64_t uid, int x, int y)
+        {
+            m_cellList[x + y * m_w].push_back(uid);
+        }
+
+        void remove(uint64_t uid, int x, int y)
+        {
+            auto &uidList = m_cellList[x + y * m_w];
+            if(auto p = std::find(uidList.begin(), uidList.end(), uid); p != uidList.end()){
+                std::swap(*p, uidList.back());
+                uidList.pop_back();
+            }
+        }
+
+        void collect(int cx0, int cy0, int r, std::vector<uint64_t> &uidList) const
+        {
+            int doW = 2 * r - 1;
+            int doH = 2 * r - 1;
+
+            int x0 = cx0 - r + 1;
+            int y0 = cy0 - r + 1;
+
+            if(mathf::rectangleOverlapRegion(0, 0, m_w, m_h, &x0, &y0, &doW, &doH)){
+                for(int x = x0; x < x0 + doW; ++x){
+                    for(int y = y0; y < y0 + doH; ++y){
+                        if(mathf::LDistance2(x, y, cx0, cy0) <= (r - 1) * (r - 1)){
+                            for(const auto uid: m_cellList[x + y * m_w]){
+                                uidList.push_back(uid);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+};
+
+class AOIMap
+{
+    private:
+        struct AOIEntry
+        {
+            uint64_t uid;
+            int x;
+            int y;
+        };
+
+    private:
+        constexpr static int m_regionSize = 20;
+
+    private:
+        const int m_w;
+        const int m_h;
+        const int m_regionW;
+        const int m_regionH;
+
+    private:
+        std::unordered_map<int, std::vector<uint64_t>> m_cellUIDList;
+        std::vector<std::vector<AOIEntry>> m_regionList;
+
+    public:
+        AOIMap(int w, int h)
+            : m_w(w)
+            , m_h(h)
+            , m_regionW((w + m_regionSize - 1) / m_regionSize)
+            , m_regionH((h + m_regionSize - 1) / m_regionSize)
+            , m_regionList((size_t)(m_regionW) * m_regionH)
+        {}
+
+    private:
+        auto &getRegion(int x, int y)
+        {
+            return m_regionList[x / m_regionSize + (y / m_regionSize) * m_regionW];
+        }
+
+    public:
+        void add(uint64_t uid, int x, int y)
+        {
+            m_cellUIDList[x + y * m_w].push_back(uid);
+            getRegion(x, y).push_back({uid, x, y});
+        }
+
+        void remove(uint64_t uid, int x, int y)
+        {
+            auto uidListIter = m_cellUIDList.find(x + y * m_w);
+            if(uidListIter == m_cellUIDList.end()){
+                return;
+            }
+
+            auto &uidList = uidListIter->second;
+            if(auto p = std::find(uidList.begin(), uidList.end(), uid); p != uidList.end()){
+                std::swap(*p, uidList.back());
+                uidList.pop_back();
+            }
+
+            if(uidList.empty()){
+                m_cellUIDList.erase(uidListIter);
+            }
+
+            auto &entryList = getRegion(x, y);
+            if(auto q = std::find_if(entryList.begin(), entryList.end(), [uid, x, y](const auto &entry){ return entry.uid == uid && entry.x == x && entry.y == y; }); q != entryList.end()){
+                std::swap(*q, entryList.back());
+                entryList.pop_back();
+            }
+        }
+
+        void collect(int cx0, int cy0, int r, std::vector<uint64_t> &uidList) const
+        {
+            int doW = 2 * r - 1;
+            int doH = 2 * r - 1;
+
+            int x0 = cx0 - r + 1;
+            int y0 = cy0 - r + 1;
+
+            if(mathf::rectangleOverlapRegion(0, 0, m_w, m_h, &x0, &y0, &doW, &doH)){
+                const int rx0 = x0 / m_regionSize;
+                const int ry0 = y0 / m_regionSize;
+                const int rx1 = (x0 + doW - 1) / m_regionSize;
+                const int ry1 = (y0 + doH - 1) / m_regionSize;
+
+                for(int ry = ry0; ry <= ry1; ++ry){
+                    for(int rx = rx0; rx <= rx1; ++rx){
+                        for(const auto &entry: m_regionList[rx + ry * m_regionW]){
+                            if(mathf::LDistance2(entry.x, entry.y, cx0, cy0) <= (r - 1) * (r - 1)){
+                                uidList.push_back(entry.uid);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+};
+
+// returns actions per second and total receivers
+// same seed gives the same moves for both maps
+template<typename Map> static std::pair<double, uint64_t> runBench(int mapSize, int radius, int moverCount, int actionCount)
+{
+    Map map(mapSize, mapSize);
+    std::minstd_rand rng(moverCount);
+    std::vector<Mover> moverList;
+
+    for(int i = 0; i < moverCount; ++i){
+        moverList.push_back({(uint64_t)(i + 1), (int)(rng() % mapSize), (int)(rng() % mapSize)});
+        map.add(moverList.back().uid, moverList.back().x, moverList.back().y);
+    }
+
+    uint64_t receiverCount = 0;
+    std::vector<uint64_t> uidList;
+    const hres_timer timer;
+
+    for(int i = 0; i < actionCount; ++i){
+        auto &mover = moverList[rng() % moverList.size()];
+        const int dstX = std::clamp<int>(mover.x + (int)(rng() % 3) - 1, 0, mapSize - 1);
+        const int dstY = std::clamp<int>(mover.y + (int)(rng() % 3) - 1, 0, mapSize - 1);
+
+        map.remove(mover.uid, mover.x, mover.y);
+        map.add(mover.uid, dstX, dstY);
+
+        mover.x = dstX;
+        mover.y = dstY;
+
+        uidList.clear();
+        map.collect(mover.x, mover.y, radius, uidList);
+        receiverCount += uidList.size();
+    }
+    return {actionCount * 1000000000.0 / timer.diff_nsec(), receiverCount};
+}
+
+int main(int argc, char *argv[])
+{
+    const int mapSize = (argc > 1) ? std::atoi(argv[1]) : 300;
+    const int radius  = (argc > 2) ? std::atoi(argv[2]) : 10;
+
+    if(mapSize < 1 || radius < 1 || radius > 20){
+        std::fprintf(stderr, "usage: aoibench [map size] [radius <= 20]\n");
+        return 1;
+    }
+
+    try{
+        constexpr int actionCount = 200000;
+        std::printf("map: %d x %d, radius: %d, actions: %d\n", mapSize, mapSize, radius, actionCount);
+        std::printf("%8s %14s %14s %8s %14s\n", "movers", "cell (act/s)", "aoi (act/s)", "ratio", "receiver/act");
+
+        for(const int moverCount: {1, 100, 1000, 5000, 20000}){
+            const auto [cellRate, cellReceiver] = runBench<CellMap>(mapSize, radius, moverCount, actionCount);
+            const auto [ aoiRate,  aoiReceiver] = runBench< AOIMap>(mapSize, radius, moverCount, actionCount);
+
+            if(cellReceiver != aoiReceiver){
+                throw fflerror("receiver mismatch: cell %llu, aoi %llu", to_llu(cellReceiver), to_llu(aoiReceiver));
+            }
+            std::printf("%8d %14.0f %14.0f %8.2f %14.2f\n", moverCount, cellRate, aoiRate, aoiRate / cellRate, 1.0 * aoiReceiver / actionCount);
+        }
+    }
+    catch(const std::exception &e){
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
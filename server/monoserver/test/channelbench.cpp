@@ -0,0 +1,293 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: channelbench.cpp
+ *        Created: 10/17/2026 22:31:47
+ *    Description: packets per second and writes per packet of Channel over loopback
+ *
+ *                 one Channel on an accepted loopback socket, a thread drains the client
+ *                 side, the main thread posts SM_ACTION in bursts like an actor thread does
+ *                 per tick, at most --bench-inflight bursts are not sent yet
+ *
+ *                 every burst size runs twice, --channel-gather-size=0 sends one pack per
+ *                 async_write as before gather mode, then with the configured gather size
+ *
+ *                     $ channelbench [--channel-gather-size=65536] [--bench-pack=1000000]
+ *                                    [--bench-inflight=64]
+ *
+ *                 reports per run
+ *
+ *                     pack/s : packs posted / time till the last done callback
+ *                     write  : async_write issued by Channel::DoSendPack() per pack, one async_write
+ *                              is one sendmsg() unless the socket buffer is full
+ *
+ *                 not run by ctest, numbers depend on the machine
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#include <array>
+#include <atomic>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <cstdio>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <asio.hpp>
+#include "strf.hpp"
+#include "totype.hpp"
+#include "channel.hpp"
+#include "fflerror.hpp"
+#include "raiitimer.hpp"
+#include "netdriver.hpp"
+#include "servermsg.hpp"
+#include "dispatcher.hpp"
+#include "monoserver.hpp"
+#include "serverargparser.hpp"
+
+NetDriver       *g_netDriver       = nullptr;
+MonoServer      *g_monoServer      = nullptr;
+ServerArgParser *g_serverArgParser = nullptr;
+
+static std::atomic<bool> g_closing {false};
+
+// bench doesn't link netdriver.cpp, dispatcher.cpp and monoserver.cpp
+// Channel only recycles its ID, reports MPK_BADCHANNEL at close and logs
+NetDriver::NetDriver()
+    : Dispatcher()
+    , m_port(0)
+    , m_IO(nullptr)
+    , m_endPoint(nullptr)
+    , m_acceptor(nullptr)
+    , m_socket(nullptr)
+    , m_thread()
+    , m_serviceCoreUID(0)
+    , m_channIDQ()
+    , m_channelList()
+{}
+
+NetDriver::~NetDriver()
+{}
+
+bool Dispatcher::forward(uint64_t, const MessageBuf &, uint32_t)
+{
+    return true;
+}
+
+MonoServer::MonoServer()
+    : m_logLock()
+    , m_logBuf()
+    , m_serviceCore(nullptr)
+    , m_currException()
+    , m_hrtimer()
+{}
+
+void MonoServer::addLog(const std::array<std::string, 4> &logDesc, const char *format, ...)
+{
+    // channel close stats are logged at debug level, bench prints its own
+    if(g_closing || logDesc[0] == std::to_string(Log::LOGTYPEV_DEBUG)){
+        return;
+    }
+
+    va_list ap;
+    va_start(ap, format);
+
+    const std::lock_guard<std::mutex> lockGuard(m_logLock);
+    std::printf("[%s] ", logDesc[0].c_str());
+    std::vprintf(format, ap);
+    std::printf("\n");
+    va_end(ap);
+}
+
+void MonoServer::propagateException() noexcept
+{
+    try{
+        throw;
+    }
+    catch(const std::exception &e){
+        std::fprintf(stderr, "exception: %s\n", e.what());
+    }
+    catch(...){
+        std::fprintf(stderr, "exception: unknown\n");
+    }
+    std::abort();
+}
+
+struct BenchResult
+{
+    double   packRate   = 0.0;
+    uint64_t packCount  = 0;
+    uint64_t callCount  = 0;
+};
+
+static BenchResult runBench(asio::io_service &io, int burst, int packCount, int maxInflight)
+{
+    asio::ip::tcp::acceptor acceptor(io, asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), 0));
+    asio::ip::tcp::socket client(io);
+    asio::ip::tcp::socket server(io);
+
+    client.connect(acceptor.local_endpoint());
+    acceptor.accept(server);
+
+    // client drains everything till channel closes the socket
+    std::thread reader([&client]()
+    {
+        asio::error_code ec;
+        std::array<uint8_t, 64 * 1024> buf;
+
+        while(true){
+            client.read_some(asio::buffer(buf), ec);
+            if(ec){
+                return;
+            }
+        }
+    });
+
+    auto channPtr = std::make_shared<Channel>(1, std::move(server));
+    if(!channPtr->Launch(1)){
+        throw fflerror("failed to launch channel");
+    }
+
+    SMAction smA;
+    std::memset(&smA, 0, sizeof(smA));
+
+    smA.UID   = 1;
+    smA.MapID = 1;
+
+    std::atomic<int> doneBurst {0};
+    const std::function<void()> fnDone = [&doneBurst]()
+    {
+        doneBurst++;
+    };
+
+    const hres_timer timer;
+
+    int postBurst = 0;
+    for(int i = 0; i < packCount; i += burst, ++postBurst){
+        while(postBurst - doneBurst.load() >= maxInflight){
+            std::this_thread::yield();
+        }
+
+        for(int j = 0; j < burst; ++j){
+            smA.action.x = (uint16_t)(i + j);
+            smA.action.y = (uint16_t)((i + j) / 7);
+            if(!channPtr->Post(SM_ACTION, smA, (j + 1 == burst) ? fnDone : std::function<void()>())){
+                throw fflerror("failed to post pack");
+            }
+        }
+    }
+
+    while(doneBurst.load() < postBurst){
+        std::this_thread::yield();
+    }
+
+    BenchResult result;
+    result.packRate = 1000000000.0 * postBurst * burst / timer.diff_nsec();
+
+    // counters are only touched in asio main loop
+    std::promise<void> done;
+    io.post([&result, &done, channPtr]()
+    {
+        result.packCount = channPtr->sendPackCount();
+        result.callCount = channPtr->sendCallCount();
+
+        // pending read gets canceled and logs a network error
+        g_closing = true;
+        channPtr->Shutdown(true);
+        done.set_value();
+    });
+
+    done.get_future().wait();
+    reader.join();
+
+    // last reference can be held by a handler still queued in asio main loop
+    // wait for it then channel is destroyed before next run
+    std::promise<void> drained;
+    channPtr.reset();
+
+    io.post([&drained]()
+    {
+        drained.set_value();
+    });
+
+    drained.get_future().wait();
+    g_closing = false;
+    return result;
+}
+
+static int parseInt(const argh::parser &cmdParser, const char *name, int defVal)
+{
+    if(const auto numStr = cmdParser(name).str(); !numStr.empty()){
+        try{
+            return std::max<int>(1, std::stoi(numStr));
+        }
+        catch(...){
+            return defVal;
+        }
+    }
+    return defVal;
+}
+
+int main(int argc, char *argv[])
+{
+    try{
+        const argh::parser cmdParser(argc, argv);
+        const int packCount   = parseInt(cmdParser, "bench-pack"    , 1000000);
+        const int maxInflight = parseInt(cmdParser, "bench-inflight",      64);
+
+        // no high-water mark, inflight bursts already bound the pending bytes
+        // --channel-gather-size of command line only decides the gather size of second run
+        const auto gatherSizeArg = str_printf("--channel-gather-size=%d", ServerArgParser(cmdParser).channelGatherSize);
+        const char *gatherArgv[] = {"channelbench", gatherSizeArg.c_str(), "--channel-send-hwm=0"};
+        const char *noGatherArgv[] = {"channelbench", "--channel-gather-size=0", "--channel-send-hwm=0"};
+
+        const ServerArgParser gatherArgParser(argh::parser(3, gatherArgv));
+        const ServerArgParser noGatherArgParser(argh::parser(3, noGatherArgv));
+
+        g_monoServer = new MonoServer();
+        g_netDriver = new NetDriver();
+
+        asio::io_service io;
+        asio::io_service::work work(io);
+        std::thread ioThread([&io]()
+        {
+            io.run();
+        });
+
+        std::printf("packs: %d, pack size: %zu, inflight bursts: %d, gather size: %d\n", packCount, sizeof(SMAction), maxInflight, gatherArgParser.channelGatherSize);
+        std::printf("%6s %8s %12s %10s\n", "burst", "gather", "pack/s", "write");
+
+        for(const int burst: {1, 8, 32, 128}){
+            for(auto argParserPtr: {&noGatherArgParser, &gatherArgParser}){
+                g_serverArgParser = const_cast<ServerArgParser *>(argParserPtr);
+                const auto result = runBench(io, burst, packCount, maxInflight);
+                std::printf("%6d %8d %12.0f %10.4f\n",
+                        burst,
+                        argParserPtr->channelGatherSize,
+                        result.packRate,
+                        1.0 * result.callCount / std::max<uint64_t>(1, result.packCount));
+            }
+        }
+
+        io.stop();
+        ioThread.join();
+    }
+    catch(const std::exception &e){
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
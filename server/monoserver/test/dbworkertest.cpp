@@ -0,0 +1,457 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: dbworkertest.cpp
+ *        Created: 10/17/2026 15:02:11
+ *    Description: stress test of DBWorker
+ *
+ *                 multiple producer threads post concurrent saves, loads and bad requests
+ *                 then check
+ *
+ *                     1. every row in DB holds the last value posted for every field
+ *                     2. every request gets exactly one response
+ *                     3. commits are no more than number of flush windows elapsed
+ *                     4. requests posted before stop() are all drained
+ *
+ *                 and with the DB locked by another connection
+ *
+ *                     5. failed saves are kept and written after the lock is gone
+ *                     6. saves still failing at stop() get MPK_ERROR, never MPK_OK
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#include <mutex>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <condition_variable>
+#include "strf.hpp"
+#include "totype.hpp"
+#include "fflerror.hpp"
+#include "dbworker.hpp"
+
+#define CHECK(expr) do{ if(!(expr)){ throw fflerror("check failed: %s", #expr); } }while(0)
+
+// same wait/pop semantics as Receiver
+// Receiver can't be used here since it attaches to g_actorPool
+class TestSource final
+{
+    private:
+        std::mutex m_lock;
+        std::condition_variable m_condition;
+
+    private:
+        std::vector<MessagePack> m_messageList;
+
+    public:
+        void push(MessagePack mpk)
+        {
+            std::lock_guard<std::mutex> lockGuard(m_lock);
+            m_messageList.push_back(std::move(mpk));
+            m_condition.notify_all();
+        }
+
+        size_t wait(uint32_t timeout)
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_condition.wait_for(lock, std::chrono::milliseconds(timeout), [this, origLen = m_messageList.size()]() -> bool
+            {
+                return m_messageList.size() > origLen;
+            });
+            return m_messageList.size();
+        }
+
+        std::vector<MessagePack> pop()
+        {
+            std::vector<MessagePack> mpkList;
+            {
+                std::lock_guard<std::mutex> lockGuard(m_lock);
+                std::swap(mpkList, m_messageList);
+            }
+            return mpkList;
+        }
+};
+
+constexpr int g_producerCount = 8;
+constexpr int g_playerPerProducer = 16;
+constexpr int g_requestPerProducer = 4000;
+
+static std::string createDB()
+{
+    const auto dbName = (std::filesystem::temp_directory_path() / str_printf("dbworkertest.%llu.db3", to_llu(std::chrono::steady_clock::now().time_since_epoch().count()))).string();
+    SQLite::Database db(dbName, SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE);
+
+    db.exec("create table tbl_dbid(fld_dbid integer primary key, fld_id integer, fld_name text, fld_mapname text, fld_mapx integer, fld_mapy integer, fld_exp integer, fld_gold integer, fld_level integer, fld_jobid integer, fld_direction integer)");
+    for(int dbid = 1; dbid <= g_producerCount * g_playerPerProducer; ++dbid){
+        db.exec(str_printf("insert into tbl_dbid values(%d, %d, 'player_%d', 'map', 0, 0, 0, 0, 0, 0, 0)", dbid, dbid, dbid));
+    }
+    return dbName;
+}
+
+static void testMergeSave()
+{
+    AMDBSavePlayer dst;
+    std::memset(&dst, 0, sizeof(dst));
+
+    DBWorker::mergeSave(dst, AMDBSavePlayer{7, DBSPF_GOLD | DBSPF_EXP, 1, 2, 3});
+    DBWorker::mergeSave(dst, AMDBSavePlayer{7, DBSPF_LEVEL, 10, 20, 30});
+    DBWorker::mergeSave(dst, AMDBSavePlayer{7, DBSPF_GOLD, 100, 200, 300});
+
+    CHECK(dst.DBID  == 7);
+    CHECK(dst.dirty == (DBSPF_EXP | DBSPF_GOLD | DBSPF_LEVEL));
+    CHECK(dst.exp   == 1);
+    CHECK(dst.gold  == 200);
+    CHECK(dst.level == 30);
+
+    bool caught = false;
+    try{
+        DBWorker::mergeSave(dst, AMDBSavePlayer{8, DBSPF_GOLD, 0, 0, 0});
+    }
+    catch(const std::exception &){
+        caught = true;
+    }
+    CHECK(caught);
+}
+
+static void testStress()
+{
+    const auto dbName = createDB();
+    TestSource source;
+
+    std::atomic<uint64_t> okCount {0};
+    std::atomic<uint64_t> errorCount {0};
+    std::atomic<uint64_t> loadCount {0};
+    std::atomic<uint64_t> badLoadCount {0};
+    std::atomic<uint64_t> warningCount {0};
+
+    DBWorker worker
+    {
+        {
+            [&source](uint32_t timeout) -> size_t
+            {
+                return source.wait(timeout);
+            },
+
+            [&source]() -> std::vector<MessagePack>
+            {
+                return source.pop();
+            },
+        },
+
+        [&](const MessagePack &mpk, const MessageBuf &mb)
+        {
+            switch(mb.Type()){
+                case MPK_OK:
+                    {
+                        okCount++;
+                        break;
+                    }
+                case MPK_ERROR:
+                    {
+                        errorCount++;
+                        break;
+                    }
+                case MPK_DBPLAYERDATA:
+                    {
+                        AMDBPlayerData amDBPD;
+                        CHECK(mb.DataLen() == sizeof(amDBPD));
+                        std::memcpy(&amDBPD, mb.Data(), sizeof(amDBPD));
+
+                        const auto dbid = mpk.conv<AMDBLoadPlayer>().DBID;
+                        if(amDBPD.DBID != dbid || std::string(amDBPD.name) != str_printf("player_%llu", to_llu(dbid))){
+                            badLoadCount++;
+                        }
+                        loadCount++;
+                        break;
+                    }
+                default:
+                    {
+                        throw fflerror("unexpected response: %s", mpkName(mb.Type()));
+                    }
+            }
+        },
+
+        [&warningCount](bool warning, const std::string &)
+        {
+            if(warning){
+                warningCount++;
+            }
+        },
+    };
+
+    const auto startTime = std::chrono::steady_clock::now();
+    worker.launch(dbName.c_str(), [](){ std::fprintf(stderr, "DBWorker exits by exception\n"); std::abort(); });
+
+    // expected last value of every field, indexed by dbid
+    // each player is owned by one producer, no race on last value
+    std::vector<std::array<uint32_t, 3>> expected(g_producerCount * g_playerPerProducer + 1, {0, 0, 0});
+
+    std::atomic<uint64_t> saveCount {0};
+    std::atomic<uint64_t> queryCount {0};
+    std::atomic<uint64_t> badCount {0};
+
+    std::vector<std::thread> producerList;
+    for(int producer = 0; producer < g_producerCount; ++producer){
+        producerList.emplace_back([producer, &source, &expected, &saveCount, &queryCount, &badCount]()
+        {
+            std::minstd_rand rng(producer + 1);
+            for(int i = 0; i < g_requestPerProducer; ++i){
+                const uint32_t dbid = producer * g_playerPerProducer + (rng() % g_playerPerProducer) + 1;
+                const uint64_t from = producer + 1;
+                const uint32_t seq  = i + 1;
+
+                switch(rng() % 16){
+                    case 0:
+                        {
+                            source.push(MessagePack(MessageBuf(MPK_DBLOADPLAYER, AMDBLoadPlayer{dbid}), from, seq));
+                            queryCount++;
+                            break;
+                        }
+                    case 1:
+                        {
+                            // unsupported message gets MPK_ERROR without breaking the window
+                            source.push(MessagePack(MessageBuf(MPK_METRONOME), from, seq));
+                            badCount++;
+                            break;
+                        }
+                    default:
+                        {
+                            AMDBSavePlayer amDBSP;
+                            std::memset(&amDBSP, 0, sizeof(amDBSP));
+
+                            amDBSP.DBID  = dbid;
+                            amDBSP.dirty = (rng() % 7) + 1;
+                            amDBSP.exp   = seq * 10 + 1;
+                            amDBSP.gold  = seq * 10 + 2;
+                            amDBSP.level = seq * 10 + 3;
+
+                            if(amDBSP.dirty & DBSPF_EXP  ){ expected[dbid][0] = amDBSP.exp  ; }
+                            if(amDBSP.dirty & DBSPF_GOLD ){ expected[dbid][1] = amDBSP.gold ; }
+                            if(amDBSP.dirty & DBSPF_LEVEL){ expected[dbid][2] = amDBSP.level; }
+
+                            // fire-and-forget saves get no response
+                            if(rng() % 4){
+                                source.push(MessagePack(MessageBuf(MPK_DBSAVEPLAYER, amDBSP), from, seq));
+                                saveCount++;
+                            }
+                            else{
+                                source.push(MessagePack(MessageBuf(MPK_DBSAVEPLAYER, amDBSP)));
+                            }
+                            break;
+                        }
+                }
+
+                // spread requests over multiple flush windows
+                if(rng() % 64 == 0){
+                    std::this_thread::sleep_for(std::chrono::microseconds(rng() % 4000));
+                }
+            }
+        });
+    }
+
+    for(auto &producer: producerList){
+        producer.join();
+    }
+
+    // stop() is called right after producers are done
+    // requests still pending in source must be drained, not dropped
+    worker.stop();
+    const auto elapsedMS = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+
+    const uint64_t totalCount = to_llu(g_producerCount) * g_requestPerProducer;
+    std::printf("requests: %llu, commits: %llu, statements: %llu, elapsed: %llu ms\n", to_llu(worker.requestCount()), to_llu(worker.commitCount()), to_llu(worker.statementCount()), to_llu(elapsedMS));
+
+    CHECK(worker.requestCount() == totalCount);
+    CHECK(okCount == saveCount);
+    CHECK(errorCount == badCount);
+    CHECK(loadCount == queryCount);
+    CHECK(badLoadCount == 0);
+    CHECK(warningCount == badCount);
+
+    // two flushes are at least one window apart
+    // one extra for the drain at exit
+    CHECK(worker.commitCount() >= 1);
+    CHECK(worker.commitCount() <= to_llu(elapsedMS) / DBWorker::m_flushWindow + 2);
+
+    SQLite::Database db(dbName, SQLite::OPEN_READONLY);
+    SQLite::Statement query(db, "select fld_dbid, fld_exp, fld_gold, fld_level from tbl_dbid");
+
+    int rowCount = 0;
+    while(query.executeStep()){
+        const uint32_t dbid = query.getColumn(0).getUInt();
+        CHECK(dbid < expected.size());
+
+        CHECK(query.getColumn(1).getUInt() == expected[dbid][0]);
+        CHECK(query.getColumn(2).getUInt() == expected[dbid][1]);
+        CHECK(query.getColumn(3).getUInt() == expected[dbid][2]);
+        rowCount++;
+    }
+    CHECK(rowCount == g_producerCount * g_playerPerProducer);
+    std::filesystem::remove(dbName);
+}
+
+static AMDBSavePlayer buildSave(uint32_t dbid, uint32_t dirty, uint32_t value)
+{
+    AMDBSavePlayer amDBSP;
+    std::memset(&amDBSP, 0, sizeof(amDBSP));
+
+    amDBSP.DBID  = dbid;
+    amDBSP.dirty = dirty;
+    amDBSP.exp   = value + 1;
+    amDBSP.gold  = value + 2;
+    amDBSP.level = value + 3;
+    return amDBSP;
+}
+
+// worker with a response counter
+// DB gets locked by the test, every failed flush waits the busy timeout
+class RetryWorker final
+{
+    public:
+        TestSource source;
+
+    public:
+        std::atomic<uint64_t> okCount {0};
+        std::atomic<uint64_t> errorCount {0};
+        std::atomic<uint64_t> warningCount {0};
+
+    public:
+        DBWorker worker
+        {
+            {
+                [this](uint32_t timeout) -> size_t
+                {
+                    return source.wait(timeout);
+                },
+
+                [this]() -> std::vector<MessagePack>
+                {
+                    return source.pop();
+                },
+            },
+
+            [this](const MessagePack &, const MessageBuf &mb)
+            {
+                CHECK(mb.Type() == MPK_OK || mb.Type() == MPK_ERROR);
+                (mb.Type() == MPK_OK) ? okCount++ : errorCount++;
+            },
+
+            [this](bool warning, const std::string &)
+            {
+                if(warning){
+                    warningCount++;
+                }
+            },
+        };
+
+    public:
+        void waitRetry() const
+        {
+            const auto startTime = std::chrono::steady_clock::now();
+            while(!worker.retryCount()){
+                CHECK(std::chrono::steady_clock::now() - startTime < std::chrono::seconds(20));
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+};
+
+static void testRetry()
+{
+    const auto dbName = createDB();
+    RetryWorker rw;
+    rw.worker.launch(dbName.c_str(), [](){ std::fprintf(stderr, "DBWorker exits by exception\n"); std::abort(); });
+
+    SQLite::Database lockDB(dbName, SQLite::OPEN_READWRITE);
+    lockDB.exec("begin exclusive");
+
+    for(uint32_t dbid = 1; dbid <= 4; ++dbid){
+        rw.source.push(MessagePack(MessageBuf(MPK_DBSAVEPLAYER, buildSave(dbid, DBSPF_GOLD | DBSPF_LEVEL, dbid * 100)), dbid, 1));
+    }
+
+    rw.waitRetry();
+    CHECK(rw.okCount == 0);
+    CHECK(rw.errorCount == 0);
+
+    // merged into the kept save of the same player
+    rw.source.push(MessagePack(MessageBuf(MPK_DBSAVEPLAYER, buildSave(1, DBSPF_EXP | DBSPF_GOLD, 1000)), 1, 2));
+    lockDB.exec("rollback");
+
+    const auto startTime = std::chrono::steady_clock::now();
+    while(rw.okCount < 5){
+        CHECK(std::chrono::steady_clock::now() - startTime < std::chrono::seconds(20));
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    rw.worker.stop();
+    CHECK(rw.okCount == 5);
+    CHECK(rw.errorCount == 0);
+
+    SQLite::Statement query(lockDB, "select fld_dbid, fld_exp, fld_gold, fld_level from tbl_dbid where fld_dbid <= 4");
+    while(query.executeStep()){
+        const uint32_t dbid = query.getColumn(0).getUInt();
+        CHECK(query.getColumn(1).getUInt() == ((dbid == 1) ? 1001 : 0));
+        CHECK(query.getColumn(2).getUInt() == ((dbid == 1) ? 1002 : dbid * 100 + 2));
+        CHECK(query.getColumn(3).getUInt() == dbid * 100 + 3);
+    }
+
+    std::printf("retry: %llu flushes kept failed saves, %llu warnings\n", to_llu(rw.worker.retryCount()), to_llu(rw.warningCount.load()));
+    std::filesystem::remove(dbName);
+}
+
+static void testRetryLost()
+{
+    const auto dbName = createDB();
+    RetryWorker rw;
+    rw.worker.launch(dbName.c_str(), [](){ std::fprintf(stderr, "DBWorker exits by exception\n"); std::abort(); });
+
+    SQLite::Database lockDB(dbName, SQLite::OPEN_READWRITE);
+    lockDB.exec("begin exclusive");
+
+    rw.source.push(MessagePack(MessageBuf(MPK_DBSAVEPLAYER, buildSave(1, DBSPF_GOLD, 100)), 1, 1));
+    rw.source.push(MessagePack(MessageBuf(MPK_DBSAVEPLAYER, buildSave(2, DBSPF_GOLD, 200))));
+
+    // lock held till stop() returns
+    // lost saves are reported, not acknowledged
+    rw.waitRetry();
+    rw.worker.stop();
+
+    CHECK(rw.okCount == 0);
+    CHECK(rw.errorCount == 1);
+    CHECK(rw.warningCount > 0);
+
+    lockDB.exec("rollback");
+    std::filesystem::remove(dbName);
+}
+
+int main()
+{
+    try{
+        testMergeSave();
+        testStress();
+        testRetry();
+        testRetryLost();
+    }
+    catch(const std::exception &e){
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    std::printf("dbworkertest passed\n");
+    return 0;
+}
@@ -0,0 +1,107 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: mailboxqueuebench.cpp
+ *        Created: 10/17/2026 17:31:05
+ *    Description: throughput of LockFreeMailboxQueue vs MutexMailboxQueue
+ *
+ *                 N producers push the same element type as ActorPool::Mailbox, one consumer
+ *                 takes in a loop, report pushed messages per second
+ *
+ *                     $ mailboxqueuebench [message per producer]
+ *
+ *                 not run by ctest, numbers depend on the machine
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+#include "totype.hpp"
+#include "messagepack.hpp"
+#include "mailboxqueue.hpp"
+
+using MailboxElement = std::pair<MessagePack, uint64_t>;
+
+template<typename Queue> static double runBench(int producerCount, uint64_t msgPerProducer)
+{
+    Queue q;
+    std::atomic<bool> start {false};
+    std::atomic<int> readyCount {0};
+
+    std::vector<std::thread> producerList;
+    for(int producer = 0; producer < producerCount; ++producer){
+        producerList.emplace_back([producer, msgPerProducer, &q, &start, &readyCount]()
+        {
+            readyCount++;
+            while(!start.load()){
+                std::this_thread::yield();
+            }
+
+            for(uint64_t i = 0; i < msgPerProducer; ++i){
+                q.push({MessagePack(MPK_METRONOME, nullptr, 0, producer + 1, (uint32_t)(i)), 0}, [](){ return false; });
+            }
+        });
+    }
+
+    while(readyCount.load() < producerCount){
+        std::this_thread::yield();
+    }
+
+    const auto startTime = std::chrono::steady_clock::now();
+    start = true;
+
+    uint64_t takeCount = 0;
+    std::vector<MailboxElement> elemList;
+
+    while(takeCount < msgPerProducer * producerCount){
+        elemList.clear();
+        if(q.take(elemList)){
+            takeCount += elemList.size();
+        }
+        else{
+            std::this_thread::yield();
+        }
+    }
+
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    for(auto &producer: producerList){
+        producer.join();
+    }
+    return takeCount / elapsed;
+}
+
+int main(int argc, char *argv[])
+{
+    const uint64_t msgPerProducer = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 500000;
+    std::printf("hardware threads: %u, message per producer: %llu\n", std::thread::hardware_concurrency(), to_llu(msgPerProducer));
+    std::printf("%9s %16s %16s %8s\n", "producers", "mutex (msg/s)", "lockfree (msg/s)", "ratio");
+
+    for(const int producerCount: {1, 2, 4, 8, 16}){
+        // take best of 3
+        // producer threads are created per run, lock-free nodes are recycled only within one run
+        double mutexRate = 0.0;
+        double lockFreeRate = 0.0;
+
+        for(int i = 0; i < 3; ++i){
+            mutexRate    = std::max(mutexRate,    runBench<MutexMailboxQueue   <MailboxElement>>(producerCount, msgPerProducer));
+            lockFreeRate = std::max(lockFreeRate, runBench<LockFreeMailboxQueue<MailboxElement>>(producerCount, msgPerProducer));
+        }
+        std::printf("%9d %16.0f %16.0f %8.2f\n", producerCount, mutexRate, lockFreeRate, lockFreeRate / mutexRate);
+    }
+    return 0;
+}
@@ -0,0 +1,255 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: mailboxqueuetest.cpp
+ *        Created: 10/17/2026 16:52:20
+ *    Description: stress test of LockFreeMailboxQueue and MutexMailboxQueue
+ *
+ *                 used the same way as ActorPool::Mailbox: many producers push, consumer
+ *                 threads compete for a schedLock and only the holder takes, then
+ *
+ *                     1. every pushed message is taken exactly once
+ *                     2. messages of one producer are taken in posting order
+ *                     3. after seal() all push() fail and nothing pushed before is lost
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include "strf.hpp"
+#include "totype.hpp"
+#include "fflerror.hpp"
+#include "mailboxqueue.hpp"
+
+#define CHECK(expr) do{ if(!(expr)){ throw fflerror("check failed: %s", #expr); } }while(0)
+
+constexpr int g_producerCount = 8;
+constexpr int g_consumerCount = 2;
+constexpr uint32_t g_messagePerProducer = 200000;
+
+// message = (producer << 32) | seq
+// seq starts from 1, zero is the default value of recycled node
+static uint64_t buildMessage(uint32_t producer, uint32_t seq)
+{
+    return ((uint64_t)(producer) << 32) | seq;
+}
+
+// consumers check message order under schedLock
+// the lock makes the taken order of different consumers a single sequence
+class Checker final
+{
+    private:
+        std::vector<uint32_t> m_lastSeq;
+
+    public:
+        Checker()
+            : m_lastSeq(g_producerCount, 0)
+        {}
+
+    public:
+        void check(const std::vector<uint64_t> &msgList)
+        {
+            for(const auto msg: msgList){
+                const auto producer = (uint32_t)(msg >> 32);
+                const auto seq = (uint32_t)(msg);
+
+                CHECK(producer < m_lastSeq.size());
+                CHECK(seq == m_lastSeq[producer] + 1);
+                m_lastSeq[producer] = seq;
+            }
+        }
+
+        uint32_t lastSeq(uint32_t producer) const
+        {
+            return m_lastSeq.at(producer);
+        }
+};
+
+template<typename Queue> static void testStress(const char *name)
+{
+    Queue q;
+    Checker checker;
+
+    std::mutex schedLock;
+    std::atomic<int> doneCount {0};
+
+    std::vector<std::thread> threadList;
+    for(int producer = 0; producer < g_producerCount; ++producer){
+        threadList.emplace_back([producer, &q, &doneCount]()
+        {
+            for(uint32_t seq = 1; seq <= g_messagePerProducer; ++seq){
+                CHECK(q.push(buildMessage(producer, seq), [](){ return false; }));
+            }
+            doneCount++;
+        });
+    }
+
+    std::atomic<uint64_t> takeCount {0};
+    std::atomic<uint64_t> emptyCount {0};
+
+    for(int consumer = 0; consumer < g_consumerCount; ++consumer){
+        threadList.emplace_back([&]()
+        {
+            std::vector<uint64_t> msgList;
+            while(true){
+                // read before take, then the last take after all producers done sees everything
+                const bool producerDone = (doneCount.load() == g_producerCount);
+                if(std::unique_lock<std::mutex> lock(schedLock, std::try_to_lock); lock.owns_lock()){
+                    msgList.clear();
+                    if(q.take(msgList)){
+                        CHECK(!msgList.empty());
+                        checker.check(msgList);
+                        takeCount += msgList.size();
+                    }
+                    else{
+                        emptyCount++;
+                    }
+                }
+                std::this_thread::yield();
+
+                if(producerDone && takeCount.load() == to_llu(g_producerCount) * g_messagePerProducer){
+                    return;
+                }
+            }
+        });
+    }
+
+    for(auto &t: threadList){
+        t.join();
+    }
+
+    std::vector<uint64_t> msgList;
+    CHECK(!q.take(msgList));
+    CHECK(msgList.empty());
+
+    for(int producer = 0; producer < g_producerCount; ++producer){
+        CHECK(checker.lastSeq(producer) == g_messagePerProducer);
+    }
+    std::printf("%-8s stress: %llu messages taken, %llu empty takes\n", name, to_llu(takeCount.load()), to_llu(emptyCount.load()));
+}
+
+template<typename Queue> static void testSeal(const char *name)
+{
+    // producers push till the first failure
+    // consumer seals the queue in the middle, same as ActorPool::clearOneMailbox()
+
+    Queue q;
+    Checker checker;
+
+    std::atomic<bool> closed {false};
+    std::atomic<int> startCount {0};
+    std::vector<uint32_t> pushCount(g_producerCount, 0);
+
+    std::vector<std::thread> threadList;
+    for(int producer = 0; producer < g_producerCount; ++producer){
+        threadList.emplace_back([producer, &q, &closed, &startCount, &pushCount]()
+        {
+            // stop if not sealed after g_messagePerProducer pushes
+            // keeps memory bounded if consumer thread is slow to get scheduled
+            uint32_t seq = 1;
+            for(; seq <= g_messagePerProducer; ++seq){
+                if(!q.push(buildMessage(producer, seq), [&closed](){ return closed.load(); })){
+                    break;
+                }
+
+                if(seq == 1){
+                    startCount++;
+                }
+
+                if(seq % 256 == 0){
+                    std::this_thread::yield();
+                }
+            }
+            pushCount[producer] = seq - 1;
+        });
+    }
+
+    // seal when all producers are pushing
+    // then seal() races with push() in every producer
+    std::vector<uint64_t> msgList;
+    for(int i = 0; i < 16 || startCount.load() < g_producerCount; ++i){
+        msgList.clear();
+        if(q.take(msgList)){
+            checker.check(msgList);
+        }
+        std::this_thread::yield();
+    }
+
+    // mutex version relies on the closed flag checked with lock
+    // lock-free version relies on the sentinel
+    closed = true;
+
+    msgList.clear();
+    q.seal(msgList);
+    checker.check(msgList);
+
+    for(auto &t: threadList){
+        t.join();
+    }
+
+    // every successful push is taken before or by seal()
+    // nothing is taken, dropped or accepted after seal()
+    uint64_t total = 0;
+    for(int producer = 0; producer < g_producerCount; ++producer){
+        CHECK(pushCount[producer] > 0);
+        CHECK(checker.lastSeq(producer) == pushCount[producer]);
+        total += pushCount[producer];
+    }
+
+    msgList.clear();
+    CHECK(!q.push(buildMessage(0, pushCount[0] + 1), [](){ return true; }));
+    CHECK(!q.take(msgList));
+    CHECK(msgList.empty());
+
+    q.seal(msgList);
+    CHECK(msgList.empty());
+    std::printf("%-8s seal  : %llu messages taken before sealed\n", name, to_llu(total));
+}
+
+template<typename Queue> static void testSealNoFlag(const char *name)
+{
+    // lock-free queue rejects push after seal() even if fnClosed says open
+    // fnClosed is only a shortcut there
+    Queue q;
+    std::vector<uint64_t> msgList;
+
+    CHECK(q.push(buildMessage(0, 1), [](){ return false; }));
+    q.seal(msgList);
+
+    CHECK(msgList.size() == 1);
+    CHECK(!q.push(buildMessage(0, 2), [](){ return false; }));
+    std::printf("%-8s seal without closed flag passed\n", name);
+}
+
+int main()
+{
+    try{
+        testStress<LockFreeMailboxQueue<uint64_t>>("lockfree");
+        testStress<MutexMailboxQueue   <uint64_t>>("mutex"   );
+
+        testSeal<LockFreeMailboxQueue<uint64_t>>("lockfree");
+        testSeal<MutexMailboxQueue   <uint64_t>>("mutex"   );
+
+        testSealNoFlag<LockFreeMailboxQueue<uint64_t>>("lockfree");
+    }
+    catch(const std::exception &e){
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    std::printf("mailboxqueuetest passed\n");
+    return 0;
+}
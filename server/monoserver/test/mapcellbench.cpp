@@ -0,0 +1,531 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: mapcellbench.cpp
+ *        Created: 10/17/2026 03:05:26
+ *    Description: memory and path finding time of ServerMap cell states, per-cell struct vs
+ *                 packed flags
+ *
+ *                     $ mapcellbench old|new [map count] [map size] [pairs per map]
+ *
+ *                 old : Vec2D<MapCell>, one struct with UID vector, switch and inline ground
+ *                       item queue per cell, walkability read from Mir2xMapData, the way
+ *                       ServerMap kept cells before packed flags
+ *                 new : one flag byte per cell plus sparse UID / item / switch tables, same
+ *                       as ServerMap::m_cellFlagList
+ *
+ *                 both modes put the same UIDs, items, locks and switches on the same
+ *                 synthetic maps, then run
+ *
+ *                     scan  : canMove(true, true) on every cell
+ *                     astar : AStarPathFinder with OneStepCost() over CheckPathGrid(),
+ *                             CheckCO = CheckLock = 1 as ServerPathFinder does, max step 1
+ *
+ *                 path steps are printed for both modes and have to be equal
+ *                 RSS is taken after map data is created, the delta is the cell states only
+ *
+ *                 run each mode in a fresh process
+ *                 not run by ctest, numbers depend on the machine
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#include <memory>
+#include <random>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+#include "uidf.hpp"
+#include "mathf.hpp"
+#include "fflerror.hpp"
+#include "sysconst.hpp"
+#include "raiitimer.hpp"
+#include "commonitem.hpp"
+#include "pathfinder.hpp"
+#include "cachequeue.hpp"
+#include "mir2xmapdata.hpp"
+#include "mapdataregistry.hpp"
+
+using GroundItemQueue = CacheQueue<CommonItem, SYS_MAXDROPITEM>;
+
+// per-cell struct, copied from ServerMap before packed flags
+class OldCellMap
+{
+    private:
+        struct MapCell
+        {
+            bool Locked;
+            std::vector<uint64_t> UIDList;
+
+            uint32_t mapID;
+            int      switchX;
+            int      switchY;
+
+            CacheQueue<CommonItem, SYS_MAXDROPITEM> GroundItemQueue;
+
+            MapCell()
+                : Locked(false)
+                , mapID(0)
+                , switchX(-1)
+                , switchY(-1)
+                , GroundItemQueue()
+            {}
+        };
+
+    private:
+        template<typename T> using Vec2D = std::vector<std::vector<T>>;
+
+    private:
+        const Mir2xMapData &m_mapData;
+
+    private:
+        Vec2D<MapCell> m_cellVec2D;
+
+    public:
+        OldCellMap(const Mir2xMapData &mapData)
+            : m_mapData(mapData)
+        {
+            m_cellVec2D.resize(W());
+            m_cellVec2D.shrink_to_fit();
+
+            for(auto &rstStateLine: m_cellVec2D){
+                rstStateLine.resize(H());
+                rstStateLine.shrink_to_fit();
+            }
+        }
+
+    public:
+        int W() const { return m_mapData.W(); }
+        int H() const { return m_mapData.H(); }
+
+    public:
+        void addUID(uint64_t uid, int nX, int nY)
+        {
+            m_cellVec2D[nX][nY].UIDList.push_back(uid);
+        }
+
+        void addItem(const CommonItem &item, int nX, int nY)
+        {
+            m_cellVec2D[nX][nY].GroundItemQueue.PushBack(item);
+        }
+
+        void setLocked(int nX, int nY)
+        {
+            m_cellVec2D[nX][nY].Locked = true;
+        }
+
+        void setSwitch(uint32_t mapID, int nX, int nY)
+        {
+            m_cellVec2D[nX][nY].mapID   = mapID;
+            m_cellVec2D[nX][nY].switchX = nX;
+            m_cellVec2D[nX][nY].switchY = nY;
+        }
+
+    public:
+        bool groundValid(int nX, int nY) const
+        {
+            return true
+                && m_mapData.Valid()
+                && m_mapData.ValidC(nX, nY)
+                && m_mapData.Cell(nX, nY).CanThrough();
+        }
+
+        bool canMove(bool bCheckCO, bool bCheckLock, int nX, int nY) const
+        {
+            if(groundValid(nX, nY)){
+                if(bCheckCO){
+                    for(auto nUID: m_cellVec2D[nX][nY].UIDList){
+                        if(auto nType = uidf::getUIDType(nUID); nType == UID_PLY || nType == UID_MON){
+                            return false;
+                        }
+                    }
+                }
+
+                if(bCheckLock){
+                    if(m_cellVec2D[nX][nY].Locked){
+                        return false;
+                    }
+                }
+                return true;
+            }
+            return false;
+        }
+
+        int CheckPathGrid(int nX, int nY) const
+        {
+            if(!m_mapData.ValidC(nX, nY)){
+                return PathFind::INVALID;
+            }
+
+            if(!m_mapData.Cell(nX, nY).CanThrough()){
+                return PathFind::OBSTACLE;
+            }
+
+            if(!m_cellVec2D[nX][nY].UIDList.empty()){
+                return PathFind::OCCUPIED;
+            }
+
+            if(m_cellVec2D[nX][nY].Locked){
+                return PathFind::LOCKED;
+            }
+            return PathFind::FREE;
+        }
+};
+
+// packed flags, same layout as ServerMap::m_cellFlagList
+class NewCellMap
+{
+    private:
+        enum CellFlagType: uint8_t
+        {
+            CELL_CANTHROUGH = (1 << 0),
+            CELL_LOCKED     = (1 << 1),
+            CELL_HASUID     = (1 << 2),
+            CELL_HASCO      = (1 << 3),
+            CELL_HASITEM    = (1 << 4),
+            CELL_HASSWITCH  = (1 << 5),
+        };
+
+        struct CellSwitch
+        {
+            uint32_t mapID = 0;
+            int x = -1;
+            int y = -1;
+        };
+
+    private:
+        const int m_w;
+        const int m_h;
+
+    private:
+        std::vector<uint8_t> m_cellFlagList;
+
+    private:
+        std::unordered_map<int, CellSwitch> m_cellSwitchList;
+        std::unordered_map<int, GroundItemQueue> m_cellGroundItemList;
+        std::unordered_map<int, std::vector<uint64_t>> m_cellUIDList;
+
+    public:
+        NewCellMap(const Mir2xMapData &mapData)
+            : m_w(mapData.W())
+            , m_h(mapData.H())
+        {
+            m_cellFlagList.resize(W() * H(), 0);
+            for(int nY = 0; nY < H(); ++nY){
+                for(int nX = 0; nX < W(); ++nX){
+                    if(mapData.Cell(nX, nY).CanThrough()){
+                        m_cellFlagList[nX + nY * W()] |= CELL_CANTHROUGH;
+                    }
+                }
+            }
+        }
+
+    public:
+        int W() const { return m_w; }
+        int H() const { return m_h; }
+
+    public:
+        bool ValidC(int nX, int nY) const
+        {
+            return nX >= 0 && nX < W() && nY >= 0 && nY < H();
+        }
+
+    public:
+        void addUID(uint64_t uid, int nX, int nY)
+        {
+            m_cellUIDList[nX + nY * W()].push_back(uid);
+            m_cellFlagList[nX + nY * W()] |= CELL_HASUID;
+
+            if(const auto uidType = uidf::getUIDType(uid); uidType == UID_PLY || uidType == UID_MON){
+                m_cellFlagList[nX + nY * W()] |= CELL_HASCO;
+            }
+        }
+
+        void addItem(const CommonItem &item, int nX, int nY)
+        {
+            m_cellGroundItemList[nX + nY * W()].PushBack(item);
+            m_cellFlagList[nX + nY * W()] |= CELL_HASITEM;
+        }
+
+        void setLocked(int nX, int nY)
+        {
+            m_cellFlagList[nX + nY * W()] |= CELL_LOCKED;
+        }
+
+        void setSwitch(uint32_t mapID, int nX, int nY)
+        {
+            m_cellSwitchList[nX + nY * W()] = {mapID, nX, nY};
+            m_cellFlagList[nX + nY * W()] |= CELL_HASSWITCH;
+        }
+
+    public:
+        bool canMove(bool bCheckCO, bool bCheckLock, int nX, int nY) const
+        {
+            if(!ValidC(nX, nY)){
+                return false;
+            }
+
+            const auto flag = m_cellFlagList[nX + nY * W()];
+            if(!(flag & CELL_CANTHROUGH)){
+                return false;
+            }
+
+            if(bCheckCO && (flag & CELL_HASCO)){
+                return false;
+            }
+
+            if(bCheckLock && (flag & CELL_LOCKED)){
+                return false;
+            }
+            return true;
+        }
+
+        int CheckPathGrid(int nX, int nY) const
+        {
+            if(!ValidC(nX, nY)){
+                return PathFind::INVALID;
+            }
+
+            const auto flag = m_cellFlagList[nX + nY * W()];
+            if(!(flag & CELL_CANTHROUGH)){
+                return PathFind::OBSTACLE;
+            }
+
+            if(flag & CELL_HASUID){
+                return PathFind::OCCUPIED;
+            }
+
+            if(flag & CELL_LOCKED){
+                return PathFind::LOCKED;
+            }
+            return PathFind::FREE;
+        }
+};
+
+// blocks of walkable area with walls, same pattern as mapdatabench
+static std::unique_ptr<Mir2xMapData> createMap(uint16_t mapW, uint16_t mapH, uint32_t seed)
+{
+    auto mapDataPtr = std::make_unique<Mir2xMapData>();
+    if(!mapDataPtr->Allocate(mapW, mapH)){
+        throw fflerror("failed to allocate map: %d x %d", (int)(mapW), (int)(mapH));
+    }
+
+    std::minstd_rand rng(seed);
+    for(int nY = 0; nY < mapH; ++nY){
+        for(int nX = 0; nX < mapW; ++nX){
+            if((nX / 16 + nY / 16) % 5 && (rng() % 16)){
+                mapDataPtr->Cell(nX, nY).Param = 0X00800000;
+            }
+        }
+    }
+    return mapDataPtr;
+}
+
+// one UID per 64 walkable cells, mostly monsters
+// items on one of 200 cells, a few locks and switches
+template<typename CellMap> static void populateMap(CellMap &cellMap, const Mir2xMapData &mapData, uint32_t seed)
+{
+    std::minstd_rand rng(seed);
+    for(int nY = 0; nY < mapData.H(); ++nY){
+        for(int nX = 0; nX < mapData.W(); ++nX){
+            if(!mapData.Cell(nX, nY).CanThrough()){
+                continue;
+            }
+
+            const auto r = rng() % 12800;
+            if(r < 200){
+                switch(r % 4){
+                    case 0 : cellMap.addUID(uidf::buildNPCUID((uint16_t)(r + 1)),       nX, nY); break;
+                    case 1 : cellMap.addUID(uidf::buildPlayerUID((uint32_t)(r + 1)),   nX, nY); break;
+                    default: cellMap.addUID(uidf::buildMonsterUID((uint32_t)(r % 16) + 1), nX, nY); break;
+                }
+            }
+            else if(r < 264){
+                cellMap.addItem(CommonItem(1 + r, 0), nX, nY);
+            }
+            else if(r < 266){
+                cellMap.setLocked(nX, nY);
+            }
+            else if(r < 267){
+                cellMap.setSwitch(1 + r, nX, nY);
+            }
+        }
+    }
+}
+
+// ServerMap::OneStepCost() for max step 1
+template<typename CellMap> static double oneStepCost(const CellMap &cellMap, int nX0, int nY0, int nX1, int nY1)
+{
+    switch(mathf::LDistance2(nX0, nY0, nX1, nY1)){
+        case 1:
+        case 2:
+            {
+                break;
+            }
+        default:
+            {
+                return -1.00;
+            }
+    }
+
+    double fExtraPen = 0.00;
+    for(const auto [nX, nY]: {std::make_pair(nX0, nY0), std::make_pair(nX1, nY1)}){
+        switch(cellMap.CheckPathGrid(nX, nY)){
+            case PathFind::FREE:
+                {
+                    break;
+                }
+            case PathFind::OCCUPIED:
+            case PathFind::LOCKED:
+                {
+                    fExtraPen += 100.00;
+                    break;
+                }
+            default:
+                {
+                    return -1.00;
+                }
+        }
+    }
+    return 1.10 + fExtraPen;
+}
+
+struct BenchResult
+{
+    uint64_t scanTime  = 0;
+    uint64_t astarTime = 0;
+
+    size_t moveCount = 0;
+    size_t pathCount = 0;
+    size_t pathStep  = 0;
+};
+
+template<typename CellMap> static void runBench(const CellMap &cellMap, int pairCount, uint32_t seed, BenchResult &result)
+{
+    {
+        const hres_timer timer;
+        for(int nY = 0; nY < cellMap.H(); ++nY){
+            for(int nX = 0; nX < cellMap.W(); ++nX){
+                if(cellMap.canMove(true, true, nX, nY)){
+                    result.moveCount++;
+                }
+            }
+        }
+        result.scanTime += timer.diff_nsec();
+    }
+
+    // monsters chase in short range, searches are local
+    std::minstd_rand rng(seed);
+    for(int i = 0; i < pairCount; ++i){
+        const int nX0 = rng() % cellMap.W();
+        const int nY0 = rng() % cellMap.H();
+        const int nX1 = std::clamp<int>(nX0 + (int)(rng() % 61) - 30, 0, cellMap.W() - 1);
+        const int nY1 = std::clamp<int>(nY0 + (int)(rng() % 61) - 30, 0, cellMap.H() - 1);
+
+        if(!cellMap.canMove(false, false, nX0, nY0) || !cellMap.canMove(false, false, nX1, nY1)){
+            continue;
+        }
+
+        const hres_timer timer;
+        AStarPathFinder finder([&cellMap](int nSrcX, int nSrcY, int nDstX, int nDstY) -> double
+        {
+            return oneStepCost(cellMap, nSrcX, nSrcY, nDstX, nDstY);
+        });
+
+        if(finder.Search(nX0, nY0, nX1, nY1)){
+            result.pathCount++;
+            result.pathStep += finder.GetPathNode().size() - 1;
+        }
+        result.astarTime += timer.diff_nsec();
+    }
+}
+
+template<typename CellMap> static void runMode(const char *mode, const std::vector<std::unique_ptr<Mir2xMapData>> &mapList, int pairCount)
+{
+    const auto rssStart = MapDataRegistry::processRSS();
+    const hres_timer buildTimer;
+
+    std::vector<std::unique_ptr<CellMap>> cellMapList;
+    for(size_t i = 0; i < mapList.size(); ++i){
+        cellMapList.push_back(std::make_unique<CellMap>(*mapList[i]));
+        populateMap(*cellMapList.back(), *mapList[i], (uint32_t)(i + 1));
+    }
+
+    const auto buildTime = buildTimer.diff_nsec();
+    const auto rssEnd = MapDataRegistry::processRSS();
+
+    BenchResult result;
+    for(size_t i = 0; i < cellMapList.size(); ++i){
+        runBench(*cellMapList[i], pairCount, (uint32_t)(i + 1), result);
+    }
+
+    size_t cellCount = 0;
+    for(const auto &mapDataPtr: mapList){
+        cellCount += (size_t)(mapDataPtr->W()) * mapDataPtr->H();
+    }
+
+    std::printf("mode: %s, maps: %zu, cells: %zu, build: %.2fms, RSS: +%zuKB, %.2f bytes/cell\n",
+            mode,
+            mapList.size(),
+            cellCount,
+            buildTime / 1000000.0,
+            (rssEnd - rssStart) / 1024,
+            1.0 * (rssEnd - rssStart) / std::max<size_t>(1, cellCount));
+
+    std::printf("scan : %zu movable, %.3f ns/cell\n", result.moveCount, 1.0 * result.scanTime / std::max<size_t>(1, cellCount));
+    std::printf("astar: %zu paths, %zu steps, %.2fms, %.2f us/path\n",
+            result.pathCount,
+            result.pathStep,
+            result.astarTime / 1000000.0,
+            result.astarTime / 1000.0 / std::max<size_t>(1, result.pathCount));
+}
+
+int main(int argc, char *argv[])
+{
+    if(argc < 2 || (std::strcmp(argv[1], "old") && std::strcmp(argv[1], "new"))){
+        std::fprintf(stderr, "usage: mapcellbench old|new [map count] [map size] [pairs per map]\n");
+        return 1;
+    }
+
+    try{
+        const int mapCount  = (argc > 2) ? std::atoi(argv[2]) :   16;
+        const int mapSize   = (argc > 3) ? std::atoi(argv[3]) :  800;
+        const int pairCount = (argc > 4) ? std::atoi(argv[4]) : 1000;
+
+        if(mapCount <= 0 || mapSize < 64 || mapSize > 65535 || pairCount < 0){
+            throw fflerror("invalid map count, map size or pairs per map");
+        }
+
+        // vary size by map as mapdatabench does
+        std::vector<std::unique_ptr<Mir2xMapData>> mapList;
+        for(int i = 0; i < mapCount; ++i){
+            const auto mapW = (uint16_t)((mapSize / 2 + (i * 37) % (mapSize / 2)) & ~1);
+            const auto mapH = (uint16_t)((mapSize / 2 + (i * 53) % (mapSize / 2)) & ~1);
+            mapList.push_back(createMap(mapW, mapH, (uint32_t)(i + 1)));
+        }
+
+        if(!std::strcmp(argv[1], "old")){
+            runMode<OldCellMap>(argv[1], mapList, pairCount);
+        }
+        else{
+            runMode<NewCellMap>(argv[1], mapList, pairCount);
+        }
+    }
+    catch(const std::exception &e){
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,221 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: mapdatabench.cpp
+ *        Created: 10/17/2026 19:12:40
+ *    Description: load time and RSS of map data, MapBinDB copy vs MapDataRegistry
+ *
+ *                     $ mapdatabench work-dir copy|share [map count] [map size]
+ *
+ *                 copy  : MapBinDB::Retrieve() then copy into a Mir2xMapData per map, the
+ *                         way ServerMap used to hold it
+ *                 share : MapDataRegistry::retrieve(), first run decompresses and writes
+ *                         work-dir/map.zsdb.cache, later runs map the cache files
+ *
+ *                 generates synthetic maps into work-dir/map.zsdb if it doesn't exist
+ *                 a real map database can be copied there instead
+ *
+ *                 run each mode in a fresh process, RSS includes everything loaded before
+ *                 not run by ctest, numbers depend on the machine
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include "zsdb.hpp"
+#include "strf.hpp"
+#include "totype.hpp"
+#include "hexstr.hpp"
+#include "fflerror.hpp"
+#include "mapbindb.hpp"
+#include "raiitimer.hpp"
+#include "mir2xmapdata.hpp"
+#include "mapdataregistry.hpp"
+
+// same layout as the map files in the map database
+// blocked walkable area with sparse tiles and objects, compresses like a real map
+static void createMap(const std::string &fileName, uint16_t mapW, uint16_t mapH, uint32_t seed)
+{
+    Mir2xMapData mapData;
+    if(!mapData.Allocate(mapW, mapH)){
+        throw fflerror("failed to allocate map: %d x %d", (int)(mapW), (int)(mapH));
+    }
+
+    std::minstd_rand rng(seed);
+    for(int nY = 0; nY < mapH; ++nY){
+        for(int nX = 0; nX < mapW; ++nX){
+            if(!(nX % 2) && !(nY % 2) && (rng() % 4)){
+                mapData.Tile(nX, nY).Param = 0X80000000 | (rng() % 64);
+            }
+
+            auto &cell = mapData.Cell(nX, nY);
+            if((nX / 16 + nY / 16) % 5){
+                cell.Param = 0X00800000;
+            }
+
+            if(rng() % 8 == 0){
+                cell.Obj[0].Param = 0X80000000 | 0X00010000 | (rng() % 512);
+                cell.ObjParam = 0X00000040;
+            }
+        }
+    }
+
+    if(!mapData.Save(fileName.c_str())){
+        throw fflerror("failed to save map: %s", fileName.c_str());
+    }
+}
+
+static void createMapDB(const std::string &workDir, int mapCount, int mapSize)
+{
+    const auto dataDir = workDir + "/map";
+    std::filesystem::create_directories(dataDir);
+
+    for(int i = 0; i < mapCount; ++i){
+        char keyString[16];
+        const auto mapID = (uint32_t)(i + 1);
+
+        // vary size by map, real maps range from tens to about a thousand cells
+        const auto mapW = (uint16_t)((mapSize / 2 + (i * 37) % (mapSize / 2)) & ~1);
+        const auto mapH = (uint16_t)((mapSize / 2 + (i * 53) % (mapSize / 2)) & ~1);
+        createMap(str_printf("%s/%s.bin", dataDir.c_str(), hexstr::to_string<uint32_t, 4>(mapID, keyString, true)), mapW, mapH, mapID);
+    }
+
+    ZSDB::BuildOption option;
+    option.FileNameRegex = ".*\\.bin";
+
+    if(!ZSDB::BuildDB((workDir + "/map.zsdb").c_str(), dataDir.c_str(), option)){
+        throw fflerror("failed to build map database");
+    }
+    std::filesystem::remove_all(dataDir);
+}
+
+// ServerMap reads every cell when building its cell grid
+// reading here makes mapped pages resident as they are in the server
+static size_t touchMap(const Mir2xMapData &mapData)
+{
+    size_t walkCount = 0;
+    for(int nY = 0; nY < mapData.H(); ++nY){
+        for(int nX = 0; nX < mapData.W(); ++nX){
+            if(mapData.Cell(nX, nY).CanThrough()){
+                walkCount++;
+            }
+        }
+    }
+    return walkCount;
+}
+
+int main(int argc, char *argv[])
+{
+    if(argc < 3 || (std::strcmp(argv[2], "copy") && std::strcmp(argv[2], "share"))){
+        std::fprintf(stderr, "usage: mapdatabench work-dir copy|share [map count] [map size]\n");
+        return 1;
+    }
+
+    try{
+        const std::string workDir = argv[1];
+        const std::string dbName  = workDir + "/map.zsdb";
+        const bool copyMode = !std::strcmp(argv[2], "copy");
+
+        if(!std::filesystem::exists(dbName)){
+            const int mapCount = (argc > 3) ? std::atoi(argv[3]) : 64;
+            const int mapSize  = (argc > 4) ? std::atoi(argv[4]) : 800;
+
+            if(mapCount <= 0 || mapSize < 8){
+                throw fflerror("invalid map count or map size");
+            }
+
+            const hres_timer timer;
+            createMapDB(workDir, mapCount, mapSize);
+            std::printf("created %s: %d maps, max size %d, %.2fms\n", dbName.c_str(), mapCount, mapSize, timer.diff_usec() / 1000.0);
+        }
+
+        // server never unloads a map
+        // keep everything alive till the end
+        MapBinDB mapBinDB;
+        MapDataRegistry mapDataRegistry;
+        std::vector<std::unique_ptr<Mir2xMapData>> copyList;
+        std::vector<std::shared_ptr<const Mir2xMapData>> shareList;
+
+        if(copyMode ? !mapBinDB.Load(dbName.c_str()) : !mapDataRegistry.load(dbName.c_str())){
+            throw fflerror("failed to load map database: %s", dbName.c_str());
+        }
+
+        std::vector<uint32_t> mapIDList;
+        const ZSDB zsdb(dbName.c_str());
+
+        for(const auto &entry: zsdb.GetEntryList()){
+            mapIDList.push_back(hexstr::to_hex<uint32_t, 4>(entry.FileName));
+        }
+
+        const auto rssStart = MapDataRegistry::processRSS();
+        const hres_timer totalTimer;
+
+        size_t totalSize = 0;
+        size_t totalWalk = 0;
+        uint64_t totalLoadTime = 0;
+
+        std::printf("%8s %10s %10s %10s %12s\n", "map", "size(KB)", "load(ms)", "touch(ms)", "RSS(KB)");
+        for(const auto mapID: mapIDList){
+            const hres_timer loadTimer;
+            const Mir2xMapData *mapDataPtr = nullptr;
+
+            if(copyMode){
+                if(auto p = mapBinDB.Retrieve(mapID)){
+                    copyList.push_back(std::make_unique<Mir2xMapData>(*p));
+                    mapDataPtr = copyList.back().get();
+                }
+            }
+            else{
+                if(auto p = mapDataRegistry.retrieve(mapID)){
+                    shareList.push_back(p);
+                    mapDataPtr = p.get();
+                }
+            }
+
+            if(!mapDataPtr){
+                throw fflerror("failed to load map: %llu", to_llu(mapID));
+            }
+
+            const auto loadTime = loadTimer.diff_usec();
+            const hres_timer touchTimer;
+            totalWalk += touchMap(*mapDataPtr);
+
+            totalSize += mapDataPtr->DataLen();
+            totalLoadTime += loadTime;
+            std::printf("%08llX %10zu %10.2f %10.2f %12zu\n", to_llu(mapID), mapDataPtr->DataLen() / 1024, loadTime / 1000.0, touchTimer.diff_usec() / 1000.0, MapDataRegistry::processRSS() / 1024);
+        }
+
+        const auto rssEnd = MapDataRegistry::processRSS();
+        std::printf("mode: %s, maps: %zu, data: %zuKB, walkable: %zu, load: %.2fms, total: %.2fms, RSS: %zuKB -> %zuKB (+%zuKB)\n",
+                argv[2],
+                mapIDList.size(),
+                totalSize / 1024,
+                totalWalk,
+                totalLoadTime / 1000.0,
+                totalTimer.diff_usec() / 1000.0,
+                rssStart / 1024,
+                rssEnd / 1024,
+                (rssEnd - rssStart) / 1024);
+    }
+    catch(const std::exception &e){
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,306 @@
+/*
+ * =====================================================================================
+ *
+ *       Filename: pathfindtest.cpp
+ *        Created: 10/17/2026 23:20:15
+ *    Description: JPS/HPA* against the A* finder on random start/end pairs of every map
+ *
+ *                 HPAGraph is built and searched the way ServerMap does, A* uses the same
+ *                 static walkability and max step 1, for each pair:
+ *
+ *                     1. HPA* path starts and ends at the pair, every step is 8-adjacent
+ *                        and walkable
+ *                     2. HPA* never finds a path if A* doesn't, A* is complete
+ *                     3. HPA* can miss a path A* finds, ServerMap falls back to A* then,
+ *                        it's counted but not a failure
+ *
+ *                 reports time of both finders and the HPA* / A* path length ratio
+ *
+ *                     $ pathfindtest [map.zsdb] [pairs per map]
+ *
+ *                 without a map database it runs synthetic maps, that's what ctest runs
+ *
+ *        Version: 1.0
+ *       Revision: none
+ *       Compiler: gcc
+ *
+ *         Author: ANHONG
+ *          Email: anhonghe@gmail.com
+ *   Organization: USTC
+ *
+ * =====================================================================================
+ */
+
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include "zsdb.hpp"
+#include "hexstr.hpp"
+#include "totype.hpp"
+#include "fflerror.hpp"
+#include "mapbindb.hpp"
+#include "raiitimer.hpp"
+#include "jpsfinder.hpp"
+#include "pathfinder.hpp"
+
+struct TestMap
+{
+    std::string name;
+    int w = 0;
+    int h = 0;
+    std::vector<uint8_t> walkList;
+
+    bool walkable(int nX, int nY) const
+    {
+        return nX >= 0 && nX < w && nY >= 0 && nY < h && walkList[nX + nY * w];
+    }
+};
+
+struct TestResult
+{
+    int pairCount     = 0;
+    int bothCount     = 0;
+    int noneCount     = 0;
+    int fallbackCount = 0;
+
+    uint64_t hpaTime   = 0;
+    uint64_t astarTime = 0;
+    uint64_t buildTime = 0;
+
+    size_t hpaStep   = 0;
+    size_t astarStep = 0;
+};
+
+// walls with gaps on a grid of rooms, plus random blocks
+// gives detours across clusters, dead ends and disconnected parts
+static TestMap createMap(int nW, int nH, uint32_t nSeed)
+{
+    TestMap stMap;
+    stMap.name = str_printf("synthetic %dx%d", nW, nH);
+    stMap.w = nW;
+    stMap.h = nH;
+    stMap.walkList.assign((size_t)(nW) * nH, 1);
+
+    std::minstd_rand stRNG(nSeed);
+    const auto fnBlock = [&stMap](int nX, int nY)
+    {
+        if(nX >= 0 && nX < stMap.w && nY >= 0 && nY < stMap.h){
+            stMap.walkList[nX + nY * stMap.w] = 0;
+        }
+    };
+
+    for(int nX = 24; nX < nW; nX += 24){
+        for(int nY = 0; nY < nH; ++nY){
+            if(stRNG() % 8){
+                fnBlock(nX, nY);
+            }
+        }
+    }
+
+    for(int nY = 24; nY < nH; nY += 24){
+        for(int nX = 0; nX < nW; ++nX){
+            if(stRNG() % 8){
+                fnBlock(nX, nY);
+            }
+        }
+    }
+
+    for(int nCount = nW * nH / 200; nCount > 0; --nCount){
+        const int nX0 = stRNG() % nW;
+        const int nY0 = stRNG() % nH;
+        const int nBW = 1 + stRNG() % 6;
+        const int nBH = 1 + stRNG() % 6;
+
+        for(int nX = nX0; nX < nX0 + nBW; ++nX){
+            for(int nY = nY0; nY < nY0 + nBH; ++nY){
+                fnBlock(nX, nY);
+            }
+        }
+    }
+    return stMap;
+}
+
+static std::vector<TestMap> loadMapDB(const char *szMapDBName)
+{
+    MapBinDB stMapBinDB;
+    if(!stMapBinDB.Load(szMapDBName)){
+        throw fflerror("failed to load map database: %s", szMapDBName);
+    }
+
+    std::vector<TestMap> stMapList;
+    const ZSDB stZSDB(szMapDBName);
+
+    for(const auto &rstEntry: stZSDB.GetEntryList()){
+        const auto nMapID = hexstr::to_hex<uint32_t, 4>(rstEntry.FileName);
+        const auto pMapData = stMapBinDB.Retrieve(nMapID);
+
+        if(!pMapData){
+            throw fflerror("failed to load map: %llu", to_llu(nMapID));
+        }
+
+        // same as ServerMap::groundValid()
+        TestMap stMap;
+        stMap.name = str_printf("%08llX", to_llu(nMapID));
+        stMap.w = pMapData->W();
+        stMap.h = pMapData->H();
+        stMap.walkList.resize((size_t)(stMap.w) * stMap.h);
+
+        for(int nY = 0; nY < stMap.h; ++nY){
+            for(int nX = 0; nX < stMap.w; ++nX){
+                stMap.walkList[nX + nY * stMap.w] = pMapData->Cell(nX, nY).CanThrough() ? 1 : 0;
+            }
+        }
+        stMapList.push_back(std::move(stMap));
+    }
+    return stMapList;
+}
+
+static void checkPath(const TestMap &rstMap, const std::vector<PathFind::PathNode> &rstPathList, int nX0, int nY0, int nX1, int nY1)
+{
+    if(!rstPathList.front().Eq(nX0, nY0) || !rstPathList.back().Eq(nX1, nY1)){
+        throw fflerror("%s: path (%d, %d) -> (%d, %d) has wrong ends", rstMap.name.c_str(), nX0, nY0, nX1, nY1);
+    }
+
+    for(size_t nIndex = 1; nIndex < rstPathList.size(); ++nIndex){
+        const auto &rstSrc = rstPathList[nIndex - 1];
+        const auto &rstDst = rstPathList[nIndex];
+
+        if(std::max<int>(std::abs(rstSrc.X - rstDst.X), std::abs(rstSrc.Y - rstDst.Y)) != 1){
+            throw fflerror("%s: path (%d, %d) -> (%d, %d) jumps from (%d, %d) to (%d, %d)", rstMap.name.c_str(), nX0, nY0, nX1, nY1, rstSrc.X, rstSrc.Y, rstDst.X, rstDst.Y);
+        }
+
+        if(!rstMap.walkable(rstDst.X, rstDst.Y)){
+            throw fflerror("%s: path (%d, %d) -> (%d, %d) steps on blocked (%d, %d)", rstMap.name.c_str(), nX0, nY0, nX1, nY1, rstDst.X, rstDst.Y);
+        }
+    }
+}
+
+static TestResult testMap(const TestMap &rstMap, int nPairCount, uint32_t nSeed)
+{
+    TestResult stResult;
+    std::vector<std::pair<int, int>> stWalkList;
+
+    for(int nY = 0; nY < rstMap.h; ++nY){
+        for(int nX = 0; nX < rstMap.w; ++nX){
+            if(rstMap.walkable(nX, nY)){
+                stWalkList.emplace_back(nX, nY);
+            }
+        }
+    }
+
+    if(stWalkList.size() < 2){
+        return stResult;
+    }
+
+    const hres_timer stBuildTimer;
+    PathFind::HPAGraph stGraph(rstMap.w, rstMap.h, [&rstMap](int nX, int nY) -> bool
+    {
+        return rstMap.walkable(nX, nY);
+    });
+    stResult.buildTime = stBuildTimer.diff_nsec();
+
+    std::minstd_rand stRNG(nSeed);
+    for(int nPair = 0; nPair < nPairCount; ++nPair){
+        const auto [nX0, nY0] = stWalkList[stRNG() % stWalkList.size()];
+        const auto [nX1, nY1] = stWalkList[stRNG() % stWalkList.size()];
+
+        const hres_timer stHPATimer;
+        const auto stHPAPathList = stGraph.search(nX0, nY0, nX1, nY1);
+        stResult.hpaTime += stHPATimer.diff_nsec();
+
+        const hres_timer stAStarTimer;
+        AStarPathFinder stAStarFinder([&rstMap](int nSrcX, int nSrcY, int nDstX, int nDstY) -> double
+        {
+            if(!rstMap.walkable(nDstX, nDstY) || std::max<int>(std::abs(nSrcX - nDstX), std::abs(nSrcY - nDstY)) != 1){
+                return -1.00;
+            }
+            return 1.00;
+        });
+
+        const bool bAStarFound = stAStarFinder.Search(nX0, nY0, nX1, nY1);
+        const auto stAStarPathList = stAStarFinder.GetPathNode();
+        stResult.astarTime += stAStarTimer.diff_nsec();
+
+        stResult.pairCount++;
+        if(!stHPAPathList.empty()){
+            checkPath(rstMap, stHPAPathList, nX0, nY0, nX1, nY1);
+            if(!bAStarFound){
+                throw fflerror("%s: HPA* finds a path (%d, %d) -> (%d, %d) but A* doesn't", rstMap.name.c_str(), nX0, nY0, nX1, nY1);
+            }
+
+            stResult.bothCount++;
+            stResult.hpaStep   += stHPAPathList.size() - 1;
+            stResult.astarStep += stAStarPathList.size() - 1;
+        }
+        else if(bAStarFound){
+            stResult.fallbackCount++;
+        }
+        else{
+            stResult.noneCount++;
+        }
+    }
+    return stResult;
+}
+
+int main(int argc, char *argv[])
+{
+    try{
+        const int nPairCount = (argc > 2) ? std::max<int>(1, std::atoi(argv[2])) : 200;
+
+        std::vector<TestMap> stMapList;
+        if(argc > 1){
+            stMapList = loadMapDB(argv[1]);
+        }
+        else{
+            stMapList.push_back(createMap( 64,  64, 1));
+            stMapList.push_back(createMap(200, 120, 2));
+            stMapList.push_back(createMap(300, 300, 3));
+        }
+
+        TestResult stTotal;
+        std::printf("%-18s %6s %6s %6s %8s %10s %10s %10s %8s\n", "map", "pairs", "none", "fback", "step", "build(ms)", "hpa(ms)", "astar(ms)", "speedup");
+
+        for(size_t nIndex = 0; nIndex < stMapList.size(); ++nIndex){
+            const auto stResult = testMap(stMapList[nIndex], nPairCount, (uint32_t)(nIndex + 1));
+            std::printf("%-18s %6d %6d %6d %8.3f %10.2f %10.2f %10.2f %8.2f\n",
+                    stMapList[nIndex].name.c_str(),
+                    stResult.pairCount,
+                    stResult.noneCount,
+                    stResult.fallbackCount,
+                    1.0 * stResult.hpaStep / std::max<size_t>(1, stResult.astarStep),
+                    stResult.buildTime / 1000000.0,
+                    stResult.hpaTime   / 1000000.0,
+                    stResult.astarTime / 1000000.0,
+                    1.0 * stResult.astarTime / std::max<uint64_t>(1, stResult.hpaTime));
+
+            stTotal.pairCount     += stResult.pairCount;
+            stTotal.bothCount     += stResult.bothCount;
+            stTotal.noneCount     += stResult.noneCount;
+            stTotal.fallbackCount += stResult.fallbackCount;
+            stTotal.hpaTime       += stResult.hpaTime;
+            stTotal.astarTime     += stResult.astarTime;
+            stTotal.hpaStep       += stResult.hpaStep;
+            stTotal.astarStep     += stResult.astarStep;
+        }
+
+        std::printf("maps: %zu, pairs: %d, found by both: %d, A* only: %d, step ratio: %.3f, hpa: %.2fms, astar: %.2fms\n",
+                stMapList.size(),
+                stTotal.pairCount,
+                stTotal.bothCount,
+                stTotal.fallbackCount,
+                1.0 * stTotal.hpaStep / std::max<size_t>(1, stTotal.astarStep),
+                stTotal.hpaTime   / 1000000.0,
+                stTotal.astarTime / 1000000.0);
+    }
+    catch(const std::exception &e){
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    std::printf("pathfindtest passed\n");
+    return 0;
+}
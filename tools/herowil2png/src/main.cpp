@@ -34,6 +34,7 @@
  * =====================================================================================
  */
 
+#include <string>
 #include <vector>
 #include <cstdio>
 #include <cstring>
@@ -42,10 +43,9 @@
 #include <cinttypes>
 #include <algorithm>
 
-#include "pngf.hpp"
-#include "filesys.hpp"
-#include "shadow.hpp"
+#include "strf.hpp"
 #include "wilimagepackage.hpp"
+#include "wil2pngconverter.hpp"
 
 void printUsage()
 {
@@ -65,8 +65,7 @@ void printUsage()
     std::printf("%s", szUsage);
 }
 
-const char *createOffsetFileName(char *szFileName,
-        const char *szOutDir,
+std::string createOffsetFileName(
         bool bShadow,
         bool bGender,
         int  nDress,
@@ -76,31 +75,27 @@ const char *createOffsetFileName(char *szFileName,
         int  nDX,
         int  nDY)
 {
-    if(szFileName){
-        // refer to client/src/hero.cpp to get encoding strategy
-        uint32_t nEncodeShadow    = bShadow ? 1 : 0;
-        uint32_t nEncodeGender    = bGender ? 1 : 0;
-        uint32_t nEncodeDress     = nDress;
-        uint32_t nEncodeMotion    = nMotion;
-        uint32_t nEncodeDirection = nDirection;
-        uint32_t nEncodeFrame     = nFrame;
-        uint32_t nEncode = 0
-            | (nEncodeShadow    << 23)
-            | (nEncodeGender    << 22)
-            | (nEncodeDress     << 14)
-            | (nEncodeMotion    <<  8)
-            | (nEncodeDirection <<  5)
-            | (nEncodeFrame     <<  0);
-
-        std::sprintf(szFileName, "%s/%08" PRIX32 "%s%s%04X%04X.PNG",
-                szOutDir,
-                nEncode, 
-                ((nDX > 0) ? "1" : "0"),
-                ((nDY > 0) ? "1" : "0"),
-                std::abs(nDX),
-                std::abs(nDY));
-    }
-    return szFileName;
+    // refer to client/src/hero.cpp to get encoding strategy
+    uint32_t nEncodeShadow    = bShadow ? 1 : 0;
+    uint32_t nEncodeGender    = bGender ? 1 : 0;
+    uint32_t nEncodeDress     = nDress;
+    uint32_t nEncodeMotion    = nMotion;
+    uint32_t nEncodeDirection = nDirection;
+    uint32_t nEncodeFrame     = nFrame;
+    uint32_t nEncode = 0
+        | (nEncodeShadow    << 23)
+        | (nEncodeGender    << 22)
+        | (nEncodeDress     << 14)
+        | (nEncodeMotion    <<  8)
+        | (nEncodeDirection <<  5)
+        | (nEncodeFrame     <<  0);
+
+    return str_printf("%08" PRIX32 "%s%s%04X%04X.PNG",
+            nEncode, 
+            ((nDX > 0) ? "1" : "0"),
+            ((nDY > 0) ? "1" : "0"),
+            std::abs(nDX),
+            std::abs(nDY));
 }
 
 bool heroWil2PNG(bool bGender,
@@ -115,82 +110,58 @@ bool heroWil2PNG(bool bGender,
         return false;
     }
 
-    std::vector<uint32_t> stPNGBuf;
-    std::vector<uint32_t> stPNGBufShadow;
+    Wil2PNGConverter stConverter(szOutDir, "herowil2png");
     for(int nDress = 0; nDress < 8; ++nDress){
         for(int nMotion = 0; nMotion < 33; ++nMotion){
             for(int nDirection = 0; nDirection < 8; ++nDirection){
                 for(int nFrame = 0; nFrame < 10; ++nFrame){
                     int nBaseIndex = nDress * 3000 + nMotion * 80 + nDirection * 10 + nFrame + 1;
-                    if(true
-                            && stPackage.SetIndex(nBaseIndex)
-                            && stPackage.CurrentImageValid()){
-
-                        auto stInfo = stPackage.CurrentImageInfo();
-                        stPNGBuf.resize(stInfo.shWidth * stInfo.shHeight);
-                        stPackage.Decode(&(stPNGBuf[0]), 0XFFFFFFFF, 0XFFFFFFFF, 0XFFFFFFFF);
-
-                        // export for HumanGfxDBN
-                        char szSaveFileName[128];
-                        createOffsetFileName(szSaveFileName,
-                                szOutDir,
-                                false,
-                                bGender,
-                                nDress,
-                                nMotion,
-                                nDirection,
-                                nFrame,
-                                stInfo.shPX,
-                                stInfo.shPY);
-
-                        if(!pngf::saveRGBABuffer((uint8_t *)(&(stPNGBuf[0])), stInfo.shWidth, stInfo.shHeight, szSaveFileName)){
-                            std::printf("save PNG failed: %s", szSaveFileName);
-                            return false;
-                        }
-
-                        // make a big buffer to hold the shadow as needed
-                        // shadow buffer size depends on do project or not
-                        //
-                        //  project :  (nW + nH / 2) x (nH / 2 + 1)
-                        //          :  (nW x nH)
-                        //
-                        int nMaxW = (std::max<int>)(stInfo.shWidth + stInfo.shHeight / 2, stInfo.shWidth ) + 20;
-                        int nMaxH = (std::max<int>)(             1 + stInfo.shHeight / 2, stInfo.shHeight) + 20;
-                        stPNGBufShadow.resize(nMaxW * nMaxH);
-
-                        bool bProject = true;
-                        if(true
-                                && nMotion == 19
-                                && nFrame  ==  9){ bProject = false; }
-
-                        int nShadowW = 0;
-                        int nShadowH = 0;
-                        Shadow::MakeShadow(&(stPNGBufShadow[0]), bProject, &(stPNGBuf[0]), stInfo.shWidth, stInfo.shHeight, &nShadowW, &nShadowH, 0XFF000000);
-
-                        if(true
-                                && nShadowW > 0
-                                && nShadowH > 0){
-                            createOffsetFileName(szSaveFileName,
-                                    szOutDir,
-                                    true,
-                                    bGender,
-                                    nDress,
-                                    nMotion,
-                                    nDirection,
-                                    nFrame,
-                                    bProject ? stInfo.shShadowPX : (stInfo.shPX + 3),
-                                    bProject ? stInfo.shShadowPY : (stInfo.shPY + 2));
-
-                            if(!pngf::saveRGBABuffer((uint8_t *)(&(stPNGBufShadow[0])), nShadowW, nShadowH, szSaveFileName)){
-                                std::printf("save shadow PNG failed: %s", szSaveFileName);
-                                return false;
-                            }
-                        }
+
+                    std::vector<Wil2PNGConverter::FrameImage> stImageList(1);
+                    if(!Wil2PNGConverter::readImage(&stPackage, nBaseIndex, &stImageList[0])){
+                        continue;
                     }
+
+                    stConverter.addFrame(
+                    {
+                        .key = str_printf("hero/%d/%d/%d/%d/%d", (int)(bGender), nDress, nMotion, nDirection, nFrame),
+                        .imageList = std::move(stImageList),
+                        .convert = [bGender, nDress, nMotion, nDirection, nFrame](const Wil2PNGConverter::FrameJob &rstJob, std::vector<Wil2PNGConverter::OutputImage> *pOutputList)
+                        {
+                            const auto &stInfo = rstJob.imageList[0].info;
+
+                            // export for HumanGfxDBN
+                            Wil2PNGConverter::OutputImage stBody;
+                            Wil2PNGConverter::decodeImage(rstJob.imageList[0], &stBody.buf);
+
+                            stBody.w = stInfo.shWidth;
+                            stBody.h = stInfo.shHeight;
+                            stBody.fileName = createOffsetFileName(false, bGender, nDress, nMotion, nDirection, nFrame, stInfo.shPX, stInfo.shPY);
+
+                            bool bProject = true;
+                            if(true
+                                    && nMotion == 19
+                                    && nFrame  ==  9){ bProject = false; }
+
+                            Wil2PNGConverter::OutputImage stShadow;
+                            const bool bHasShadow = Wil2PNGConverter::makeShadow(stBody.buf.data(), stInfo.shWidth, stInfo.shHeight, bProject, &stShadow);
+
+                            pOutputList->push_back(std::move(stBody));
+                            if(bHasShadow){
+                                stShadow.fileName = createOffsetFileName(true, bGender, nDress, nMotion, nDirection, nFrame,
+                                        bProject ? stInfo.shShadowPX : (stInfo.shPX + 3),
+                                        bProject ? stInfo.shShadowPY : (stInfo.shPY + 2));
+                                pOutputList->push_back(std::move(stShadow));
+                            }
+                        },
+                    });
                 }
             }
         }
     }
+
+    const auto stStat = stConverter.finish();
+    std::printf("frames: %zu, unchanged: %zu, PNG written: %zu\n", stStat.frameNum, stStat.frameSkip, stStat.outputNum);
     return true;
 }
 
@@ -31,6 +31,7 @@
  * =====================================================================================
  */
 
+#include <string>
 #include <vector>
 #include <cstdio>
 #include <cstring>
@@ -39,19 +40,15 @@
 #include <cinttypes>
 #include <algorithm>
 
+#include "strf.hpp"
 #include "totype.hpp"
 #include "fflerror.hpp"
-#include "pngf.hpp"
 #include "alphaf.hpp"
-#include "filesys.hpp"
 #include "wilimagepackage.hpp"
+#include "wil2pngconverter.hpp"
 
-const char *createOffsetFileName(char *fileNameBuf, const char *outDir, int fileIndex, int imgIndex,  int dx, int dy, int prefixIndex, int prefixWidth)
+std::string createOffsetFileName(int fileIndex, int imgIndex,  int dx, int dy, int prefixIndex, int prefixWidth)
 {
-    if(!fileNameBuf){
-        throw fflerror("invalid arguments");
-    }
-
     char prefixBuf[64];
     if(prefixWidth > 0){
         std::sprintf(prefixBuf, "%0*d_", prefixWidth, prefixIndex);
@@ -60,8 +57,7 @@ const char *createOffsetFileName(char *fileNameBuf, const char *outDir, int file
         prefixBuf[0] = '\0';
     }
 
-    std::sprintf(fileNameBuf, "%s/%s%02llX%06llX%s%s%04X%04X.PNG",
-            outDir,
+    return str_printf("%s%02llX%06llX%s%s%04X%04X.PNG",
             prefixBuf,
             to_llu(fileIndex),
             to_llu(imgIndex),
@@ -69,13 +65,13 @@ const char *createOffsetFileName(char *fileNameBuf, const char *outDir, int file
             ((dy > 0) ? "1" : "0"),
             std::abs(dx),
             std::abs(dy));
-
-    return fileNameBuf;
 }
 
 void magicWil2PNG(const char *dataPath, const char *outDir, int prefixWidth)
 {
     int prefixIndex = 0;
+    Wil2PNGConverter converter(outDir, "magicwil2png");
+
     for(int fileIndex = 0; const auto fileBodyName:
     {
         "Magic",
@@ -93,24 +89,37 @@ void magicWil2PNG(const char *dataPath, const char *outDir, int prefixWidth)
             throw fflerror("load wil file failed: %s/%s.wil", dataPath, fileBodyName);
         }
 
-        std::vector<uint32_t> pngBuf;
         for(int i = 0; i < imgPackage.IndexCount(); ++i){
-            if(imgPackage.SetIndex(i) && imgPackage.CurrentImageValid()){
-                const auto imgInfo = imgPackage.CurrentImageInfo();
-                pngBuf.resize(imgInfo.shWidth * imgInfo.shHeight);
-                imgPackage.Decode(&(pngBuf[0]), 0XFFFFFFFF, 0XFFFFFFFF, 0XFFFFFFFF);
-                alphaf::autoAlpha(pngBuf.data(), pngBuf.size());
+            std::vector<Wil2PNGConverter::FrameImage> imageList(1);
+            if(!Wil2PNGConverter::readImage(&imgPackage, i, &imageList[0])){
+                continue;
+            }
 
-                char saveFileName[256];
-                createOffsetFileName(saveFileName, outDir, fileIndex, i, imgInfo.shPX, imgInfo.shPY, prefixIndex++, prefixWidth);
+            const int imgPrefixIndex = prefixIndex++;
+            converter.addFrame(
+            {
+                .key = str_printf("magic/%d/%d", fileIndex, i),
+                .param = str_printf("%d/%d", prefixWidth, imgPrefixIndex),
+                .imageList = std::move(imageList),
+                .convert = [fileIndex, i, imgPrefixIndex, prefixWidth](const Wil2PNGConverter::FrameJob &job, std::vector<Wil2PNGConverter::OutputImage> *outputList)
+                {
+                    const auto &imgInfo = job.imageList[0].info;
+                    auto &output = outputList->emplace_back();
 
-                if(!pngf::saveRGBABuffer((uint8_t *)(pngBuf.data()), imgInfo.shWidth, imgInfo.shHeight, saveFileName)){
-                    throw fflerror("save PNG failed: %s", saveFileName);
-                }
-            }
+                    Wil2PNGConverter::decodeImage(job.imageList[0], &output.buf);
+                    alphaf::autoAlpha(output.buf.data(), output.buf.size());
+
+                    output.w = imgInfo.shWidth;
+                    output.h = imgInfo.shHeight;
+                    output.fileName = createOffsetFileName(fileIndex, i, imgInfo.shPX, imgInfo.shPY, imgPrefixIndex, prefixWidth);
+                },
+            });
         }
         fileIndex++;
     }
+
+    const auto stat = converter.finish();
+    std::printf("frames: %zu, unchanged: %zu, PNG written: %zu\n", stat.frameNum, stat.frameSkip, stat.outputNum);
 }
 
 int main(int argc, char *argv[])
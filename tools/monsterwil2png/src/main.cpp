@@ -37,6 +37,7 @@
  * =====================================================================================
  */
 
+#include <string>
 #include <vector>
 #include <cstdio>
 #include <cstring>
@@ -45,11 +46,10 @@
 #include <cinttypes>
 #include <algorithm>
 
+#include "strf.hpp"
 #include "totype.hpp"
-#include "shadow.hpp"
-#include "pngf.hpp"
-#include "filesys.hpp"
 #include "wilimagepackage.hpp"
+#include "wil2pngconverter.hpp"
 
 int g_MonWilFileIndex []
 {
@@ -83,8 +83,7 @@ void printUsage()
     std::printf("%s", szUsage);
 }
 
-const char *createOffsetFileName(char *szFileName,
-        const char *szOutDir,
+std::string createOffsetFileName(
         bool bShadow,
         int  nLookID,
         int  nMotion,
@@ -95,38 +94,34 @@ const char *createOffsetFileName(char *szFileName,
         int  nImgCount,
         int  nPrefixWidth)
 {
-    if(szFileName){
-        // refer to client/src/monster.cpp to get encoding strategy
-        uint32_t nEncodeShadow    = bShadow    ? 0X0001 : 0X0000;
-        uint32_t nEncodeLookID    = nLookID    & 0X07FF;
-        uint32_t nEncodeMotion    = nMotion    & 0X000F;
-        uint32_t nEncodeDirection = nDirection & 0X0007;
-        uint32_t nEncodeFrame     = nFrame     & 0X001F;
-        uint32_t nEncode = 0
-            | (nEncodeShadow    << 23)
-            | (nEncodeLookID    << 12)
-            | (nEncodeMotion    <<  8)
-            | (nEncodeDirection <<  5)
-            | (nEncodeFrame     <<  0);
-
-        char prefixBuf[64];
-        if(nPrefixWidth > 0){
-            std::sprintf(prefixBuf, "%0*d_", nPrefixWidth, nImgCount);
-        }
-        else{
-            prefixBuf[0] = '\0';
-        }
-
-        std::sprintf(szFileName, "%s/%s%08llX%s%s%04X%04X.PNG",
-                szOutDir,
-                prefixBuf,
-                to_llu(nEncode),
-                ((nDX > 0) ? "1" : "0"),
-                ((nDY > 0) ? "1" : "0"),
-                std::abs(nDX),
-                std::abs(nDY));
+    // refer to client/src/monster.cpp to get encoding strategy
+    uint32_t nEncodeShadow    = bShadow    ? 0X0001 : 0X0000;
+    uint32_t nEncodeLookID    = nLookID    & 0X07FF;
+    uint32_t nEncodeMotion    = nMotion    & 0X000F;
+    uint32_t nEncodeDirection = nDirection & 0X0007;
+    uint32_t nEncodeFrame     = nFrame     & 0X001F;
+    uint32_t nEncode = 0
+        | (nEncodeShadow    << 23)
+        | (nEncodeLookID    << 12)
+        | (nEncodeMotion    <<  8)
+        | (nEncodeDirection <<  5)
+        | (nEncodeFrame     <<  0);
+
+    char prefixBuf[64];
+    if(nPrefixWidth > 0){
+        std::sprintf(prefixBuf, "%0*d_", nPrefixWidth, nImgCount);
+    }
+    else{
+        prefixBuf[0] = '\0';
     }
-    return szFileName;
+
+    return str_printf("%s%08llX%s%s%04X%04X.PNG",
+            prefixBuf,
+            to_llu(nEncode),
+            ((nDX > 0) ? "1" : "0"),
+            ((nDY > 0) ? "1" : "0"),
+            std::abs(nDX),
+            std::abs(nDY));
 }
 
 bool monsterWil2PNG(int nMonsterFileIndex,
@@ -151,8 +146,7 @@ bool monsterWil2PNG(int nMonsterFileIndex,
         return false;
     }
 
-    std::vector<uint32_t> stPNGBuf;
-    std::vector<uint32_t> stPNGBufShadow;
+    Wil2PNGConverter stConverter(szOutDir, "monsterwil2png");
 
     int imgCount = 0;
     const int prefixWidth = std::stoi(szPrefixWidth);
@@ -224,81 +218,64 @@ bool monsterWil2PNG(int nMonsterFileIndex,
                         }
                     }
 
-                    if(true
-                            && stPackageBody.SetIndex(nBaseIndex)
-                            && stPackageBody.CurrentImageValid()){
-
-                        auto stInfo = stPackageBody.CurrentImageInfo();
-                        stPNGBuf.resize(stInfo.shWidth * stInfo.shHeight);
-                        stPackageBody.Decode(&(stPNGBuf[0]), 0XFFFFFFFF, 0XFFFFFFFF, 0XFFFFFFFF);
-
-                        // export for MonsterDBN
-                        char szSaveFileName[128];
-                        createOffsetFileName(szSaveFileName,
-                                szOutDir,
-                                false,
-                                nGlobalMonID,
-                                nMotion,
-                                nDirection,
-                                nFrame,
-                                stInfo.shPX,
-                                stInfo.shPY,
-                                imgCount++,
-                                prefixWidth);
-
-                        if(!pngf::saveRGBABuffer((uint8_t *)(&(stPNGBuf[0])), stInfo.shWidth, stInfo.shHeight, szSaveFileName)){
-                            std::printf("save PNG failed: %s", szSaveFileName);
-                            return false;
-                        }
+                    std::vector<Wil2PNGConverter::FrameImage> stImageList(2);
+                    if(!Wil2PNGConverter::readImage(&stPackageBody, nBaseIndex, &stImageList[0])){
+                        continue;
+                    }
 
-                        // to save shadow png file
-                        // try shadow file first, failed then try to make a dynamically one
+                    // to save shadow png file
+                    // try shadow file first, failed then try to make a dynamically one
 
-                        if(alterShadowBaseIndex >= 0){
-                            nBaseIndex = alterShadowBaseIndex;
-                        }
+                    if(alterShadowBaseIndex >= 0){
+                        nBaseIndex = alterShadowBaseIndex;
+                    }
+                    const bool bShadowValid = Wil2PNGConverter::readImage(&stPackageShadow, nBaseIndex, &stImageList[1]);
+
+                    // prefix index decided here to keep file names independent of job order
+                    // dynamic shadow is made for every body image with non-zero size, then the number of
+                    // files of this frame is known before converting and prefix numbering is same as sequential run
+                    const bool bHasShadow = bShadowValid || (stImageList[0].info.shWidth > 0 && stImageList[0].info.shHeight > 0);
+                    const int nImgCount = imgCount;
+                    imgCount += (bHasShadow ? 2 : 1);
+
+                    stConverter.addFrame(
+                    {
+                        .key = str_printf("monster/%d/%d/%d/%d", nGlobalMonID, nMotion, nDirection, nFrame),
+                        .param = str_printf("%d/%d", prefixWidth, nImgCount),
+                        .imageList = std::move(stImageList),
+                        .convert = [nGlobalMonID, nMotion, nDirection, nFrame, nImgCount, prefixWidth, bShadowValid, bHasShadow](const Wil2PNGConverter::FrameJob &rstJob, std::vector<Wil2PNGConverter::OutputImage> *pOutputList)
+                        {
+                            const auto &stInfo = rstJob.imageList[0].info;
+
+                            // export for MonsterDBN
+                            Wil2PNGConverter::OutputImage stBody;
+                            Wil2PNGConverter::decodeImage(rstJob.imageList[0], &stBody.buf);
 
-                        if(true
-                                && stPackageShadow.SetIndex(nBaseIndex)
-                                && stPackageShadow.CurrentImageValid()){
+                            stBody.w = stInfo.shWidth;
+                            stBody.h = stInfo.shHeight;
+                            stBody.fileName = createOffsetFileName(false, nGlobalMonID, nMotion, nDirection, nFrame, stInfo.shPX, stInfo.shPY, nImgCount, prefixWidth);
 
-                            auto stShadowInfo = stPackageShadow.CurrentImageInfo();
-                            stPNGBufShadow.resize(stShadowInfo.shWidth * stShadowInfo.shHeight);
-                            stPackageShadow.Decode(&(stPNGBufShadow[0]), 0XFFFFFFFF, 0XFFFFFFFF, 0XFFFFFFFF);
+                            if(bShadowValid){
+                                const auto &stShadowInfo = rstJob.imageList[1].info;
 
-                            // export for MonsterDBN
-                            char szSaveShadowFileName[128];
-                            createOffsetFileName(szSaveShadowFileName,
-                                    szOutDir,
-                                    true,
-                                    nGlobalMonID,
-                                    nMotion,
-                                    nDirection,
-                                    nFrame,
-                                    stShadowInfo.shPX,
-                                    stShadowInfo.shPY,
-                                    imgCount++,
-                                    prefixWidth);
-
-                            if(!pngf::saveRGBABuffer((uint8_t *)(&(stPNGBufShadow[0])), stShadowInfo.shWidth, stShadowInfo.shHeight, szSaveShadowFileName)){
-                                std::printf("save PNG failed: %s", szSaveShadowFileName);
-                                return false;
-                            }
+                                Wil2PNGConverter::OutputImage stShadow;
+                                Wil2PNGConverter::decodeImage(rstJob.imageList[1], &stShadow.buf);
 
-                        }else{
+                                stShadow.w = stShadowInfo.shWidth;
+                                stShadow.h = stShadowInfo.shHeight;
+                                stShadow.fileName = createOffsetFileName(true, nGlobalMonID, nMotion, nDirection, nFrame, stShadowInfo.shPX, stShadowInfo.shPY, nImgCount + 1, prefixWidth);
 
-                            // dynamically create one
+                                pOutputList->push_back(std::move(stBody));
+                                pOutputList->push_back(std::move(stShadow));
+                                return;
+                            }
 
-                            // make a big buffer to hold the shadow as needed
-                            // shadow buffer size depends on do project or not
-                            //
-                            //  project :  (nW + nH / 2) x (nH / 2 + 1)
-                            //          :  (nW x nH)
-                            //
-                            int nMaxW = (std::max<int>)(stInfo.shWidth + stInfo.shHeight / 2, stInfo.shWidth ) + 20;
-                            int nMaxH = (std::max<int>)(             1 + stInfo.shHeight / 2, stInfo.shHeight) + 20;
-                            stPNGBufShadow.resize(nMaxW * nMaxH);
+                            if(!bHasShadow){
+                                pOutputList->push_back(std::move(stBody));
+                                return;
+                            }
 
+                            // dynamically create one
                             bool bProject = true;
                             if(nMotion == 4){
                                 switch(nGlobalMonID){
@@ -326,39 +303,27 @@ bool monsterWil2PNG(int nMonsterFileIndex,
                                 }
                             }
 
-                            int nShadowW = 0;
-                            int nShadowH = 0;
-                            Shadow::MakeShadow(&(stPNGBufShadow[0]), bProject, &(stPNGBuf[0]), stInfo.shWidth, stInfo.shHeight, &nShadowW, &nShadowH, 0XFF000000);
-
-                            if(true
-                                    && nShadowW > 0
-                                    && nShadowH > 0){
-
-                                char szSaveShadowFileName[128];
-                                createOffsetFileName(szSaveShadowFileName,
-                                        szOutDir,
-                                        true,
-                                        nGlobalMonID,
-                                        nMotion,
-                                        nDirection,
-                                        nFrame,
+                            Wil2PNGConverter::OutputImage stShadow;
+                            const bool bMadeShadow = Wil2PNGConverter::makeShadow(stBody.buf.data(), stInfo.shWidth, stInfo.shHeight, bProject, &stShadow);
+
+                            pOutputList->push_back(std::move(stBody));
+                            if(bMadeShadow){
+                                stShadow.fileName = createOffsetFileName(true, nGlobalMonID, nMotion, nDirection, nFrame,
                                         bProject ? stInfo.shShadowPX : (stInfo.shPX + 3),
                                         bProject ? stInfo.shShadowPY : (stInfo.shPY + 2),
-                                        imgCount++,
+                                        nImgCount + 1,
                                         prefixWidth);
-
-                                if(!pngf::saveRGBABuffer((uint8_t *)(&(stPNGBufShadow[0])), nShadowW, nShadowH, szSaveShadowFileName)){
-                                    std::printf("save shadow PNG failed: %s", szSaveShadowFileName);
-                                    return false;
-                                }
+                                pOutputList->push_back(std::move(stShadow));
                             }
-                        }
-                    }
+                        },
+                    });
                 }
             }
         }
     }
 
+    const auto stStat = stConverter.finish();
+    std::printf("frames: %zu, unchanged: %zu, PNG written: %zu\n", stStat.frameNum, stStat.frameSkip, stStat.outputNum);
     return true;
 }
 
@@ -33,6 +33,7 @@
 
 #include <map>
 #include <array>
+#include <tuple>
 #include <vector>
 #include <string>
 #include <cstdio>
@@ -41,13 +42,13 @@
 #include <cstdlib>
 #include <cstdint>
 
-#include "pngf.hpp"
 #include "strf.hpp"
-#include "shadow.hpp"
+#include "totype.hpp"
 #include "motion.hpp"
-#include "filesys.hpp"
+#include "fflerror.hpp"
 #include "protocoldef.hpp"
 #include "wilimagepackage.hpp"
+#include "wil2pngconverter.hpp"
 
 void printUsage()
 {
@@ -65,7 +66,7 @@ void printUsage()
     std::printf("%s", usage);
 }
 
-std::string createOffsetFileName(const char *outDir, bool shadow, int look, int motion, int direction, int frame, int dx, int dy)
+std::string createOffsetFileName(bool shadow, int look, int motion, int direction, int frame, int dx, int dy)
 {
     const uint32_t encodeShadow    = shadow ? 1 : 0;
     const uint32_t encodeLookID    = look;
@@ -79,8 +80,7 @@ std::string createOffsetFileName(const char *outDir, bool shadow, int look, int
         | (encodeDirection <<  5)
         | (encodeFrame     <<  0);
 
-    return str_printf("%s/%08llX%s%s%04X%04X.PNG",
-            outDir,
+    return str_printf("%08llX%s%s%04X%04X.PNG",
             to_llu(encode),
             ((dx > 0) ? "1" : "0"),
             ((dy > 0) ? "1" : "0"),
@@ -95,8 +95,7 @@ void npcWil2PNG(const char *path, const char *baseName, const char *fileExt, con
         throw fflerror("Load wil file failed: %s/%s/%s", path, baseName, fileExt);
     }
 
-    std::vector<uint32_t> pngBuf;
-    std::vector<uint32_t> pngBufShadow;
+    Wil2PNGConverter converter(outDir, "npcwil2png");
 
     struct frameSeq
     {
@@ -320,62 +319,67 @@ void npcWil2PNG(const char *path, const char *baseName, const char *fileExt, con
 
             for(int frame = 0; frame < frameCount; ++frame){
                 const int gfxId = lookId * 100 + frameStart + frame;
-                if(!(package.SetIndex(gfxId) && package.CurrentImageValid())){
+
+                std::vector<Wil2PNGConverter::FrameImage> imageList(1);
+                if(!Wil2PNGConverter::readImage(&package, gfxId, &imageList[0])){
                     throw fflerror("gfx table is wrong");
                 }
 
-                const auto imgInfo = package.CurrentImageInfo();
-                pngBuf.resize(imgInfo.shWidth * imgInfo.shHeight);
-                package.Decode(&(pngBuf[0]), 0XFFFFFFFF, 0XFFFFFFFF, 0XFFFFFFFF);
-
                 const int dir = dirMap.at(p.first.at(0));
-                const auto fileName = createOffsetFileName(outDir, false, lookId, encodeMotion, dir, frame, imgInfo.shPX, imgInfo.shPY);
-                pngf::saveRGBABuffer(reinterpret_cast<const uint8_t *>(pngBuf.data()), imgInfo.shWidth, imgInfo.shHeight, fileName.c_str());
-
-                const auto [needShadow, projectShadow] = [lookId]() -> std::tuple<bool, bool>
+                converter.addFrame(
                 {
-                    switch(lookId){
-                        case 51:
-                        case 52:
-                        case 55:
-                        case 56:
-                        case 59: return {false, false};
-                        case 71:
-                        case 72:
-                        case 73: return {true , false};
-                        default: return {true , true };
-                    }
-                }();
-
-                if(!needShadow){
-                    continue;
-                }
-
-                // make a big buffer to hold the shadow as needed
-                // shadow buffer size depends on do project or not
-                //
-                //  project :  (nW + nH / 2) x (nH / 2 + 1)
-                //          :  (nW x nH)
-
-                const int maxShadowW = (std::max<int>)(imgInfo.shWidth + imgInfo.shHeight / 2, imgInfo.shWidth ) + 20;
-                const int maxShadowH = (std::max<int>)(             1 + imgInfo.shHeight / 2, imgInfo.shHeight) + 20;
-                pngBufShadow.resize(maxShadowW * maxShadowH);
-
-                int nShadowW = 0;
-                int nShadowH = 0;
-                Shadow::MakeShadow(&(pngBufShadow[0]), projectShadow, &(pngBuf[0]), imgInfo.shWidth, imgInfo.shHeight, &nShadowW, &nShadowH, 0XFF000000);
-
-                if(nShadowW <= 0 || nShadowH <= 0){
-                    throw fflerror("create shadow image failed");
-                }
-
-                const auto shadowFileName = createOffsetFileName(outDir, true, lookId, encodeMotion, dir, frame, 
-                        projectShadow ? imgInfo.shShadowPX : (imgInfo.shPX + 3),
-                        projectShadow ? imgInfo.shShadowPY : (imgInfo.shPY + 2));
-                pngf::saveRGBABuffer(reinterpret_cast<const uint8_t *>(pngBufShadow.data()), nShadowW, nShadowH, shadowFileName.c_str());
+                    .key = str_printf("npc/%d/%d/%d/%d", lookId, encodeMotion, dir, frame),
+                    .imageList = std::move(imageList),
+                    .convert = [lookId, encodeMotion, dir, frame](const Wil2PNGConverter::FrameJob &job, std::vector<Wil2PNGConverter::OutputImage> *outputList)
+                    {
+                        const auto &imgInfo = job.imageList[0].info;
+
+                        Wil2PNGConverter::OutputImage body;
+                        Wil2PNGConverter::decodeImage(job.imageList[0], &body.buf);
+
+                        body.w = imgInfo.shWidth;
+                        body.h = imgInfo.shHeight;
+                        body.fileName = createOffsetFileName(false, lookId, encodeMotion, dir, frame, imgInfo.shPX, imgInfo.shPY);
+
+                        const auto [needShadow, projectShadow] = [lookId]() -> std::tuple<bool, bool>
+                        {
+                            switch(lookId){
+                                case 51:
+                                case 52:
+                                case 55:
+                                case 56:
+                                case 59: return {false, false};
+                                case 71:
+                                case 72:
+                                case 73: return {true , false};
+                                default: return {true , true };
+                            }
+                        }();
+
+                        if(!needShadow){
+                            outputList->push_back(std::move(body));
+                            return;
+                        }
+
+                        Wil2PNGConverter::OutputImage shadow;
+                        if(!Wil2PNGConverter::makeShadow(body.buf.data(), imgInfo.shWidth, imgInfo.shHeight, projectShadow, &shadow)){
+                            throw fflerror("create shadow image failed");
+                        }
+
+                        shadow.fileName = createOffsetFileName(true, lookId, encodeMotion, dir, frame,
+                                projectShadow ? imgInfo.shShadowPX : (imgInfo.shPX + 3),
+                                projectShadow ? imgInfo.shShadowPY : (imgInfo.shPY + 2));
+
+                        outputList->push_back(std::move(body));
+                        outputList->push_back(std::move(shadow));
+                    },
+                });
             }
         }
     }
+
+    const auto stat = converter.finish();
+    std::printf("frames: %zu, unchanged: %zu, PNG written: %zu\n", stat.frameNum, stat.frameSkip, stat.outputNum);
 }
 
 int main(int argc, char *argv[])
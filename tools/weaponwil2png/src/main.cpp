@@ -46,6 +46,7 @@
  * =====================================================================================
  */
 
+#include <string>
 #include <vector>
 #include <cstdio>
 #include <cstring>
@@ -54,10 +55,9 @@
 #include <cinttypes>
 #include <algorithm>
 
-#include "pngf.hpp"
-#include "filesys.hpp"
-#include "shadow.hpp"
+#include "strf.hpp"
 #include "wilimagepackage.hpp"
+#include "wil2pngconverter.hpp"
 
 void printUsage()
 {
@@ -87,8 +87,7 @@ void printUsage()
             "   otherwise get error\n");
 }
 
-const char *createOffsetFileName(char *szFileName,
-        const char *szOutDir,
+std::string createOffsetFileName(
         bool bShadow,
         bool bGender,
         int  nWeapon,
@@ -98,31 +97,27 @@ const char *createOffsetFileName(char *szFileName,
         int  nDX,
         int  nDY)
 {
-    if(szFileName){
-        // refer to client/src/hero.cpp to get encoding strategy
-        uint32_t nEncodeShadow    = bShadow ? 1 : 0;
-        uint32_t nEncodeGender    = bGender ? 1 : 0;
-        uint32_t nEncodeDress     = nWeapon;
-        uint32_t nEncodeMotion    = nMotion;
-        uint32_t nEncodeDirection = nDirection;
-        uint32_t nEncodeFrame     = nFrame;
-        uint32_t nEncode = 0
-            | (nEncodeShadow    << 23)
-            | (nEncodeGender    << 22)
-            | (nEncodeDress     << 14)
-            | (nEncodeMotion    <<  8)
-            | (nEncodeDirection <<  5)
-            | (nEncodeFrame     <<  0);
+    // refer to client/src/hero.cpp to get encoding strategy
+    uint32_t nEncodeShadow    = bShadow ? 1 : 0;
+    uint32_t nEncodeGender    = bGender ? 1 : 0;
+    uint32_t nEncodeDress     = nWeapon;
+    uint32_t nEncodeMotion    = nMotion;
+    uint32_t nEncodeDirection = nDirection;
+    uint32_t nEncodeFrame     = nFrame;
+    uint32_t nEncode = 0
+        | (nEncodeShadow    << 23)
+        | (nEncodeGender    << 22)
+        | (nEncodeDress     << 14)
+        | (nEncodeMotion    <<  8)
+        | (nEncodeDirection <<  5)
+        | (nEncodeFrame     <<  0);
 
-        std::sprintf(szFileName, "%s/%08" PRIX32 "%s%s%04X%04X.PNG",
-                szOutDir,
-                nEncode, 
-                ((nDX > 0) ? "1" : "0"),
-                ((nDY > 0) ? "1" : "0"),
-                std::abs(nDX),
-                std::abs(nDY));
-    }
-    return szFileName;
+    return str_printf("%08" PRIX32 "%s%s%04X%04X.PNG",
+            nEncode, 
+            ((nDX > 0) ? "1" : "0"),
+            ((nDY > 0) ? "1" : "0"),
+            std::abs(nDX),
+            std::abs(nDY));
 }
 
 bool weaponWil2PNG(bool bGender, int nIndex,
@@ -147,124 +142,95 @@ bool weaponWil2PNG(bool bGender, int nIndex,
         return false;
     }
 
-    std::vector<uint32_t> stWeaponPNGBuf;
-    std::vector<uint32_t> stWeaponPNGBufShadow;
+    Wil2PNGConverter stConverter(szOutDir, "weaponwil2png");
 
     for(int nWeapon = 0; nWeapon < 10; ++nWeapon){
         for(int nMotion = 0; nMotion < 33; ++nMotion){
             for(int nDirection = 0; nDirection < 8; ++nDirection){
                 for(int nFrame = 0; nFrame < 10; ++nFrame){
 
-                    bool bProject = true;
-                    if(true
-                            && nMotion == 19
-                            && nFrame  ==  9){ bProject = false; }
-
                     int   nHeroIndex =       0 * 3000 + nMotion * 80 + nDirection * 10 + nFrame + 1;
                     int nWeaponIndex = nWeapon * 3000 + nMotion * 80 + nDirection * 10 + nFrame + 1;
 
-                    if(true
-                            && stHeroWilPackage.SetIndex(nHeroIndex)
-                            && stHeroWilPackage.CurrentImageValid()
-
-                            && stWeaponWilPackage.SetIndex(nWeaponIndex)
-                            && stWeaponWilPackage.CurrentImageValid()){
+                    // only need info of the hero image to locate weapon shadow
+                    if(!(stHeroWilPackage.SetIndex(nHeroIndex) && stHeroWilPackage.CurrentImageValid())){
+                        continue;
+                    }
+                    const auto stHeroInfo = stHeroWilPackage.CurrentImageInfo();
 
-                        auto stHeroInfo   =   stHeroWilPackage.CurrentImageInfo();
-                        auto stWeaponInfo = stWeaponWilPackage.CurrentImageInfo();
+                    std::vector<Wil2PNGConverter::FrameImage> stImageList(1);
+                    if(!Wil2PNGConverter::readImage(&stWeaponWilPackage, nWeaponIndex, &stImageList[0])){
+                        continue;
+                    }
 
-                        stWeaponPNGBuf.resize(stWeaponInfo.shWidth * stWeaponInfo.shHeight);
-                        stWeaponWilPackage.Decode(&(stWeaponPNGBuf[0]), 0XFFFFFFFF, 0XFFFFFFFF, 0XFFFFFFFF);
+                    const int nEncodeWeapon = (nIndex - 1) * 10 + nWeapon;
+                    stConverter.addFrame(
+                    {
+                        .key = str_printf("weapon/%d/%d/%d/%d/%d", (int)(bGender), nEncodeWeapon, nMotion, nDirection, nFrame),
+                        .param = str_printf("%d/%d/%d/%d/%d/%d", stHeroInfo.shPX, stHeroInfo.shPY, stHeroInfo.shShadowPX, stHeroInfo.shShadowPY, stHeroInfo.shWidth, stHeroInfo.shHeight),
+                        .imageList = std::move(stImageList),
+                        .convert = [bGender, nEncodeWeapon, nMotion, nDirection, nFrame, stHeroInfo](const Wil2PNGConverter::FrameJob &rstJob, std::vector<Wil2PNGConverter::OutputImage> *pOutputList)
+                        {
+                            const auto &stWeaponInfo = rstJob.imageList[0].info;
 
-                        // make a buffer to hold the shadow as needed
-                        // shadow buffer size depends on do project or not
-                        //
-                        //  project :  (nW + nH / 2) x (nH / 2 + 1)
-                        //          :  (nW x nH)
-                        //
+                            bool bProject = true;
+                            if(true
+                                    && nMotion == 19
+                                    && nFrame  ==  9){ bProject = false; }
 
-                        int nMaxShadowW = (std::max<int>)(stWeaponInfo.shWidth + stWeaponInfo.shHeight / 2, stWeaponInfo.shWidth ) + 20;
-                        int nMaxShadowH = (std::max<int>)(                   1 + stWeaponInfo.shHeight / 2, stWeaponInfo.shHeight) + 20;
-                        stWeaponPNGBufShadow.resize(nMaxShadowW * nMaxShadowH);
+                            Wil2PNGConverter::OutputImage stWeapon;
+                            Wil2PNGConverter::decodeImage(rstJob.imageList[0], &stWeapon.buf);
 
-                        int nShadowW = 0;
-                        int nShadowH = 0;
-                        Shadow::MakeShadow(
-                                &(stWeaponPNGBufShadow[0]),
-                                bProject,
-                                &(stWeaponPNGBuf[0]),
-                                stWeaponInfo.shWidth,
-                                stWeaponInfo.shHeight,
-                                &nShadowW,
-                                &nShadowH,
-                                0XFF000000);
+                            stWeapon.w = stWeaponInfo.shWidth;
+                            stWeapon.h = stWeaponInfo.shHeight;
+                            stWeapon.fileName = createOffsetFileName(false, bGender, nEncodeWeapon, nMotion, nDirection, nFrame, stWeaponInfo.shPX, stWeaponInfo.shPY);
 
-                        char szSaveFileName[128];
-                        createOffsetFileName(szSaveFileName,
-                                szOutDir,
-                                false,
-                                bGender,
-                                (nIndex - 1) * 10 + nWeapon,
-                                nMotion,
-                                nDirection,
-                                nFrame,
-                                stWeaponInfo.shPX,
-                                stWeaponInfo.shPY);
+                            Wil2PNGConverter::OutputImage stShadow;
+                            const bool bHasShadow = Wil2PNGConverter::makeShadow(stWeapon.buf.data(), stWeaponInfo.shWidth, stWeaponInfo.shHeight, bProject, &stShadow);
 
-                        if(!pngf::saveRGBABuffer((uint8_t *)(&(stWeaponPNGBuf[0])), stWeaponInfo.shWidth, stWeaponInfo.shHeight, szSaveFileName)){
-                            std::printf("save weapon PNG failed: %s", szSaveFileName);
-                            return false;
-                        }
+                            pOutputList->push_back(std::move(stWeapon));
+                            if(!bHasShadow){
+                                return;
+                            }
 
-                        // understand how I get it:
-                        // two coords: origin at left-top    : coord-1
-                        //             origin at left-bottom : coord-2
-                        //
-                        // 1. every frame consists of body image and weapon image, in coord-1: (X0, Y0) and (X1, Y1)
-                        // 2. these two images construct a bigger image, call it combined image, take (W, H) as its size
-                        // 3. then take origin of coord-2 at the left-bottom of the combined image
-                        // 4. (X0, Y0) -> (X0, H - Y0)
-                        //    (X1, Y1) -> (X1, H - Y1)
-                        // 5. any point (x, y) in coord-2 will project to (x + y / 2, 1 + y / 2)
-                        //    then calculate the projectioin of start point of body image and weapon image in coord-2
-                        // 6. real start point of the projected images has a (y / 2) shift to the left
-                        //
-                        //     p   q
-                        //     +---+----+      p : real start point of projected image
-                        //     |  /    /       q :      start point of projected image
-                        //     | /    /
-                        //     +-----+
-                        // 7. convert back to coord-1 of ``real start point" of shadow images
-                        // 8. offset of ``real start point" of body shadow image is given, then we calculate for weapon shadow image
-                        // 9. this method works pretty good!
+                            // understand how I get it:
+                            // two coords: origin at left-top    : coord-1
+                            //             origin at left-bottom : coord-2
+                            //
+                            // 1. every frame consists of body image and weapon image, in coord-1: (X0, Y0) and (X1, Y1)
+                            // 2. these two images construct a bigger image, call it combined image, take (W, H) as its size
+                            // 3. then take origin of coord-2 at the left-bottom of the combined image
+                            // 4. (X0, Y0) -> (X0, H - Y0)
+                            //    (X1, Y1) -> (X1, H - Y1)
+                            // 5. any point (x, y) in coord-2 will project to (x + y / 2, 1 + y / 2)
+                            //    then calculate the projectioin of start point of body image and weapon image in coord-2
+                            // 6. real start point of the projected images has a (y / 2) shift to the left
+                            //
+                            //     p   q
+                            //     +---+----+      p : real start point of projected image
+                            //     |  /    /       q :      start point of projected image
+                            //     | /    /
+                            //     +-----+
+                            // 7. convert back to coord-1 of ``real start point" of shadow images
+                            // 8. offset of ``real start point" of body shadow image is given, then we calculate for weapon shadow image
+                            // 9. this method works pretty good!
 
-                        int nWeaponDX = stHeroInfo.shShadowPX + (stWeaponInfo.shPX - stHeroInfo.shPX) - (stWeaponInfo.shPY - stHeroInfo.shPY) / 2 - (stWeaponInfo.shHeight - stHeroInfo.shHeight) / 2;
-                        int nWeaponDY = stHeroInfo.shShadowPY + (stWeaponInfo.shPY - stHeroInfo.shPY) / 2;
+                            int nWeaponDX = stHeroInfo.shShadowPX + (stWeaponInfo.shPX - stHeroInfo.shPX) - (stWeaponInfo.shPY - stHeroInfo.shPY) / 2 - (stWeaponInfo.shHeight - stHeroInfo.shHeight) / 2;
+                            int nWeaponDY = stHeroInfo.shShadowPY + (stWeaponInfo.shPY - stHeroInfo.shPY) / 2;
 
-                        if(true
-                                && nShadowW > 0
-                                && nShadowH > 0){
-                            createOffsetFileName(szSaveFileName,
-                                    szOutDir,
-                                    true,
-                                    bGender,
-                                    (nIndex - 1) * 10 + nWeapon,
-                                    nMotion,
-                                    nDirection,
-                                    nFrame,
+                            stShadow.fileName = createOffsetFileName(true, bGender, nEncodeWeapon, nMotion, nDirection, nFrame,
                                     bProject ? (nWeaponDX) : (stWeaponInfo.shPX + 3),
                                     bProject ? (nWeaponDY) : (stWeaponInfo.shPY + 2));
-
-                            if(!pngf::saveRGBABuffer((uint8_t *)(&(stWeaponPNGBufShadow[0])), nShadowW, nShadowH, szSaveFileName)){
-                                std::printf("save shadow PNG failed: %s", szSaveFileName);
-                                return false;
-                            }
-                        }
-                    }
+                            pOutputList->push_back(std::move(stShadow));
+                        },
+                    });
                 }
             }
         }
     }
+
+    const auto stStat = stConverter.finish();
+    std::printf("frames: %zu, unchanged: %zu, PNG written: %zu\n", stStat.frameNum, stStat.frameSkip, stStat.outputNum);
     return true;
 }
 
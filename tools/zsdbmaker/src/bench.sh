@@ -0,0 +1,84 @@
+#!/bin/bash
+
+# build one zsdb with different options and report the numbers zsdbmaker prints
+# also check the output is byte-identical for any thread count
+# or time lookup + decompress of a v1 file against the same data rebuilt as v2
+# usage:
+#        bench.sh path/to/zsdbmaker path/to/data-dir [dict-size]
+#        bench.sh path/to/zsdbmaker --lookup path/to/v1.zsdb [round]
+
+function printUsage()
+{
+    echo "Usage:"
+    echo "      bench.sh path/to/zsdbmaker path/to/data-dir [dict-size]"
+    echo "# 1. build with 1 thread and no dictionary, same as the serial builder"
+    echo "# 2. build with 2, 4, 8 and nproc threads, compare output to 1"
+    echo "# 3. build with a trained dictionary, default size 112640"
+    echo ""
+    echo "      bench.sh path/to/zsdbmaker --lookup path/to/v1.zsdb [round]"
+    echo "# 1. extract the v1 file and rebuild it as v2, no dictionary"
+    echo "# 2. run --lookup-db on both, every entry decompressed [round] times, default 5"
+}
+
+if [[ $# -lt 2 || $# -gt 4 ]]
+then
+    printUsage
+    exit 1
+fi
+
+zsdbmaker=$(readlink -m $1)
+work_dir=$(mktemp -d)
+trap "rm -rf $work_dir" EXIT
+
+if [[ $2 == "--lookup" ]]
+then
+    if [[ $# != 3 && $# != 4 ]]
+    then
+        printUsage
+        exit 1
+    fi
+
+    v1_file=$(readlink -m $3)
+    round=${4:-5}
+
+    # --decomp-db writes into current directory
+    mkdir $work_dir/data
+    (cd $work_dir/data && $zsdbmaker --decomp-db=$v1_file > /dev/null) || exit 1
+    $zsdbmaker --create-db=$work_dir/v2.zsdb --input-data-dir=$work_dir/data --train-dict-size=0 > /dev/null || exit 1
+
+    echo "---- $(basename $v1_file): $(stat -c %s $v1_file) bytes -> v2: $(stat -c %s $work_dir/v2.zsdb) bytes"
+    $zsdbmaker --lookup-db=$v1_file --lookup-round=$round || exit 1
+    $zsdbmaker --lookup-db=$work_dir/v2.zsdb --lookup-round=$round || exit 1
+    exit 0
+fi
+
+if [[ $# == 4 ]]
+then
+    printUsage
+    exit 1
+fi
+
+data_dir=$(readlink -m $2)
+dict_size=${3:-112640}
+
+function runBuild()
+{
+    # $1: output, $2: thread, $3: dict size
+    echo "---- thread = $2, train-dict-size = $3"
+    $zsdbmaker --create-db=$1 --input-data-dir=$data_dir --thread=$2 --train-dict-size=$3 || exit 1
+}
+
+runBuild $work_dir/1.zsdb 1 0
+
+# more threads than cores still checks the output order
+for thread in 2 4 8 $(nproc)
+do
+    runBuild $work_dir/$thread.zsdb $thread 0
+    if ! cmp -s $work_dir/1.zsdb $work_dir/$thread.zsdb
+    then
+        echo "ERROR: output with $thread threads differs from 1 thread"
+        exit 1
+    fi
+done
+
+runBuild $work_dir/dict.zsdb $(nproc) $dict_size
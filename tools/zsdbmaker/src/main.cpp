@@ -15,10 +15,15 @@
  * =====================================================================================
  */
 #include <regex>
+#include <chrono>
+#include <random>
+#include <cctype>
 #include <cstdio>
+#include <string>
 #include <fstream>
 #include <cinttypes>
 #include "zsdb.hpp"
+#include "hexstr.hpp"
 #include "argparser.hpp"
 
 static int cmd_help()
@@ -29,6 +34,12 @@ static int cmd_help()
     std::printf("--decomp-db\n");
     std::printf("--input-data-dir\n");
     std::printf("--input-dict\n");
+    std::printf("--thread\n");
+    std::printf("--train-dict-size\n");
+    std::printf("--comp-level\n");
+    std::printf("--comp-level-list\n");
+    std::printf("--lookup-db\n");
+    std::printf("--lookup-round\n");
 
     return 0;
 }
@@ -110,18 +121,115 @@ static int cmd_create_db(const argh::parser &cmd)
         return fCompressThreshold;
     }();
 
-    if(ZSDB::BuildDB(
-                szDBOutputName.c_str(),
-                szFileNameRegex.empty() ? nullptr : szFileNameRegex.c_str(),
-                szDBInputDirName.c_str(),
-                szDictInputName.empty() ? nullptr : szDictInputName.c_str(),
-                fCompressThreshold
-                )){
-        return 0;
+    auto nThreadNum = [&cmd]() -> int
+    {
+        if(!has_option(cmd, "thread")){
+            return 0;
+        }
+
+        if(cmd["thread"] || cmd("thread").str().empty()){
+            throw std::invalid_argument("thread requires an argument");
+        }
+        return std::stoi(cmd("thread").str());
+    }();
+
+    auto nTrainDictSize = [&cmd]() -> size_t
+    {
+        if(!has_option(cmd, "train-dict-size")){
+            return 0;
+        }
+
+        if(cmd["train-dict-size"] || cmd("train-dict-size").str().empty()){
+            throw std::invalid_argument("train-dict-size requires an argument");
+        }
+        return std::stoul(cmd("train-dict-size").str());
+    }();
+
+    auto nCompLevel = [&cmd]() -> int
+    {
+        if(!has_option(cmd, "comp-level")){
+            return 3;
+        }
+
+        if(cmd["comp-level"] || cmd("comp-level").str().empty()){
+            throw std::invalid_argument("comp-level requires an argument");
+        }
+        return std::stoi(cmd("comp-level").str());
+    }();
+
+    // format: regex:level;regex:level
+    // file name takes the level of the first matched regex
+    auto stCompLevelList = [&cmd]() -> std::vector<std::pair<std::string, int>>
+    {
+        if(!has_option(cmd, "comp-level-list")){
+            return {};
+        }
+
+        if(cmd["comp-level-list"] || cmd("comp-level-list").str().empty()){
+            throw std::invalid_argument("comp-level-list requires an argument");
+        }
+
+        std::vector<std::pair<std::string, int>> stLevelList;
+        const auto szLevelList = cmd("comp-level-list").str();
+
+        for(size_t nBegin = 0; nBegin < szLevelList.size();){
+            const auto nEnd = std::min<size_t>(szLevelList.find(';', nBegin), szLevelList.size());
+            const auto szItem = szLevelList.substr(nBegin, nEnd - nBegin);
+
+            if(const auto nColon = szItem.rfind(':'); nColon == std::string::npos){
+                throw std::invalid_argument("invalid comp-level-list item: " + szItem);
+            }
+            else{
+                stLevelList.emplace_back(szItem.substr(0, nColon), std::stoi(szItem.substr(nColon + 1)));
+            }
+            nBegin = nEnd + 1;
+        }
+        return stLevelList;
+    }();
+
+    ZSDB::BuildOption stOption;
+    stOption.FileNameRegex = szFileNameRegex.empty() ? nullptr : szFileNameRegex.c_str();
+    stOption.DictPath      = szDictInputName.empty() ? nullptr : szDictInputName.c_str();
+    stOption.CompRatio     = fCompressThreshold;
+    stOption.ThreadNum     = nThreadNum;
+    stOption.TrainDictSize = nTrainDictSize;
+    stOption.CompLevel     = nCompLevel;
+    stOption.CompLevelList = stCompLevelList;
+
+    ZSDB::BuildStat stStat;
+    const auto fnNow = []()
+    {
+        return std::chrono::steady_clock::now();
+    };
+
+    const auto stBuildStart = fnNow();
+    if(!ZSDB::BuildDB(szDBOutputName.c_str(), szDBInputDirName.c_str(), stOption, &stStat)){
+        std::printf("build zsdb failed...\n");
+        return -1;
+    }
+    const auto fBuildTime = std::chrono::duration<double>(fnNow() - stBuildStart).count();
+
+    // decode everything once to report the read speed
+    size_t nDecodeLength = 0;
+    const auto stDecodeStart = fnNow();
+    {
+        ZSDB stZSDB(szDBOutputName.c_str());
+        std::vector<uint8_t> stReadBuf;
+
+        for(const auto &rstEntry: stZSDB.GetEntryList()){
+            if(stZSDB.Decomp(rstEntry.FileName, 0, &stReadBuf)){
+                nDecodeLength += stReadBuf.size();
+            }
+        }
     }
+    const auto fDecodeTime = std::chrono::duration<double>(fnNow() - stDecodeStart).count();
 
-    std::printf("build zsdb failed...\n");
-    return -1;
+    std::printf("entries    : %zu\n", stStat.EntryNum);
+    std::printf("dictionary : %zu bytes\n", stStat.DictLength);
+    std::printf("size       : %zu -> %zu bytes [%.2f%%]\n", stStat.SrcLength, stStat.DstLength, stStat.SrcLength ? (100.0 * stStat.DstLength / stStat.SrcLength) : 0.0);
+    std::printf("build time : %.3f s\n", fBuildTime);
+    std::printf("decode     : %.2f MB/s\n", (fDecodeTime > 0.0) ? (nDecodeLength / fDecodeTime / 1024.0 / 1024.0) : 0.0);
+    return 0;
 }
 
 static int cmd_list(const argh::parser &cmd)
@@ -198,6 +306,95 @@ static int cmd_uncomp_db(const argh::parser &cmd)
     return 0;
 }
 
+// time lookup + decompress of every entry in random order, same as texture/map databases read
+// names starting with 8 hex digits go through Decomp(uint32_t), v2 uses its integer index then
+static int cmd_lookup_db(const argh::parser &cmd)
+{
+    auto szDBFileName = [&cmd]() -> std::string
+    {
+        if(cmd["lookup-db"] || cmd("lookup-db").str().empty()){
+            throw std::invalid_argument("option --lookup-db requires an argument");
+        }
+
+        return cmd("lookup-db").str();
+    }();
+
+    auto nRound = [&cmd]() -> int
+    {
+        if(!has_option(cmd, "lookup-round")){
+            return 5;
+        }
+
+        if(cmd["lookup-round"] || cmd("lookup-round").str().empty()){
+            throw std::invalid_argument("lookup-round requires an argument");
+        }
+        return std::max<int>(1, std::stoi(cmd("lookup-round").str()));
+    }();
+
+    // v2 header starts with "ZSDB2", v1 starts with the zstd version number
+    auto szFormat = [&szDBFileName]() -> std::string
+    {
+        char szMagic[5] {};
+        std::ifstream f(szDBFileName, std::ios::in | std::ios::binary);
+
+        f.read(szMagic, sizeof(szMagic));
+        return std::string(szMagic, sizeof(szMagic)) == "ZSDB2" ? "v2" : "v1";
+    }();
+
+    const auto fnNow = []()
+    {
+        return std::chrono::steady_clock::now();
+    };
+
+    const auto stOpenStart = fnNow();
+    ZSDB stZSDB(szDBFileName.c_str());
+    const auto fOpenTime = std::chrono::duration<double>(fnNow() - stOpenStart).count();
+
+    std::vector<std::string> stNameList;
+    for(const auto &rstEntry: stZSDB.GetEntryList()){
+        stNameList.push_back(rstEntry.FileName);
+    }
+
+    std::shuffle(stNameList.begin(), stNameList.end(), std::minstd_rand(17));
+
+    size_t nKeyCount = 0;
+    std::vector<std::pair<uint32_t, const char *>> stLookupList;
+
+    for(const auto &szName: stNameList){
+        if(szName.size() >= 8 && std::all_of(szName.begin(), szName.begin() + 8, [](char chByte){ return std::isxdigit((unsigned char)(chByte)); })){
+            stLookupList.emplace_back(hexstr::to_hex<uint32_t, 4>(szName.c_str()), nullptr);
+            nKeyCount++;
+        }
+        else{
+            stLookupList.emplace_back(0, szName.c_str());
+        }
+    }
+
+    size_t nDecodeLength = 0;
+    std::vector<uint8_t> stReadBuf;
+
+    const auto stLookupStart = fnNow();
+    for(int nCurrRound = 0; nCurrRound < nRound; ++nCurrRound){
+        for(const auto &[nKey, szName]: stLookupList){
+            if(szName ? stZSDB.Decomp(szName, 0, &stReadBuf) : stZSDB.Decomp(nKey, &stReadBuf)){
+                nDecodeLength += stReadBuf.size();
+            }
+            else{
+                throw std::runtime_error("lookup failed: " + (szName ? std::string(szName) : std::to_string(nKey)));
+            }
+        }
+    }
+    const auto fLookupTime = std::chrono::duration<double>(fnNow() - stLookupStart).count();
+    const auto nLookupCount = stLookupList.size() * nRound;
+
+    std::printf("format     : %s\n", szFormat.c_str());
+    std::printf("entries    : %zu, integer key: %zu\n", stLookupList.size(), nKeyCount);
+    std::printf("open time  : %.3f ms\n", fOpenTime * 1000.0);
+    std::printf("lookup     : %.2f us/entry, %.0f entry/s\n", (nLookupCount > 0) ? (fLookupTime * 1000000.0 / nLookupCount) : 0.0, (fLookupTime > 0.0) ? (nLookupCount / fLookupTime) : 0.0);
+    std::printf("decode     : %.2f MB/s\n", (fLookupTime > 0.0) ? (nDecodeLength / fLookupTime / 1024.0 / 1024.0) : 0.0);
+    return 0;
+}
+
 int main(int argc, char *argv[])
 {
     try{
@@ -218,6 +415,10 @@ int main(int argc, char *argv[])
             return cmd_uncomp_db(cmd);
         }
 
+        if(has_option(cmd, "lookup-db")){
+            return cmd_lookup_db(cmd);
+        }
+
     }catch(std::exception &e){
         std::printf("%s\n", e.what());
         return -1;